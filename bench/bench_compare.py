@@ -0,0 +1,291 @@
+#!/usr/bin/env python3
+"""Baseline store and regression check for the size-sweep benchmarks.
+
+Reads the JSON written by `sm4_sweep` / `sm3_sweep --json` (bench_harness.c),
+keys it on a host fingerprint (CPU model, CPU flags, compiler, kernel) and
+either stores it as the baseline or compares it against the stored one.
+
+    bench_compare.py fingerprint RESULTS.json
+    bench_compare.py record  RESULTS.json [--store DIR]
+    bench_compare.py compare RESULTS.json [--store DIR | --baseline FILE]
+                             [--threshold 0.05] [--alpha 0.01]
+                             [--method mannwhitney|bootstrap]
+
+A (case, variant, size) cell is a regression when its median cycles/byte is
+more than --threshold slower than the baseline AND the slowdown is
+significant: one-sided Mann-Whitney U p < alpha, or the bootstrap
+(1 - alpha) confidence interval of the median ratio lies above 1. Cells with
+too few runs for the exact test to reach alpha are reported as "untestable"
+when they moved by more than the threshold, and never fail the check.
+`compare` exits with 1 when any cell regresses, 2 when there is no baseline.
+"""
+import argparse
+import hashlib
+import json
+import math
+import os
+import random
+import sys
+
+DEFAULT_STORE = os.environ.get(
+    'BENCH_BASELINE_DIR',
+    os.path.join(os.path.dirname(os.path.abspath(__file__)), 'baselines'))
+
+
+def load_results(path):
+    with open(path) as f:
+        doc = json.load(f)
+    if 'results' not in doc or 'suite' not in doc:
+        raise ValueError(f'{path}: not a bench_harness JSON file')
+    return doc
+
+
+def host_of(doc):
+    # Older files only had a top-level cpu_model
+    host = doc.get('host') or {}
+    return {
+        'cpu_model': host.get('cpu_model', doc.get('cpu_model', 'unknown')),
+        'cpu_flags': host.get('cpu_flags', 'unknown'),
+        'compiler': host.get('compiler', 'unknown'),
+        'kernel': host.get('kernel', 'unknown'),
+    }
+
+
+def fingerprint(doc):
+    h = host_of(doc)
+    key = json.dumps([h['cpu_model'], sorted(h['cpu_flags'].split()),
+                      h['compiler'], h['kernel']])
+    return hashlib.sha256(key.encode()).hexdigest()[:16]
+
+
+def baseline_path(store, doc):
+    suite = ''.join(c if c.isalnum() or c in '-_.' else '_' for c in doc['suite'])
+    return os.path.join(store, fingerprint(doc), suite + '.json')
+
+
+def cells(doc):
+    out = {}
+    for r in doc['results']:
+        key = (r['case'], r.get('variant', ''), int(r['bytes']))
+        samples = r.get('cpb_samples') or []
+        out[key] = {'median': r['cycles_per_byte']['median'], 'samples': samples}
+    return out
+
+
+def median(v):
+    s = sorted(v)
+    n = len(s)
+    return s[n // 2] if n % 2 else 0.5 * (s[n // 2 - 1] + s[n // 2])
+
+
+# --- Mann-Whitney U -------------------------------------------------------
+
+def _u_distribution(m, n):
+    """Counts of U = 0..m*n under H0 (no ties): coefficients of the Gaussian
+    binomial [m+n choose m]_q, built as prod (1 - q^(n+i)) / (1 - q^i)."""
+    size = m * n + 1
+    poly = [0] * size
+    poly[0] = 1
+    for i in range(1, m + 1):
+        # Multiply by (1 - q^(n+i)), then divide exactly by (1 - q^i)
+        for k in range(size - 1, n + i - 1, -1):
+            poly[k] -= poly[k - n - i]
+        for k in range(i, size):
+            poly[k] += poly[k - i]
+    return poly
+
+
+def mann_whitney_min_p(m, n):
+    """Smallest one-sided p the exact test can give for m vs n samples."""
+    return 1.0 / math.comb(m + n, m) if m * n <= 1600 else 0.0
+
+
+def mann_whitney_greater(new, base):
+    """One-sided p-value for 'new tends to be larger than base'."""
+    m, n = len(new), len(base)
+    u = 0.0
+    for x in new:
+        for y in base:
+            u += 1.0 if x > y else (0.5 if x == y else 0.0)
+
+    if m * n <= 1600:
+        dist = _u_distribution(m, n)
+        total = sum(dist)
+        start = math.ceil(u - 1e-9)
+        return sum(dist[start:]) / total
+
+    # Normal approximation with tie and continuity correction
+    pooled = sorted(new + base)
+    ties = 0.0
+    i = 0
+    while i < len(pooled):
+        j = i
+        while j < len(pooled) and pooled[j] == pooled[i]:
+            j += 1
+        t = j - i
+        ties += t ** 3 - t
+        i = j
+    nn = m + n
+    var = m * n / 12.0 * ((nn + 1) - ties / (nn * (nn - 1)))
+    if var <= 0:
+        return 1.0
+    z = (u - m * n / 2.0 - 0.5) / math.sqrt(var)
+    return 0.5 * math.erfc(z / math.sqrt(2))
+
+
+# --- Bootstrap ------------------------------------------------------------
+
+def bootstrap_ratio_ci(new, base, alpha, resamples, rng):
+    """(1 - alpha) percentile interval of median(new) / median(base)."""
+    ratios = []
+    for _ in range(resamples):
+        a = [new[rng.randrange(len(new))] for _ in new]
+        b = [base[rng.randrange(len(base))] for _ in base]
+        mb = median(b)
+        if mb > 0:
+            ratios.append(median(a) / mb)
+    ratios.sort()
+    lo = ratios[int(alpha / 2 * (len(ratios) - 1))]
+    hi = ratios[int((1 - alpha / 2) * (len(ratios) - 1))]
+    return lo, hi
+
+
+# --- Commands -------------------------------------------------------------
+
+def cmd_fingerprint(args):
+    doc = load_results(args.results)
+    print(fingerprint(doc))
+    for k, v in host_of(doc).items():
+        if k == 'cpu_flags':
+            v = f'{len(v.split())} flags'
+        print(f'  {k}: {v}')
+    return 0
+
+
+def cmd_record(args):
+    doc = load_results(args.results)
+    path = baseline_path(args.store, doc)
+    os.makedirs(os.path.dirname(path), exist_ok=True)
+    with open(path, 'w') as f:
+        json.dump(doc, f, indent=1)
+    with open(os.path.join(os.path.dirname(path), 'host.json'), 'w') as f:
+        json.dump(host_of(doc), f, indent=1)
+    print(f'Baseline for {doc["suite"]} on host {fingerprint(doc)}: {path} '
+          f'({len(doc["results"])} cells)')
+    return 0
+
+
+def cmd_compare(args):
+    doc = load_results(args.results)
+    path = args.baseline or baseline_path(args.store, doc)
+    if not os.path.exists(path):
+        print(f'No baseline for {doc["suite"]} on host {fingerprint(doc)} ({path}); '
+              f'run "record" first', file=sys.stderr)
+        return 2
+    base_doc = load_results(path)
+    if not args.baseline and fingerprint(base_doc) != fingerprint(doc):
+        print(f'{path} was recorded on a different host', file=sys.stderr)
+        return 2
+
+    rng = random.Random(args.seed)
+    new_cells, base_cells = cells(doc), cells(base_doc)
+    regressions = improvements = untestables = 0
+
+    print(f'Suite {doc["suite"]}, host {fingerprint(doc)}, baseline {path}')
+    print(f'Threshold {args.threshold * 100:.1f}%, alpha {args.alpha}, method {args.method}\n')
+    print(f'{"case / variant":44s} {"size":>10s} {"base cpb":>10s} {"new cpb":>10s} '
+          f'{"change":>8s} {"test":>20s}  verdict')
+
+    for key in sorted(new_cells, key=lambda k: (k[0], k[1], k[2])):
+        if key not in base_cells:
+            continue
+        new, base = new_cells[key], base_cells[key]
+        change = new['median'] / base['median'] - 1 if base['median'] > 0 else 0.0
+        untestable = False
+
+        if len(new['samples']) >= 2 and len(base['samples']) >= 2:
+            if args.method == 'bootstrap':
+                lo, hi = bootstrap_ratio_ci(new['samples'], base['samples'],
+                                            args.alpha, args.resamples, rng)
+                slower, faster = lo > 1.0, hi < 1.0
+                test = f'CI [{lo - 1:+.1%},{hi - 1:+.1%}]'
+            elif mann_whitney_min_p(len(new['samples']), len(base['samples'])) >= args.alpha:
+                # Too few runs for any outcome to be significant at alpha
+                untestable = True
+                test = f'n={len(new["samples"])}/{len(base["samples"])} too few'
+            else:
+                p_slow = mann_whitney_greater(new['samples'], base['samples'])
+                p_fast = mann_whitney_greater(base['samples'], new['samples'])
+                slower, faster = p_slow < args.alpha, p_fast < args.alpha
+                test = f'p={min(p_slow, p_fast):.2g}'
+        else:
+            # Summary-only files: the threshold is all we have
+            slower, faster = True, True
+            test = 'no samples'
+
+        verdict = ''
+        if untestable:
+            if abs(change) > args.threshold:
+                verdict = 'untestable'
+                untestables += 1
+            elif not args.all:
+                continue
+        elif change > args.threshold and slower:
+            verdict = 'REGRESSION'
+            regressions += 1
+        elif change < -args.threshold and faster:
+            verdict = 'improved'
+            improvements += 1
+        elif not args.all:
+            continue
+
+        name = f'{key[0]} / {key[1]}'
+        print(f'{name[:44]:44s} {key[2]:>10d} {base["median"]:10.3f} {new["median"]:10.3f} '
+              f'{change:+8.1%} {test:>20s}  {verdict}')
+
+    only_new = len(set(new_cells) - set(base_cells))
+    only_base = len(set(base_cells) - set(new_cells))
+    print(f'\n{regressions} regression(s), {improvements} improvement(s) over '
+          f'{len(set(new_cells) & set(base_cells))} common cells'
+          + (f'; {only_new} new, {only_base} missing' if only_new or only_base else '')
+          + (f'; {untestables} changed cell(s) had too few runs to test at alpha {args.alpha}'
+             if untestables else ''))
+    return 1 if regressions else 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Benchmark baseline store and regression check')
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    p = sub.add_parser('fingerprint', help='print the host fingerprint of a results file')
+    p.add_argument('results')
+    p.set_defaults(func=cmd_fingerprint)
+
+    p = sub.add_parser('record', help='store a results file as the baseline for its host')
+    p.add_argument('results')
+    p.add_argument('--store', default=DEFAULT_STORE)
+    p.set_defaults(func=cmd_record)
+
+    p = sub.add_parser('compare', help='compare a results file against the stored baseline')
+    p.add_argument('results')
+    p.add_argument('--store', default=DEFAULT_STORE)
+    p.add_argument('--baseline', help='compare against this file instead (any host)')
+    p.add_argument('--threshold', type=float, default=0.05,
+                   help='relative slowdown that counts as a regression (default 0.05)')
+    p.add_argument('--alpha', type=float, default=0.01, help='significance level (default 0.01)')
+    p.add_argument('--method', choices=['mannwhitney', 'bootstrap'], default='mannwhitney')
+    p.add_argument('--resamples', type=int, default=2000, help='bootstrap resamples')
+    p.add_argument('--seed', type=int, default=1)
+    p.add_argument('--all', action='store_true', help='list unchanged cells too')
+    p.set_defaults(func=cmd_compare)
+
+    args = parser.parse_args()
+    try:
+        return args.func(args)
+    except (OSError, ValueError, KeyError) as e:
+        print(f'error: {e}', file=sys.stderr)
+        return 2
+
+
+if __name__ == '__main__':
+    sys.exit(main())
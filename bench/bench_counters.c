@@ -0,0 +1,201 @@
+#define _GNU_SOURCE
+#include "bench_counters.h"
+#include <errno.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+static const char *const fixed_names[BENCH_CTR_FIXED] = {
+    "instructions", "cycles", "l1d_misses", "llc_misses", "branch_misses",
+    "port0_uops", "port1_uops", "port5_uops", "port6_uops"};
+
+const char *bench_counter_name(int slot)
+{
+    return (slot >= 0 && slot < BENCH_CTR_FIXED) ? fixed_names[slot] : "?";
+}
+
+#ifdef __linux__
+// Raw event code for UOPS_DISPATCHED on the given port slot, 0 if this CPU's
+// encoding is unknown (generic perf events have no per-port equivalent)
+static uint64_t port_event_config(int slot)
+{
+    static const uint8_t port_umask[4] = {0x01, 0x02, 0x20, 0x40}; // ports 0, 1, 5, 6
+    uint32_t eax, ebx, ecx, edx;
+    uint32_t vendor[3], family, model;
+
+    __asm__ volatile(
+        "cpuid"
+        : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+        : "a"(0));
+    vendor[0] = ebx;
+    vendor[1] = edx;
+    vendor[2] = ecx;
+    if (memcmp(vendor, "GenuineIntel", 12) != 0)
+    {
+        return 0;
+    }
+
+    __asm__ volatile(
+        "cpuid"
+        : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+        : "a"(1));
+    family = (eax >> 8) & 0xf;
+    model = ((eax >> 4) & 0xf) | ((eax >> 12) & 0xf0);
+    if (family != 6)
+    {
+        return 0;
+    }
+
+    switch (model)
+    {
+    // Haswell .. Comet Lake: UOPS_DISPATCHED_PORT.PORT_n (0xA1)
+    case 0x3c: case 0x3f: case 0x45: case 0x46:
+    case 0x3d: case 0x47: case 0x4f: case 0x56:
+    case 0x4e: case 0x5e: case 0x55: case 0x8e:
+    case 0x9e: case 0xa5: case 0xa6:
+        return 0xa1 | ((uint64_t)port_umask[slot] << 8);
+    // Ice Lake .. Emerald Rapids: UOPS_DISPATCHED.PORT_n (0xB2)
+    case 0x6a: case 0x6c: case 0x7d: case 0x7e:
+    case 0x8c: case 0x8d: case 0x8f: case 0xcf:
+        return 0xb2 | ((uint64_t)port_umask[slot] << 8);
+    default:
+        return 0;
+    }
+}
+
+static int counter_open(uint32_t type, uint64_t config)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static int fixed_open(int slot)
+{
+    static const uint64_t hw[BENCH_CTR_PORT0] = {
+        PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CPU_CYCLES, 0,
+        PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+
+    if (slot == BENCH_CTR_L1D_MISSES)
+    {
+        return counter_open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+                                                    (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                                    (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    }
+    if (slot < BENCH_CTR_PORT0)
+    {
+        return counter_open(PERF_TYPE_HARDWARE, hw[slot]);
+    }
+
+    uint64_t config = port_event_config(slot - BENCH_CTR_PORT0);
+    return config ? counter_open(PERF_TYPE_RAW, config) : -1;
+}
+#endif
+
+int bench_counters_open(bench_counters *bc, int nraw, const char *const raw_name[],
+                        const uint64_t raw_config[])
+{
+    int usable = 0, err = 0;
+
+    nraw = nraw < BENCH_CTR_MAX_RAW ? nraw : BENCH_CTR_MAX_RAW;
+    bc->n = BENCH_CTR_FIXED + nraw;
+    bc->error = NULL;
+    for (int i = 0; i < bc->n; i++)
+    {
+        bc->name[i] = i < BENCH_CTR_FIXED ? fixed_names[i] : raw_name[i - BENCH_CTR_FIXED];
+        bc->fd[i] = -1;
+#ifdef __linux__
+        errno = 0;
+        bc->fd[i] = i < BENCH_CTR_FIXED ? fixed_open(i)
+                                        : counter_open(PERF_TYPE_RAW, raw_config[i - BENCH_CTR_FIXED]);
+        if (bc->fd[i] >= 0)
+            usable++;
+        else if (i == BENCH_CTR_INSTRUCTIONS)
+            err = errno; // The most basic event; record why it failed
+#else
+        (void)raw_config;
+#endif
+    }
+
+    if (usable == 0)
+    {
+#ifdef __linux__
+        bc->error = (err == EACCES || err == EPERM) ? "not permitted, see /proc/sys/kernel/perf_event_paranoid"
+                    : err == ENOSYS                  ? "perf_event_open not supported"
+                                                     : "no PMU exposed to this host";
+#else
+        (void)err;
+        bc->error = "perf_event_open is Linux-only";
+#endif
+    }
+    return usable;
+}
+
+void bench_counters_close(bench_counters *bc)
+{
+    for (int i = 0; i < bc->n; i++)
+    {
+#ifdef __linux__
+        if (bc->fd[i] >= 0)
+        {
+            close(bc->fd[i]);
+        }
+#endif
+        bc->fd[i] = -1;
+    }
+    bc->n = 0;
+}
+
+void bench_counters_start(const bench_counters *bc)
+{
+#ifdef __linux__
+    for (int i = 0; i < bc->n; i++)
+    {
+        if (bc->fd[i] >= 0)
+        {
+            ioctl(bc->fd[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(bc->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#else
+    (void)bc;
+#endif
+}
+
+void bench_counters_stop(const bench_counters *bc, double *v)
+{
+#ifdef __linux__
+    for (int i = 0; i < bc->n; i++)
+    {
+        if (bc->fd[i] >= 0)
+        {
+            ioctl(bc->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+#endif
+    for (int i = 0; i < bc->n; i++)
+    {
+        v[i] = -1;
+#ifdef __linux__
+        uint64_t r[3]; // value, time enabled, time running
+
+        if (bc->fd[i] >= 0 && read(bc->fd[i], r, sizeof(r)) == (ssize_t)sizeof(r) && r[2] > 0)
+        {
+            v[i] = (double)r[0] * ((double)r[1] / (double)r[2]);
+        }
+#endif
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef BENCH_COUNTERS_H
+#define BENCH_COUNTERS_H
+
+#include <stdint.h>
+
+// Hardware counters read around a measured region (Linux perf_event_open),
+// shared by the sweep harness and project1's bench-compare. Slots are fixed:
+// the generic events, then uops dispatched on ports 0/1/5/6 (Intel cores with
+// known event codes only), then caller-supplied raw events. Each is opened on
+// its own (not as a group) so a PMU with few counters still gives what it can;
+// values are scaled when the kernel multiplexes them.
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    enum
+    {
+        BENCH_CTR_INSTRUCTIONS,
+        BENCH_CTR_CYCLES,
+        BENCH_CTR_L1D_MISSES,
+        BENCH_CTR_LLC_MISSES,
+        BENCH_CTR_BRANCH_MISSES,
+        BENCH_CTR_PORT0,
+        BENCH_CTR_PORT1,
+        BENCH_CTR_PORT5,
+        BENCH_CTR_PORT6,
+        BENCH_CTR_FIXED // First raw event slot
+    };
+
+#define BENCH_CTR_MAX_RAW 4
+#define BENCH_CTR_MAX (BENCH_CTR_FIXED + BENCH_CTR_MAX_RAW)
+
+    typedef struct
+    {
+        int n;                  // Slots in use
+        int fd[BENCH_CTR_MAX];  // -1 when the event could not be opened
+        const char *name[BENCH_CTR_MAX];
+        const char *error;      // Why nothing was opened
+    } bench_counters;
+
+    // Open every fixed slot plus nraw raw events (config values as for perf
+    // stat -e rNNNN); returns how many are usable. 0 without a PMU, with
+    // perf_event_paranoid too strict, or off Linux - bc->error says which.
+    int bench_counters_open(bench_counters *bc, int nraw, const char *const raw_name[],
+                            const uint64_t raw_config[]);
+    void bench_counters_start(const bench_counters *bc);
+    // Read every slot into v[0..n) (-1 where unavailable)
+    void bench_counters_stop(const bench_counters *bc, double *v);
+    void bench_counters_close(bench_counters *bc);
+    const char *bench_counter_name(int slot); // Fixed slots only
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BENCH_COUNTERS_H
@@ -0,0 +1,435 @@
+#define _GNU_SOURCE
+#include "bench_dudect.h"
+#include <math.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "bench_timer.h"
+
+#define NPERC 100                  // Cropping percentiles
+#define NTESTS (1 + NPERC + 1)     // Raw, cropped, second order
+#define ENOUGH_MEASUREMENTS 10000  // Tests with fewer samples are not reported
+#define T_LEAK 10.0                // |t| above this: the timing depends on the input
+#define T_LIKELY 4.5               // |t| above this: probably does
+
+// xorshift64*: only has to be unpredictable to the code under test's branch
+// predictors, not to an attacker
+static uint64_t rng_state;
+
+static uint64_t rng_next(void)
+{
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 0x2545F4914F6CDD1DULL;
+}
+
+static void rng_fill(uint8_t *p, size_t len)
+{
+    while (len >= 8)
+    {
+        uint64_t r = rng_next();
+        memcpy(p, &r, 8);
+        p += 8;
+        len -= 8;
+    }
+    if (len)
+    {
+        uint64_t r = rng_next();
+        memcpy(p, &r, len);
+    }
+}
+
+// --- Welch's t-test (Welford's online mean/variance) ----------------------
+
+typedef struct
+{
+    double mean[2];
+    double m2[2];
+    double n[2];
+} ttest_ctx;
+
+static void ttest_push(ttest_ctx *t, double x, int cls)
+{
+    double delta;
+
+    t->n[cls]++;
+    delta = x - t->mean[cls];
+    t->mean[cls] += delta / t->n[cls];
+    t->m2[cls] += delta * (x - t->mean[cls]);
+}
+
+static double ttest_t(const ttest_ctx *t)
+{
+    double v0, v1, den;
+
+    if (t->n[0] < 2 || t->n[1] < 2)
+    {
+        return 0.0;
+    }
+    v0 = t->m2[0] / (t->n[0] - 1);
+    v1 = t->m2[1] / (t->n[1] - 1);
+    den = sqrt(v0 / t->n[0] + v1 / t->n[1]);
+    return den > 0 ? (t->mean[0] - t->mean[1]) / den : 0.0;
+}
+
+// --- Options ---------------------------------------------------------------
+
+static void usage(const char *prog)
+{
+    printf("Usage: %s [options]\n", prog);
+    printf("  --measurements N    timed calls per case (default 1M, accepts K/M suffixes)\n");
+    printf("  --batch N           calls per batch; the first batch is warm-up (default 10000)\n");
+    printf("  --cpu N             pin to CPU N (default: the CPU we start on; -1 = no pinning)\n");
+    printf("  --filter TEXT       only cases whose name/variant contains TEXT\n");
+    printf("  --json FILE         write results as JSON\n");
+    printf("  --csv FILE          write results as CSV\n");
+}
+
+int bench_dudect_parse_args(bench_dudect_options *opt, const char *suite, int argc, char **argv)
+{
+    opt->measurements = 1000000;
+    opt->batch = 10000;
+    opt->cpu = sched_getcpu();
+    opt->filter = NULL;
+    opt->json = NULL;
+    opt->csv = NULL;
+    opt->suite = suite;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *a = argv[i];
+        const char *v = (i + 1 < argc) ? argv[i + 1] : NULL;
+        int ok = 1;
+
+        if (strcmp(a, "--help") == 0 || strcmp(a, "-h") == 0)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        if (!v)
+        {
+            fprintf(stderr, "%s: missing value for %s\n", argv[0], a);
+            return -1;
+        }
+
+        if (strcmp(a, "--measurements") == 0)
+        {
+            size_t n;
+            ok = bench_parse_size(v, &n) == 0 && n > 0;
+            opt->measurements = (long)n;
+        }
+        else if (strcmp(a, "--batch") == 0)
+            ok = (opt->batch = atoi(v)) >= 1000;
+        else if (strcmp(a, "--cpu") == 0)
+            opt->cpu = atoi(v);
+        else if (strcmp(a, "--filter") == 0)
+            opt->filter = v;
+        else if (strcmp(a, "--json") == 0)
+            opt->json = v;
+        else if (strcmp(a, "--csv") == 0)
+            opt->csv = v;
+        else
+        {
+            fprintf(stderr, "%s: unknown option %s\n", argv[0], a);
+            return -1;
+        }
+
+        if (!ok)
+        {
+            fprintf(stderr, "%s: bad value for %s: %s\n", argv[0], a, v);
+            return -1;
+        }
+        i++;
+    }
+    return 0;
+}
+
+// --- Runner ----------------------------------------------------------------
+
+typedef struct
+{
+    long measurements; // Counted (warm-up batch excluded)
+    double max_t;      // Largest |t| over the tests with enough samples
+    char max_test[16]; // Which one
+    double cycles;     // Median cycles per call (class 1, timer overhead removed)
+} dudect_result;
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static const char *verdict(double t)
+{
+    return t > T_LEAK ? "LEAK" : t > T_LIKELY ? "likely leak" : "no leak found";
+}
+
+static int case_matches(const bench_dudect_case *c, const char *filter)
+{
+    char full[256];
+
+    if (!filter)
+    {
+        return 1;
+    }
+    snprintf(full, sizeof(full), "%s/%s", c->name, c->variant ? c->variant : "");
+    return strstr(full, filter) != NULL;
+}
+
+static int run_case(const bench_dudect_case *c, const bench_dudect_options *opt,
+                    uint64_t overhead, dudect_result *res)
+{
+    size_t batch = (size_t)opt->batch;
+    uint8_t *inputs = malloc(batch * c->input_len);
+    uint8_t *fixed = malloc(c->input_len);
+    uint8_t *classes = malloc(batch);
+    uint64_t *exec = malloc(batch * sizeof(uint64_t));
+    uint64_t *sorted = malloc(batch * sizeof(uint64_t));
+    ttest_ctx *tests = calloc(NTESTS, sizeof(ttest_ctx));
+    uint64_t thresholds[NPERC];
+    long done = 0;
+    int first = 1;
+
+    if (!inputs || !fixed || !classes || !exec || !sorted || !tests)
+    {
+        free(inputs);
+        free(fixed);
+        free(classes);
+        free(exec);
+        free(sorted);
+        free(tests);
+        return -1;
+    }
+    if (c->fixed)
+    {
+        memcpy(fixed, c->fixed, c->input_len);
+    }
+    else
+    {
+        rng_fill(fixed, c->input_len);
+    }
+
+    memset(res, 0, sizeof(*res));
+    while (done < opt->measurements)
+    {
+        size_t nclass1 = 0;
+
+        // Inputs are made before timing, so generation never overlaps a call
+        for (size_t i = 0; i < batch; i++)
+        {
+            classes[i] = (uint8_t)(rng_next() >> 63);
+            if (classes[i])
+            {
+                rng_fill(inputs + i * c->input_len, c->input_len);
+            }
+            else
+            {
+                memcpy(inputs + i * c->input_len, fixed, c->input_len);
+            }
+        }
+
+        for (size_t i = 0; i < batch; i++)
+        {
+            uint64_t t0 = bench_tsc_begin();
+            c->call(c->arg, inputs + i * c->input_len);
+            uint64_t t1 = bench_tsc_end();
+            exec[i] = t1 - t0;
+        }
+
+        // Median speed from the class 1 calls of this batch
+        for (size_t i = 0; i < batch; i++)
+        {
+            if (classes[i])
+            {
+                sorted[nclass1++] = exec[i];
+            }
+        }
+        if (nclass1)
+        {
+            qsort(sorted, nclass1, sizeof(uint64_t), cmp_u64);
+            res->cycles = sorted[nclass1 / 2] > overhead ? (double)(sorted[nclass1 / 2] - overhead) : 0.0;
+        }
+
+        if (first)
+        {
+            // Warm-up batch: only used to place the cropping thresholds
+            memcpy(sorted, exec, batch * sizeof(uint64_t));
+            qsort(sorted, batch, sizeof(uint64_t), cmp_u64);
+            for (int p = 0; p < NPERC; p++)
+            {
+                double q = 1.0 - pow(0.5, 10.0 * (p + 1) / NPERC);
+                thresholds[p] = sorted[(size_t)(q * (double)batch)];
+            }
+            first = 0;
+            continue;
+        }
+
+        for (size_t i = 0; i < batch; i++)
+        {
+            double x = (double)exec[i];
+            int cls = classes[i];
+
+            ttest_push(&tests[0], x, cls);
+            for (int p = 0; p < NPERC; p++)
+            {
+                if (exec[i] < thresholds[p])
+                {
+                    ttest_push(&tests[1 + p], x, cls);
+                }
+            }
+            if (tests[0].n[0] + tests[0].n[1] > ENOUGH_MEASUREMENTS)
+            {
+                double centered = x - tests[0].mean[cls];
+                ttest_push(&tests[1 + NPERC], centered * centered, cls);
+            }
+        }
+        done += (long)batch;
+    }
+
+    res->measurements = done;
+    for (int k = 0; k < NTESTS; k++)
+    {
+        double t;
+
+        if (tests[k].n[0] + tests[k].n[1] < ENOUGH_MEASUREMENTS)
+        {
+            continue;
+        }
+        t = fabs(ttest_t(&tests[k]));
+        if (t > res->max_t)
+        {
+            res->max_t = t;
+            if (k == 0)
+                snprintf(res->max_test, sizeof(res->max_test), "raw");
+            else if (k == NTESTS - 1)
+                snprintf(res->max_test, sizeof(res->max_test), "2nd order");
+            else
+                snprintf(res->max_test, sizeof(res->max_test), "crop %d", k);
+        }
+    }
+
+    free(inputs);
+    free(fixed);
+    free(classes);
+    free(exec);
+    free(sorted);
+    free(tests);
+    return 0;
+}
+
+int bench_dudect_run(const bench_dudect_case *cases, size_t ncases, const bench_dudect_options *opt)
+{
+    FILE *json = NULL, *csv = NULL;
+    int first_row = 1, leaks = 0;
+    char model[256];
+    uint64_t overhead;
+    double ghz;
+
+    if (opt->cpu >= 0)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(opt->cpu, &set);
+        if (sched_setaffinity(0, sizeof(set), &set) != 0)
+        {
+            fprintf(stderr, "warning: could not pin to CPU %d, running unpinned\n", opt->cpu);
+        }
+    }
+
+    rng_state = (uint64_t)bench_now_ns() ^ ((uint64_t)getpid() << 32) ^ 0x9E3779B97F4A7C15ULL;
+    rng_state = rng_state ? rng_state : 1;
+    overhead = bench_timer_overhead();
+    ghz = bench_tsc_ghz();
+    bench_cpuinfo_field("model name", model, sizeof(model));
+
+    if (opt->json && !(json = fopen(opt->json, "w")))
+    {
+        perror(opt->json);
+    }
+    if (opt->csv && !(csv = fopen(opt->csv, "w")))
+    {
+        perror(opt->csv);
+    }
+    if (json)
+    {
+        fprintf(json, "{\n  \"suite\": ");
+        bench_json_string(json, opt->suite);
+        fprintf(json, ",\n");
+        bench_json_host(json, model);
+        fprintf(json, "  \"pinned_cpu\": %d,\n  \"tsc_ghz\": %.4f,\n  \"t_leak\": %.1f,\n  \"t_likely\": %.1f,\n"
+                      "  \"results\": [",
+                opt->cpu, ghz, T_LEAK, T_LIKELY);
+    }
+    if (csv)
+    {
+        fprintf(csv, "suite,case,variant,measurements,max_t,test,verdict,cycles_per_call,cycles_per_byte,gbps\n");
+    }
+
+    printf("=== %s constant-time check (CPU: %s, pinned: %d) ===\n", opt->suite, model, opt->cpu);
+    printf("Fixed vs random input, Welch t-test; |t| > %.1f leak, > %.1f likely leak. "
+           "Speed: median TSC cycles of the random-input calls.\n\n", T_LEAK, T_LIKELY);
+    printf("%-48s %9s %8s %-10s %-14s %9s %8s %7s\n", "case / variant", "n", "max|t|", "test", "verdict",
+           "cyc/call", "cyc/B", "GB/s");
+
+    for (size_t ci = 0; ci < ncases; ci++)
+    {
+        const bench_dudect_case *c = &cases[ci];
+        dudect_result r;
+        char label[128];
+        double cpb, gbps;
+
+        if (!case_matches(c, opt->filter))
+        {
+            continue;
+        }
+        if (run_case(c, opt, overhead, &r) != 0)
+        {
+            fprintf(stderr, "%s: out of memory\n", c->name);
+            continue;
+        }
+        leaks += r.max_t > T_LEAK;
+        cpb = c->bytes ? r.cycles / (double)c->bytes : 0.0;
+        gbps = (c->bytes && r.cycles > 0) ? (double)c->bytes / (r.cycles / ghz) : 0.0;
+
+        snprintf(label, sizeof(label), "%s / %s", c->name, c->variant ? c->variant : "-");
+        printf("%-48.48s %9ld %8.2f %-10s %-14s %9.0f %8.2f %7.3f\n", label, r.measurements, r.max_t,
+               r.max_test, verdict(r.max_t), r.cycles, cpb, gbps);
+        fflush(stdout);
+
+        if (json)
+        {
+            fprintf(json, "%s\n    {\"case\": ", first_row ? "" : ",");
+            bench_json_string(json, c->name);
+            fprintf(json, ", \"variant\": ");
+            bench_json_string(json, c->variant ? c->variant : "");
+            fprintf(json, ", \"measurements\": %ld, \"max_t\": %.3f, \"test\": \"%s\", \"verdict\": \"%s\",\n"
+                          "     \"cycles_per_call\": %.1f, \"cycles_per_byte\": %.3f, \"gbps\": %.4f}",
+                    r.measurements, r.max_t, r.max_test, verdict(r.max_t), r.cycles, cpb, gbps);
+            first_row = 0;
+        }
+        if (csv)
+        {
+            fprintf(csv, "%s,\"%s\",\"%s\",%ld,%.3f,%s,%s,%.1f,%.3f,%.4f\n", opt->suite, c->name,
+                    c->variant ? c->variant : "", r.measurements, r.max_t, r.max_test, verdict(r.max_t),
+                    r.cycles, cpb, gbps);
+        }
+    }
+
+    if (json)
+    {
+        fprintf(json, "\n  ]\n}\n");
+        fclose(json);
+        printf("\nJSON written to %s\n", opt->json);
+    }
+    if (csv)
+    {
+        fclose(csv);
+        printf("%sCSV written to %s\n", json ? "" : "\n", opt->csv);
+    }
+    return leaks;
+}
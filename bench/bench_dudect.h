@@ -0,0 +1,55 @@
+#ifndef BENCH_DUDECT_H
+#define BENCH_DUDECT_H
+
+#include "bench_harness.h"
+
+// Constant-time check in the style of dudect (Reparaz, Balasch, Verbauwhede):
+// each measurement times one call on an input drawn at random from one of two
+// classes - class 0 always the same fixed input, class 1 fresh random bytes -
+// and Welch's t-test compares the two timing distributions. Besides the raw
+// test, measurements are cropped at 100 percentiles (dropping the slow tail
+// where interrupts live) and a second-order test runs on centered products.
+// The largest |t| decides: above 10 the timing depends on the input, above
+// 4.5 a leak is likely; below that nothing was found at this sample count.
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef struct
+    {
+        const char *name;    // e.g. "sm4-block"
+        const char *variant; // Backend / entry point
+        void *arg;
+        size_t input_len; // Bytes of secret input per call
+        size_t bytes;     // Bytes processed per call, for the throughput column
+        // Class 0 input (input_len bytes); NULL for a fixed pseudo-random one
+        const uint8_t *fixed;
+        // The timed call
+        void (*call)(void *arg, const uint8_t *input);
+    } bench_dudect_case;
+
+    typedef struct
+    {
+        long measurements; // Per case (default 1M)
+        int batch;         // Measurements per batch; the first is warm-up (default 10000)
+        int cpu;
+        const char *filter;
+        const char *json;
+        const char *csv;
+        const char *suite;
+    } bench_dudect_options;
+
+    // Defaults, then command line (--help lists the options). Returns 0, 1 for
+    // --help, -1 on a bad argument.
+    int bench_dudect_parse_args(bench_dudect_options *opt, const char *suite, int argc, char **argv);
+
+    // Every matching case; returns the number of cases judged leaky, -1 on error
+    int bench_dudect_run(const bench_dudect_case *cases, size_t ncases, const bench_dudect_options *opt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BENCH_DUDECT_H
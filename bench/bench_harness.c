@@ -0,0 +1,656 @@
+#define _GNU_SOURCE
+#include "bench_harness.h"
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/utsname.h>
+#include "bench_timer.h"
+
+// Cycles are TSC (reference) cycles: constant-rate, so cycles/byte and GB/s
+// agree up to the TSC frequency, which is reported alongside.
+
+int bench_parse_size(const char *s, size_t *out)
+{
+    char *end;
+    double v = strtod(s, &end);
+
+    if (end == s || v <= 0)
+    {
+        return -1;
+    }
+    switch (*end)
+    {
+    case 'k':
+    case 'K':
+        v *= 1024.0;
+        end++;
+        break;
+    case 'm':
+    case 'M':
+        v *= 1024.0 * 1024.0;
+        end++;
+        break;
+    case 'g':
+    case 'G':
+        v *= 1024.0 * 1024.0 * 1024.0;
+        end++;
+        break;
+    }
+    if (*end == 'B' || *end == 'b')
+    {
+        end++;
+    }
+    if (*end != '\0')
+    {
+        return -1;
+    }
+    *out = (size_t)v;
+    return 0;
+}
+
+void bench_format_size(size_t len, char *buf, size_t n)
+{
+    static const char *units[] = {"B", "KiB", "MiB", "GiB"};
+    int u = 0;
+    double v = (double)len;
+
+    while (v >= 1024.0 && u < 3 && (size_t)v % 1024 == 0)
+    {
+        v /= 1024.0;
+        u++;
+    }
+    snprintf(buf, n, "%.0f %s", v, units[u]);
+}
+
+static void usage(const char *prog)
+{
+    printf("Usage: %s [options]\n", prog);
+    printf("  --min SIZE       smallest message (default 16)\n");
+    printf("  --max SIZE       largest message (default 1G); sizes take K/M/G suffixes\n");
+    printf("  --step X         size multiplier between points (default 4)\n");
+    printf("  --runs N         timed runs per point (default 9)\n");
+    printf("  --min-time SEC   length of one run (default 0.02)\n");
+    printf("  --budget SEC     time allowed per point (default 3)\n");
+    printf("  --cpu N          pin to CPU N (default: the CPU we start on; -1 = no pinning)\n");
+    printf("  --filter TEXT    only cases whose name/variant contains TEXT\n");
+    printf("  --json FILE      write results as JSON\n");
+    printf("  --csv FILE       write results as CSV\n");
+    printf("  --counters       also read hardware counters (perf_event_open) per run\n");
+    printf("  --event N=CFG    extra raw PMU event with --counters, e.g. port7=0x80a1 (up to %d)\n",
+           BENCH_MAX_RAW_EVENTS);
+}
+
+int bench_parse_args(bench_options *opt, const char *suite, int argc, char **argv)
+{
+    opt->min_len = 16;
+    opt->max_len = (size_t)1 << 30;
+    opt->step = 4.0;
+    opt->runs = 9;
+    opt->min_time = 0.02;
+    opt->budget = 3.0;
+    opt->cpu = sched_getcpu();
+    opt->filter = NULL;
+    opt->json = NULL;
+    opt->csv = NULL;
+    opt->suite = suite;
+    opt->counters = 0;
+    opt->nraw = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *a = argv[i];
+        const char *v = (i + 1 < argc) ? argv[i + 1] : NULL;
+        int ok = 1;
+
+        if (strcmp(a, "--help") == 0 || strcmp(a, "-h") == 0)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        if (strcmp(a, "--counters") == 0)
+        {
+            opt->counters = 1;
+            continue;
+        }
+        if (!v)
+        {
+            fprintf(stderr, "%s: missing value for %s\n", argv[0], a);
+            return -1;
+        }
+
+        if (strcmp(a, "--min") == 0)
+            ok = bench_parse_size(v, &opt->min_len) == 0;
+        else if (strcmp(a, "--max") == 0)
+            ok = bench_parse_size(v, &opt->max_len) == 0;
+        else if (strcmp(a, "--step") == 0)
+            ok = (opt->step = atof(v)) > 1.0;
+        else if (strcmp(a, "--runs") == 0)
+            ok = (opt->runs = atoi(v)) > 0;
+        else if (strcmp(a, "--min-time") == 0)
+            ok = (opt->min_time = atof(v)) > 0;
+        else if (strcmp(a, "--budget") == 0)
+            ok = (opt->budget = atof(v)) > 0;
+        else if (strcmp(a, "--cpu") == 0)
+            opt->cpu = atoi(v);
+        else if (strcmp(a, "--filter") == 0)
+            opt->filter = v;
+        else if (strcmp(a, "--json") == 0)
+            opt->json = v;
+        else if (strcmp(a, "--csv") == 0)
+            opt->csv = v;
+        else if (strcmp(a, "--event") == 0)
+        {
+            const char *eq = strchr(v, '=');
+            char *end = NULL;
+            ok = eq && eq != v && opt->nraw < BENCH_MAX_RAW_EVENTS;
+            if (ok)
+            {
+                opt->raw_config[opt->nraw] = strtoull(eq + 1, &end, 0);
+                ok = end != eq + 1 && *end == '\0';
+            }
+            if (ok)
+            {
+                // Name is the part before '=' (argv outlives the options)
+                argv[i + 1][eq - v] = '\0';
+                opt->raw_name[opt->nraw++] = v;
+            }
+        }
+        else
+        {
+            fprintf(stderr, "%s: unknown option %s\n", argv[0], a);
+            return -1;
+        }
+
+        if (!ok)
+        {
+            fprintf(stderr, "%s: bad value for %s: %s\n", argv[0], a, v);
+            return -1;
+        }
+        i++;
+    }
+
+    if (opt->min_len == 0 || opt->min_len > opt->max_len)
+    {
+        fprintf(stderr, "%s: --min must be positive and not above --max\n", argv[0]);
+        return -1;
+    }
+    return 0;
+}
+
+static int case_matches(const bench_case *c, const char *filter)
+{
+    char full[256];
+
+    if (!filter)
+    {
+        return 1;
+    }
+    snprintf(full, sizeof(full), "%s/%s", c->name, c->variant ? c->variant : "");
+    return strstr(full, filter) != NULL;
+}
+
+static size_t case_limit(const bench_case *c, const bench_options *opt)
+{
+    return (c->max_len && c->max_len < opt->max_len) ? c->max_len : opt->max_len;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Order statistics of a sample (sorted in place)
+typedef struct
+{
+    double median, min, max, p25, p75;
+} bench_stats;
+
+static bench_stats summarize(double *v, int n)
+{
+    bench_stats s;
+
+    qsort(v, n, sizeof(double), cmp_double);
+    s.min = v[0];
+    s.max = v[n - 1];
+    s.median = (n % 2) ? v[n / 2] : 0.5 * (v[n / 2 - 1] + v[n / 2]);
+    s.p25 = v[(n - 1) / 4];
+    s.p75 = v[(3 * (n - 1) + 3) / 4];
+    return s;
+}
+
+void bench_json_string(FILE *f, const char *s)
+{
+    fputc('"', f);
+    for (; s && *s; s++)
+    {
+        if (*s == '"' || *s == '\\')
+        {
+            fputc('\\', f);
+        }
+        fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+// First /proc/cpuinfo value for key ("model name", "flags")
+void bench_cpuinfo_field(const char *key, char *buf, size_t n)
+{
+    FILE *f = fopen("/proc/cpuinfo", "r");
+    char line[4096];
+    size_t klen = strlen(key);
+
+    snprintf(buf, n, "unknown");
+    if (!f)
+    {
+        return;
+    }
+    while (fgets(line, sizeof(line), f))
+    {
+        if (strncmp(line, key, klen) == 0 && (line[klen] == ' ' || line[klen] == '\t' || line[klen] == ':'))
+        {
+            char *p = strchr(line, ':');
+            if (p)
+            {
+                p += 1 + (p[1] == ' ');
+                p[strcspn(p, "\n")] = '\0';
+                snprintf(buf, n, "%s", p);
+            }
+            break;
+        }
+    }
+    fclose(f);
+}
+
+// Host description recorded with every result; bench/bench_compare.py keys
+// baselines on it so runs are only compared against the same machine/build
+void bench_json_host(FILE *f, const char *model)
+{
+    static char flags[4096];
+    struct utsname u;
+
+    bench_cpuinfo_field("flags", flags, sizeof(flags));
+    fprintf(f, "  \"host\": {\"cpu_model\": ");
+    bench_json_string(f, model);
+    fprintf(f, ", \"cpu_flags\": ");
+    bench_json_string(f, flags);
+    fprintf(f, ", \"compiler\": ");
+#if defined(__GNUC__) && !defined(__clang__)
+    bench_json_string(f, "gcc " __VERSION__);
+#elif defined(__VERSION__)
+    bench_json_string(f, __VERSION__);
+#else
+    bench_json_string(f, "unknown");
+#endif
+    fprintf(f, ", \"kernel\": ");
+    if (uname(&u) == 0)
+    {
+        char kernel[512];
+        snprintf(kernel, sizeof(kernel), "%s %s %s", u.sysname, u.release, u.machine);
+        bench_json_string(f, kernel);
+    }
+    else
+    {
+        bench_json_string(f, "unknown");
+    }
+    fprintf(f, "},\n");
+}
+
+typedef struct
+{
+    int runs;
+    uint64_t reps;
+    bench_stats cpb;   // TSC cycles per byte
+    bench_stats gbps;  // 1e9 bytes per second
+    bench_stats ns_op; // Nanoseconds per operation
+    double samples[64]; // Cycles per byte of each run (sorted), for regression tests
+    unsigned ctr_valid;
+    double ctr_per_byte[BENCH_CTR_MAX]; // Median over the runs
+    double ipc;                   // Median instructions / core cycles
+} bench_point;
+
+// Time one (case, size) point. Returns 0, or 1 when a single call exceeds the budget.
+static int measure(const bench_case *c, void *state, uint8_t *buf, size_t len,
+                   const bench_options *opt, const bench_counters *bc,
+                   bench_point *pt, double *tsc_cycles, double *tsc_ns)
+{
+    double cpb[64], gbps[64], ns_op[64];
+    double ctr[BENCH_CTR_MAX][64], ipc[64];
+    int runs = opt->runs < 64 ? opt->runs : 64;
+    double per_call;
+    uint64_t reps = 1, calib = 1;
+    double t0;
+
+    // Warm-up, then estimate the cost of one call (batching tiny ones)
+    c->run(state, buf, len);
+    for (;;)
+    {
+        t0 = bench_now_ns();
+        for (uint64_t i = 0; i < calib; i++)
+        {
+            c->run(state, buf, len);
+        }
+        per_call = (bench_now_ns() - t0) / calib;
+        if (per_call * calib > 1e5 || calib >= (1u << 20))
+        {
+            break;
+        }
+        calib *= 8;
+    }
+
+    if (per_call > opt->budget * 1e9)
+    {
+        return 1;
+    }
+
+    if (per_call < opt->min_time * 1e9)
+    {
+        reps = (uint64_t)(opt->min_time * 1e9 / per_call) + 1;
+    }
+    if (per_call * reps * runs > opt->budget * 1e9)
+    {
+        // At least 5: with fewer, bench_compare.py's exact Mann-Whitney test
+        // cannot reach p < 0.01 (3 vs 3 bottoms out at p = 0.05)
+        runs = (int)(opt->budget * 1e9 / (per_call * reps));
+        runs = runs < 5 ? 5 : runs;
+    }
+    if (runs > opt->runs)
+    {
+        runs = opt->runs;
+    }
+
+    pt->ctr_valid = bc ? ~0u : 0;
+    for (int r = 0; r < runs; r++)
+    {
+        double v[BENCH_CTR_MAX];
+
+        if (bc)
+        {
+            bench_counters_start(bc);
+        }
+        double n0 = bench_now_ns();
+        uint64_t c0 = bench_tsc_begin();
+        for (uint64_t i = 0; i < reps; i++)
+        {
+            c->run(state, buf, len);
+        }
+        uint64_t c1 = bench_tsc_end();
+        double n1 = bench_now_ns();
+        if (bc)
+        {
+            bench_counters_stop(bc, v);
+        }
+
+        double bytes = (double)len * (double)reps;
+        for (int k = 0; bc && k < bc->n; k++)
+        {
+            if (v[k] < 0)
+                pt->ctr_valid &= ~(1u << k);
+            else
+                ctr[k][r] = v[k] / bytes;
+        }
+        ipc[r] = (bc && v[BENCH_CTR_CYCLES] > 0) ? v[BENCH_CTR_INSTRUCTIONS] / v[BENCH_CTR_CYCLES] : 0;
+        cpb[r] = (double)(c1 - c0) / bytes;
+        gbps[r] = bytes / (n1 - n0);
+        ns_op[r] = (n1 - n0) / (double)reps;
+        *tsc_cycles += (double)(c1 - c0);
+        *tsc_ns += n1 - n0;
+    }
+
+    pt->runs = runs;
+    pt->reps = reps;
+    pt->cpb = summarize(cpb, runs);
+    memcpy(pt->samples, cpb, runs * sizeof(double));
+    pt->gbps = summarize(gbps, runs);
+    pt->ns_op = summarize(ns_op, runs);
+    for (int k = 0; bc && k < bc->n; k++)
+    {
+        if (pt->ctr_valid & (1u << k))
+        {
+            pt->ctr_per_byte[k] = summarize(ctr[k], runs).median;
+        }
+    }
+    pt->ipc = 0;
+    if ((pt->ctr_valid & 3u) == 3u) // instructions and cycles
+    {
+        pt->ipc = summarize(ipc, runs).median;
+    }
+    return 0;
+}
+
+int bench_run(const bench_case *cases, size_t ncases, const bench_options *opt)
+{
+    size_t buf_len = 0;
+    uint8_t *buf;
+    FILE *json = NULL, *csv = NULL;
+    int first_row = 1;
+    double tsc_cycles = 0, tsc_ns = 0;
+    char model[256];
+    bench_counters counters = {0};
+    const bench_counters *bc = NULL;
+
+    if (opt->cpu >= 0)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(opt->cpu, &set);
+        if (sched_setaffinity(0, sizeof(set), &set) != 0)
+        {
+            fprintf(stderr, "warning: could not pin to CPU %d, running unpinned\n", opt->cpu);
+        }
+    }
+
+    for (size_t i = 0; i < ncases; i++)
+    {
+        size_t lim = case_limit(&cases[i], opt);
+        if (case_matches(&cases[i], opt->filter) && lim > buf_len)
+        {
+            buf_len = lim;
+        }
+    }
+    if (buf_len == 0)
+    {
+        fprintf(stderr, "no benchmark case matches\n");
+        return -1;
+    }
+
+    // One buffer for everything, touched up front so page faults stay out of the timings
+    buf = aligned_alloc(64, (buf_len + 63) & ~(size_t)63);
+    if (!buf)
+    {
+        fprintf(stderr, "cannot allocate %zu bytes\n", buf_len);
+        return -1;
+    }
+    for (size_t i = 0; i < buf_len; i++)
+    {
+        buf[i] = (uint8_t)(i * 131 + 7);
+    }
+
+    bench_cpuinfo_field("model name", model, sizeof(model));
+
+    if (opt->counters)
+    {
+        if (bench_counters_open(&counters, opt->nraw, opt->raw_name, opt->raw_config) > 0)
+            bc = &counters;
+        else
+            printf("Hardware counters unavailable (%s), reporting timings only\n\n", counters.error);
+    }
+
+    if (opt->json && !(json = fopen(opt->json, "w")))
+    {
+        perror(opt->json);
+    }
+    if (opt->csv && !(csv = fopen(opt->csv, "w")))
+    {
+        perror(opt->csv);
+    }
+    if (json)
+    {
+        fprintf(json, "{\n  \"suite\": ");
+        bench_json_string(json, opt->suite);
+        fprintf(json, ",\n");
+        bench_json_host(json, model);
+        fprintf(json, "  \"pinned_cpu\": %d,\n  \"runs\": %d,\n  \"min_time_s\": %g,\n  \"results\": [",
+                opt->cpu, opt->runs, opt->min_time);
+    }
+    if (csv)
+    {
+        fprintf(csv, "suite,case,variant,bytes,runs,reps,"
+                     "cpb_median,cpb_min,cpb_max,cpb_p25,cpb_p75,"
+                     "gbps_median,gbps_min,gbps_max,ns_per_op_median");
+        // Counter columns: per byte and per block (empty where not applicable)
+        for (int k = 0; bc && k < bc->n; k++)
+        {
+            fprintf(csv, ",%s_per_byte,%s_per_block", bc->name[k], bc->name[k]);
+        }
+        fprintf(csv, "%s\n", bc ? ",ipc" : "");
+    }
+
+    printf("=== %s size sweep (CPU: %s, pinned: %d, %d runs, median [IQR]) ===\n\n",
+           opt->suite, model, opt->cpu, opt->runs);
+
+    for (size_t ci = 0; ci < ncases; ci++)
+    {
+        const bench_case *c = &cases[ci];
+        size_t granule = c->granule ? c->granule : 1;
+        size_t limit = case_limit(c, opt);
+        size_t prev = 0;
+
+        if (!case_matches(c, opt->filter))
+        {
+            continue;
+        }
+
+        printf("%s / %s\n", c->name, c->variant ? c->variant : "-");
+        printf("  %10s %10s %19s %10s %12s %5s\n", "size", "cyc/B", "[p25 - p75]", "GB/s", "ns/op", "runs");
+
+        for (double s = (double)opt->min_len; s <= (double)limit; s *= opt->step)
+        {
+            size_t len = (size_t)s / granule * granule;
+            bench_point pt;
+            void *state;
+            char size_str[32];
+
+            if (len == 0 || len == prev)
+            {
+                continue;
+            }
+            prev = len;
+            bench_format_size(len, size_str, sizeof(size_str));
+
+            state = c->setup ? c->setup(c->arg, buf, len) : c->arg;
+            if (c->setup && !state)
+            {
+                printf("  %10s   setup failed\n", size_str);
+                continue;
+            }
+
+            int skipped = measure(c, state, buf, len, opt, bc, &pt, &tsc_cycles, &tsc_ns);
+            if (c->teardown)
+            {
+                c->teardown(state);
+            }
+            if (skipped)
+            {
+                printf("  %10s   skipped: one call exceeds the %.1f s budget\n", size_str, opt->budget);
+                break;
+            }
+
+            printf("  %10s %10.3f   [%6.3f - %6.3f] %10.3f %12.1f %5d\n", size_str,
+                   pt.cpb.median, pt.cpb.p25, pt.cpb.p75, pt.gbps.median, pt.ns_op.median, pt.runs);
+            if (bc)
+            {
+                // Per byte, and per algorithm block where the case has one
+                printf("  %10s  IPC %.2f", "", pt.ipc);
+                for (int k = 0; k < bc->n; k++)
+                {
+                    if (pt.ctr_valid & (1u << k))
+                    {
+                        printf("  %s %.4g/B", bc->name[k], pt.ctr_per_byte[k]);
+                        if (c->block)
+                            printf(" %.4g/blk", pt.ctr_per_byte[k] * c->block);
+                    }
+                }
+                printf("\n");
+            }
+
+            if (json)
+            {
+                fprintf(json, "%s\n    {\"case\": ", first_row ? "" : ",");
+                bench_json_string(json, c->name);
+                fprintf(json, ", \"variant\": ");
+                bench_json_string(json, c->variant ? c->variant : "");
+                fprintf(json, ", \"bytes\": %zu, \"runs\": %d, \"reps\": %llu,\n", len, pt.runs, (unsigned long long)pt.reps);
+                fprintf(json, "     \"cycles_per_byte\": {\"median\": %.6g, \"min\": %.6g, \"max\": %.6g, \"p25\": %.6g, \"p75\": %.6g},\n",
+                        pt.cpb.median, pt.cpb.min, pt.cpb.max, pt.cpb.p25, pt.cpb.p75);
+                fprintf(json, "     \"gbytes_per_sec\": {\"median\": %.6g, \"min\": %.6g, \"max\": %.6g, \"p25\": %.6g, \"p75\": %.6g},\n",
+                        pt.gbps.median, pt.gbps.min, pt.gbps.max, pt.gbps.p25, pt.gbps.p75);
+                fprintf(json, "     \"ns_per_op\": {\"median\": %.6g, \"min\": %.6g, \"max\": %.6g},\n",
+                        pt.ns_op.median, pt.ns_op.min, pt.ns_op.max);
+                fprintf(json, "     \"cpb_samples\": [");
+                for (int r = 0; r < pt.runs; r++)
+                {
+                    fprintf(json, "%s%.6g", r ? ", " : "", pt.samples[r]);
+                }
+                fprintf(json, "]");
+                if (bc)
+                {
+                    fprintf(json, ",\n     \"ipc\": %.4g, \"counters\": {", pt.ipc);
+                    for (int k = 0, n = 0; k < bc->n; k++)
+                    {
+                        if (!(pt.ctr_valid & (1u << k)))
+                            continue;
+                        fprintf(json, "%s\"%s\": {\"per_byte\": %.6g", n++ ? ", " : "", bc->name[k], pt.ctr_per_byte[k]);
+                        if (c->block)
+                            fprintf(json, ", \"per_block\": %.6g", pt.ctr_per_byte[k] * c->block);
+                        fprintf(json, "}");
+                    }
+                    fprintf(json, "}");
+                }
+                fprintf(json, "}");
+                first_row = 0;
+            }
+            if (csv)
+            {
+                fprintf(csv, "%s,\"%s\",\"%s\",%zu,%d,%llu,%.6g,%.6g,%.6g,%.6g,%.6g,%.6g,%.6g,%.6g,%.6g",
+                        opt->suite, c->name, c->variant ? c->variant : "", len, pt.runs, (unsigned long long)pt.reps,
+                        pt.cpb.median, pt.cpb.min, pt.cpb.max, pt.cpb.p25, pt.cpb.p75,
+                        pt.gbps.median, pt.gbps.min, pt.gbps.max, pt.ns_op.median);
+                for (int k = 0; bc && k < bc->n; k++)
+                {
+                    if (!(pt.ctr_valid & (1u << k)))
+                        fprintf(csv, ",,");
+                    else if (c->block)
+                        fprintf(csv, ",%.6g,%.6g", pt.ctr_per_byte[k], pt.ctr_per_byte[k] * c->block);
+                    else
+                        fprintf(csv, ",%.6g,", pt.ctr_per_byte[k]);
+                }
+                if (bc)
+                    fprintf(csv, ",%.4g", pt.ipc);
+                fprintf(csv, "\n");
+            }
+        }
+        printf("\n");
+    }
+
+    double tsc_ghz = tsc_ns > 0 ? tsc_cycles / tsc_ns : 0;
+    printf("TSC frequency (measured): %.3f GHz\n", tsc_ghz);
+
+    if (json)
+    {
+        fprintf(json, "\n  ],\n  \"tsc_ghz\": %.4f\n}\n", tsc_ghz);
+        fclose(json);
+        printf("JSON written to %s\n", opt->json);
+    }
+    if (csv)
+    {
+        fclose(csv);
+        printf("CSV written to %s\n", opt->csv);
+    }
+
+    bench_counters_close(&counters);
+    free(buf);
+    return 0;
+}
@@ -0,0 +1,78 @@
+#ifndef BENCH_HARNESS_H
+#define BENCH_HARNESS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "bench_counters.h"
+
+// Size-sweep benchmark harness shared by project1 (SM4) and project4 (SM3/Merkle)
+// Each case is timed over message sizes from --min to --max on a pinned CPU,
+// with serialized RDTSC/RDTSCP and CLOCK_MONOTONIC_RAW around every run.
+// Results are median and spread over --runs runs, printed as a table and
+// optionally written as JSON and/or CSV. With --counters, perf_event_open
+// counters (bench_counters.h: instructions, cycles, cache and branch misses,
+// per-port uops on known Intel cores) are read around the same runs; hosts
+// without a usable PMU just get the timings.
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef struct
+    {
+        const char *name;    // Operation, e.g. "sm4-ecb" or "sm3"
+        const char *variant; // Backend / implementation
+        size_t granule;      // Sizes are rounded down to a multiple of this (0 = 1)
+        size_t max_len;      // Largest size worth timing (0 = no limit)
+        void *arg;           // Passed to setup(), or to run() when there is no setup
+
+        // Optional untimed per-size setup; the returned pointer goes to run()
+        void *(*setup)(void *arg, uint8_t *buf, size_t len);
+        // One timed operation over buf[0..len)
+        void (*run)(void *state, uint8_t *buf, size_t len);
+        void (*teardown)(void *state);
+        size_t block; // Algorithm block size, for per-block counter figures (0 = none)
+    } bench_case;
+
+#define BENCH_MAX_RAW_EVENTS BENCH_CTR_MAX_RAW
+
+    typedef struct
+    {
+        size_t min_len;     // Smallest size (default 16)
+        size_t max_len;     // Largest size (default 1 GB)
+        double step;        // Size multiplier between points (default 4)
+        int runs;           // Timed runs per point (default 9)
+        double min_time;    // Seconds per run, reached by repeating the operation (default 0.02)
+        double budget;      // Seconds allowed per point; fewer runs / skipped above this (default 3)
+        int cpu;            // CPU to pin to, -1 to leave affinity alone
+        const char *filter; // Only cases whose "name/variant" contains this
+        const char *json;   // JSON output file
+        const char *csv;    // CSV output file
+        const char *suite;  // Recorded in the output
+        int counters;       // Read hardware counters around every run (--counters)
+        int nraw;           // Extra raw PMU events (--event NAME=CONFIG), e.g. per-port uops
+        const char *raw_name[BENCH_MAX_RAW_EVENTS];
+        uint64_t raw_config[BENCH_MAX_RAW_EVENTS];
+    } bench_options;
+
+    // Defaults, then command line (--help lists the options). Returns 0, 1 for
+    // --help, -1 on a bad argument.
+    int bench_parse_args(bench_options *opt, const char *suite, int argc, char **argv);
+
+    // Run every matching case over the size sweep; 0 on success
+    int bench_run(const bench_case *cases, size_t ncases, const bench_options *opt);
+
+    // Helpers shared with bench_scaling.c
+    int bench_parse_size(const char *s, size_t *out); // "64K", "1G", ...; 0 or -1
+    void bench_format_size(size_t len, char *buf, size_t n);
+    void bench_cpuinfo_field(const char *key, char *buf, size_t n);
+    void bench_json_string(FILE *f, const char *s);
+    void bench_json_host(FILE *f, const char *model); // "host": {...}, line
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BENCH_HARNESS_H
@@ -0,0 +1,421 @@
+#define _GNU_SOURCE
+#include "bench_latency.h"
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bench_timer.h"
+
+#define KEY_POOL 1024
+
+// --- Histogram -------------------------------------------------------------
+
+#define SUB (1u << BENCH_HIST_SUB_BITS)
+#define NBUCKETS ((BENCH_HIST_MAGNITUDES + 1) << BENCH_HIST_SUB_BITS)
+
+void bench_hist_reset(bench_hist *h)
+{
+    memset(h, 0, sizeof(*h));
+}
+
+// Values below SUB get their own bucket; above, the top BENCH_HIST_SUB_BITS+1
+// bits pick the bucket within the value's power of two
+static size_t hist_index(uint64_t v)
+{
+    if (v < SUB)
+    {
+        return (size_t)v;
+    }
+    int e = 63 - __builtin_clzll(v); // >= BENCH_HIST_SUB_BITS
+    size_t idx = SUB + (size_t)(e - BENCH_HIST_SUB_BITS) * SUB + (size_t)((v >> (e - BENCH_HIST_SUB_BITS)) - SUB);
+    return idx < NBUCKETS ? idx : NBUCKETS - 1;
+}
+
+static uint64_t hist_upper(size_t idx)
+{
+    if (idx < SUB)
+    {
+        return idx;
+    }
+    int shift = (int)((idx - SUB) / SUB);
+    uint64_t mant = SUB + (idx - SUB) % SUB;
+    return ((mant + 1) << shift) - 1;
+}
+
+void bench_hist_record(bench_hist *h, uint64_t value)
+{
+    h->counts[hist_index(value)]++;
+    h->total++;
+    if (value > h->max)
+    {
+        h->max = value;
+    }
+}
+
+uint64_t bench_hist_percentile(const bench_hist *h, double p)
+{
+    uint64_t want, seen = 0;
+
+    if (h->total == 0)
+    {
+        return 0;
+    }
+    want = (uint64_t)(p / 100.0 * (double)h->total + 0.5);
+    want = want < 1 ? 1 : want;
+    for (size_t i = 0; i < NBUCKETS; i++)
+    {
+        seen += h->counts[i];
+        if (seen >= want)
+        {
+            uint64_t v = hist_upper(i);
+            return v < h->max ? v : h->max;
+        }
+    }
+    return h->max;
+}
+
+// --- Options ---------------------------------------------------------------
+
+// Last-level cache size from sysfs, 0 if unknown
+static size_t llc_size(void)
+{
+    size_t best = 0;
+
+    for (int i = 0; i < 8; i++)
+    {
+        char path[96], text[64];
+        FILE *f;
+        size_t v;
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/size", i);
+        if (!(f = fopen(path, "r")))
+        {
+            continue;
+        }
+        if (fgets(text, sizeof(text), f))
+        {
+            text[strcspn(text, "\n")] = '\0';
+            if (bench_parse_size(text, &v) == 0 && v > best)
+            {
+                best = v;
+            }
+        }
+        fclose(f);
+    }
+    return best;
+}
+
+static void usage(const char *prog)
+{
+    printf("Usage: %s [options]\n", prog);
+    printf("  --sizes A,B,...     message sizes (default 64,128,256,512)\n");
+    printf("  --samples N         timed calls per warm-cache cell (default 20000)\n");
+    printf("  --cold-samples N    timed calls per cold-cache cell (default 500)\n");
+    printf("  --flush SIZE        eviction buffer for cold-cache runs (default 2x LLC, 8M..64M)\n");
+    printf("  --cpu N             pin to CPU N (default: the CPU we start on; -1 = no pinning)\n");
+    printf("  --filter TEXT       only cases whose name/variant contains TEXT\n");
+    printf("  --json FILE         write results as JSON\n");
+    printf("  --csv FILE          write results as CSV\n");
+}
+
+int bench_latency_parse_args(bench_latency_options *opt, const char *suite, int argc, char **argv)
+{
+    static const size_t default_sizes[] = {64, 128, 256, 512};
+    size_t llc = llc_size();
+
+    memcpy(opt->sizes, default_sizes, sizeof(default_sizes));
+    opt->nsizes = 4;
+    opt->samples = 20000;
+    opt->cold_samples = 500;
+    // 2x LLC within [8, 64] MiB: hosts (or VMs) reporting a huge shared LLC
+    // would otherwise stream hundreds of MiB before every cold call
+    opt->flush_len = 2 * llc > ((size_t)8 << 20) ? 2 * llc : (size_t)8 << 20;
+    opt->flush_len = opt->flush_len < ((size_t)64 << 20) ? opt->flush_len : (size_t)64 << 20;
+    opt->cpu = sched_getcpu();
+    opt->filter = NULL;
+    opt->json = NULL;
+    opt->csv = NULL;
+    opt->suite = suite;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *a = argv[i];
+        const char *v = (i + 1 < argc) ? argv[i + 1] : NULL;
+        int ok = 1;
+
+        if (strcmp(a, "--help") == 0 || strcmp(a, "-h") == 0)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        if (!v)
+        {
+            fprintf(stderr, "%s: missing value for %s\n", argv[0], a);
+            return -1;
+        }
+
+        if (strcmp(a, "--sizes") == 0)
+        {
+            char list[256];
+            opt->nsizes = 0;
+            snprintf(list, sizeof(list), "%s", v);
+            for (char *tok = strtok(list, ","); tok && ok; tok = strtok(NULL, ","))
+            {
+                ok = opt->nsizes < BENCH_LATENCY_MAX_SIZES &&
+                     bench_parse_size(tok, &opt->sizes[opt->nsizes++]) == 0;
+            }
+            ok = ok && opt->nsizes > 0;
+        }
+        else if (strcmp(a, "--samples") == 0)
+            ok = (opt->samples = atoi(v)) > 0;
+        else if (strcmp(a, "--cold-samples") == 0)
+            ok = (opt->cold_samples = atoi(v)) > 0;
+        else if (strcmp(a, "--flush") == 0)
+            ok = bench_parse_size(v, &opt->flush_len) == 0;
+        else if (strcmp(a, "--cpu") == 0)
+            opt->cpu = atoi(v);
+        else if (strcmp(a, "--filter") == 0)
+            opt->filter = v;
+        else if (strcmp(a, "--json") == 0)
+            opt->json = v;
+        else if (strcmp(a, "--csv") == 0)
+            opt->csv = v;
+        else
+        {
+            fprintf(stderr, "%s: unknown option %s\n", argv[0], a);
+            return -1;
+        }
+
+        if (!ok)
+        {
+            fprintf(stderr, "%s: bad value for %s: %s\n", argv[0], a, v);
+            return -1;
+        }
+        i++;
+    }
+    return 0;
+}
+
+// --- Runner ----------------------------------------------------------------
+
+// Write one byte per cache line of a buffer larger than the LLC
+static void flush_caches(uint8_t *flush, size_t len)
+{
+    for (size_t i = 0; i < len; i += 64)
+    {
+        flush[i]++;
+    }
+    _mm_mfence();
+}
+
+static int case_matches(const bench_latency_case *c, const char *filter)
+{
+    char full[256];
+
+    if (!filter)
+    {
+        return 1;
+    }
+    snprintf(full, sizeof(full), "%s/%s", c->name, c->variant ? c->variant : "");
+    return strstr(full, filter) != NULL;
+}
+
+static void measure(const bench_latency_case *c, uint8_t *buf, size_t len,
+                    const uint8_t (*keys)[16], int cold_key, uint8_t *flush, size_t flush_len,
+                    int samples, uint64_t overhead, bench_hist *h)
+{
+    const uint8_t *prev = NULL;
+
+    bench_hist_reset(h);
+    // Warm-up: code, tables, branch predictors and (for warm key) the key's state
+    for (int i = 0; i < 256; i++)
+    {
+        const uint8_t *k = keys[cold_key ? (KEY_POOL - 1 - i) : 0];
+        if (c->prepare)
+            c->prepare(c->arg, k, buf, len);
+        c->call(c->arg, k, k != prev, buf, len);
+        prev = k;
+    }
+
+    for (int s = 0; s < samples; s++)
+    {
+        const uint8_t *k = keys[cold_key ? (s % KEY_POOL) : 0];
+        int new_key = k != prev;
+
+        if (c->prepare)
+        {
+            c->prepare(c->arg, k, buf, len);
+        }
+        if (flush)
+        {
+            flush_caches(flush, flush_len);
+        }
+
+        uint64_t t0 = bench_tsc_begin();
+        c->call(c->arg, k, new_key, buf, len);
+        uint64_t t1 = bench_tsc_end();
+
+        bench_hist_record(h, t1 - t0 > overhead ? t1 - t0 - overhead : 0);
+        prev = k;
+    }
+}
+
+int bench_latency_run(const bench_latency_case *cases, size_t ncases, const bench_latency_options *opt)
+{
+    static const double pcts[] = {50, 90, 99, 99.9};
+    static uint8_t keys[KEY_POOL][16];
+    static bench_hist hist;
+    size_t max_len = 0;
+    uint8_t *buf, *flush;
+    FILE *json = NULL, *csv = NULL;
+    int first_row = 1;
+    char model[256];
+    uint64_t overhead;
+    double ghz;
+
+    if (opt->cpu >= 0)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(opt->cpu, &set);
+        if (sched_setaffinity(0, sizeof(set), &set) != 0)
+        {
+            fprintf(stderr, "warning: could not pin to CPU %d, running unpinned\n", opt->cpu);
+        }
+    }
+
+    for (int i = 0; i < opt->nsizes; i++)
+    {
+        max_len = opt->sizes[i] > max_len ? opt->sizes[i] : max_len;
+    }
+    buf = aligned_alloc(64, (max_len + 63) & ~(size_t)63);
+    flush = aligned_alloc(64, (opt->flush_len + 63) & ~(size_t)63);
+    if (!buf || !flush)
+    {
+        fprintf(stderr, "cannot allocate buffers\n");
+        free(buf);
+        free(flush);
+        return -1;
+    }
+    memset(buf, 0x5a, max_len);
+    memset(flush, 0, opt->flush_len);
+    for (int k = 0; k < KEY_POOL; k++)
+    {
+        for (int j = 0; j < 16; j++)
+        {
+            keys[k][j] = (uint8_t)(k * 197 + j * 31 + (k >> 8));
+        }
+    }
+
+    overhead = bench_timer_overhead();
+    ghz = bench_tsc_ghz();
+    bench_cpuinfo_field("model name", model, sizeof(model));
+
+    if (opt->json && !(json = fopen(opt->json, "w")))
+    {
+        perror(opt->json);
+    }
+    if (opt->csv && !(csv = fopen(opt->csv, "w")))
+    {
+        perror(opt->csv);
+    }
+    if (json)
+    {
+        fprintf(json, "{\n  \"suite\": ");
+        bench_json_string(json, opt->suite);
+        fprintf(json, ",\n");
+        bench_json_host(json, model);
+        fprintf(json, "  \"pinned_cpu\": %d,\n  \"tsc_ghz\": %.4f,\n  \"timer_overhead_cycles\": %llu,\n"
+                      "  \"flush_bytes\": %zu,\n  \"results\": [",
+                opt->cpu, ghz, (unsigned long long)overhead, opt->flush_len);
+    }
+    if (csv)
+    {
+        fprintf(csv, "suite,case,variant,bytes,key,cache,samples,"
+                     "p50_cycles,p90_cycles,p99_cycles,p999_cycles,max_cycles,p50_ns,p99_ns\n");
+    }
+
+    printf("=== %s per-call latency (CPU: %s, pinned: %d) ===\n", opt->suite, model, opt->cpu);
+    printf("TSC cycles at %.3f GHz, timer overhead %llu cycles subtracted; cold cache = %zu MiB streamed before each call\n\n",
+           ghz, (unsigned long long)overhead, opt->flush_len >> 20);
+
+    for (size_t ci = 0; ci < ncases; ci++)
+    {
+        const bench_latency_case *c = &cases[ci];
+
+        if (!case_matches(c, opt->filter))
+        {
+            continue;
+        }
+        printf("%s / %s\n", c->name, c->variant ? c->variant : "-");
+        printf("  %6s %5s %5s %7s %8s %8s %8s %8s %9s %9s %9s\n", "size", "key", "cache", "samples",
+               "p50", "p90", "p99", "p99.9", "max", "p50 ns", "p99 ns");
+
+        for (int si = 0; si < opt->nsizes; si++)
+        {
+            size_t len = opt->sizes[si];
+
+            for (int cold_key = 0; cold_key <= (c->keyed ? 1 : 0); cold_key++)
+            {
+                for (int cold_cache = 0; cold_cache <= 1; cold_cache++)
+                {
+                    int samples = cold_cache ? opt->cold_samples : opt->samples;
+                    const char *key_mode = c->keyed ? (cold_key ? "cold" : "warm") : "-";
+                    const char *cache_mode = cold_cache ? "cold" : "warm";
+                    uint64_t p[4];
+
+                    measure(c, buf, len, (const uint8_t(*)[16])keys, cold_key,
+                            cold_cache ? flush : NULL, opt->flush_len, samples, overhead, &hist);
+                    for (int k = 0; k < 4; k++)
+                    {
+                        p[k] = bench_hist_percentile(&hist, pcts[k]);
+                    }
+
+                    printf("  %6zu %5s %5s %7d %8llu %8llu %8llu %8llu %9llu %9.0f %9.0f\n", len, key_mode,
+                           cache_mode, samples, (unsigned long long)p[0], (unsigned long long)p[1],
+                           (unsigned long long)p[2], (unsigned long long)p[3], (unsigned long long)hist.max,
+                           p[0] / ghz, p[2] / ghz);
+
+                    if (json)
+                    {
+                        fprintf(json, "%s\n    {\"case\": ", first_row ? "" : ",");
+                        bench_json_string(json, c->name);
+                        fprintf(json, ", \"variant\": ");
+                        bench_json_string(json, c->variant ? c->variant : "");
+                        fprintf(json, ", \"bytes\": %zu, \"key\": \"%s\", \"cache\": \"%s\", \"samples\": %d,\n"
+                                      "     \"cycles\": {\"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"p99.9\": %llu, \"max\": %llu}}",
+                                len, key_mode, cache_mode, samples,
+                                (unsigned long long)p[0], (unsigned long long)p[1], (unsigned long long)p[2],
+                                (unsigned long long)p[3], (unsigned long long)hist.max);
+                        first_row = 0;
+                    }
+                    if (csv)
+                    {
+                        fprintf(csv, "%s,\"%s\",\"%s\",%zu,%s,%s,%d,%llu,%llu,%llu,%llu,%llu,%.1f,%.1f\n",
+                                opt->suite, c->name, c->variant ? c->variant : "", len, key_mode, cache_mode,
+                                samples, (unsigned long long)p[0], (unsigned long long)p[1],
+                                (unsigned long long)p[2], (unsigned long long)p[3],
+                                (unsigned long long)hist.max, p[0] / ghz, p[2] / ghz);
+                    }
+                }
+            }
+        }
+        printf("\n");
+    }
+
+    if (json)
+    {
+        fprintf(json, "\n  ]\n}\n");
+        fclose(json);
+        printf("JSON written to %s\n", opt->json);
+    }
+    if (csv)
+    {
+        fclose(csv);
+        printf("CSV written to %s\n", opt->csv);
+    }
+    free(buf);
+    free(flush);
+    return 0;
+}
@@ -0,0 +1,77 @@
+#ifndef BENCH_LATENCY_H
+#define BENCH_LATENCY_H
+
+#include "bench_harness.h"
+
+// Per-call latency for small messages: every call is timed on its own with
+// serialized RDTSC/RDTSCP (timer overhead subtracted) into an HDR-style
+// histogram, reported as p50/p90/p99/p99.9/max. Each case runs with
+//   warm key  - the same key on every call,
+//   cold key  - a key not used since the last round of the pool on every call,
+// and with
+//   warm cache - back-to-back calls,
+//   cold cache - caches flushed by streaming over a buffer larger than the LLC.
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // Log-linear histogram: 128 sub-buckets per power of two (< 0.8% error)
+#define BENCH_HIST_SUB_BITS 7
+#define BENCH_HIST_MAGNITUDES 40
+
+    typedef struct
+    {
+        uint64_t counts[(BENCH_HIST_MAGNITUDES + 1) << BENCH_HIST_SUB_BITS];
+        uint64_t total;
+        uint64_t max;
+    } bench_hist;
+
+    void bench_hist_reset(bench_hist *h);
+    void bench_hist_record(bench_hist *h, uint64_t value);
+    // Smallest recorded value v with at least p percent of samples <= v
+    // (upper edge of its bucket, as HdrHistogram reports it)
+    uint64_t bench_hist_percentile(const bench_hist *h, double p);
+
+    typedef struct
+    {
+        const char *name;    // e.g. "sm4-gcm-dec"
+        const char *variant; // Backend / entry point
+        void *arg;
+        int keyed; // 0: no key, the cold-key runs are skipped
+
+        // Optional untimed step before every sample (e.g. produce a valid tag)
+        void (*prepare)(void *arg, const uint8_t *key, uint8_t *buf, size_t len);
+        // The timed call; new_key is set when key differs from the previous call's
+        void (*call)(void *arg, const uint8_t *key, int new_key, uint8_t *buf, size_t len);
+    } bench_latency_case;
+
+#define BENCH_LATENCY_MAX_SIZES 8
+
+    typedef struct
+    {
+        size_t sizes[BENCH_LATENCY_MAX_SIZES]; // Message sizes (default 64,128,256,512)
+        int nsizes;
+        int samples;      // Warm-cache samples per cell (default 20000)
+        int cold_samples; // Cold-cache samples per cell (default 500)
+        size_t flush_len; // Eviction buffer (default 2x the LLC, clamped to 8..64 MiB)
+        int cpu;
+        const char *filter;
+        const char *json;
+        const char *csv;
+        const char *suite;
+    } bench_latency_options;
+
+    // Defaults, then command line (--help lists the options). Returns 0, 1 for
+    // --help, -1 on a bad argument.
+    int bench_latency_parse_args(bench_latency_options *opt, const char *suite, int argc, char **argv);
+
+    // Every matching case x size x key mode x cache mode; 0 on success
+    int bench_latency_run(const bench_latency_case *cases, size_t ncases, const bench_latency_options *opt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BENCH_LATENCY_H
@@ -0,0 +1,544 @@
+#define _GNU_SOURCE
+#include "bench_scaling.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "bench_timer.h"
+
+#define MAX_THREADS 1024
+#define MAX_NODES 64
+
+// Effective core clock: a chain of dependent 1-cycle register adds, so the
+// iteration rate is the clock the core is actually running at (TSC would not
+// show the AVX-512 licence drop). add-immediate chains are avoided because
+// newer cores fold them at rename. Best of three short samples.
+static double probe_ghz(void)
+{
+    const uint64_t iters = 1u << 16;
+    double best = 0;
+
+    for (int k = 0; k < 3; k++)
+    {
+        uint64_t n = iters, x = 1;
+        double t0 = bench_now_ns();
+        __asm__ volatile(
+            "1:\n\t"
+            "add %1, %1\n\tadd %1, %1\n\tadd %1, %1\n\tadd %1, %1\n\t"
+            "add %1, %1\n\tadd %1, %1\n\tadd %1, %1\n\tadd %1, %1\n\t"
+            "dec %0\n\t"
+            "jnz 1b"
+            : "+r"(n), "+r"(x));
+        double ghz = 8.0 * iters / (bench_now_ns() - t0);
+        best = ghz > best ? ghz : best;
+    }
+    return best;
+}
+
+// --- CPU placement ---------------------------------------------------------
+
+typedef struct
+{
+    int ncpus;
+    int cpu[CPU_SETSIZE];  // Placement order
+    int node[CPU_SETSIZE]; // NUMA node of cpu[i]
+    int nnodes;
+} cpu_layout;
+
+// Node of every CPU from /sys/devices/system/node/node*/cpulist (-1 if unknown)
+static int read_nodes(int *node_of)
+{
+    int nnodes = 0;
+
+    for (int c = 0; c < CPU_SETSIZE; c++)
+    {
+        node_of[c] = -1;
+    }
+    for (int n = 0; n < MAX_NODES; n++)
+    {
+        char path[96], list[4096];
+        FILE *f;
+
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", n);
+        if (!(f = fopen(path, "r")))
+        {
+            continue;
+        }
+        if (fgets(list, sizeof(list), f))
+        {
+            // "0-3,8-11"
+            for (char *tok = strtok(list, ",\n"); tok; tok = strtok(NULL, ",\n"))
+            {
+                int lo, hi;
+                int k = sscanf(tok, "%d-%d", &lo, &hi);
+                if (k == 1)
+                    hi = lo;
+                for (int c = lo; k >= 1 && c <= hi && c < CPU_SETSIZE; c++)
+                    node_of[c] = n;
+            }
+        }
+        fclose(f);
+        nnodes = n + 1;
+    }
+    return nnodes;
+}
+
+static void build_layout(cpu_layout *l, int spread)
+{
+    static int node_of[CPU_SETSIZE];
+    cpu_set_t allowed;
+    int nnodes = read_nodes(node_of);
+
+    l->ncpus = 0;
+    l->nnodes = nnodes > 0 ? nnodes : 1;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+    {
+        CPU_ZERO(&allowed);
+        CPU_SET(0, &allowed);
+    }
+
+    if (!spread)
+    {
+        // Node by node, CPUs in id order (SMT siblings usually come last)
+        for (int n = 0; n < l->nnodes; n++)
+        {
+            for (int c = 0; c < CPU_SETSIZE; c++)
+            {
+                if (CPU_ISSET(c, &allowed) && (node_of[c] < 0 ? 0 : node_of[c]) == n)
+                {
+                    l->node[l->ncpus] = n;
+                    l->cpu[l->ncpus++] = c;
+                }
+            }
+        }
+    }
+    else
+    {
+        // One CPU from each node in turn
+        int next[MAX_NODES] = {0};
+        int placed = 1;
+        while (placed)
+        {
+            placed = 0;
+            for (int n = 0; n < l->nnodes; n++)
+            {
+                for (int c = next[n]; c < CPU_SETSIZE; c++)
+                {
+                    int cn = node_of[c] < 0 ? 0 : node_of[c];
+                    if (CPU_ISSET(c, &allowed) && cn == n)
+                    {
+                        l->node[l->ncpus] = n;
+                        l->cpu[l->ncpus++] = c;
+                        next[n] = c + 1;
+                        placed = 1;
+                        break;
+                    }
+                    next[n] = c + 1;
+                }
+            }
+        }
+    }
+
+    if (l->ncpus == 0)
+    {
+        l->cpu[0] = 0;
+        l->node[0] = 0;
+        l->ncpus = 1;
+    }
+}
+
+// --- Options ---------------------------------------------------------------
+
+static void usage(const char *prog)
+{
+    printf("Usage: %s [options]\n", prog);
+    printf("  --threads N         largest thread count (default: CPUs available)\n");
+    printf("  --sizes A,B,...     per-thread message sizes (default 16K,64M)\n");
+    printf("  --time SEC          measured time per point (default 0.5)\n");
+    printf("  --placement P       compact (fill a NUMA node first, default) or spread\n");
+    printf("  --filter TEXT       only cases whose name/variant contains TEXT\n");
+    printf("  --json FILE         write results as JSON\n");
+    printf("  --csv FILE          write results as CSV\n");
+}
+
+int bench_scaling_parse_args(bench_scaling_options *opt, const char *suite, int argc, char **argv)
+{
+    cpu_set_t allowed;
+
+    opt->max_threads = sched_getaffinity(0, sizeof(allowed), &allowed) == 0 ? CPU_COUNT(&allowed) : 1;
+    opt->sizes[0] = (size_t)16 << 10;
+    opt->sizes[1] = (size_t)64 << 20;
+    opt->nsizes = 2;
+    opt->seconds = 0.5;
+    opt->spread = 0;
+    opt->filter = NULL;
+    opt->json = NULL;
+    opt->csv = NULL;
+    opt->suite = suite;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *a = argv[i];
+        const char *v = (i + 1 < argc) ? argv[i + 1] : NULL;
+        int ok = 1;
+
+        if (strcmp(a, "--help") == 0 || strcmp(a, "-h") == 0)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        if (!v)
+        {
+            fprintf(stderr, "%s: missing value for %s\n", argv[0], a);
+            return -1;
+        }
+
+        if (strcmp(a, "--threads") == 0)
+            ok = (opt->max_threads = atoi(v)) > 0 && opt->max_threads <= MAX_THREADS;
+        else if (strcmp(a, "--time") == 0)
+            ok = (opt->seconds = atof(v)) > 0;
+        else if (strcmp(a, "--placement") == 0)
+        {
+            ok = strcmp(v, "compact") == 0 || strcmp(v, "spread") == 0;
+            opt->spread = strcmp(v, "spread") == 0;
+        }
+        else if (strcmp(a, "--sizes") == 0)
+        {
+            char list[256];
+            opt->nsizes = 0;
+            snprintf(list, sizeof(list), "%s", v);
+            for (char *tok = strtok(list, ","); tok && ok; tok = strtok(NULL, ","))
+            {
+                ok = opt->nsizes < BENCH_SCALING_MAX_SIZES &&
+                     bench_parse_size(tok, &opt->sizes[opt->nsizes++]) == 0;
+            }
+            ok = ok && opt->nsizes > 0;
+        }
+        else if (strcmp(a, "--filter") == 0)
+            opt->filter = v;
+        else if (strcmp(a, "--json") == 0)
+            opt->json = v;
+        else if (strcmp(a, "--csv") == 0)
+            opt->csv = v;
+        else
+        {
+            fprintf(stderr, "%s: unknown option %s\n", argv[0], a);
+            return -1;
+        }
+
+        if (!ok)
+        {
+            fprintf(stderr, "%s: bad value for %s: %s\n", argv[0], a, v);
+            return -1;
+        }
+        i++;
+    }
+    return 0;
+}
+
+// --- Workers ---------------------------------------------------------------
+
+typedef struct
+{
+    const bench_case *c;
+    size_t len;
+    int cpu;
+    double seconds;
+    pthread_barrier_t *ready;
+
+    int ok;
+    double gbps;
+    double ghz_before, ghz_after;
+} worker;
+
+// Bandwidth reference: read every 64-bit word of the buffer
+static void run_mem_read(void *arg, uint8_t *buf, size_t len)
+{
+    const uint64_t *p = (const uint64_t *)buf;
+    uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    size_t n = len / 8, i = 0;
+
+    (void)arg;
+    for (; i + 4 <= n; i += 4)
+    {
+        s0 += p[i];
+        s1 += p[i + 1];
+        s2 += p[i + 2];
+        s3 += p[i + 3];
+    }
+    for (; i < n; i++)
+    {
+        s0 += p[i];
+    }
+    __asm__ volatile("" ::"r"(s0 + s1 + s2 + s3));
+}
+
+static const bench_case mem_read_case = {"mem-read", "64-bit loads", 64, 0, NULL, NULL, run_mem_read, NULL, 0};
+
+static void *worker_main(void *p)
+{
+    worker *w = p;
+    const bench_case *c = w->c;
+    cpu_set_t set;
+    uint8_t *buf;
+    void *state;
+
+    // Pin first, then allocate and touch: first-touch puts the pages on this CPU's node
+    CPU_ZERO(&set);
+    CPU_SET(w->cpu, &set);
+    sched_setaffinity(0, sizeof(set), &set);
+
+    buf = aligned_alloc(64, (w->len + 63) & ~(size_t)63);
+    if (buf)
+    {
+        for (size_t i = 0; i < w->len; i++)
+        {
+            buf[i] = (uint8_t)(i * 131 + 7);
+        }
+    }
+    state = (buf && c->setup) ? c->setup(c->arg, buf, w->len) : c->arg;
+    w->ok = buf && (!c->setup || state);
+    if (w->ok)
+    {
+        c->run(state, buf, w->len); // Warm-up
+    }
+
+    pthread_barrier_wait(w->ready);
+
+    if (w->ok)
+    {
+        // Batch small operations so the clock read stays out of the way
+        size_t batch = w->len >= 65536 ? 1 : 65536 / (w->len ? w->len : 1);
+        uint64_t ops = 0;
+        double t0, t1;
+
+        w->ghz_before = probe_ghz();
+        t0 = bench_now_ns();
+        do
+        {
+            for (size_t i = 0; i < batch; i++)
+            {
+                c->run(state, buf, w->len);
+            }
+            ops += batch;
+            t1 = bench_now_ns();
+        } while (t1 - t0 < w->seconds * 1e9);
+        w->ghz_after = probe_ghz();
+        w->gbps = (double)ops * (double)w->len / (t1 - t0);
+
+        if (c->teardown)
+        {
+            c->teardown(state);
+        }
+    }
+    free(buf);
+    return NULL;
+}
+
+static int case_matches(const bench_case *c, const char *filter)
+{
+    char full[256];
+
+    if (!filter)
+    {
+        return 1;
+    }
+    snprintf(full, sizeof(full), "%s/%s", c->name, c->variant ? c->variant : "");
+    return strstr(full, filter) != NULL;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double median(double *v, int n)
+{
+    qsort(v, n, sizeof(double), cmp_double);
+    return (n % 2) ? v[n / 2] : 0.5 * (v[n / 2 - 1] + v[n / 2]);
+}
+
+typedef struct
+{
+    int threads, nodes, oversubscribed;
+    double gbps_total, gbps_per_thread, efficiency;
+    double ghz_before, ghz_after;
+} scaling_point;
+
+static int run_point(const bench_case *c, size_t len, int threads, const cpu_layout *l,
+                     double seconds, scaling_point *pt)
+{
+    static worker w[MAX_THREADS];
+    static pthread_t tid[MAX_THREADS];
+    static double before[MAX_THREADS], after[MAX_THREADS];
+    pthread_barrier_t ready;
+    int used[MAX_NODES] = {0};
+    int ok = 1;
+
+    pthread_barrier_init(&ready, NULL, threads);
+    for (int t = 0; t < threads; t++)
+    {
+        w[t] = (worker){c, len, l->cpu[t % l->ncpus], seconds, &ready, 0, 0, 0, 0};
+        used[l->node[t % l->ncpus] % MAX_NODES] = 1;
+        pthread_create(&tid[t], NULL, worker_main, &w[t]);
+    }
+
+    pt->threads = threads;
+    pt->nodes = 0;
+    pt->oversubscribed = threads > l->ncpus;
+    pt->gbps_total = 0;
+    for (int n = 0; n < MAX_NODES; n++)
+    {
+        pt->nodes += used[n];
+    }
+    for (int t = 0; t < threads; t++)
+    {
+        pthread_join(tid[t], NULL);
+        ok &= w[t].ok;
+        pt->gbps_total += w[t].gbps;
+        before[t] = w[t].ghz_before;
+        after[t] = w[t].ghz_after;
+    }
+    pthread_barrier_destroy(&ready);
+
+    pt->gbps_per_thread = pt->gbps_total / threads;
+    pt->ghz_before = median(before, threads);
+    pt->ghz_after = median(after, threads);
+    return ok ? 0 : -1;
+}
+
+int bench_scaling_run(const bench_case *cases, size_t ncases, const bench_scaling_options *opt)
+{
+    static cpu_layout layout;
+    int counts[32], ncounts = 0;
+    FILE *json = NULL, *csv = NULL;
+    int first_row = 1;
+    char model[256];
+
+    build_layout(&layout, opt->spread);
+    for (int t = 1; t < opt->max_threads && ncounts < 31; t *= 2)
+    {
+        counts[ncounts++] = t;
+    }
+    counts[ncounts++] = opt->max_threads;
+
+    bench_cpuinfo_field("model name", model, sizeof(model));
+    if (opt->json && !(json = fopen(opt->json, "w")))
+    {
+        perror(opt->json);
+    }
+    if (opt->csv && !(csv = fopen(opt->csv, "w")))
+    {
+        perror(opt->csv);
+    }
+    if (json)
+    {
+        fprintf(json, "{\n  \"suite\": ");
+        bench_json_string(json, opt->suite);
+        fprintf(json, ",\n");
+        bench_json_host(json, model);
+        fprintf(json, "  \"cpus\": %d,\n  \"numa_nodes\": %d,\n  \"placement\": \"%s\",\n  \"seconds\": %g,\n  \"results\": [",
+                layout.ncpus, layout.nnodes, opt->spread ? "spread" : "compact", opt->seconds);
+    }
+    if (csv)
+    {
+        fprintf(csv, "suite,case,variant,bytes_per_thread,threads,nodes,oversubscribed,"
+                     "gbps_total,gbps_per_thread,efficiency,ghz_before,ghz_after\n");
+    }
+
+    printf("=== %s multi-core scaling (CPU: %s, %d CPUs on %d NUMA node(s), %s placement) ===\n",
+           opt->suite, model, layout.ncpus, layout.nnodes, opt->spread ? "spread" : "compact");
+    printf("Independent state and buffer per thread; efficiency = per-thread rate / 1-thread rate;\n");
+    printf("GHz = effective core clock right before / right after the load.\n\n");
+
+    for (size_t ci = 0; ci <= ncases; ci++)
+    {
+        // The memory-read reference goes first
+        const bench_case *c = ci == 0 ? &mem_read_case : &cases[ci - 1];
+
+        if (ci > 0 && !case_matches(c, opt->filter))
+        {
+            continue;
+        }
+
+        for (int si = 0; si < opt->nsizes; si++)
+        {
+            size_t granule = c->granule ? c->granule : 1;
+            size_t len = opt->sizes[si] / granule * granule;
+            double single = 0;
+            char size_str[32];
+
+            if (len == 0 || (c->max_len && len > c->max_len))
+            {
+                continue;
+            }
+            bench_format_size(len, size_str, sizeof(size_str));
+            printf("%s / %s, %s per thread\n", c->name, c->variant ? c->variant : "-", size_str);
+            printf("  %7s %5s %11s %12s %10s %11s %10s\n",
+                   "threads", "nodes", "total GB/s", "GB/s/thread", "efficiency", "GHz before", "GHz after");
+
+            for (int k = 0; k < ncounts; k++)
+            {
+                scaling_point pt;
+
+                if (run_point(c, len, counts[k], &layout, opt->seconds, &pt) != 0)
+                {
+                    printf("  %7d   setup or allocation failed\n", counts[k]);
+                    break;
+                }
+                if (k == 0)
+                {
+                    single = pt.gbps_per_thread;
+                }
+                pt.efficiency = single > 0 ? pt.gbps_per_thread / single : 0;
+
+                printf("  %6d%s %5d %11.3f %12.3f %9.1f%% %11.2f %10.2f\n", pt.threads,
+                       pt.oversubscribed ? "*" : " ", pt.nodes, pt.gbps_total, pt.gbps_per_thread,
+                       pt.efficiency * 100.0, pt.ghz_before, pt.ghz_after);
+
+                if (json)
+                {
+                    fprintf(json, "%s\n    {\"case\": ", first_row ? "" : ",");
+                    bench_json_string(json, c->name);
+                    fprintf(json, ", \"variant\": ");
+                    bench_json_string(json, c->variant ? c->variant : "");
+                    fprintf(json, ", \"bytes_per_thread\": %zu, \"threads\": %d, \"nodes\": %d, \"oversubscribed\": %s,\n",
+                            len, pt.threads, pt.nodes, pt.oversubscribed ? "true" : "false");
+                    fprintf(json, "     \"gbps_total\": %.6g, \"gbps_per_thread\": %.6g, \"efficiency\": %.4f, "
+                                  "\"ghz_before\": %.4g, \"ghz_after\": %.4g}",
+                            pt.gbps_total, pt.gbps_per_thread, pt.efficiency, pt.ghz_before, pt.ghz_after);
+                    first_row = 0;
+                }
+                if (csv)
+                {
+                    fprintf(csv, "%s,\"%s\",\"%s\",%zu,%d,%d,%d,%.6g,%.6g,%.4f,%.4g,%.4g\n",
+                            opt->suite, c->name, c->variant ? c->variant : "", len, pt.threads, pt.nodes,
+                            pt.oversubscribed, pt.gbps_total, pt.gbps_per_thread, pt.efficiency,
+                            pt.ghz_before, pt.ghz_after);
+                }
+            }
+            printf("\n");
+        }
+    }
+
+    if (opt->max_threads > layout.ncpus)
+    {
+        printf("* more threads than CPUs: threads share CPUs, so efficiency drops by design\n");
+    }
+    if (json)
+    {
+        fprintf(json, "\n  ]\n}\n");
+        fclose(json);
+        printf("JSON written to %s\n", opt->json);
+    }
+    if (csv)
+    {
+        fclose(csv);
+        printf("CSV written to %s\n", opt->csv);
+    }
+    return 0;
+}
@@ -0,0 +1,45 @@
+#ifndef BENCH_SCALING_H
+#define BENCH_SCALING_H
+
+#include "bench_harness.h"
+
+// Multi-core scaling on top of the size-sweep cases: 1..N threads, each pinned
+// to its own CPU with its own buffer and its own case state (setup() is called
+// once per thread, so contexts are independent). Reports aggregate GB/s,
+// per-thread GB/s and efficiency against one thread, and the effective core
+// clock right before and right after the load, which shows AVX-512 frequency
+// droop. Large per-thread sizes show where memory bandwidth saturates; a
+// plain read of the same buffers is timed as the bandwidth reference.
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define BENCH_SCALING_MAX_SIZES 8
+
+    typedef struct
+    {
+        int max_threads; // Largest thread count (default: CPUs we may run on)
+        size_t sizes[BENCH_SCALING_MAX_SIZES]; // Per-thread message sizes (default 16K, 64M)
+        int nsizes;
+        double seconds;     // Measured time per point (default 0.5)
+        int spread;         // 1: round-robin over NUMA nodes, 0: fill node by node
+        const char *filter; // Only cases whose "name/variant" contains this
+        const char *json;
+        const char *csv;
+        const char *suite;
+    } bench_scaling_options;
+
+    // Defaults, then command line (--help lists the options). Returns 0, 1 for
+    // --help, -1 on a bad argument.
+    int bench_scaling_parse_args(bench_scaling_options *opt, const char *suite, int argc, char **argv);
+
+    // 1, 2, 4, ... max_threads threads for every matching case and size; 0 on success
+    int bench_scaling_run(const bench_case *cases, size_t ncases, const bench_scaling_options *opt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BENCH_SCALING_H
@@ -0,0 +1,64 @@
+#ifndef BENCH_TIMER_H
+#define BENCH_TIMER_H
+
+#include <stdint.h>
+#include <time.h>
+#include <x86intrin.h>
+
+// Timers shared by the sweep, latency, scaling and constant-time harnesses.
+// Serialized TSC reads: nothing before the start read or after the end read
+// is allowed to leak into the measured window.
+
+static inline uint64_t bench_tsc_begin(void)
+{
+    _mm_lfence();
+    uint64_t t = __rdtsc();
+    _mm_lfence();
+    return t;
+}
+
+static inline uint64_t bench_tsc_end(void)
+{
+    unsigned int aux;
+    uint64_t t = __rdtscp(&aux);
+    _mm_lfence();
+    return t;
+}
+
+static inline double bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Cost of an empty timed region, subtracted from per-call samples
+static inline uint64_t bench_timer_overhead(void)
+{
+    uint64_t best = UINT64_MAX;
+
+    for (int i = 0; i < 2000; i++)
+    {
+        uint64_t t0 = bench_tsc_begin();
+        uint64_t t1 = bench_tsc_end();
+        if (t1 - t0 < best)
+        {
+            best = t1 - t0;
+        }
+    }
+    return best;
+}
+
+// TSC ticks per nanosecond, measured over 50 ms
+static inline double bench_tsc_ghz(void)
+{
+    double n0 = bench_now_ns();
+    uint64_t c0 = bench_tsc_begin();
+    while (bench_now_ns() - n0 < 5e7)
+    {
+    }
+    uint64_t c1 = bench_tsc_end();
+    return (double)(c1 - c0) / (bench_now_ns() - n0);
+}
+
+#endif // BENCH_TIMER_H
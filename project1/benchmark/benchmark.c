@@ -1,14 +1,63 @@
 #include "../src/sm4.h"
+#include "../../bench/bench_counters.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+// Hardware counters are opt-in: SM4_PERF_COUNTERS=1 in the environment
+static int perf_counters_requested(void)
+{
+    const char *v = getenv("SM4_PERF_COUNTERS");
+    return v && *v && strcmp(v, "0") != 0;
+}
+
+static void counters_start(void *ctx)
+{
+    bench_counters_start(ctx);
+}
+
+static unsigned counters_stop(void *ctx, uint64_t counters[SM4_PERF_CTR_COUNT])
+{
+    double v[BENCH_CTR_MAX];
+    unsigned valid = 0;
+
+    bench_counters_stop(ctx, v);
+    for (int i = 0; i < SM4_PERF_CTR_COUNT; i++)
+    {
+        counters[i] = v[i] < 0 ? 0 : (uint64_t)v[i];
+        valid |= v[i] < 0 ? 0 : 1u << i;
+    }
+    return valid;
+}
+
 int main(void)
 {
+    bench_counters bc;
+    int have_counters = 0;
+
     printf("=== SM4 Performance Benchmark ===\n\n");
 
+    if (perf_counters_requested())
+    {
+        if (bench_counters_open(&bc, 0, NULL, NULL) > 0)
+        {
+            have_counters = 1;
+        }
+        else
+        {
+            printf("Hardware counters unavailable: %s\n\n", bc.error);
+        }
+    }
+    sm4_perf_counters source = {&bc, counters_start, counters_stop, bench_counter_name};
+    sm4_set_perf_counters(have_counters ? &source : NULL);
+
     // Run comparative benchmark
     sm4_compare_implementations();
+    sm4_set_perf_counters(NULL);
+    if (have_counters)
+    {
+        bench_counters_close(&bc);
+    }
 
     // Additional detailed benchmarks
     printf("=== Detailed Performance Analysis ===\n\n");
@@ -63,7 +112,6 @@ int main(void)
 
             // Benchmark
             uint64_t start_cycles = __builtin_ia32_rdtsc();
-            double start_time = 0; // Simplified timing
 
             const int iterations = 1000;
             for (int iter = 0; iter < iterations; iter++)
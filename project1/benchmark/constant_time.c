@@ -0,0 +1,180 @@
+#include "../src/sm4.h"
+#include "../../bench/bench_dudect.h"
+#include <stdio.h>
+#include <string.h>
+
+// Constant-time qualification of the SM4 backends, GHASH and the tag compare
+// (see bench/bench_dudect.h). The secret input is the key and plaintext for
+// the one-shot block APIs, the plaintext for the kernels on a fixed key
+// schedule, the data for GHASH under a fixed H and the compared buffer for
+// the memcmp cases. libc memcmp is included as a control that must leak.
+
+#define KERNEL_BLOCKS 8
+#define GHASH_BLOCKS 8
+#define CMP_LEN 64
+
+static volatile uint8_t sink;
+
+typedef void (*oneshot_func)(const uint8_t *key, const uint8_t *input, uint8_t *output);
+
+typedef struct
+{
+    oneshot_func oneshot;
+    sm4_blocks_func kernel;
+    sm4_context ctx;
+    sm4_ghash_key gkey;
+    sm4_gcm_context gcm;
+} ct_state;
+
+static const uint8_t key[16] = {
+    0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef,
+    0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10};
+
+static uint8_t cmp_secret[CMP_LEN];
+
+// input = key || plaintext
+static void call_oneshot(void *arg, const uint8_t *input)
+{
+    ct_state *s = arg;
+    uint8_t out[16];
+    s->oneshot(input, input + 16, out);
+    sink = out[0];
+}
+
+static void call_ecb(void *arg, const uint8_t *input)
+{
+    ct_state *s = arg;
+    uint8_t out[16];
+    sm4_crypt_ecb(&s->ctx, 1, input, out);
+    sink = out[0];
+}
+
+static void call_kernel(void *arg, const uint8_t *input)
+{
+    ct_state *s = arg;
+    uint8_t out[KERNEL_BLOCKS * 16];
+    s->kernel(&s->ctx, input, out, KERNEL_BLOCKS);
+    sink = out[0];
+}
+
+static void call_ghash(void *arg, const uint8_t *input)
+{
+    ct_state *s = arg;
+    uint8_t X[16] = {0};
+    sm4_ghash_blocks(&s->gkey, X, input, GHASH_BLOCKS);
+    sink = X[0];
+}
+
+// The reference GCM keeps its bitwise GF(2^128) multiply private; a 16-byte
+// IV sends it through GHASH to derive J0
+static void call_gcm_ref_j0(void *arg, const uint8_t *input)
+{
+    ct_state *s = arg;
+    sm4_gcm_starts(&s->gcm, 1, input, 16);
+    sink = s->gcm.y[15];
+}
+
+static void call_memcmp_ct(void *arg, const uint8_t *input)
+{
+    (void)arg;
+    sink = (uint8_t)sm4_memcmp_const_time(cmp_secret, input, CMP_LEN);
+}
+
+static void call_memcmp_libc(void *arg, const uint8_t *input)
+{
+    (void)arg;
+    sink = (uint8_t)memcmp(cmp_secret, input, CMP_LEN);
+}
+
+#define MAX_CASES 24
+
+int main(int argc, char **argv)
+{
+    static ct_state states[MAX_CASES];
+    static sm4_blocks_backend backends[8];
+    bench_dudect_case cases[MAX_CASES];
+    bench_dudect_options opt;
+    size_t n = 0, nb;
+    int rc = bench_dudect_parse_args(&opt, "project1-sm4-ct", argc, argv);
+
+    if (rc != 0)
+    {
+        return rc > 0 ? 0 : 1;
+    }
+
+    for (int i = 0; i < CMP_LEN; i++)
+    {
+        cmp_secret[i] = (uint8_t)(i * 37 + 11);
+    }
+
+    // One-block APIs: key schedule and encryption on every call
+    states[n].oneshot = sm4_basic_encrypt;
+    cases[n] = (bench_dudect_case){"sm4-block", "sm4_basic_encrypt", &states[n], 32, 16, NULL, call_oneshot};
+    n++;
+    states[n].oneshot = sm4_ttable_encrypt;
+    cases[n] = (bench_dudect_case){"sm4-block", "sm4_ttable_encrypt", &states[n], 32, 16, NULL, call_oneshot};
+    n++;
+    if (sm4_cpu_support_aesni())
+    {
+        states[n].oneshot = sm4_aesni_encrypt;
+        cases[n] = (bench_dudect_case){"sm4-block", "sm4_aesni_encrypt", &states[n], 32, 16, NULL, call_oneshot};
+        n++;
+    }
+#ifdef __GFNI__
+    if (sm4_cpu_support_gfni())
+    {
+        states[n].oneshot = sm4_gfni_encrypt;
+        cases[n] = (bench_dudect_case){"sm4-block", "sm4_gfni_encrypt", &states[n], 32, 16, NULL, call_oneshot};
+        n++;
+    }
+#endif
+    sm4_setkey_enc(&states[n].ctx, key);
+    cases[n] = (bench_dudect_case){"sm4-block", "sm4_crypt_ecb", &states[n], 16, 16, NULL, call_ecb};
+    n++;
+
+    // Multi-block kernels on a fixed key schedule
+    nb = sm4_blocks_backends(backends, 8);
+    for (size_t i = 0; i < nb && n < MAX_CASES - 5; i++)
+    {
+        sm4_setkey_enc(&states[n].ctx, key);
+        states[n].kernel = backends[i].crypt;
+        cases[n] = (bench_dudect_case){"sm4-blocks", backends[i].name, &states[n],
+                                       KERNEL_BLOCKS * 16, KERNEL_BLOCKS * 16, NULL, call_kernel};
+        n++;
+    }
+
+    // GHASH: both backends of sm4_ghash_blocks, then the reference multiply
+    {
+        uint8_t H[16] = {0};
+        sm4_context ctx;
+
+        sm4_setkey_enc(&ctx, key);
+        sm4_crypt_ecb(&ctx, 1, H, H);
+
+        sm4_ghash_setkey(&states[n].gkey, H);
+        states[n].gkey.use_pclmul = 0;
+        cases[n] = (bench_dudect_case){"ghash", "4-bit table", &states[n], GHASH_BLOCKS * 16,
+                                       GHASH_BLOCKS * 16, NULL, call_ghash};
+        n++;
+
+        sm4_ghash_setkey(&states[n].gkey, H);
+        if (states[n].gkey.use_pclmul)
+        {
+            cases[n] = (bench_dudect_case){"ghash", sm4_ghash_backend_name(&states[n].gkey), &states[n],
+                                           GHASH_BLOCKS * 16, GHASH_BLOCKS * 16, NULL, call_ghash};
+            n++;
+        }
+    }
+    sm4_gcm_setkey(&states[n].gcm, key, SM4_KEY_SIZE);
+    cases[n] = (bench_dudect_case){"ghash", "sm4_gcm.c bitwise (J0 of a 16-byte IV)", &states[n], 16, 32, NULL,
+                                   call_gcm_ref_j0};
+    n++;
+
+    // Tag comparison: class 0 equals the secret, class 1 differs almost at once
+    cases[n++] = (bench_dudect_case){"memcmp", "sm4_memcmp_const_time", NULL, CMP_LEN, CMP_LEN, cmp_secret,
+                                     call_memcmp_ct};
+    cases[n++] = (bench_dudect_case){"memcmp", "libc memcmp (control)", NULL, CMP_LEN, CMP_LEN, cmp_secret,
+                                     call_memcmp_libc};
+
+    return bench_dudect_run(cases, n, &opt) < 0 ? 1 : 0;
+}
@@ -0,0 +1,155 @@
+#include "../src/sm4.h"
+#include "../../bench/bench_harness.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// SM4 size sweep: every multi-block kernel, the modes on top of the
+// dispatcher, GCM/GMAC/CMAC, and the one-block-per-call APIs
+// (see bench/bench_harness.h for options and output formats).
+
+static const uint8_t key[16] = {
+    0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef,
+    0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10};
+
+static const uint8_t iv[16] = {
+    0xca, 0xfe, 0xba, 0xbe, 0xfa, 0xce, 0xdb, 0xad,
+    0xde, 0xca, 0xf8, 0x88, 0x00, 0x00, 0x00, 0x01};
+
+static sm4_context enc_ctx, dec_ctx;
+static sm4_prepared_key prepared;
+static sm4_cmac_key cmac_key;
+
+// Multi-block kernels, called directly (arg is the kernel)
+static void run_kernel(void *arg, uint8_t *buf, size_t len)
+{
+    sm4_blocks_func crypt = *(sm4_blocks_func *)arg;
+    crypt(&enc_ctx, buf, buf, len / SM4_BLOCK_SIZE);
+}
+
+static void run_ecb(void *arg, uint8_t *buf, size_t len)
+{
+    (void)arg;
+    sm4_ecb_crypt(&enc_ctx, buf, buf, len);
+}
+
+static void run_ctr(void *arg, uint8_t *buf, size_t len)
+{
+    uint8_t ctr[16];
+    (void)arg;
+    memcpy(ctr, iv, 16);
+    sm4_ctr_crypt(&enc_ctx, ctr, buf, buf, len);
+}
+
+static void run_cbc_enc(void *arg, uint8_t *buf, size_t len)
+{
+    uint8_t v[16];
+    (void)arg;
+    memcpy(v, iv, 16);
+    sm4_cbc_encrypt(&enc_ctx, v, buf, buf, len);
+}
+
+static void run_cbc_dec(void *arg, uint8_t *buf, size_t len)
+{
+    uint8_t v[16];
+    (void)arg;
+    memcpy(v, iv, 16);
+    sm4_cbc_decrypt(&dec_ctx, v, buf, buf, len);
+}
+
+static void run_gcm_prepared(void *arg, uint8_t *buf, size_t len)
+{
+    uint8_t tag[16];
+    (void)arg;
+    sm4_gcm_encrypt_prepared(&prepared, iv, 12, NULL, 0, buf, len, buf, tag, 16);
+}
+
+static void run_gcm_opt(void *arg, uint8_t *buf, size_t len)
+{
+    uint8_t tag[16];
+    (void)arg;
+    sm4_gcm_encrypt_opt(key, iv, 12, NULL, 0, buf, len, buf, tag, 16);
+}
+
+static void run_gmac(void *arg, uint8_t *buf, size_t len)
+{
+    uint8_t tag[16];
+    (void)arg;
+    sm4_gmac(key, iv, 12, buf, len, tag, 16);
+}
+
+static void run_cmac(void *arg, uint8_t *buf, size_t len)
+{
+    uint8_t tag[16];
+    (void)arg;
+    sm4_cmac_compute(&cmac_key, buf, len, tag, 16);
+}
+
+// One-block APIs that take the raw key (key schedule on every call)
+typedef void (*oneshot_func)(const uint8_t *, const uint8_t *, uint8_t *);
+
+static void run_oneshot(void *arg, uint8_t *buf, size_t len)
+{
+    oneshot_func f = *(oneshot_func *)arg;
+    for (size_t off = 0; off < len; off += SM4_BLOCK_SIZE)
+    {
+        f(key, buf + off, buf + off);
+    }
+}
+
+static oneshot_func oneshot_basic = sm4_basic_encrypt;
+static oneshot_func oneshot_ttable = sm4_ttable_encrypt;
+static oneshot_func oneshot_aesni = sm4_aesni_encrypt;
+static oneshot_func oneshot_gfni = sm4_gfni_encrypt;
+
+#define MAX_CASES 32
+#define ONESHOT_MAX ((size_t)16 << 20)
+
+int main(int argc, char **argv)
+{
+    static sm4_blocks_backend backends[8];
+    static sm4_blocks_func kernels[8];
+    bench_case cases[MAX_CASES];
+    size_t n = 0, nb;
+    bench_options opt;
+    int rc = bench_parse_args(&opt, "project1-sm4", argc, argv);
+
+    if (rc != 0)
+    {
+        return rc > 0 ? 0 : 1;
+    }
+
+    sm4_setkey_enc(&enc_ctx, key);
+    sm4_setkey_dec(&dec_ctx, key);
+    sm4_prepare_key(&prepared, key);
+    sm4_cmac_setkey(&cmac_key, key);
+
+    nb = sm4_blocks_backends(backends, 8);
+    for (size_t i = 0; i < nb; i++)
+    {
+        kernels[i] = backends[i].crypt;
+        cases[n++] = (bench_case){"sm4-blocks", backends[i].name, 16, 0, &kernels[i], NULL, run_kernel, NULL, SM4_BLOCK_SIZE};
+    }
+
+    cases[n++] = (bench_case){"sm4-ecb", "sm4_ecb_crypt", 16, 0, NULL, NULL, run_ecb, NULL, SM4_BLOCK_SIZE};
+    cases[n++] = (bench_case){"sm4-ctr", "sm4_ctr_crypt", 1, 0, NULL, NULL, run_ctr, NULL, SM4_BLOCK_SIZE};
+    cases[n++] = (bench_case){"sm4-cbc-enc", "sm4_cbc_encrypt", 16, 0, NULL, NULL, run_cbc_enc, NULL, SM4_BLOCK_SIZE};
+    cases[n++] = (bench_case){"sm4-cbc-dec", "sm4_cbc_decrypt", 16, 0, NULL, NULL, run_cbc_dec, NULL, SM4_BLOCK_SIZE};
+    cases[n++] = (bench_case){"sm4-gcm-enc", "sm4_gcm_encrypt_prepared", 1, 0, NULL, NULL, run_gcm_prepared, NULL, SM4_BLOCK_SIZE};
+    cases[n++] = (bench_case){"sm4-gcm-enc", "sm4_gcm_encrypt_opt", 1, 0, NULL, NULL, run_gcm_opt, NULL, SM4_BLOCK_SIZE};
+    cases[n++] = (bench_case){"sm4-gmac", "sm4_gmac", 1, 0, NULL, NULL, run_gmac, NULL, SM4_BLOCK_SIZE};
+    cases[n++] = (bench_case){"sm4-cmac", "sm4_cmac_compute", 1, 0, NULL, NULL, run_cmac, NULL, SM4_BLOCK_SIZE};
+
+    cases[n++] = (bench_case){"sm4-oneshot", "sm4_basic_encrypt", 16, ONESHOT_MAX, &oneshot_basic, NULL, run_oneshot, NULL, SM4_BLOCK_SIZE};
+    cases[n++] = (bench_case){"sm4-oneshot", "sm4_ttable_encrypt", 16, ONESHOT_MAX, &oneshot_ttable, NULL, run_oneshot, NULL, SM4_BLOCK_SIZE};
+    if (sm4_cpu_support_aesni())
+    {
+        cases[n++] = (bench_case){"sm4-oneshot", "sm4_aesni_encrypt", 16, ONESHOT_MAX, &oneshot_aesni, NULL, run_oneshot, NULL, SM4_BLOCK_SIZE};
+    }
+    if (sm4_cpu_support_gfni())
+    {
+        cases[n++] = (bench_case){"sm4-oneshot", "sm4_gfni_encrypt", 16, ONESHOT_MAX, &oneshot_gfni, NULL, run_oneshot, NULL, SM4_BLOCK_SIZE};
+    }
+
+    return bench_run(cases, n, &opt) == 0 ? 0 : 1;
+}
@@ -40,3 +40,42 @@ int sm4_cpu_support_avx2(void)
 
     return (ebx & (1 << 5)) != 0; // AVX2 flag
 }
+
+int sm4_cpu_support_pclmul(void)
+{
+    uint32_t eax, ebx, ecx, edx;
+
+    // Check CPUID for PCLMULQDQ support
+    __asm__ volatile(
+        "cpuid"
+        : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+        : "a"(1));
+
+    return (ecx & (1 << 1)) != 0; // PCLMULQDQ flag
+}
+
+int sm4_cpu_support_avx512vbmi(void)
+{
+    uint32_t eax, ebx, ecx, edx;
+
+    // Check CPUID for AVX512F, AVX512BW and AVX512_VBMI
+    __asm__ volatile(
+        "cpuid"
+        : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+        : "a"(7), "c"(0));
+
+    return (ebx & (1 << 16)) != 0 && (ebx & (1u << 30)) != 0 && (ecx & (1 << 1)) != 0;
+}
+
+int sm4_cpu_support_ssse3(void)
+{
+    uint32_t eax, ebx, ecx, edx;
+
+    // Check CPUID for SSSE3 support
+    __asm__ volatile(
+        "cpuid"
+        : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+        : "a"(1));
+
+    return (ecx & (1 << 9)) != 0; // SSSE3 flag
+}
@@ -53,7 +53,64 @@ extern "C"
 #ifdef __GFNI__
     void sm4_gfni_encrypt(const uint8_t *key, const uint8_t *input, uint8_t *output);
     void sm4_gfni_decrypt(const uint8_t *key, const uint8_t *input, uint8_t *output);
+    int sm4_cpu_support_avx512(void);
+#ifdef __AVX512F__
+    void sm4_crypt_blocks_gfni(const sm4_context *ctx, const uint8_t *input, uint8_t *output, size_t nblocks);
 #endif
+#endif
+
+// AVX-512 VBMI implementation (S-box via 64-byte vpermi2b lookups)
+#if defined(__AVX512VBMI__) && defined(__AVX512BW__)
+    void sm4_crypt_blocks_vbmi(const sm4_context *ctx, const uint8_t *input, uint8_t *output, size_t nblocks);
+#endif
+
+// Vector-permute implementation (tower-field S-box via pshufb nibble tables)
+#ifdef __SSSE3__
+    void sm4_crypt_blocks_ssse3(const sm4_context *ctx, const uint8_t *input, uint8_t *output, size_t nblocks);
+#endif
+#ifdef __AVX2__
+    void sm4_crypt_blocks_avx2(const sm4_context *ctx, const uint8_t *input, uint8_t *output, size_t nblocks);
+#endif
+
+    // Multi-block ECB over independent blocks (direction comes from the key schedule)
+    // sm4_crypt_blocks() dispatches to the widest kernel the CPU supports
+    void sm4_crypt_blocks(const sm4_context *ctx, const uint8_t *input, uint8_t *output, size_t nblocks);
+    void sm4_crypt_blocks_scalar(const sm4_context *ctx, const uint8_t *input, uint8_t *output, size_t nblocks);
+    void sm4_crypt_blocks_interleaved(const sm4_context *ctx, const uint8_t *input, uint8_t *output, size_t nblocks);
+    const char *sm4_blocks_backend_name(void);
+
+    // Block cipher modes on the multi-block kernels (len in bytes)
+    // ECB/CBC need len % 16 == 0; CBC decryption takes a sm4_setkey_dec() context.
+    // CTR uses a 128-bit big-endian counter; ctr and iv are advanced for chaining calls.
+    int sm4_ecb_crypt(const sm4_context *ctx, const uint8_t *input, uint8_t *output, size_t len);
+    int sm4_ctr_crypt(const sm4_context *ctx, uint8_t ctr[SM4_BLOCK_SIZE],
+                      const uint8_t *input, uint8_t *output, size_t len);
+    int sm4_cbc_encrypt(const sm4_context *ctx, uint8_t iv[SM4_BLOCK_SIZE],
+                        const uint8_t *input, uint8_t *output, size_t len);
+    int sm4_cbc_decrypt(const sm4_context *ctx, uint8_t iv[SM4_BLOCK_SIZE],
+                        const uint8_t *input, uint8_t *output, size_t len);
+
+    typedef void (*sm4_blocks_func)(const sm4_context *ctx, const uint8_t *input, uint8_t *output, size_t nblocks);
+    typedef struct
+    {
+        const char *name;
+        sm4_blocks_func crypt;
+    } sm4_blocks_backend;
+
+    // Kernels usable on this CPU, preferred first (for tests and benchmarks)
+    size_t sm4_blocks_backends(sm4_blocks_backend *out, size_t max);
+
+    // GHASH key material (per key, built once by sm4_ghash_setkey)
+#define SM4_GHASH_AGG_BLOCKS 8
+
+    typedef struct
+    {
+        uint8_t H[16];                             // Hash subkey
+        uint8_t Hpow[SM4_GHASH_AGG_BLOCKS][16];    // H^1..H^8, byte-reflected for PCLMULQDQ
+        uint64_t HL[16];                           // 4-bit table (low halves) for the portable path
+        uint64_t HH[16];                           // 4-bit table (high halves) for the portable path
+        int use_pclmul;                            // Backend chosen at setkey time
+    } sm4_ghash_key;
 
     // GCM mode
     typedef struct
@@ -64,6 +121,7 @@ extern "C"
         uint8_t y[16];         // Current counter
         uint8_t buf[16];       // Buffer
         size_t len;            // Length of processed data
+        sm4_ghash_key gkey;    // Per-key GHASH tables (built by sm4_gcm_setkey_opt)
     } sm4_gcm_context;
 
     // GCM functions
@@ -97,13 +155,147 @@ extern "C"
                             const uint8_t *tag, size_t tag_len,
                             uint8_t *plaintext);
 
+    // GHASH over a prepared key
+    void sm4_ghash_setkey(sm4_ghash_key *gk, const uint8_t H[16]);
+    void sm4_ghash_blocks(const sm4_ghash_key *gk, uint8_t X[16], const uint8_t *data, size_t nblocks);
+    void sm4_ghash_update_padded(const sm4_ghash_key *gk, uint8_t X[16], const uint8_t *data, size_t len);
+    void sm4_ghash_j0(const sm4_ghash_key *gk, const uint8_t *iv, size_t iv_len, uint8_t J0[16]);
+    const char *sm4_ghash_backend_name(const sm4_ghash_key *gk);
+
+    // GMAC (GCM authentication only, no CTR encryption)
+    typedef struct
+    {
+        sm4_context sm4_ctx;
+        sm4_ghash_key gkey;
+        uint8_t X[16];     // Running GHASH value
+        uint8_t ek0[16];   // E_K(J0)
+        uint8_t buf[16];   // Partial block
+        size_t buf_len;    // Bytes held in buf
+        uint64_t len;      // Total bytes authenticated
+    } sm4_gmac_context;
+
+    int sm4_gmac_init(sm4_gmac_context *ctx, const uint8_t *key, const uint8_t *iv, size_t iv_len);
+    int sm4_gmac_reset(sm4_gmac_context *ctx, const uint8_t *iv, size_t iv_len);
+    int sm4_gmac_update(sm4_gmac_context *ctx, const uint8_t *data, size_t len);
+    int sm4_gmac_final(sm4_gmac_context *ctx, uint8_t *tag, size_t tag_len);
+
+    // One-shot and multi-message GMAC (one key, one IV per message, tags packed tag_len apart)
+    int sm4_gmac(const uint8_t *key, const uint8_t *iv, size_t iv_len,
+                 const uint8_t *data, size_t len, uint8_t *tag, size_t tag_len);
+
+    int sm4_gmac_batch(const uint8_t *key,
+                       const uint8_t *const ivs[], size_t iv_len,
+                       const uint8_t *const msgs[], const size_t lens[], size_t count,
+                       uint8_t *tags, size_t tag_len);
+
+    // Fully expanded per-key material: everything the one-shot APIs rebuild on each call
+    typedef struct
+    {
+        sm4_context enc;    // Encryption round keys
+        sm4_context dec;    // Decryption round keys
+        sm4_ghash_key gkey; // H, H powers and 4-bit tables for GCM/GMAC
+    } sm4_prepared_key;
+
+    void sm4_prepare_key(sm4_prepared_key *pk, const uint8_t key[SM4_KEY_SIZE]);
+
+    // GCM on a prepared key (full GHASH over AAD and ciphertext, multi-block CTR).
+    // tag_len is SM4_GCM_MIN_TAG_LEN..16; shorter tags are rejected, a 0-byte
+    // tag would let any ciphertext verify
+#define SM4_GCM_MIN_TAG_LEN 4
+    int sm4_gcm_encrypt_prepared(const sm4_prepared_key *pk, const uint8_t *iv, size_t iv_len,
+                                 const uint8_t *aad, size_t aad_len,
+                                 const uint8_t *plaintext, size_t pt_len,
+                                 uint8_t *ciphertext, uint8_t *tag, size_t tag_len);
+
+    int sm4_gcm_decrypt_prepared(const sm4_prepared_key *pk, const uint8_t *iv, size_t iv_len,
+                                 const uint8_t *aad, size_t aad_len,
+                                 const uint8_t *ciphertext, size_t ct_len,
+                                 const uint8_t *tag, size_t tag_len,
+                                 uint8_t *plaintext);
+
+    // Concurrent cache of prepared keys indexed by a 64-bit key ID
+    // Lookups are lock-free; inserts and evictions lock one shard. Entries are
+    // pinned while in use and wiped when evicted or removed.
+    typedef struct sm4_key_cache sm4_key_cache;
+
+    typedef struct
+    {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t insertions;
+        uint64_t evictions;
+        size_t entries;      // Live entries
+        size_t capacity;     // Maximum entries within the memory budget
+        size_t memory_bytes; // Memory actually reserved
+    } sm4_key_cache_stats;
+
+    sm4_key_cache *sm4_key_cache_create(size_t memory_budget, unsigned int nshards);
+    void sm4_key_cache_destroy(sm4_key_cache *cache);
+
+    // get/put return a pinned entry (NULL on miss, or when every slot in the shard is pinned);
+    // every non-NULL result must be handed back with sm4_key_cache_release()
+    const sm4_prepared_key *sm4_key_cache_get(sm4_key_cache *cache, uint64_t key_id);
+    const sm4_prepared_key *sm4_key_cache_put(sm4_key_cache *cache, uint64_t key_id, const uint8_t key[SM4_KEY_SIZE]);
+    void sm4_key_cache_release(sm4_key_cache *cache, const sm4_prepared_key *pk);
+
+    // Drop a key (e.g. after revocation); the entry is wiped once its last user releases it
+    int sm4_key_cache_remove(sm4_key_cache *cache, uint64_t key_id);
+    void sm4_key_cache_get_stats(sm4_key_cache *cache, sm4_key_cache_stats *stats);
+
+    // CMAC (NIST SP 800-38B with SM4)
+#define SM4_CMAC_LANES 16
+
+    typedef struct
+    {
+        sm4_context sm4_ctx;
+        uint8_t K1[16]; // Subkey for complete final blocks
+        uint8_t K2[16]; // Subkey for padded final blocks
+    } sm4_cmac_key;
+
+    int sm4_cmac_setkey(sm4_cmac_key *ck, const uint8_t *key);
+    int sm4_cmac_compute(const sm4_cmac_key *ck, const uint8_t *msg, size_t len, uint8_t *tag, size_t tag_len);
+    int sm4_cmac(const uint8_t *key, const uint8_t *msg, size_t len, uint8_t *tag, size_t tag_len);
+
+    // Many messages under one key, up to SM4_CMAC_LANES in flight (tags packed tag_len apart)
+    int sm4_cmac_batch(const uint8_t *key,
+                       const uint8_t *const msgs[], const size_t lens[], size_t count,
+                       uint8_t *tags, size_t tag_len);
+
     // Utility functions
     void sm4_print_block(const char *label, const uint8_t *data, size_t len);
     void sm4_print_hex(const uint8_t *data, size_t len);
     int sm4_memcmp_const_time(const uint8_t *a, const uint8_t *b, size_t len);
     void sm4_memzero(void *ptr, size_t len);
 
-    // Random number generation for testing
+    // CTR_DRBG (NIST SP 800-90A, SM4, no derivation function)
+#define SM4_DRBG_SEED_LEN 32                  // seedlen = keylen + blocklen
+#define SM4_DRBG_MAX_REQUEST 65536            // 2^19 bits per generate call
+#define SM4_DRBG_RESEED_INTERVAL (1ULL << 32) // Generate calls between reseeds
+
+    typedef struct
+    {
+        sm4_context sm4_ctx;     // Expanded Key
+        uint8_t V[16];           // Counter block
+        uint64_t reseed_counter; // Generate calls since the last (re)seed
+        int auto_reseed;         // Seeded from getrandom, reseeds itself when due
+    } sm4_drbg;
+
+    // entropy == NULL draws entropy from getrandom(); otherwise it must be SM4_DRBG_SEED_LEN bytes
+    int sm4_drbg_instantiate(sm4_drbg *drbg, const uint8_t *entropy, size_t entropy_len,
+                             const uint8_t *pers, size_t pers_len);
+    int sm4_drbg_reseed(sm4_drbg *drbg, const uint8_t *entropy, size_t entropy_len,
+                        const uint8_t *addl, size_t addl_len);
+    int sm4_drbg_generate(sm4_drbg *drbg, uint8_t *out, size_t len, const uint8_t *addl, size_t addl_len);
+    void sm4_drbg_uninstantiate(sm4_drbg *drbg);
+
+    // Per-thread DRBG instance, seeded on first use and reseeded after fork()
+    int sm4_random_bytes(uint8_t *buf, size_t len);
+
+    // Random IV/nonce for GCM and GMAC
+    int sm4_gcm_generate_iv(uint8_t *iv, size_t iv_len);
+
+    // Random number generation for testing (a separate per-thread DRBG; sm4_srand makes it
+    // deterministic without touching the sm4_random_bytes / IV stream)
     void sm4_srand(uint32_t seed);
     uint32_t sm4_rand(void);
     void sm4_rand_bytes(uint8_t *buf, size_t len);
@@ -112,6 +304,25 @@ extern "C"
     int sm4_cpu_support_aesni(void);
     int sm4_cpu_support_gfni(void);
     int sm4_cpu_support_avx2(void);
+    int sm4_cpu_support_pclmul(void);
+    int sm4_cpu_support_avx512vbmi(void);
+    int sm4_cpu_support_ssse3(void);
+
+    // Hardware counters read around a measured region; the slots are the
+    // fixed ones of bench/bench_counters.h
+    enum
+    {
+        SM4_PERF_CTR_INSTRUCTIONS,
+        SM4_PERF_CTR_CYCLES,
+        SM4_PERF_CTR_L1D_MISSES,
+        SM4_PERF_CTR_LLC_MISSES,
+        SM4_PERF_CTR_BRANCH_MISSES,
+        SM4_PERF_CTR_PORT0, // Uops dispatched per port: Intel cores with known event codes only
+        SM4_PERF_CTR_PORT1,
+        SM4_PERF_CTR_PORT5,
+        SM4_PERF_CTR_PORT6,
+        SM4_PERF_CTR_COUNT
+    };
 
     // Performance measurement
     typedef struct
@@ -120,11 +331,32 @@ extern "C"
         double mbytes_per_sec;
         uint64_t total_cycles;
         size_t total_bytes;
+        size_t total_blocks;
+        unsigned counters_valid;               // Bit i set when counters[i] was read
+        uint64_t counters[SM4_PERF_CTR_COUNT]; // Scaled up when the kernel multiplexed them
     } sm4_perf_result;
 
+    // Counter source for sm4_benchmark(). The library opens no counters
+    // itself; benchmark/benchmark.c installs one built on bench_counters.c
+    typedef struct
+    {
+        void *ctx;
+        void (*start)(void *ctx);
+        // Fills counters[] and returns which of them were read
+        unsigned (*stop)(void *ctx, uint64_t counters[SM4_PERF_CTR_COUNT]);
+        const char *(*name)(int slot);
+    } sm4_perf_counters;
+
+    // NULL removes the source again; src must outlive the benchmarks
+    void sm4_set_perf_counters(const sm4_perf_counters *src);
+
+    // Counters per byte and per block, plus IPC
+    void sm4_perf_print_counters(const sm4_perf_result *result);
+
     void sm4_benchmark(const char *impl_name,
                        void (*encrypt_func)(const uint8_t *, const uint8_t *, uint8_t *),
                        sm4_perf_result *result);
+    void sm4_compare_implementations(void);
 
 #ifdef __cplusplus
 }
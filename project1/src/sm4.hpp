@@ -0,0 +1,683 @@
+#ifndef SM4_HPP
+#define SM4_HPP
+
+// Header-only C++17 layer over sm4.h
+// Sm4<Backend, Lanes> binds the block kernel at compile time: the scalar and
+// GFNI kernels are defined here and inlined into every instantiation with
+// their 32 rounds unrolled; the VBMI and vector-permute kernels are called
+// directly, without going through the sm4_crypt_blocks() dispatcher.
+// AnySm4 / AnySm4Gcm pick a backend at runtime behind one virtual call per
+// buffer (not per block).
+
+// g++ 12 warns about the self-initialised _mm512_undefined_epi32() that
+// backs most AVX-512 intrinsics once they are inlined into C++
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+#endif
+
+#include "sm4.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace sm4
+{
+
+    // Minimal contiguous view (std::span is C++20)
+    template <class T>
+    class span
+    {
+    public:
+        constexpr span() noexcept = default;
+        constexpr span(T *data, std::size_t size) noexcept : data_(data), size_(size) {}
+
+        template <std::size_t N>
+        constexpr span(T (&arr)[N]) noexcept : data_(arr), size_(N) {}
+
+        // Any container with data()/size() (std::vector, std::array, std::string, ...)
+        template <class C, class = std::enable_if_t<
+                               std::is_convertible_v<decltype(std::declval<C &>().data()), T *> &&
+                               !std::is_same_v<std::remove_cv_t<C>, span>>>
+        constexpr span(C &c) noexcept : data_(c.data()), size_(c.size()) {}
+
+        // span<uint8_t> -> span<const uint8_t>
+        template <class U, class = std::enable_if_t<std::is_convertible_v<U *, T *>>>
+        constexpr span(const span<U> &other) noexcept : data_(other.data()), size_(other.size()) {}
+
+        constexpr T *data() const noexcept { return data_; }
+        constexpr std::size_t size() const noexcept { return size_; }
+        constexpr bool empty() const noexcept { return size_ == 0; }
+        constexpr T *begin() const noexcept { return data_; }
+        constexpr T *end() const noexcept { return data_ + size_; }
+        constexpr T &operator[](std::size_t i) const noexcept { return data_[i]; }
+
+        constexpr span subspan(std::size_t offset, std::size_t count) const noexcept
+        {
+            return span(data_ + offset, count);
+        }
+
+    private:
+        T *data_ = nullptr;
+        std::size_t size_ = 0;
+    };
+
+    using bytes_view = span<const std::uint8_t>;
+    using bytes_span = span<std::uint8_t>;
+
+    // Expanded key, encryption and decryption schedules
+    // Move-only; the round keys are wiped on destruction and on move.
+    class Key
+    {
+    public:
+        explicit Key(bytes_view key)
+        {
+            if (key.size() != SM4_KEY_SIZE)
+            {
+                throw std::invalid_argument("SM4 key must be 16 bytes");
+            }
+            sm4_setkey_enc(&enc_, key.data());
+            sm4_setkey_dec(&dec_, key.data());
+        }
+
+        Key(const Key &) = delete;
+        Key &operator=(const Key &) = delete;
+
+        Key(Key &&other) noexcept : enc_(other.enc_), dec_(other.dec_)
+        {
+            other.wipe();
+        }
+
+        Key &operator=(Key &&other) noexcept
+        {
+            if (this != &other)
+            {
+                enc_ = other.enc_;
+                dec_ = other.dec_;
+                other.wipe();
+            }
+            return *this;
+        }
+
+        ~Key() { wipe(); }
+
+        const sm4_context &enc() const noexcept { return enc_; }
+        const sm4_context &dec() const noexcept { return dec_; }
+
+    private:
+        void wipe() noexcept
+        {
+            sm4_memzero(&enc_, sizeof(enc_));
+            sm4_memzero(&dec_, sizeof(dec_));
+        }
+
+        sm4_context enc_;
+        sm4_context dec_;
+    };
+
+    namespace detail
+    {
+        inline std::uint32_t rotl(std::uint32_t x, int n) noexcept
+        {
+            return (x << n) | (x >> (32 - n));
+        }
+
+        inline std::uint32_t load_be(const std::uint8_t *p) noexcept
+        {
+            return (std::uint32_t(p[0]) << 24) | (std::uint32_t(p[1]) << 16) |
+                   (std::uint32_t(p[2]) << 8) | std::uint32_t(p[3]);
+        }
+
+        inline void store_be(std::uint8_t *p, std::uint32_t v) noexcept
+        {
+            p[0] = std::uint8_t(v >> 24);
+            p[1] = std::uint8_t(v >> 16);
+            p[2] = std::uint8_t(v >> 8);
+            p[3] = std::uint8_t(v);
+        }
+    } // namespace detail
+
+    // Block kernels. Each backend processes exactly Lanes blocks per call;
+    // Lanes must be a multiple of lane_multiple.
+    namespace backend
+    {
+        // Portable: Lanes blocks per round in lockstep (see sm4_crypt_blocks_interleaved)
+        struct Scalar
+        {
+            static constexpr const char *name = "scalar";
+            static constexpr std::size_t lane_multiple = 1;
+            static constexpr std::size_t default_lanes = 4;
+            static bool available() noexcept { return true; }
+
+            template <std::size_t Lanes>
+            static void crypt(const sm4_context &ctx, const std::uint8_t *in, std::uint8_t *out) noexcept
+            {
+                std::uint32_t x[4][Lanes];
+                for (std::size_t b = 0; b < Lanes; b++)
+                {
+                    for (std::size_t w = 0; w < 4; w++)
+                    {
+                        x[w][b] = detail::load_be(in + 16 * b + 4 * w);
+                    }
+                }
+
+                rounds(x, ctx.rk, std::make_index_sequence<SM4_ROUNDS>{});
+
+                // Output is (X35, X34, X33, X32)
+                for (std::size_t b = 0; b < Lanes; b++)
+                {
+                    for (std::size_t w = 0; w < 4; w++)
+                    {
+                        detail::store_be(out + 16 * b + 4 * w, x[3 - w][b]);
+                    }
+                }
+            }
+
+        private:
+            static std::uint32_t t(std::uint32_t x) noexcept
+            {
+                std::uint32_t b = (std::uint32_t(SM4_SBOX[x >> 24]) << 24) |
+                                  (std::uint32_t(SM4_SBOX[(x >> 16) & 0xff]) << 16) |
+                                  (std::uint32_t(SM4_SBOX[(x >> 8) & 0xff]) << 8) |
+                                  std::uint32_t(SM4_SBOX[x & 0xff]);
+                return b ^ detail::rotl(b, 2) ^ detail::rotl(b, 10) ^ detail::rotl(b, 18) ^ detail::rotl(b, 24);
+            }
+
+            // Round R updates word R % 4 of every block
+            template <std::size_t R, std::size_t Lanes>
+            static void round(std::uint32_t (&x)[4][Lanes], std::uint32_t rk) noexcept
+            {
+                for (std::size_t b = 0; b < Lanes; b++)
+                {
+                    x[R % 4][b] ^= t(x[(R + 1) % 4][b] ^ x[(R + 2) % 4][b] ^ x[(R + 3) % 4][b] ^ rk);
+                }
+            }
+
+            template <std::size_t Lanes, std::size_t... R>
+            static void rounds(std::uint32_t (&x)[4][Lanes], const std::uint32_t *rk, std::index_sequence<R...>) noexcept
+            {
+                (round<R>(x, rk[R]), ...);
+            }
+        };
+
+#if defined(__GFNI__) && defined(__AVX512F__)
+        // GFNI + AVX-512, 16 blocks per zmm group (see sm4_gfni.c for the S-box derivation)
+        struct Gfni
+        {
+            static constexpr const char *name = "gfni";
+            static constexpr std::size_t lane_multiple = 16;
+            static constexpr std::size_t default_lanes = 32;
+            static bool available() noexcept { return sm4_cpu_support_gfni() && sm4_cpu_support_avx512(); }
+
+            template <std::size_t Lanes>
+            static void crypt(const sm4_context &ctx, const std::uint8_t *in, std::uint8_t *out) noexcept
+            {
+                static_assert(Lanes % 16 == 0, "GFNI backend works on groups of 16 blocks");
+                constexpr std::size_t G = Lanes / 16;
+                __m512i x[4][G];
+
+                for (std::size_t g = 0; g < G; g++)
+                {
+                    for (std::size_t w = 0; w < 4; w++)
+                    {
+                        x[w][g] = bswap(_mm512_loadu_si512(in + 256 * g + 64 * w));
+                    }
+                    transpose(x[0][g], x[1][g], x[2][g], x[3][g]);
+                }
+
+                rounds(x, ctx.rk, std::make_index_sequence<SM4_ROUNDS>{});
+
+                for (std::size_t g = 0; g < G; g++)
+                {
+                    transpose(x[3][g], x[2][g], x[1][g], x[0][g]);
+                    for (std::size_t w = 0; w < 4; w++)
+                    {
+                        _mm512_storeu_si512(out + 256 * g + 64 * w, bswap(x[3 - w][g]));
+                    }
+                }
+            }
+
+        private:
+            static __m512i bswap(__m512i x) noexcept
+            {
+                const __m512i lo = _mm512_set1_epi32(0x00ff00ff);
+                return _mm512_or_si512(_mm512_rol_epi32(_mm512_and_si512(x, lo), 24),
+                                       _mm512_rol_epi32(_mm512_andnot_si512(lo, x), 8));
+            }
+
+            static void transpose(__m512i &r0, __m512i &r1, __m512i &r2, __m512i &r3) noexcept
+            {
+                __m512i t0 = _mm512_unpacklo_epi32(r0, r1);
+                __m512i t1 = _mm512_unpackhi_epi32(r0, r1);
+                __m512i t2 = _mm512_unpacklo_epi32(r2, r3);
+                __m512i t3 = _mm512_unpackhi_epi32(r2, r3);
+                r0 = _mm512_unpacklo_epi64(t0, t2);
+                r1 = _mm512_unpackhi_epi64(t0, t2);
+                r2 = _mm512_unpacklo_epi64(t1, t3);
+                r3 = _mm512_unpackhi_epi64(t1, t3);
+            }
+
+            static __m512i t(__m512i x) noexcept
+            {
+                x = _mm512_gf2p8affine_epi64_epi8(x, _mm512_set1_epi64(0x4c287db91a22505dLL), 0x3e);
+                x = _mm512_gf2p8affineinv_epi64_epi8(x, _mm512_set1_epi64((long long)0xf3ab34a974a6b589ULL), 0xd3);
+                __m512i l = _mm512_ternarylogic_epi32(x, _mm512_rol_epi32(x, 2), _mm512_rol_epi32(x, 10), 0x96);
+                return _mm512_ternarylogic_epi32(l, _mm512_rol_epi32(x, 18), _mm512_rol_epi32(x, 24), 0x96);
+            }
+
+            template <std::size_t R, std::size_t G>
+            static void round(__m512i (&x)[4][G], std::uint32_t rk) noexcept
+            {
+                const __m512i k = _mm512_set1_epi32(int(rk));
+                for (std::size_t g = 0; g < G; g++)
+                {
+                    __m512i s = _mm512_ternarylogic_epi32(x[(R + 1) % 4][g], x[(R + 2) % 4][g], x[(R + 3) % 4][g], 0x96);
+                    x[R % 4][g] = _mm512_xor_si512(x[R % 4][g], t(_mm512_xor_si512(s, k)));
+                }
+            }
+
+            template <std::size_t G, std::size_t... R>
+            static void rounds(__m512i (&x)[4][G], const std::uint32_t *rk, std::index_sequence<R...>) noexcept
+            {
+                (round<R>(x, rk[R]), ...);
+            }
+        };
+#endif
+
+#if defined(__AVX512VBMI__) && defined(__AVX512BW__)
+        struct Vbmi
+        {
+            static constexpr const char *name = "vbmi";
+            static constexpr std::size_t lane_multiple = 16;
+            static constexpr std::size_t default_lanes = 32;
+            static bool available() noexcept { return sm4_cpu_support_avx512vbmi(); }
+
+            template <std::size_t Lanes>
+            static void crypt(const sm4_context &ctx, const std::uint8_t *in, std::uint8_t *out) noexcept
+            {
+                static_assert(Lanes % 16 == 0, "VBMI backend works on groups of 16 blocks");
+                sm4_crypt_blocks_vbmi(&ctx, in, out, Lanes);
+            }
+        };
+#endif
+
+#ifdef __AVX2__
+        struct Avx2
+        {
+            static constexpr const char *name = "avx2";
+            static constexpr std::size_t lane_multiple = 8;
+            static constexpr std::size_t default_lanes = 16;
+            static bool available() noexcept { return sm4_cpu_support_avx2(); }
+
+            template <std::size_t Lanes>
+            static void crypt(const sm4_context &ctx, const std::uint8_t *in, std::uint8_t *out) noexcept
+            {
+                static_assert(Lanes % 8 == 0, "AVX2 backend works on groups of 8 blocks");
+                sm4_crypt_blocks_avx2(&ctx, in, out, Lanes);
+            }
+        };
+#endif
+
+#ifdef __SSSE3__
+        struct Ssse3
+        {
+            static constexpr const char *name = "ssse3";
+            static constexpr std::size_t lane_multiple = 4;
+            static constexpr std::size_t default_lanes = 8;
+            static bool available() noexcept { return sm4_cpu_support_ssse3(); }
+
+            template <std::size_t Lanes>
+            static void crypt(const sm4_context &ctx, const std::uint8_t *in, std::uint8_t *out) noexcept
+            {
+                static_assert(Lanes % 4 == 0, "SSSE3 backend works on groups of 4 blocks");
+                sm4_crypt_blocks_ssse3(&ctx, in, out, Lanes);
+            }
+        };
+#endif
+    } // namespace backend
+
+    template <class Backend = backend::Scalar, std::size_t Lanes = Backend::default_lanes>
+    class Sm4
+    {
+        static_assert(Lanes > 0 && Lanes % Backend::lane_multiple == 0,
+                      "Lanes must be a multiple of the backend's native width");
+
+    public:
+        using backend_type = Backend;
+        static constexpr std::size_t lanes = Lanes;
+
+        explicit Sm4(Key key) noexcept : key_(std::move(key)) {}
+        explicit Sm4(bytes_view key) : key_(key) {}
+
+        // ECB over whole blocks; in and out may alias exactly
+        void encrypt_ecb(bytes_view in, bytes_span out) const
+        {
+            check_blocks(in, out);
+            crypt_blocks(key_.enc(), in.data(), out.data(), in.size() / SM4_BLOCK_SIZE);
+        }
+
+        void decrypt_ecb(bytes_view in, bytes_span out) const
+        {
+            check_blocks(in, out);
+            crypt_blocks(key_.dec(), in.data(), out.data(), in.size() / SM4_BLOCK_SIZE);
+        }
+
+        // CTR with a 128-bit big-endian counter, advanced for chained calls
+        void ctr(std::array<std::uint8_t, SM4_BLOCK_SIZE> &counter, bytes_view in, bytes_span out) const
+        {
+            if (in.size() != out.size())
+            {
+                throw std::invalid_argument("SM4-CTR output size must match input");
+            }
+            keystream_xor<false>(counter.data(), in.data(), out.data(), in.size());
+        }
+
+        // nblocks independent blocks with the given schedule, Lanes at a time
+        void crypt_blocks(const sm4_context &ctx, const std::uint8_t *in, std::uint8_t *out, std::size_t nblocks) const noexcept
+        {
+            while (nblocks >= Lanes)
+            {
+                Backend::template crypt<Lanes>(ctx, in, out);
+                in += Lanes * SM4_BLOCK_SIZE;
+                out += Lanes * SM4_BLOCK_SIZE;
+                nblocks -= Lanes;
+            }
+
+            if constexpr (Lanes > 1)
+            {
+                if (nblocks)
+                {
+                    // Tail: one full pass over a padded copy
+                    std::uint8_t buf[Lanes * SM4_BLOCK_SIZE] = {};
+                    std::memcpy(buf, in, nblocks * SM4_BLOCK_SIZE);
+                    Backend::template crypt<Lanes>(ctx, buf, buf);
+                    std::memcpy(out, buf, nblocks * SM4_BLOCK_SIZE);
+                    sm4_memzero(buf, sizeof(buf));
+                }
+            }
+        }
+
+        // out = in ^ keystream; Inc32 selects the GCM 32-bit counter instead of the full 128-bit one
+        template <bool Inc32>
+        void keystream_xor(std::uint8_t counter[SM4_BLOCK_SIZE], const std::uint8_t *in, std::uint8_t *out, std::size_t len) const noexcept
+        {
+            std::uint8_t ks[Lanes * SM4_BLOCK_SIZE];
+
+            while (len > 0)
+            {
+                std::size_t n = len < sizeof(ks) ? len : sizeof(ks);
+                std::size_t nblocks = (n + SM4_BLOCK_SIZE - 1) / SM4_BLOCK_SIZE;
+
+                for (std::size_t b = 0; b < nblocks; b++)
+                {
+                    if constexpr (Inc32)
+                    {
+                        detail::store_be(counter + 12, detail::load_be(counter + 12) + 1);
+                        std::memcpy(ks + SM4_BLOCK_SIZE * b, counter, SM4_BLOCK_SIZE);
+                    }
+                    else
+                    {
+                        std::memcpy(ks + SM4_BLOCK_SIZE * b, counter, SM4_BLOCK_SIZE);
+                        for (int i = SM4_BLOCK_SIZE - 1; i >= 0 && ++counter[i] == 0; i--)
+                        {
+                        }
+                    }
+                }
+                crypt_blocks(key_.enc(), ks, ks, nblocks);
+
+                for (std::size_t i = 0; i < n; i++)
+                {
+                    out[i] = in[i] ^ ks[i];
+                }
+                in += n;
+                out += n;
+                len -= n;
+            }
+
+            sm4_memzero(ks, sizeof(ks));
+        }
+
+        const Key &key() const noexcept { return key_; }
+
+    private:
+        static void check_blocks(bytes_view in, bytes_span out)
+        {
+            if (in.size() % SM4_BLOCK_SIZE != 0 || in.size() != out.size())
+            {
+                throw std::invalid_argument("SM4-ECB needs equal, block-aligned input and output");
+            }
+        }
+
+        Key key_;
+    };
+
+    // SM4-GCM with the block kernel bound at compile time; GHASH uses sm4_ghash_*
+    template <class Backend = backend::Scalar, std::size_t Lanes = Backend::default_lanes>
+    class Sm4Gcm
+    {
+    public:
+        using backend_type = Backend;
+
+        explicit Sm4Gcm(Key key) : sm4_(std::move(key)) { init_ghash(); }
+        explicit Sm4Gcm(bytes_view key) : sm4_(key) { init_ghash(); }
+
+        Sm4Gcm(const Sm4Gcm &) = delete;
+        Sm4Gcm &operator=(const Sm4Gcm &) = delete;
+
+        Sm4Gcm(Sm4Gcm &&other) noexcept : sm4_(std::move(other.sm4_)), gkey_(other.gkey_)
+        {
+            sm4_memzero(&other.gkey_, sizeof(other.gkey_));
+        }
+
+        Sm4Gcm &operator=(Sm4Gcm &&other) noexcept
+        {
+            if (this != &other)
+            {
+                sm4_ = std::move(other.sm4_);
+                gkey_ = other.gkey_;
+                sm4_memzero(&other.gkey_, sizeof(other.gkey_));
+            }
+            return *this;
+        }
+
+        ~Sm4Gcm() { sm4_memzero(&gkey_, sizeof(gkey_)); }
+
+        // tag.size() selects the tag length (1..16 bytes)
+        void encrypt(bytes_view iv, bytes_view aad, bytes_view pt, bytes_span ct, bytes_span tag) const
+        {
+            check(iv, pt.size(), ct.size(), tag.size());
+            std::uint8_t J0[16], full[16];
+
+            sm4_ghash_j0(&gkey_, iv.data(), iv.size(), J0);
+            std::uint8_t ctr[16];
+            std::memcpy(ctr, J0, 16);
+            sm4_.template keystream_xor<true>(ctr, pt.data(), ct.data(), pt.size());
+            compute_tag(J0, aad, bytes_view(ct.data(), pt.size()), full);
+            std::memcpy(tag.data(), full, tag.size());
+        }
+
+        // Returns false (and leaves pt untouched) if the tag does not verify
+        bool decrypt(bytes_view iv, bytes_view aad, bytes_view ct, bytes_view tag, bytes_span pt) const
+        {
+            check(iv, ct.size(), pt.size(), tag.size());
+            std::uint8_t J0[16], full[16];
+
+            sm4_ghash_j0(&gkey_, iv.data(), iv.size(), J0);
+            compute_tag(J0, aad, ct, full);
+            if (sm4_memcmp_const_time(full, tag.data(), tag.size()) != 0)
+            {
+                return false;
+            }
+            sm4_.template keystream_xor<true>(J0, ct.data(), pt.data(), ct.size());
+            return true;
+        }
+
+    private:
+        void init_ghash()
+        {
+            std::uint8_t H[16] = {};
+            sm4_.encrypt_ecb(bytes_view(H, 16), bytes_span(H, 16));
+            sm4_ghash_setkey(&gkey_, H);
+            sm4_memzero(H, sizeof(H));
+        }
+
+        static void check(bytes_view iv, std::size_t in_len, std::size_t out_len, std::size_t tag_len)
+        {
+            if (iv.empty() || in_len != out_len || tag_len < SM4_GCM_MIN_TAG_LEN || tag_len > 16)
+            {
+                throw std::invalid_argument("SM4-GCM: bad IV, output or tag size");
+            }
+        }
+
+        void compute_tag(const std::uint8_t J0[16], bytes_view aad, bytes_view ct, std::uint8_t tag[16]) const
+        {
+            std::uint8_t X[16] = {}, len_block[16], ek0[16];
+
+            sm4_ghash_update_padded(&gkey_, X, aad.data(), aad.size());
+            sm4_ghash_update_padded(&gkey_, X, ct.data(), ct.size());
+            for (int i = 0; i < 8; i++)
+            {
+                len_block[i] = std::uint8_t((std::uint64_t(aad.size()) * 8) >> (56 - 8 * i));
+                len_block[8 + i] = std::uint8_t((std::uint64_t(ct.size()) * 8) >> (56 - 8 * i));
+            }
+            sm4_ghash_blocks(&gkey_, X, len_block, 1);
+
+            sm4_.crypt_blocks(sm4_.key().enc(), J0, ek0, 1);
+            for (int i = 0; i < 16; i++)
+            {
+                tag[i] = X[i] ^ ek0[i];
+            }
+            sm4_memzero(ek0, sizeof(ek0));
+        }
+
+        Sm4<Backend, Lanes> sm4_;
+        sm4_ghash_key gkey_;
+    };
+
+    namespace detail
+    {
+        // Calls f(Backend{}) with the first usable backend in preference order,
+        // or with the one whose name matches (nullptr: best available)
+        template <class F>
+        auto with_backend(const char *name, F &&f)
+        {
+            auto wanted = [name](const char *candidate)
+            { return name == nullptr || std::strcmp(name, candidate) == 0; };
+
+#if defined(__GFNI__) && defined(__AVX512F__)
+            if (wanted(backend::Gfni::name) && backend::Gfni::available())
+                return f(backend::Gfni{});
+#endif
+#if defined(__AVX512VBMI__) && defined(__AVX512BW__)
+            if (wanted(backend::Vbmi::name) && backend::Vbmi::available())
+                return f(backend::Vbmi{});
+#endif
+#ifdef __AVX2__
+            if (wanted(backend::Avx2::name) && backend::Avx2::available())
+                return f(backend::Avx2{});
+#endif
+#ifdef __SSSE3__
+            if (wanted(backend::Ssse3::name) && backend::Ssse3::available())
+                return f(backend::Ssse3{});
+#endif
+            if (wanted(backend::Scalar::name))
+                return f(backend::Scalar{});
+            throw std::invalid_argument(std::string("SM4 backend not available: ") + name);
+        }
+    } // namespace detail
+
+    // Runtime-selected SM4 (ECB/CTR)
+    class AnySm4
+    {
+    public:
+        template <class Backend, std::size_t Lanes>
+        explicit AnySm4(Sm4<Backend, Lanes> impl) : impl_(std::make_unique<Model<Sm4<Backend, Lanes>>>(std::move(impl))) {}
+
+        // name: "gfni", "vbmi", "avx2", "ssse3", "scalar", or nullptr for the best available
+        static AnySm4 create(Key key, const char *name = nullptr)
+        {
+            return detail::with_backend(name, [&key](auto b)
+                                        { return AnySm4(Sm4<decltype(b)>(std::move(key))); });
+        }
+
+        void encrypt_ecb(bytes_view in, bytes_span out) const { impl_->encrypt_ecb(in, out); }
+        void decrypt_ecb(bytes_view in, bytes_span out) const { impl_->decrypt_ecb(in, out); }
+        void ctr(std::array<std::uint8_t, SM4_BLOCK_SIZE> &counter, bytes_view in, bytes_span out) const { impl_->ctr(counter, in, out); }
+        const char *backend_name() const noexcept { return impl_->backend_name(); }
+
+    private:
+        struct Concept
+        {
+            virtual ~Concept() = default;
+            virtual void encrypt_ecb(bytes_view in, bytes_span out) const = 0;
+            virtual void decrypt_ecb(bytes_view in, bytes_span out) const = 0;
+            virtual void ctr(std::array<std::uint8_t, SM4_BLOCK_SIZE> &counter, bytes_view in, bytes_span out) const = 0;
+            virtual const char *backend_name() const noexcept = 0;
+        };
+
+        template <class Impl>
+        struct Model final : Concept
+        {
+            explicit Model(Impl impl) : impl(std::move(impl)) {}
+            void encrypt_ecb(bytes_view in, bytes_span out) const override { impl.encrypt_ecb(in, out); }
+            void decrypt_ecb(bytes_view in, bytes_span out) const override { impl.decrypt_ecb(in, out); }
+            void ctr(std::array<std::uint8_t, SM4_BLOCK_SIZE> &counter, bytes_view in, bytes_span out) const override { impl.ctr(counter, in, out); }
+            const char *backend_name() const noexcept override { return Impl::backend_type::name; }
+            Impl impl;
+        };
+
+        std::unique_ptr<Concept> impl_;
+    };
+
+    // Runtime-selected SM4-GCM
+    class AnySm4Gcm
+    {
+    public:
+        template <class Backend, std::size_t Lanes>
+        explicit AnySm4Gcm(Sm4Gcm<Backend, Lanes> impl) : impl_(std::make_unique<Model<Sm4Gcm<Backend, Lanes>>>(std::move(impl))) {}
+
+        static AnySm4Gcm create(Key key, const char *name = nullptr)
+        {
+            return detail::with_backend(name, [&key](auto b)
+                                        { return AnySm4Gcm(Sm4Gcm<decltype(b)>(std::move(key))); });
+        }
+
+        void encrypt(bytes_view iv, bytes_view aad, bytes_view pt, bytes_span ct, bytes_span tag) const { impl_->encrypt(iv, aad, pt, ct, tag); }
+        bool decrypt(bytes_view iv, bytes_view aad, bytes_view ct, bytes_view tag, bytes_span pt) const { return impl_->decrypt(iv, aad, ct, tag, pt); }
+        const char *backend_name() const noexcept { return impl_->backend_name(); }
+
+    private:
+        struct Concept
+        {
+            virtual ~Concept() = default;
+            virtual void encrypt(bytes_view iv, bytes_view aad, bytes_view pt, bytes_span ct, bytes_span tag) const = 0;
+            virtual bool decrypt(bytes_view iv, bytes_view aad, bytes_view ct, bytes_view tag, bytes_span pt) const = 0;
+            virtual const char *backend_name() const noexcept = 0;
+        };
+
+        template <class Impl>
+        struct Model final : Concept
+        {
+            explicit Model(Impl impl) : impl(std::move(impl)) {}
+            void encrypt(bytes_view iv, bytes_view aad, bytes_view pt, bytes_span ct, bytes_span tag) const override { impl.encrypt(iv, aad, pt, ct, tag); }
+            bool decrypt(bytes_view iv, bytes_view aad, bytes_view ct, bytes_view tag, bytes_span pt) const override { return impl.decrypt(iv, aad, ct, tag, pt); }
+            const char *backend_name() const noexcept override { return Impl::backend_type::name; }
+            Impl impl;
+        };
+
+        std::unique_ptr<Concept> impl_;
+    };
+
+} // namespace sm4
+
+#endif // SM4_HPP
@@ -0,0 +1,195 @@
+#include "sm4.h"
+
+// Multi-block dispatcher
+// Modes that have many independent blocks in flight (CMAC lanes, CTR, ECB,
+// CBC decryption) call sm4_crypt_blocks() and get the widest kernel available.
+
+static sm4_blocks_func blocks_impl = NULL;
+static const char *blocks_impl_name = NULL;
+
+// One block at a time through the reference implementation
+void sm4_crypt_blocks_scalar(const sm4_context *ctx, const uint8_t *input, uint8_t *output, size_t nblocks)
+{
+    while (nblocks--)
+    {
+        // sm4_crypt_ecb() only reads the context; mode is implied by the round key order
+        sm4_crypt_ecb((sm4_context *)ctx, 1, input, output);
+        input += SM4_BLOCK_SIZE;
+        output += SM4_BLOCK_SIZE;
+    }
+}
+
+static inline uint32_t rotl(uint32_t x, int n)
+{
+    return (x << n) | (x >> (32 - n));
+}
+
+static inline uint32_t get_u32_be(const uint8_t *data)
+{
+    return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) |
+           ((uint32_t)data[2] << 8) | ((uint32_t)data[3]);
+}
+
+static inline void put_u32_be(uint8_t *data, uint32_t value)
+{
+    data[0] = (uint8_t)(value >> 24);
+    data[1] = (uint8_t)(value >> 16);
+    data[2] = (uint8_t)(value >> 8);
+    data[3] = (uint8_t)value;
+}
+
+// T(x) = L(tau(x))
+static inline uint32_t sm4_t(uint32_t x)
+{
+    uint32_t b = ((uint32_t)SM4_SBOX[x >> 24] << 24) |
+                 ((uint32_t)SM4_SBOX[(x >> 16) & 0xff] << 16) |
+                 ((uint32_t)SM4_SBOX[(x >> 8) & 0xff] << 8) |
+                 ((uint32_t)SM4_SBOX[x & 0xff]);
+    return b ^ rotl(b, 2) ^ rotl(b, 10) ^ rotl(b, 18) ^ rotl(b, 24);
+}
+
+// Blocks are kept in x[word][block] so each round is a loop over independent
+// blocks that the compiler fully unrolls
+#define SM4_SCALAR_ROUND(x, n, a, b, c, d, rk)                 \
+    do                                                         \
+    {                                                          \
+        for (int blk = 0; blk < (n); blk++)                    \
+        {                                                      \
+            x[a][blk] ^= sm4_t(x[b][blk] ^ x[c][blk] ^ x[d][blk] ^ (rk)); \
+        }                                                      \
+    } while (0)
+
+#define SM4_DEFINE_SCALAR_KERNEL(name, n)                                      \
+    static void name(const uint32_t rk[SM4_ROUNDS], const uint8_t *in, uint8_t *out) \
+    {                                                                          \
+        uint32_t x[4][n];                                                      \
+        for (int blk = 0; blk < (n); blk++)                                    \
+        {                                                                      \
+            for (int w = 0; w < 4; w++)                                        \
+            {                                                                  \
+                x[w][blk] = get_u32_be(in + 16 * blk + 4 * w);                 \
+            }                                                                  \
+        }                                                                      \
+        for (int i = 0; i < SM4_ROUNDS; i += 4)                                \
+        {                                                                      \
+            SM4_SCALAR_ROUND(x, n, 0, 1, 2, 3, rk[i]);                         \
+            SM4_SCALAR_ROUND(x, n, 1, 2, 3, 0, rk[i + 1]);                     \
+            SM4_SCALAR_ROUND(x, n, 2, 3, 0, 1, rk[i + 2]);                     \
+            SM4_SCALAR_ROUND(x, n, 3, 0, 1, 2, rk[i + 3]);                     \
+        }                                                                      \
+        /* Output is (X35, X34, X33, X32) */                                   \
+        for (int blk = 0; blk < (n); blk++)                                    \
+        {                                                                      \
+            for (int w = 0; w < 4; w++)                                        \
+            {                                                                  \
+                put_u32_be(out + 16 * blk + 4 * w, x[3 - w][blk]);             \
+            }                                                                  \
+        }                                                                      \
+    }
+
+SM4_DEFINE_SCALAR_KERNEL(sm4_crypt_x4_scalar, 4)
+SM4_DEFINE_SCALAR_KERNEL(sm4_crypt_x8_scalar, 8)
+
+// Several blocks per round in lockstep: the one-block path is a single chain
+// of 32 dependent rounds, this keeps 4-8 chains in flight
+void sm4_crypt_blocks_interleaved(const sm4_context *ctx, const uint8_t *input, uint8_t *output, size_t nblocks)
+{
+    while (nblocks >= 8)
+    {
+        sm4_crypt_x8_scalar(ctx->rk, input, output);
+        input += 8 * SM4_BLOCK_SIZE;
+        output += 8 * SM4_BLOCK_SIZE;
+        nblocks -= 8;
+    }
+
+    if (nblocks >= 4)
+    {
+        sm4_crypt_x4_scalar(ctx->rk, input, output);
+        input += 4 * SM4_BLOCK_SIZE;
+        output += 4 * SM4_BLOCK_SIZE;
+        nblocks -= 4;
+    }
+
+    // Fewer than 4 blocks left: not worth padding
+    sm4_crypt_blocks_scalar(ctx, input, output, nblocks);
+}
+
+#if defined(__GFNI__) && defined(__AVX512F__)
+static int gfni_usable(void)
+{
+    return sm4_cpu_support_gfni() && sm4_cpu_support_avx512();
+}
+#endif
+
+static int always_usable(void)
+{
+    return 1;
+}
+
+// Compiled-in kernels, preferred first; each is used only if the CPU has it
+static const struct
+{
+    sm4_blocks_backend backend;
+    int (*usable)(void);
+} blocks_candidates[] = {
+#if defined(__GFNI__) && defined(__AVX512F__)
+    {{"GFNI + AVX-512 (16 blocks)", sm4_crypt_blocks_gfni}, gfni_usable},
+#endif
+#if defined(__AVX512VBMI__) && defined(__AVX512BW__)
+    {{"AVX-512 VBMI (16 blocks)", sm4_crypt_blocks_vbmi}, sm4_cpu_support_avx512vbmi},
+#endif
+#if defined(__AVX2__) && defined(__SSSE3__)
+    {{"AVX2 vpshufb (8 blocks)", sm4_crypt_blocks_avx2}, sm4_cpu_support_avx2},
+#endif
+#ifdef __SSSE3__
+    {{"SSSE3 pshufb (4 blocks)", sm4_crypt_blocks_ssse3}, sm4_cpu_support_ssse3},
+#endif
+    {{"scalar interleaved (4-8 blocks)", sm4_crypt_blocks_interleaved}, always_usable},
+    {{"scalar", sm4_crypt_blocks_scalar}, always_usable},
+};
+
+size_t sm4_blocks_backends(sm4_blocks_backend *out, size_t max)
+{
+    size_t n = 0;
+
+    for (size_t i = 0; i < sizeof(blocks_candidates) / sizeof(blocks_candidates[0]); i++)
+    {
+        if (n < max && blocks_candidates[i].usable())
+        {
+            out[n++] = blocks_candidates[i].backend;
+        }
+    }
+    return n;
+}
+
+// Lock-free one-time selection: every thread that finds no kernel yet
+// computes the same answer, and the release store publishes the name with it
+static sm4_blocks_func select_blocks_impl(void)
+{
+    sm4_blocks_backend best = {"scalar", sm4_crypt_blocks_scalar};
+
+    sm4_blocks_backends(&best, 1);
+    __atomic_store_n(&blocks_impl_name, best.name, __ATOMIC_RELAXED);
+    __atomic_store_n(&blocks_impl, best.crypt, __ATOMIC_RELEASE);
+    return best.crypt;
+}
+
+void sm4_crypt_blocks(const sm4_context *ctx, const uint8_t *input, uint8_t *output, size_t nblocks)
+{
+    // CPUID is only probed on the first call
+    sm4_blocks_func impl = __atomic_load_n(&blocks_impl, __ATOMIC_ACQUIRE);
+    if (!impl)
+    {
+        impl = select_blocks_impl();
+    }
+    impl(ctx, input, output, nblocks);
+}
+
+const char *sm4_blocks_backend_name(void)
+{
+    if (!__atomic_load_n(&blocks_impl, __ATOMIC_ACQUIRE))
+    {
+        select_blocks_impl();
+    }
+    return __atomic_load_n(&blocks_impl_name, __ATOMIC_RELAXED);
+}
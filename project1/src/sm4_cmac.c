@@ -0,0 +1,226 @@
+#include "sm4.h"
+#include <string.h>
+
+// SM4-CMAC (NIST SP 800-38B)
+// One message is inherently serial, but messages are independent of each
+// other, so sm4_cmac_batch() keeps up to SM4_CMAC_LANES messages in flight
+// and advances all of them with a single multi-block SM4 call per step.
+
+// Multiply by x in GF(2^128) (left shift with conditional 0x87 reduction)
+static void cmac_dbl(const uint8_t in[16], uint8_t out[16])
+{
+    uint8_t carry = in[0] >> 7;
+
+    for (int i = 0; i < 15; i++)
+    {
+        out[i] = (uint8_t)((in[i] << 1) | (in[i + 1] >> 7));
+    }
+    out[15] = (uint8_t)((in[15] << 1) ^ (0x87 & (0 - carry)));
+}
+
+static size_t cmac_nblocks(size_t len)
+{
+    return len == 0 ? 1 : (len + 15) / 16;
+}
+
+// Final block M_n* with padding and the matching subkey applied
+static void cmac_last_block(const sm4_cmac_key *ck, const uint8_t *msg, size_t len, uint8_t last[16])
+{
+    size_t off = (cmac_nblocks(len) - 1) * 16;
+    size_t rem = len - off;
+
+    if (len > 0 && rem == 16)
+    {
+        for (int i = 0; i < 16; i++)
+        {
+            last[i] = msg[off + i] ^ ck->K1[i];
+        }
+        return;
+    }
+
+    memset(last, 0, 16);
+    if (rem)
+    {
+        memcpy(last, msg + off, rem);
+    }
+    last[rem] = 0x80;
+    for (int i = 0; i < 16; i++)
+    {
+        last[i] ^= ck->K2[i];
+    }
+}
+
+// Derive K1, K2 from L = E_K(0^128)
+int sm4_cmac_setkey(sm4_cmac_key *ck, const uint8_t *key)
+{
+    uint8_t L[16] = {0};
+
+    if (!ck || !key)
+    {
+        return -1;
+    }
+
+    sm4_setkey_enc(&ck->sm4_ctx, key);
+    sm4_crypt_ecb(&ck->sm4_ctx, 1, L, L);
+    cmac_dbl(L, ck->K1);
+    cmac_dbl(ck->K1, ck->K2);
+    sm4_memzero(L, sizeof(L));
+
+    return 0;
+}
+
+// CMAC of one message under a prepared key
+int sm4_cmac_compute(const sm4_cmac_key *ck, const uint8_t *msg, size_t len, uint8_t *tag, size_t tag_len)
+{
+    uint8_t X[16] = {0};
+    uint8_t last[16];
+    size_t nblocks;
+
+    if (!ck || !tag || (!msg && len) || tag_len > 16)
+    {
+        return -1;
+    }
+
+    nblocks = cmac_nblocks(len);
+    for (size_t b = 0; b + 1 < nblocks; b++)
+    {
+        for (int i = 0; i < 16; i++)
+        {
+            X[i] ^= msg[16 * b + i];
+        }
+        sm4_crypt_ecb((sm4_context *)&ck->sm4_ctx, 1, X, X);
+    }
+
+    cmac_last_block(ck, msg, len, last);
+    for (int i = 0; i < 16; i++)
+    {
+        X[i] ^= last[i];
+    }
+    sm4_crypt_ecb((sm4_context *)&ck->sm4_ctx, 1, X, X);
+
+    memcpy(tag, X, tag_len);
+    return 0;
+}
+
+// One-shot CMAC
+int sm4_cmac(const uint8_t *key, const uint8_t *msg, size_t len, uint8_t *tag, size_t tag_len)
+{
+    sm4_cmac_key ck;
+    int ret;
+
+    ret = sm4_cmac_setkey(&ck, key);
+    if (ret == 0)
+        ret = sm4_cmac_compute(&ck, msg, len, tag, tag_len);
+
+    sm4_memzero(&ck, sizeof(ck));
+    return ret;
+}
+
+// Per-lane state for the batch API
+typedef struct
+{
+    size_t msg;     // Index into msgs[]
+    size_t block;   // Next block to absorb
+    size_t nblocks; // Total blocks including the final one
+    uint8_t X[16];  // CBC chaining value
+} cmac_lane;
+
+// Multi-message CMAC: each step gathers one block from every active lane,
+// encrypts them together and scatters the results back.  Lanes that finish
+// write their tag and are refilled with the next pending message, so short
+// and long messages can be mixed freely.
+int sm4_cmac_batch(const uint8_t *key,
+                   const uint8_t *const msgs[], const size_t lens[], size_t count,
+                   uint8_t *tags, size_t tag_len)
+{
+    sm4_cmac_key ck;
+    cmac_lane lanes[SM4_CMAC_LANES];
+    uint8_t blocks[SM4_CMAC_LANES * 16];
+    size_t next = 0;
+    int active = 0;
+
+    if (!key || !msgs || !lens || !tags || tag_len > 16)
+    {
+        return -1;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!msgs[i] && lens[i])
+        {
+            return -1;
+        }
+    }
+
+    sm4_cmac_setkey(&ck, key);
+
+    for (;;)
+    {
+        // Refill free lanes (active lanes are kept packed at the front)
+        while (active < SM4_CMAC_LANES && next < count)
+        {
+            cmac_lane *ln = &lanes[active++];
+            ln->msg = next++;
+            ln->block = 0;
+            ln->nblocks = cmac_nblocks(lens[ln->msg]);
+            memset(ln->X, 0, 16);
+        }
+
+        if (active == 0)
+        {
+            break;
+        }
+
+        // Gather: X ^ M_i, or X ^ M_n* for lanes on their final block
+        for (int l = 0; l < active; l++)
+        {
+            cmac_lane *ln = &lanes[l];
+            uint8_t *dst = blocks + 16 * l;
+
+            if (ln->block + 1 < ln->nblocks)
+            {
+                const uint8_t *src = msgs[ln->msg] + 16 * ln->block;
+                for (int i = 0; i < 16; i++)
+                {
+                    dst[i] = ln->X[i] ^ src[i];
+                }
+            }
+            else
+            {
+                cmac_last_block(&ck, msgs[ln->msg], lens[ln->msg], dst);
+                for (int i = 0; i < 16; i++)
+                {
+                    dst[i] ^= ln->X[i];
+                }
+            }
+        }
+
+        sm4_crypt_blocks(&ck.sm4_ctx, blocks, blocks, (size_t)active);
+
+        // Scatter and retire finished lanes, compacting the lane array
+        int kept = 0;
+        for (int l = 0; l < active; l++)
+        {
+            cmac_lane *ln = &lanes[l];
+
+            if (++ln->block == ln->nblocks)
+            {
+                memcpy(tags + ln->msg * tag_len, blocks + 16 * l, tag_len);
+                continue;
+            }
+
+            memcpy(ln->X, blocks + 16 * l, 16);
+            if (kept != l)
+            {
+                lanes[kept] = *ln;
+            }
+            kept++;
+        }
+        active = kept;
+    }
+
+    sm4_memzero(&ck, sizeof(ck));
+    sm4_memzero(lanes, sizeof(lanes));
+    sm4_memzero(blocks, sizeof(blocks));
+    return 0;
+}
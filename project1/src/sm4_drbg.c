@@ -0,0 +1,452 @@
+#include "sm4.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#ifdef __linux__
+#include <sys/random.h>
+#endif
+
+// CTR_DRBG (NIST SP 800-90A, section 10.2.1) with SM4 as the block cipher
+// No derivation function: entropy input is exactly seedlen (32) bytes of
+// full-entropy data from getrandom(). Output blocks are independent counter
+// encryptions, so bulk requests go through the multi-block kernel.
+
+// Small requests are served from a per-thread pool so that sm4_rand() and IV
+// generation don't pay for a DRBG update per call
+#define DRBG_POOL_SIZE 1024
+#define DRBG_POOL_MAX_REQUEST 256
+
+typedef struct
+{
+    sm4_drbg drbg;
+    uint8_t pool[DRBG_POOL_SIZE];
+    size_t pool_pos;       // Next unread byte, DRBG_POOL_SIZE when empty
+    unsigned int fork_gen; // fork_generation when last (re)seeded
+    int seeded;
+} drbg_thread_state;
+
+// Two streams per thread: thread_rng feeds sm4_random_bytes() and IVs and is
+// always seeded from getrandom(); thread_test_rng feeds sm4_rand() and
+// sm4_rand_bytes() and is the only one sm4_srand() can make deterministic
+static __thread drbg_thread_state thread_rng;
+static __thread drbg_thread_state thread_test_rng;
+
+// Bumped in the child after fork() so per-thread instances reseed instead of
+// repeating the parent's output; checking it costs no system call
+static volatile unsigned int fork_generation = 0;
+static pthread_once_t atfork_once = PTHREAD_ONCE_INIT;
+
+static void drbg_atfork_child(void)
+{
+    fork_generation++;
+}
+
+static void drbg_register_atfork(void)
+{
+    pthread_atfork(NULL, NULL, drbg_atfork_child);
+}
+
+// Read full-entropy bytes from the kernel
+static int drbg_get_entropy(uint8_t *buf, size_t len)
+{
+#ifdef __linux__
+    while (len > 0)
+    {
+        ssize_t n = getrandom(buf, len, 0);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+    if (len == 0)
+    {
+        return 0;
+    }
+#endif
+
+    // Fallback for kernels without getrandom()
+    FILE *f = fopen("/dev/urandom", "rb");
+    if (!f)
+    {
+        return -1;
+    }
+    size_t got = fread(buf, 1, len, f);
+    fclose(f);
+    return got == len ? 0 : -1;
+}
+
+static inline uint64_t get_u64_be(const uint8_t *p)
+{
+    return ((uint64_t)p[0] << 56) | ((uint64_t)p[1] << 48) |
+           ((uint64_t)p[2] << 40) | ((uint64_t)p[3] << 32) |
+           ((uint64_t)p[4] << 24) | ((uint64_t)p[5] << 16) |
+           ((uint64_t)p[6] << 8) | ((uint64_t)p[7]);
+}
+
+static inline void put_u64_be(uint8_t *p, uint64_t v)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        p[i] = (uint8_t)(v >> (56 - 8 * i));
+    }
+}
+
+// Write V+1, V+2, ..., V+n into out and advance V (128-bit big-endian counter)
+static void drbg_fill_counters(uint8_t V[16], uint8_t *out, size_t n)
+{
+    uint64_t hi = get_u64_be(V);
+    uint64_t lo = get_u64_be(V + 8);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        if (++lo == 0)
+        {
+            hi++;
+        }
+        // Word-sized big-endian stores; this loop runs once per output block
+        uint64_t be_hi = __builtin_bswap64(hi);
+        uint64_t be_lo = __builtin_bswap64(lo);
+        memcpy(out + 16 * i, &be_hi, 8);
+        memcpy(out + 16 * i + 8, &be_lo, 8);
+    }
+
+    put_u64_be(V, hi);
+    put_u64_be(V + 8, lo);
+}
+
+// CTR_DRBG_Update: (Key, V) = leftmost seedlen bits of E(V+1) || E(V+2), xored with provided_data
+static void drbg_update(sm4_drbg *drbg, const uint8_t provided[SM4_DRBG_SEED_LEN])
+{
+    uint8_t temp[SM4_DRBG_SEED_LEN];
+
+    drbg_fill_counters(drbg->V, temp, 2);
+    sm4_crypt_blocks(&drbg->sm4_ctx, temp, temp, 2);
+
+    if (provided)
+    {
+        for (int i = 0; i < SM4_DRBG_SEED_LEN; i++)
+        {
+            temp[i] ^= provided[i];
+        }
+    }
+
+    sm4_setkey_enc(&drbg->sm4_ctx, temp);
+    memcpy(drbg->V, temp + 16, 16);
+    sm4_memzero(temp, sizeof(temp));
+}
+
+// Zero-pad a short string (personalization / additional input) to seedlen
+static int drbg_pad(uint8_t out[SM4_DRBG_SEED_LEN], const uint8_t *in, size_t len)
+{
+    if (len > SM4_DRBG_SEED_LEN || (!in && len))
+    {
+        return -1;
+    }
+    memset(out, 0, SM4_DRBG_SEED_LEN);
+    if (len)
+    {
+        memcpy(out, in, len);
+    }
+    return 0;
+}
+
+// Instantiate; entropy == NULL draws the seed from getrandom() and lets the
+// instance reseed itself when the reseed interval runs out
+int sm4_drbg_instantiate(sm4_drbg *drbg, const uint8_t *entropy, size_t entropy_len,
+                         const uint8_t *pers, size_t pers_len)
+{
+    uint8_t seed[SM4_DRBG_SEED_LEN];
+    uint8_t zero_key[SM4_KEY_SIZE] = {0};
+
+    if (!drbg || drbg_pad(seed, pers, pers_len) != 0)
+    {
+        return -1;
+    }
+
+    if (entropy)
+    {
+        if (entropy_len != SM4_DRBG_SEED_LEN)
+        {
+            return -1;
+        }
+        for (int i = 0; i < SM4_DRBG_SEED_LEN; i++)
+        {
+            seed[i] ^= entropy[i];
+        }
+        drbg->auto_reseed = 0;
+    }
+    else
+    {
+        uint8_t fresh[SM4_DRBG_SEED_LEN];
+        if (drbg_get_entropy(fresh, sizeof(fresh)) != 0)
+        {
+            return -1;
+        }
+        for (int i = 0; i < SM4_DRBG_SEED_LEN; i++)
+        {
+            seed[i] ^= fresh[i];
+        }
+        sm4_memzero(fresh, sizeof(fresh));
+        drbg->auto_reseed = 1;
+    }
+
+    // Key = 0^keylen, V = 0^blocklen
+    sm4_setkey_enc(&drbg->sm4_ctx, zero_key);
+    memset(drbg->V, 0, 16);
+    drbg_update(drbg, seed);
+    drbg->reseed_counter = 1;
+
+    sm4_memzero(seed, sizeof(seed));
+    return 0;
+}
+
+// Reseed; entropy == NULL draws fresh entropy from getrandom()
+int sm4_drbg_reseed(sm4_drbg *drbg, const uint8_t *entropy, size_t entropy_len,
+                    const uint8_t *addl, size_t addl_len)
+{
+    uint8_t seed[SM4_DRBG_SEED_LEN];
+    uint8_t fresh[SM4_DRBG_SEED_LEN];
+    const uint8_t *src = entropy;
+
+    if (!drbg || drbg_pad(seed, addl, addl_len) != 0)
+    {
+        return -1;
+    }
+
+    if (entropy)
+    {
+        if (entropy_len != SM4_DRBG_SEED_LEN)
+        {
+            return -1;
+        }
+    }
+    else
+    {
+        if (drbg_get_entropy(fresh, sizeof(fresh)) != 0)
+        {
+            return -1;
+        }
+        src = fresh;
+    }
+
+    for (int i = 0; i < SM4_DRBG_SEED_LEN; i++)
+    {
+        seed[i] ^= src[i];
+    }
+    drbg_update(drbg, seed);
+    drbg->reseed_counter = 1;
+
+    sm4_memzero(seed, sizeof(seed));
+    sm4_memzero(fresh, sizeof(fresh));
+    return 0;
+}
+
+// One CTR_DRBG_Generate call for at most SM4_DRBG_MAX_REQUEST bytes
+static int drbg_generate_one(sm4_drbg *drbg, uint8_t *out, size_t len, const uint8_t addl[SM4_DRBG_SEED_LEN])
+{
+    size_t nfull = len / 16;
+    size_t rem = len % 16;
+
+    if (drbg->reseed_counter > SM4_DRBG_RESEED_INTERVAL)
+    {
+        if (!drbg->auto_reseed || sm4_drbg_reseed(drbg, NULL, 0, NULL, 0) != 0)
+        {
+            return -1;
+        }
+    }
+
+    if (addl)
+    {
+        drbg_update(drbg, addl);
+    }
+
+    // Counters are written straight into the output and encrypted in place
+    if (nfull)
+    {
+        drbg_fill_counters(drbg->V, out, nfull);
+        sm4_crypt_blocks(&drbg->sm4_ctx, out, out, nfull);
+    }
+
+    if (rem)
+    {
+        uint8_t block[16];
+        drbg_fill_counters(drbg->V, block, 1);
+        sm4_crypt_blocks(&drbg->sm4_ctx, block, block, 1);
+        memcpy(out + 16 * nfull, block, rem);
+        sm4_memzero(block, sizeof(block));
+    }
+
+    drbg_update(drbg, addl);
+    drbg->reseed_counter++;
+    return 0;
+}
+
+// Generate len bytes; requests above SM4_DRBG_MAX_REQUEST are split into
+// several generate calls, each followed by its own state update
+int sm4_drbg_generate(sm4_drbg *drbg, uint8_t *out, size_t len, const uint8_t *addl, size_t addl_len)
+{
+    uint8_t padded[SM4_DRBG_SEED_LEN];
+    const uint8_t *addl_block = NULL;
+    int ret = 0;
+
+    if (!drbg || (!out && len))
+    {
+        return -1;
+    }
+
+    if (addl_len)
+    {
+        if (drbg_pad(padded, addl, addl_len) != 0)
+        {
+            return -1;
+        }
+        addl_block = padded;
+    }
+
+    while (len > 0 && ret == 0)
+    {
+        size_t n = len < SM4_DRBG_MAX_REQUEST ? len : SM4_DRBG_MAX_REQUEST;
+        ret = drbg_generate_one(drbg, out, n, addl_block);
+        out += n;
+        len -= n;
+    }
+
+    sm4_memzero(padded, sizeof(padded));
+    return ret;
+}
+
+void sm4_drbg_uninstantiate(sm4_drbg *drbg)
+{
+    if (drbg)
+    {
+        sm4_memzero(drbg, sizeof(*drbg));
+    }
+}
+
+// Make sure a per-thread instance is seeded and has not been inherited through fork()
+static int thread_rng_ready(drbg_thread_state *st)
+{
+    if (!st->seeded)
+    {
+        pthread_once(&atfork_once, drbg_register_atfork);
+        if (sm4_drbg_instantiate(&st->drbg, NULL, 0, NULL, 0) != 0)
+        {
+            return -1;
+        }
+        st->pool_pos = DRBG_POOL_SIZE;
+        st->fork_gen = fork_generation;
+        st->seeded = 1;
+    }
+    else if (st->fork_gen != fork_generation)
+    {
+        // Forked child: never repeat the parent's stream
+        sm4_memzero(st->pool, sizeof(st->pool));
+        st->pool_pos = DRBG_POOL_SIZE;
+        st->fork_gen = fork_generation;
+        if (sm4_drbg_reseed(&st->drbg, NULL, 0, NULL, 0) != 0)
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+// Random bytes from one of the calling thread's instances
+static int thread_rng_read(drbg_thread_state *st, uint8_t *buf, size_t len)
+{
+    if (!buf && len)
+    {
+        return -1;
+    }
+    if (thread_rng_ready(st) != 0)
+    {
+        return -1;
+    }
+
+    if (len > DRBG_POOL_MAX_REQUEST)
+    {
+        return sm4_drbg_generate(&st->drbg, buf, len, NULL, 0);
+    }
+
+    while (len > 0)
+    {
+        if (st->pool_pos == DRBG_POOL_SIZE)
+        {
+            if (sm4_drbg_generate(&st->drbg, st->pool, DRBG_POOL_SIZE, NULL, 0) != 0)
+            {
+                return -1;
+            }
+            st->pool_pos = 0;
+        }
+
+        size_t n = DRBG_POOL_SIZE - st->pool_pos;
+        if (n > len)
+        {
+            n = len;
+        }
+        memcpy(buf, st->pool + st->pool_pos, n);
+        // Served bytes are wiped so they cannot be handed out twice
+        sm4_memzero(st->pool + st->pool_pos, n);
+        st->pool_pos += n;
+        buf += n;
+        len -= n;
+    }
+
+    return 0;
+}
+
+int sm4_random_bytes(uint8_t *buf, size_t len)
+{
+    return thread_rng_read(&thread_rng, buf, len);
+}
+
+// Fresh random IV/nonce for GCM and GMAC
+int sm4_gcm_generate_iv(uint8_t *iv, size_t iv_len)
+{
+    if (!iv || iv_len == 0)
+    {
+        return -1;
+    }
+    return sm4_random_bytes(iv, iv_len);
+}
+
+// Random number generation for testing
+// sm4_srand() switches this thread's test stream to a deterministic DRBG so
+// that tests are reproducible; without it the stream is seeded from
+// getrandom(). sm4_random_bytes() and IVs never read from this stream.
+void sm4_srand(uint32_t seed)
+{
+    drbg_thread_state *st = &thread_test_rng;
+    uint8_t entropy[SM4_DRBG_SEED_LEN] = {0};
+    static const uint8_t pers[] = "sm4_srand";
+
+    entropy[0] = (uint8_t)(seed >> 24);
+    entropy[1] = (uint8_t)(seed >> 16);
+    entropy[2] = (uint8_t)(seed >> 8);
+    entropy[3] = (uint8_t)seed;
+
+    sm4_drbg_instantiate(&st->drbg, entropy, sizeof(entropy), pers, sizeof(pers) - 1);
+    sm4_memzero(st->pool, sizeof(st->pool));
+    pthread_once(&atfork_once, drbg_register_atfork);
+    st->pool_pos = DRBG_POOL_SIZE;
+    st->fork_gen = fork_generation;
+    st->seeded = 1;
+}
+
+uint32_t sm4_rand(void)
+{
+    uint8_t b[4] = {0};
+    thread_rng_read(&thread_test_rng, b, sizeof(b));
+    return ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) | b[3];
+}
+
+void sm4_rand_bytes(uint8_t *buf, size_t len)
+{
+    thread_rng_read(&thread_test_rng, buf, len);
+}
@@ -1,136 +1,12 @@
 #include "sm4.h"
 #include <string.h>
-#include <stdlib.h>
 
 // SM4-GCM Optimized implementation
 // Uses optimized SM4 kernel and faster GHASH
 
-// Precomputed GHASH table for optimization
-typedef struct
-{
-    uint8_t table[16][256][16];
-} ghash_table_t;
-
-// Global GHASH lookup table
-static ghash_table_t ghash_lut;
-static int ghash_table_initialized = 0;
-
-// Fast GF(2^128) multiplication using 4-bit table lookup
-static void gf128_mul_fast(const uint8_t *x, const uint8_t *y, uint8_t *result)
-{
-    uint8_t z[16] = {0};
-
-    // Use byte-wise processing for better performance
-    for (int i = 0; i < 16; i++)
-    {
-        uint8_t xi = x[i];
-        if (xi == 0)
-            continue;
-
-        uint8_t v[16];
-        memcpy(v, y, 16);
-
-        // Process each bit of the byte
-        for (int j = 0; j < 8; j++)
-        {
-            if (xi & (0x80 >> j))
-            {
-                for (int k = 0; k < 16; k++)
-                {
-                    z[k] ^= v[k];
-                }
-            }
-
-            // Right shift v with conditional XOR
-            uint8_t carry = v[15] & 1;
-            for (int k = 15; k > 0; k--)
-            {
-                v[k] = (v[k] >> 1) | ((v[k - 1] & 1) << 7);
-            }
-            v[0] >>= 1;
-
-            if (carry)
-            {
-                v[0] ^= 0xe1;
-            }
-        }
-    }
-
-    memcpy(result, z, 16);
-}
-
-// Initialize GHASH table for a given H
-static void init_ghash_table(const uint8_t *H)
-{
-    if (ghash_table_initialized)
-        return;
-
-    memset(&ghash_lut, 0, sizeof(ghash_lut));
-
-    // Precompute H^i for i = 1 to 16
-    uint8_t Hi[16];
-    memcpy(Hi, H, 16);
-
-    for (int i = 0; i < 16; i++)
-    {
-        // For each byte position
-        for (int j = 1; j < 256; j++)
-        {
-            uint8_t byte_val[16] = {0};
-            byte_val[i] = j;
-            gf128_mul_fast(byte_val, Hi, ghash_lut.table[i][j]);
-        }
-
-        // Update Hi = Hi * H for next iteration
-        if (i < 15)
-        {
-            uint8_t temp[16];
-            gf128_mul_fast(Hi, H, temp);
-            memcpy(Hi, temp, 16);
-        }
-    }
-
-    ghash_table_initialized = 1;
-}
-
-// Fast GHASH using lookup table
-static void ghash_fast(const uint8_t *H, const uint8_t *X, size_t X_len, uint8_t *result)
-{
-    uint8_t Y[16] = {0};
-
-    // Initialize lookup table if needed
-    init_ghash_table(H);
-
-    for (size_t i = 0; i < X_len; i += 16)
-    {
-        size_t block_len = (X_len - i) < 16 ? (X_len - i) : 16;
-        uint8_t block[16] = {0};
-
-        memcpy(block, X + i, block_len);
-
-        // Y = Y ⊕ X_i
-        for (int j = 0; j < 16; j++)
-        {
-            Y[j] ^= block[j];
-        }
-
-        // Fast GHASH using table lookup
-        uint8_t result_temp[16] = {0};
-        for (int j = 0; j < 16; j++)
-        {
-            if (Y[j] != 0)
-            {
-                for (int k = 0; k < 16; k++)
-                {
-                    result_temp[k] ^= ghash_lut.table[j][Y[j]][k];
-                }
-            }
-        }
-        memcpy(Y, result_temp, 16);
-    }
-
-    memcpy(result, Y, 16);
-}
+// GHASH goes through the per-key sm4_ghash_key (sm4_ghash.c), built by
+// sm4_gcm_setkey_opt(): nothing is shared between contexts or threads, and
+// the only setup cost is the key's own 4-bit table / H powers.
 
 // Optimized counter increment
 static inline void inc_counter_fast(uint8_t *counter)
@@ -155,8 +31,8 @@ int sm4_gcm_setkey_opt(sm4_gcm_context *ctx, const uint8_t *key, unsigned int ke
     uint8_t zero_block[16] = {0};
     sm4_crypt_ecb(&ctx->sm4_ctx, 1, zero_block, ctx->H);
 
-    // Initialize GHASH table
-    init_ghash_table(ctx->H);
+    // Per-key GHASH tables
+    sm4_ghash_setkey(&ctx->gkey, ctx->H);
 
     return 0;
 }
@@ -166,31 +42,8 @@ int sm4_gcm_starts_opt(sm4_gcm_context *ctx, int mode, const uint8_t *iv, size_t
 {
     uint8_t J0[16];
 
-    if (iv_len == 12)
-    {
-        // Fast path for 96-bit IV
-        memcpy(J0, iv, 12);
-        *(uint32_t *)(J0 + 12) = 0x01000000; // Big-endian 1
-    }
-    else
-    {
-        // General case with optimized GHASH
-        size_t iv_padded_len = ((iv_len + 15) / 16) * 16;
-        uint8_t *iv_padded = malloc(iv_padded_len + 16);
-
-        memset(iv_padded, 0, iv_padded_len + 16);
-        memcpy(iv_padded, iv, iv_len);
-
-        // Append length in big-endian format
-        uint64_t iv_len_bits = iv_len * 8;
-        for (int i = 0; i < 8; i++)
-        {
-            iv_padded[iv_padded_len + 8 + i] = (iv_len_bits >> (56 - 8 * i)) & 0xFF;
-        }
-
-        ghash_fast(ctx->H, iv_padded, iv_padded_len + 16, J0);
-        free(iv_padded);
-    }
+    // 96-bit fast path, GHASH(IV || pad || [len(IV)]_64) otherwise
+    sm4_ghash_j0(&ctx->gkey, iv, iv_len, J0);
 
     memcpy(ctx->base_ectr, J0, 16);
     memcpy(ctx->y, J0, 16);
@@ -225,6 +78,8 @@ int sm4_gcm_update_opt(sm4_gcm_context *ctx, const uint8_t *input, uint8_t *outp
         offset += use_len;
     }
 
+    // sm4_gcm_finish() encodes this in the length block
+    ctx->len += length;
     return 0;
 }
 
@@ -0,0 +1,149 @@
+#include "sm4.h"
+#include <string.h>
+
+// SM4-GCM on a prepared key
+// Key schedule, H and the GHASH tables come from sm4_prepare_key(), so a call
+// only does the per-message work: J0, CTR through the multi-block kernel and
+// GHASH over AAD and ciphertext.
+
+// Counter blocks generated per sm4_crypt_blocks() call
+#define GCM_CTR_BATCH 32
+
+static inline uint32_t get_u32_be(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8) | ((uint32_t)p[3]);
+}
+
+static inline void put_u32_be(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+static inline void put_u64_be(uint8_t *p, uint64_t v)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        p[i] = (uint8_t)(v >> (56 - 8 * i));
+    }
+}
+
+void sm4_prepare_key(sm4_prepared_key *pk, const uint8_t key[SM4_KEY_SIZE])
+{
+    uint8_t H[16] = {0};
+
+    sm4_setkey_enc(&pk->enc, key);
+    sm4_setkey_dec(&pk->dec, key);
+    sm4_crypt_blocks(&pk->enc, H, H, 1);
+    sm4_ghash_setkey(&pk->gkey, H);
+    sm4_memzero(H, sizeof(H));
+}
+
+// out = in ^ E(inc32(J0)), E(inc32^2(J0)), ...
+static void gcm_ctr(const sm4_prepared_key *pk, const uint8_t J0[16],
+                    const uint8_t *in, uint8_t *out, size_t len)
+{
+    uint8_t ks[GCM_CTR_BATCH * 16];
+    uint32_t ctr = get_u32_be(J0 + 12);
+
+    while (len > 0)
+    {
+        size_t n = len < sizeof(ks) ? len : sizeof(ks);
+        size_t nblocks = (n + 15) / 16;
+
+        for (size_t b = 0; b < nblocks; b++)
+        {
+            memcpy(ks + 16 * b, J0, 12);
+            put_u32_be(ks + 16 * b + 12, ++ctr);
+        }
+        sm4_crypt_blocks(&pk->enc, ks, ks, nblocks);
+
+        for (size_t i = 0; i < n; i++)
+        {
+            out[i] = in[i] ^ ks[i];
+        }
+
+        in += n;
+        out += n;
+        len -= n;
+    }
+
+    sm4_memzero(ks, sizeof(ks));
+}
+
+// S = GHASH(A || pad || C || pad || [len(A)]_64 || [len(C)]_64), tag = S ^ E(J0)
+static void gcm_tag(const sm4_prepared_key *pk, const uint8_t J0[16],
+                    const uint8_t *aad, size_t aad_len,
+                    const uint8_t *ct, size_t ct_len, uint8_t tag[16])
+{
+    uint8_t X[16] = {0};
+    uint8_t len_block[16];
+    uint8_t ek0[16];
+
+    sm4_ghash_update_padded(&pk->gkey, X, aad, aad_len);
+    sm4_ghash_update_padded(&pk->gkey, X, ct, ct_len);
+
+    put_u64_be(len_block, (uint64_t)aad_len * 8);
+    put_u64_be(len_block + 8, (uint64_t)ct_len * 8);
+    sm4_ghash_blocks(&pk->gkey, X, len_block, 1);
+
+    sm4_crypt_blocks(&pk->enc, J0, ek0, 1);
+    for (int i = 0; i < 16; i++)
+    {
+        tag[i] = X[i] ^ ek0[i];
+    }
+    sm4_memzero(ek0, sizeof(ek0));
+}
+
+int sm4_gcm_encrypt_prepared(const sm4_prepared_key *pk, const uint8_t *iv, size_t iv_len,
+                             const uint8_t *aad, size_t aad_len,
+                             const uint8_t *plaintext, size_t pt_len,
+                             uint8_t *ciphertext, uint8_t *tag, size_t tag_len)
+{
+    uint8_t J0[16];
+    uint8_t full_tag[16];
+
+    if (!pk || !iv || iv_len == 0 || !tag || tag_len < SM4_GCM_MIN_TAG_LEN || tag_len > 16 ||
+        (!aad && aad_len) || ((!plaintext || !ciphertext) && pt_len))
+    {
+        return -1;
+    }
+
+    sm4_ghash_j0(&pk->gkey, iv, iv_len, J0);
+    gcm_ctr(pk, J0, plaintext, ciphertext, pt_len);
+    gcm_tag(pk, J0, aad, aad_len, ciphertext, pt_len, full_tag);
+
+    memcpy(tag, full_tag, tag_len);
+    return 0;
+}
+
+// The tag is checked before any plaintext is released
+int sm4_gcm_decrypt_prepared(const sm4_prepared_key *pk, const uint8_t *iv, size_t iv_len,
+                             const uint8_t *aad, size_t aad_len,
+                             const uint8_t *ciphertext, size_t ct_len,
+                             const uint8_t *tag, size_t tag_len,
+                             uint8_t *plaintext)
+{
+    uint8_t J0[16];
+    uint8_t computed_tag[16];
+
+    if (!pk || !iv || iv_len == 0 || !tag || tag_len < SM4_GCM_MIN_TAG_LEN || tag_len > 16 ||
+        (!aad && aad_len) || ((!plaintext || !ciphertext) && ct_len))
+    {
+        return -1;
+    }
+
+    sm4_ghash_j0(&pk->gkey, iv, iv_len, J0);
+    gcm_tag(pk, J0, aad, aad_len, ciphertext, ct_len, computed_tag);
+
+    if (sm4_memcmp_const_time(tag, computed_tag, tag_len) != 0)
+    {
+        return -2; // Authentication failure
+    }
+
+    gcm_ctr(pk, J0, ciphertext, plaintext, ct_len);
+    return 0;
+}
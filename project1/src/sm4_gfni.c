@@ -1,4 +1,4 @@
-#include "sm4.h"
+#include "sm4_internal.h"
 #include <immintrin.h>
 
 #ifdef __GFNI__
@@ -321,4 +321,159 @@ void sm4_gfni_decrypt(const uint8_t *key, const uint8_t *input, uint8_t *output)
     sm4_basic_decrypt(key, input, output);
 }
 
+#ifdef __AVX512F__
+
+// 16-block SM4 kernel: the S-box is computed as two GF(2^8) affine maps around
+// an inversion, using the isomorphism between the SM4 field (x^8+x^7+x^6+x^5+x^4+x^2+1)
+// and the AES field that gf2p8affineinv works in:
+//   S(x) = A * inv(A*x + c) + c  ==  M2 * inv_aes(M1*x + b1) + c
+static const uint64_t SM4_GFNI_PRE_MATRIX = 0x4c287db91a22505dULL;  // M1 = phi * A
+static const uint8_t SM4_GFNI_PRE_CONST = 0x3e;                     // b1 = phi(c)
+static const uint64_t SM4_GFNI_POST_MATRIX = 0xf3ab34a974a6b589ULL; // M2 = A * phi^-1
+static const uint8_t SM4_GFNI_POST_CONST = 0xd3;                    // c
+
+static inline __m512i sm4_sbox_gfni_x16(__m512i x)
+{
+    const __m512i pre = _mm512_set1_epi64((long long)SM4_GFNI_PRE_MATRIX);
+    const __m512i post = _mm512_set1_epi64((long long)SM4_GFNI_POST_MATRIX);
+    x = _mm512_gf2p8affine_epi64_epi8(x, pre, SM4_GFNI_PRE_CONST);
+    return _mm512_gf2p8affineinv_epi64_epi8(x, post, SM4_GFNI_POST_CONST);
+}
+
+// Byte swap within each 32-bit word (AVX512F only, no vpshufb needed)
+static inline __m512i bswap32_x16(__m512i x)
+{
+    const __m512i lo = _mm512_set1_epi32(0x00ff00ff);
+    __m512i a = _mm512_rol_epi32(_mm512_and_si512(x, lo), 24);
+    __m512i b = _mm512_rol_epi32(_mm512_andnot_si512(lo, x), 8);
+    return _mm512_or_si512(a, b);
+}
+
+// 4x4 transpose of 32-bit words inside each 128-bit lane
+#define SM4_TRANSPOSE_X16(r0, r1, r2, r3)           \
+    do                                              \
+    {                                               \
+        __m512i t0 = _mm512_unpacklo_epi32(r0, r1); \
+        __m512i t1 = _mm512_unpackhi_epi32(r0, r1); \
+        __m512i t2 = _mm512_unpacklo_epi32(r2, r3); \
+        __m512i t3 = _mm512_unpackhi_epi32(r2, r3); \
+        r0 = _mm512_unpacklo_epi64(t0, t2);         \
+        r1 = _mm512_unpackhi_epi64(t0, t2);         \
+        r2 = _mm512_unpacklo_epi64(t1, t3);         \
+        r3 = _mm512_unpackhi_epi64(t1, t3);         \
+    } while (0)
+
+// X0 ^= L(S(X1 ^ X2 ^ X3 ^ rk)) for 16 blocks at once
+#define SM4_ROUND_X16(x0, x1, x2, x3, rk)                               \
+    do                                                                  \
+    {                                                                   \
+        __m512i t = _mm512_ternarylogic_epi32(x1, x2, x3, 0x96);        \
+        t = sm4_sbox_gfni_x16(_mm512_xor_si512(t, _mm512_set1_epi32((int)(rk)))); \
+        __m512i l = _mm512_ternarylogic_epi32(t, _mm512_rol_epi32(t, 2),  \
+                                              _mm512_rol_epi32(t, 10), 0x96); \
+        l = _mm512_ternarylogic_epi32(l, _mm512_rol_epi32(t, 18),       \
+                                      _mm512_rol_epi32(t, 24), 0x96);   \
+        x0 = _mm512_xor_si512(x0, l);                                   \
+    } while (0)
+
+static void sm4_crypt_x16_gfni(const uint32_t rk[SM4_ROUNDS], const uint8_t *in, uint8_t *out)
+{
+    __m512i x0 = bswap32_x16(_mm512_loadu_si512((const void *)(in)));
+    __m512i x1 = bswap32_x16(_mm512_loadu_si512((const void *)(in + 64)));
+    __m512i x2 = bswap32_x16(_mm512_loadu_si512((const void *)(in + 128)));
+    __m512i x3 = bswap32_x16(_mm512_loadu_si512((const void *)(in + 192)));
+
+    SM4_TRANSPOSE_X16(x0, x1, x2, x3);
+
+    for (int i = 0; i < SM4_ROUNDS; i += 4)
+    {
+        SM4_ROUND_X16(x0, x1, x2, x3, rk[i]);
+        SM4_ROUND_X16(x1, x2, x3, x0, rk[i + 1]);
+        SM4_ROUND_X16(x2, x3, x0, x1, rk[i + 2]);
+        SM4_ROUND_X16(x3, x0, x1, x2, rk[i + 3]);
+    }
+
+    // Output is (X35, X34, X33, X32)
+    SM4_TRANSPOSE_X16(x3, x2, x1, x0);
+
+    _mm512_storeu_si512((void *)(out), bswap32_x16(x3));
+    _mm512_storeu_si512((void *)(out + 64), bswap32_x16(x2));
+    _mm512_storeu_si512((void *)(out + 128), bswap32_x16(x1));
+    _mm512_storeu_si512((void *)(out + 192), bswap32_x16(x0));
+}
+
+// Two independent 16-block groups interleaved round by round, so the
+// GFNI latency of one group is hidden behind the other
+static void sm4_crypt_x32_gfni(const uint32_t rk[SM4_ROUNDS], const uint8_t *in, uint8_t *out)
+{
+    __m512i a0 = bswap32_x16(_mm512_loadu_si512((const void *)(in)));
+    __m512i a1 = bswap32_x16(_mm512_loadu_si512((const void *)(in + 64)));
+    __m512i a2 = bswap32_x16(_mm512_loadu_si512((const void *)(in + 128)));
+    __m512i a3 = bswap32_x16(_mm512_loadu_si512((const void *)(in + 192)));
+    __m512i b0 = bswap32_x16(_mm512_loadu_si512((const void *)(in + 256)));
+    __m512i b1 = bswap32_x16(_mm512_loadu_si512((const void *)(in + 320)));
+    __m512i b2 = bswap32_x16(_mm512_loadu_si512((const void *)(in + 384)));
+    __m512i b3 = bswap32_x16(_mm512_loadu_si512((const void *)(in + 448)));
+
+    SM4_TRANSPOSE_X16(a0, a1, a2, a3);
+    SM4_TRANSPOSE_X16(b0, b1, b2, b3);
+
+    for (int i = 0; i < SM4_ROUNDS; i += 4)
+    {
+        SM4_ROUND_X16(a0, a1, a2, a3, rk[i]);
+        SM4_ROUND_X16(b0, b1, b2, b3, rk[i]);
+        SM4_ROUND_X16(a1, a2, a3, a0, rk[i + 1]);
+        SM4_ROUND_X16(b1, b2, b3, b0, rk[i + 1]);
+        SM4_ROUND_X16(a2, a3, a0, a1, rk[i + 2]);
+        SM4_ROUND_X16(b2, b3, b0, b1, rk[i + 2]);
+        SM4_ROUND_X16(a3, a0, a1, a2, rk[i + 3]);
+        SM4_ROUND_X16(b3, b0, b1, b2, rk[i + 3]);
+    }
+
+    SM4_TRANSPOSE_X16(a3, a2, a1, a0);
+    SM4_TRANSPOSE_X16(b3, b2, b1, b0);
+
+    _mm512_storeu_si512((void *)(out), bswap32_x16(a3));
+    _mm512_storeu_si512((void *)(out + 64), bswap32_x16(a2));
+    _mm512_storeu_si512((void *)(out + 128), bswap32_x16(a1));
+    _mm512_storeu_si512((void *)(out + 192), bswap32_x16(a0));
+    _mm512_storeu_si512((void *)(out + 256), bswap32_x16(b3));
+    _mm512_storeu_si512((void *)(out + 320), bswap32_x16(b2));
+    _mm512_storeu_si512((void *)(out + 384), bswap32_x16(b1));
+    _mm512_storeu_si512((void *)(out + 448), bswap32_x16(b0));
+}
+
+// Encrypt or decrypt nblocks independent blocks (direction comes from the key schedule)
+void sm4_crypt_blocks_gfni(const sm4_context *ctx, const uint8_t *input, uint8_t *output, size_t nblocks)
+{
+    while (nblocks >= 32)
+    {
+        sm4_crypt_x32_gfni(ctx->rk, input, output);
+        input += 32 * SM4_BLOCK_SIZE;
+        output += 32 * SM4_BLOCK_SIZE;
+        nblocks -= 32;
+    }
+
+    if (nblocks >= 16)
+    {
+        sm4_crypt_x16_gfni(ctx->rk, input, output);
+        input += 16 * SM4_BLOCK_SIZE;
+        output += 16 * SM4_BLOCK_SIZE;
+        nblocks -= 16;
+    }
+
+    if (nblocks)
+    {
+        // Tail: run a full 16-block pass over a padded copy
+        uint8_t buf[16 * SM4_BLOCK_SIZE];
+        memset(buf, 0, sizeof(buf));
+        memcpy(buf, input, nblocks * SM4_BLOCK_SIZE);
+        sm4_crypt_x16_gfni(ctx->rk, buf, buf);
+        memcpy(output, buf, nblocks * SM4_BLOCK_SIZE);
+        sm4_wipe(buf, sizeof(buf));
+    }
+}
+
+#endif // __AVX512F__
+
 #endif // __GFNI__
@@ -0,0 +1,321 @@
+#include "sm4.h"
+#include <string.h>
+
+#ifdef __PCLMUL__
+#include <wmmintrin.h>
+#include <tmmintrin.h>
+#endif
+
+// GHASH core shared by GMAC and the optimized GCM paths
+// Two backends, selected once per key in sm4_ghash_setkey():
+//   - PCLMULQDQ with aggregated reduction over SM4_GHASH_AGG_BLOCKS blocks
+//   - Portable 4-bit table (Shoup's method) for hosts without carry-less multiply
+
+static inline uint64_t get_u64_be(const uint8_t *p)
+{
+    return ((uint64_t)p[0] << 56) | ((uint64_t)p[1] << 48) |
+           ((uint64_t)p[2] << 40) | ((uint64_t)p[3] << 32) |
+           ((uint64_t)p[4] << 24) | ((uint64_t)p[5] << 16) |
+           ((uint64_t)p[6] << 8) | ((uint64_t)p[7]);
+}
+
+static inline void put_u64_be(uint8_t *p, uint64_t v)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        p[i] = (uint8_t)(v >> (56 - 8 * i));
+    }
+}
+
+// Reduction constants for the 4-bit table method (R = 0xe1 || 0^120)
+static const uint64_t ghash_last4[16] = {
+    0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+    0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0};
+
+// Build the per-key 4-bit multiplication table
+static void ghash_table_init(sm4_ghash_key *gk)
+{
+    uint64_t vh = get_u64_be(gk->H);
+    uint64_t vl = get_u64_be(gk->H + 8);
+    int i, j;
+
+    gk->HL[8] = vl;
+    gk->HH[8] = vh;
+    gk->HL[0] = 0;
+    gk->HH[0] = 0;
+
+    for (i = 4; i > 0; i >>= 1)
+    {
+        uint64_t T = (vl & 1) * 0xe1000000ULL;
+        vl = (vh << 63) | (vl >> 1);
+        vh = (vh >> 1) ^ (T << 32);
+        gk->HL[i] = vl;
+        gk->HH[i] = vh;
+    }
+
+    for (i = 2; i <= 8; i *= 2)
+    {
+        vh = gk->HH[i];
+        vl = gk->HL[i];
+        for (j = 1; j < i; j++)
+        {
+            gk->HH[i + j] = vh ^ gk->HH[j];
+            gk->HL[i + j] = vl ^ gk->HL[j];
+        }
+    }
+}
+
+// X = X * H using the 4-bit table
+static void ghash_mult_table(const sm4_ghash_key *gk, uint8_t X[16])
+{
+    uint8_t lo = X[15] & 0x0f;
+    uint64_t zh = gk->HH[lo];
+    uint64_t zl = gk->HL[lo];
+    int i;
+
+    for (i = 15; i >= 0; i--)
+    {
+        uint8_t hi = (X[i] >> 4) & 0x0f;
+        uint8_t rem;
+        lo = X[i] & 0x0f;
+
+        if (i != 15)
+        {
+            rem = (uint8_t)(zl & 0x0f);
+            zl = (zh << 60) | (zl >> 4);
+            zh = (zh >> 4) ^ (ghash_last4[rem] << 48);
+            zh ^= gk->HH[lo];
+            zl ^= gk->HL[lo];
+        }
+
+        rem = (uint8_t)(zl & 0x0f);
+        zl = (zh << 60) | (zl >> 4);
+        zh = (zh >> 4) ^ (ghash_last4[rem] << 48);
+        zh ^= gk->HH[hi];
+        zl ^= gk->HL[hi];
+    }
+
+    put_u64_be(X, zh);
+    put_u64_be(X + 8, zl);
+}
+
+static void ghash_blocks_table(const sm4_ghash_key *gk, uint8_t X[16], const uint8_t *data, size_t nblocks)
+{
+    while (nblocks--)
+    {
+        for (int j = 0; j < 16; j++)
+        {
+            X[j] ^= data[j];
+        }
+        ghash_mult_table(gk, X);
+        data += 16;
+    }
+}
+
+#ifdef __PCLMUL__
+
+// Byte-reflected representation: blocks are byte-reversed on load so that
+// the carry-less product can be computed with plain 64x64 multiplies.
+static inline __m128i ghash_bswap(__m128i x)
+{
+    const __m128i mask = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    return _mm_shuffle_epi8(x, mask);
+}
+
+// Unreduced 256-bit product a*b accumulated into (*lo, *mid, *hi)
+static inline void clmul_acc(__m128i a, __m128i b, __m128i *lo, __m128i *mid, __m128i *hi)
+{
+    *lo = _mm_xor_si128(*lo, _mm_clmulepi64_si128(a, b, 0x00));
+    *hi = _mm_xor_si128(*hi, _mm_clmulepi64_si128(a, b, 0x11));
+    *mid = _mm_xor_si128(*mid, _mm_clmulepi64_si128(a, b, 0x01));
+    *mid = _mm_xor_si128(*mid, _mm_clmulepi64_si128(a, b, 0x10));
+}
+
+// Shift the 256-bit product left by one and reduce modulo x^128 + x^7 + x^2 + x + 1
+static inline __m128i ghash_reduce(__m128i lo, __m128i mid, __m128i hi)
+{
+    __m128i t3, t6, t7, t8, t9, t2, t4, t5;
+
+    t3 = _mm_xor_si128(lo, _mm_slli_si128(mid, 8));
+    t6 = _mm_xor_si128(hi, _mm_srli_si128(mid, 8));
+
+    t7 = _mm_srli_epi32(t3, 31);
+    t8 = _mm_srli_epi32(t6, 31);
+    t3 = _mm_slli_epi32(t3, 1);
+    t6 = _mm_slli_epi32(t6, 1);
+    t9 = _mm_srli_si128(t7, 12);
+    t8 = _mm_slli_si128(t8, 4);
+    t7 = _mm_slli_si128(t7, 4);
+    t3 = _mm_or_si128(t3, t7);
+    t6 = _mm_or_si128(t6, t8);
+    t6 = _mm_or_si128(t6, t9);
+
+    t7 = _mm_slli_epi32(t3, 31);
+    t8 = _mm_slli_epi32(t3, 30);
+    t9 = _mm_slli_epi32(t3, 25);
+    t7 = _mm_xor_si128(t7, t8);
+    t7 = _mm_xor_si128(t7, t9);
+    t8 = _mm_srli_si128(t7, 4);
+    t7 = _mm_slli_si128(t7, 12);
+    t3 = _mm_xor_si128(t3, t7);
+
+    t2 = _mm_srli_epi32(t3, 1);
+    t4 = _mm_srli_epi32(t3, 2);
+    t5 = _mm_srli_epi32(t3, 7);
+    t2 = _mm_xor_si128(t2, t4);
+    t2 = _mm_xor_si128(t2, t5);
+    t2 = _mm_xor_si128(t2, t8);
+    t3 = _mm_xor_si128(t3, t2);
+
+    return _mm_xor_si128(t6, t3);
+}
+
+static inline __m128i gfmul_clmul(__m128i a, __m128i b)
+{
+    __m128i lo = _mm_setzero_si128();
+    __m128i mid = _mm_setzero_si128();
+    __m128i hi = _mm_setzero_si128();
+    clmul_acc(a, b, &lo, &mid, &hi);
+    return ghash_reduce(lo, mid, hi);
+}
+
+static void ghash_powers_init(sm4_ghash_key *gk)
+{
+    __m128i h = ghash_bswap(_mm_loadu_si128((const __m128i *)gk->H));
+    __m128i p = h;
+
+    _mm_storeu_si128((__m128i *)gk->Hpow[0], h);
+    for (int i = 1; i < SM4_GHASH_AGG_BLOCKS; i++)
+    {
+        p = gfmul_clmul(p, h);
+        _mm_storeu_si128((__m128i *)gk->Hpow[i], p);
+    }
+}
+
+static void ghash_blocks_clmul(const sm4_ghash_key *gk, uint8_t X[16], const uint8_t *data, size_t nblocks)
+{
+    __m128i x = ghash_bswap(_mm_loadu_si128((const __m128i *)X));
+    __m128i hp[SM4_GHASH_AGG_BLOCKS];
+    int i;
+
+    for (i = 0; i < SM4_GHASH_AGG_BLOCKS; i++)
+    {
+        hp[i] = _mm_loadu_si128((const __m128i *)gk->Hpow[i]);
+    }
+
+    // Aggregated reduction: X' = (X ^ C0)*H^8 ^ C1*H^7 ^ ... ^ C7*H, one reduction per 8 blocks
+    while (nblocks >= SM4_GHASH_AGG_BLOCKS)
+    {
+        __m128i lo = _mm_setzero_si128();
+        __m128i mid = _mm_setzero_si128();
+        __m128i hi = _mm_setzero_si128();
+
+        __m128i c = ghash_bswap(_mm_loadu_si128((const __m128i *)data));
+        clmul_acc(_mm_xor_si128(x, c), hp[SM4_GHASH_AGG_BLOCKS - 1], &lo, &mid, &hi);
+        for (i = 1; i < SM4_GHASH_AGG_BLOCKS; i++)
+        {
+            c = ghash_bswap(_mm_loadu_si128((const __m128i *)(data + 16 * i)));
+            clmul_acc(c, hp[SM4_GHASH_AGG_BLOCKS - 1 - i], &lo, &mid, &hi);
+        }
+        x = ghash_reduce(lo, mid, hi);
+
+        data += 16 * SM4_GHASH_AGG_BLOCKS;
+        nblocks -= SM4_GHASH_AGG_BLOCKS;
+    }
+
+    while (nblocks--)
+    {
+        __m128i c = ghash_bswap(_mm_loadu_si128((const __m128i *)data));
+        x = gfmul_clmul(_mm_xor_si128(x, c), hp[0]);
+        data += 16;
+    }
+
+    _mm_storeu_si128((__m128i *)X, ghash_bswap(x));
+}
+
+#endif // __PCLMUL__
+
+// Prepare per-key GHASH state for H = E_K(0^128)
+void sm4_ghash_setkey(sm4_ghash_key *gk, const uint8_t H[16])
+{
+    memset(gk, 0, sizeof(*gk));
+    memcpy(gk->H, H, 16);
+
+    ghash_table_init(gk);
+
+#ifdef __PCLMUL__
+    // CPUID is expensive (it traps under most hypervisors), so probe once.
+    // Racing threads store the same value, so a relaxed atomic is enough.
+    static int pclmul_supported = -1;
+    int pclmul = __atomic_load_n(&pclmul_supported, __ATOMIC_RELAXED);
+    if (pclmul < 0)
+    {
+        pclmul = sm4_cpu_support_pclmul();
+        __atomic_store_n(&pclmul_supported, pclmul, __ATOMIC_RELAXED);
+    }
+
+    if (pclmul)
+    {
+        ghash_powers_init(gk);
+        gk->use_pclmul = 1;
+    }
+#endif
+}
+
+// X = GHASH_H(X, data) over nblocks full 16-byte blocks
+void sm4_ghash_blocks(const sm4_ghash_key *gk, uint8_t X[16], const uint8_t *data, size_t nblocks)
+{
+#ifdef __PCLMUL__
+    if (gk->use_pclmul)
+    {
+        ghash_blocks_clmul(gk, X, data, nblocks);
+        return;
+    }
+#endif
+    ghash_blocks_table(gk, X, data, nblocks);
+}
+
+// X = GHASH_H(X, data || 0-pad) for arbitrary-length data
+void sm4_ghash_update_padded(const sm4_ghash_key *gk, uint8_t X[16], const uint8_t *data, size_t len)
+{
+    size_t full = len / 16;
+    size_t rem = len % 16;
+
+    if (full)
+    {
+        sm4_ghash_blocks(gk, X, data, full);
+    }
+    if (rem)
+    {
+        uint8_t block[16] = {0};
+        memcpy(block, data + full * 16, rem);
+        sm4_ghash_blocks(gk, X, block, 1);
+    }
+}
+
+// Pre-counter block J0 (96-bit fast path, GHASH(IV || pad || [len(IV)]_64) otherwise)
+void sm4_ghash_j0(const sm4_ghash_key *gk, const uint8_t *iv, size_t iv_len, uint8_t J0[16])
+{
+    uint8_t len_block[16] = {0};
+    uint64_t iv_len_bits = (uint64_t)iv_len * 8;
+
+    if (iv_len == 12)
+    {
+        memcpy(J0, iv, 12);
+        J0[12] = 0;
+        J0[13] = 0;
+        J0[14] = 0;
+        J0[15] = 1;
+        return;
+    }
+
+    memset(J0, 0, 16);
+    sm4_ghash_update_padded(gk, J0, iv, iv_len);
+    put_u64_be(len_block + 8, iv_len_bits);
+    sm4_ghash_blocks(gk, J0, len_block, 1);
+}
+
+const char *sm4_ghash_backend_name(const sm4_ghash_key *gk)
+{
+    return gk->use_pclmul ? "PCLMULQDQ (8-block aggregated)" : "4-bit table";
+}
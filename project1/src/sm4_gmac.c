@@ -0,0 +1,182 @@
+#include "sm4.h"
+#include <string.h>
+
+// SM4-GMAC: GCM authentication of AAD only
+// All data goes straight into the GHASH backend; no counter-mode work is done
+// apart from the single E_K(J0) block used to mask the tag.
+
+// Initialize GMAC with key and IV
+int sm4_gmac_init(sm4_gmac_context *ctx, const uint8_t *key, const uint8_t *iv, size_t iv_len)
+{
+    uint8_t H[16] = {0};
+
+    if (!ctx || !key)
+    {
+        return -1;
+    }
+
+    sm4_setkey_enc(&ctx->sm4_ctx, key);
+    sm4_crypt_ecb(&ctx->sm4_ctx, 1, H, H);
+    sm4_ghash_setkey(&ctx->gkey, H);
+    sm4_memzero(H, sizeof(H));
+
+    return sm4_gmac_reset(ctx, iv, iv_len);
+}
+
+// Start a new message under the same key (reuses the key schedule and H powers)
+int sm4_gmac_reset(sm4_gmac_context *ctx, const uint8_t *iv, size_t iv_len)
+{
+    uint8_t J0[16];
+
+    if (!ctx || !iv || iv_len == 0)
+    {
+        return -1;
+    }
+
+    sm4_ghash_j0(&ctx->gkey, iv, iv_len, J0);
+    sm4_crypt_ecb(&ctx->sm4_ctx, 1, J0, ctx->ek0);
+
+    memset(ctx->X, 0, 16);
+    memset(ctx->buf, 0, 16);
+    ctx->buf_len = 0;
+    ctx->len = 0;
+
+    return 0;
+}
+
+// Feed arbitrary-length data
+int sm4_gmac_update(sm4_gmac_context *ctx, const uint8_t *data, size_t len)
+{
+    if (!ctx || (!data && len))
+    {
+        return -1;
+    }
+
+    ctx->len += len;
+
+    // Top up a pending partial block first
+    if (ctx->buf_len)
+    {
+        size_t use_len = 16 - ctx->buf_len;
+        if (use_len > len)
+        {
+            use_len = len;
+        }
+        memcpy(ctx->buf + ctx->buf_len, data, use_len);
+        ctx->buf_len += use_len;
+        data += use_len;
+        len -= use_len;
+
+        if (ctx->buf_len < 16)
+        {
+            return 0;
+        }
+        sm4_ghash_blocks(&ctx->gkey, ctx->X, ctx->buf, 1);
+        ctx->buf_len = 0;
+    }
+
+    // Bulk data is hashed in place without copying
+    if (len >= 16)
+    {
+        size_t nblocks = len / 16;
+        sm4_ghash_blocks(&ctx->gkey, ctx->X, data, nblocks);
+        data += nblocks * 16;
+        len -= nblocks * 16;
+    }
+
+    if (len)
+    {
+        memcpy(ctx->buf, data, len);
+        ctx->buf_len = len;
+    }
+
+    return 0;
+}
+
+// Finish and produce the tag
+int sm4_gmac_final(sm4_gmac_context *ctx, uint8_t *tag, size_t tag_len)
+{
+    uint8_t len_block[16] = {0};
+    uint64_t aad_len_bits;
+
+    if (!ctx || !tag || tag_len > 16)
+    {
+        return -1;
+    }
+
+    if (ctx->buf_len)
+    {
+        memset(ctx->buf + ctx->buf_len, 0, 16 - ctx->buf_len);
+        sm4_ghash_blocks(&ctx->gkey, ctx->X, ctx->buf, 1);
+        ctx->buf_len = 0;
+    }
+
+    // len(A) || len(C) with len(C) = 0
+    aad_len_bits = ctx->len * 8;
+    for (int i = 0; i < 8; i++)
+    {
+        len_block[i] = (uint8_t)(aad_len_bits >> (56 - 8 * i));
+    }
+    sm4_ghash_blocks(&ctx->gkey, ctx->X, len_block, 1);
+
+    for (int i = 0; i < 16; i++)
+    {
+        ctx->X[i] ^= ctx->ek0[i];
+    }
+
+    memcpy(tag, ctx->X, tag_len);
+    return 0;
+}
+
+// One-shot GMAC
+int sm4_gmac(const uint8_t *key, const uint8_t *iv, size_t iv_len,
+             const uint8_t *data, size_t len, uint8_t *tag, size_t tag_len)
+{
+    sm4_gmac_context ctx;
+    int ret;
+
+    ret = sm4_gmac_init(&ctx, key, iv, iv_len);
+    if (ret == 0)
+        ret = sm4_gmac_update(&ctx, data, len);
+    if (ret == 0)
+        ret = sm4_gmac_final(&ctx, tag, tag_len);
+
+    sm4_memzero(&ctx, sizeof(ctx));
+    return ret;
+}
+
+// Multi-message GMAC under one key: the key schedule and H powers are
+// computed once and shared by every message in the batch.
+int sm4_gmac_batch(const uint8_t *key,
+                   const uint8_t *const ivs[], size_t iv_len,
+                   const uint8_t *const msgs[], const size_t lens[], size_t count,
+                   uint8_t *tags, size_t tag_len)
+{
+    sm4_gmac_context ctx;
+    int ret = 0;
+
+    if (!key || !ivs || !msgs || !lens || !tags || tag_len > 16 || iv_len == 0)
+    {
+        return -1;
+    }
+
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    ret = sm4_gmac_init(&ctx, key, ivs[0], iv_len);
+
+    for (size_t i = 0; i < count && ret == 0; i++)
+    {
+        if (i > 0)
+            ret = sm4_gmac_reset(&ctx, ivs[i], iv_len);
+        if (ret == 0)
+            ret = sm4_gmac_update(&ctx, msgs[i], lens[i]);
+        if (ret == 0)
+            ret = sm4_gmac_final(&ctx, tags + i * tag_len, tag_len);
+    }
+
+    sm4_memzero(&ctx, sizeof(ctx));
+    return ret;
+}
@@ -0,0 +1,20 @@
+#ifndef SM4_INTERNAL_H
+#define SM4_INTERNAL_H
+
+#include "sm4.h"
+
+// Helpers shared by the SM4 sources; not part of the API
+
+// Zeroing that the compiler cannot drop as a dead store. Inline so that
+// kernels linked without utils.c (test_gfni) can clear their buffers too.
+static inline void sm4_wipe(void *ptr, size_t len)
+{
+    volatile uint8_t *p = (volatile uint8_t *)ptr;
+
+    while (len--)
+    {
+        *p++ = 0;
+    }
+}
+
+#endif // SM4_INTERNAL_H
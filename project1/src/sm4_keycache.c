@@ -0,0 +1,480 @@
+#include "sm4.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <pthread.h>
+
+// Sharded cache of prepared keys
+//
+// Each shard owns a fixed slot array sized from the memory budget and an
+// open-addressing index (slot numbers, linear probing, tombstones).
+//
+// Read path (no locks): probe the index, pin the slot with a CAS on its state
+// word, then re-check the key ID.  A slot can only be recycled while its pin
+// count is zero, so a pinned slot always holds the key that was verified.
+// A reader racing with a writer may see a stale index and report a miss; it
+// can never return the wrong key.
+//
+// Write path (shard mutex): inserts, removals and CLOCK eviction.  CLOCK gives
+// every slot a second chance through its referenced bit, which approximates
+// LRU without touching shared lists on the read path.
+
+#define SLOT_LIVE 0x80000000u   // Entry is valid and may be pinned
+#define SLOT_DOOMED 0x40000000u // Removed while pinned, wiped by the last release
+#define SLOT_PINS 0x3fffffffu   // Pin count
+
+#define BUCKET_EMPTY 0u
+#define BUCKET_TOMBSTONE 1u
+#define BUCKET_SLOT(i) ((uint32_t)(i) + 2u)
+
+typedef struct
+{
+    uint64_t key_id;
+    uint32_t state;     // SLOT_LIVE | SLOT_DOOMED | pin count
+    uint8_t referenced; // CLOCK bit, set by readers
+    sm4_prepared_key pk;
+} __attribute__((aligned(64))) cache_slot;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    cache_slot *slots;
+    uint32_t nslots;
+    uint32_t fresh;      // Slots never used so far
+    uint32_t hand;       // CLOCK hand
+    uint32_t *index;     // BUCKET_* values
+    uint32_t index_mask; // Index size - 1 (power of two)
+    uint32_t tombstones;
+    uint32_t live;
+
+    // Counters (relaxed atomics, per shard to avoid a shared hot cache line)
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t insertions;
+    uint64_t evictions;
+} __attribute__((aligned(64))) cache_shard;
+
+struct sm4_key_cache
+{
+    cache_shard *shards;
+    unsigned int nshards; // Power of two
+    size_t memory_bytes;
+};
+
+// splitmix64 finalizer: key IDs are often sequential
+static inline uint64_t hash_key_id(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+static inline cache_shard *shard_for(sm4_key_cache *cache, uint64_t h)
+{
+    return &cache->shards[(h >> 48) & (cache->nshards - 1)];
+}
+
+static uint32_t next_pow2(uint32_t x)
+{
+    uint32_t p = 1;
+    while (p < x)
+    {
+        p <<= 1;
+    }
+    return p;
+}
+
+// Pin a slot if it is live; fails for free, evicting or doomed slots
+static int slot_pin(cache_slot *slot)
+{
+    uint32_t s = __atomic_load_n(&slot->state, __ATOMIC_ACQUIRE);
+
+    while (s & SLOT_LIVE)
+    {
+        if (__atomic_compare_exchange_n(&slot->state, &s, s + 1, 1,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void slot_wipe(cache_slot *slot)
+{
+    sm4_memzero(&slot->pk, sizeof(slot->pk));
+    __atomic_store_n(&slot->key_id, 0, __ATOMIC_RELAXED);
+    slot->referenced = 0;
+}
+
+sm4_key_cache *sm4_key_cache_create(size_t memory_budget, unsigned int nshards)
+{
+    sm4_key_cache *cache;
+    size_t per_entry, total_slots;
+    uint32_t per_shard, index_size;
+
+    if (nshards == 0)
+    {
+        nshards = 16;
+    }
+    nshards = next_pow2(nshards);
+
+    // Each entry costs a slot plus about two index buckets
+    per_entry = sizeof(cache_slot) + 2 * sizeof(uint32_t);
+    total_slots = memory_budget / per_entry;
+    if (total_slots < nshards || total_slots / nshards > 0x3fffffffu)
+    {
+        return NULL;
+    }
+    per_shard = (uint32_t)(total_slots / nshards);
+    index_size = next_pow2(per_shard * 2);
+
+    cache = calloc(1, sizeof(*cache));
+    if (!cache)
+    {
+        return NULL;
+    }
+    if (posix_memalign((void **)&cache->shards, 64, nshards * sizeof(cache_shard)) != 0)
+    {
+        free(cache);
+        return NULL;
+    }
+    memset(cache->shards, 0, nshards * sizeof(cache_shard));
+    cache->nshards = nshards;
+    cache->memory_bytes = sizeof(*cache) + nshards * sizeof(cache_shard);
+
+    for (unsigned int i = 0; i < nshards; i++)
+    {
+        cache_shard *sh = &cache->shards[i];
+        void *slots = NULL;
+
+        pthread_mutex_init(&sh->lock, NULL);
+        sh->nslots = per_shard;
+        sh->fresh = per_shard;
+        sh->index_mask = index_size - 1;
+        sh->index = calloc(index_size, sizeof(uint32_t));
+        if (posix_memalign(&slots, 64, per_shard * sizeof(cache_slot)) == 0)
+        {
+            sh->slots = slots;
+            memset(sh->slots, 0, per_shard * sizeof(cache_slot));
+        }
+        if (!sh->index || !sh->slots)
+        {
+            cache->nshards = i + 1;
+            sm4_key_cache_destroy(cache);
+            return NULL;
+        }
+        cache->memory_bytes += per_shard * sizeof(cache_slot) + index_size * sizeof(uint32_t);
+    }
+
+    return cache;
+}
+
+void sm4_key_cache_destroy(sm4_key_cache *cache)
+{
+    if (!cache)
+    {
+        return;
+    }
+
+    for (unsigned int i = 0; i < cache->nshards; i++)
+    {
+        cache_shard *sh = &cache->shards[i];
+        if (sh->slots)
+        {
+            sm4_memzero(sh->slots, sh->nslots * sizeof(cache_slot));
+            free(sh->slots);
+        }
+        free(sh->index);
+        pthread_mutex_destroy(&sh->lock);
+    }
+
+    free(cache->shards);
+    free(cache);
+}
+
+// Lock-free lookup; returns a pinned slot or NULL
+static cache_slot *shard_lookup(sm4_key_cache *cache, cache_shard *sh, uint64_t key_id, uint64_t h)
+{
+    uint32_t pos = (uint32_t)h & sh->index_mask;
+
+    for (uint32_t probe = 0; probe <= sh->index_mask; probe++, pos = (pos + 1) & sh->index_mask)
+    {
+        uint32_t b = __atomic_load_n(&sh->index[pos], __ATOMIC_ACQUIRE);
+
+        if (b == BUCKET_EMPTY)
+        {
+            break;
+        }
+        if (b == BUCKET_TOMBSTONE)
+        {
+            continue;
+        }
+
+        cache_slot *slot = &sh->slots[b - 2];
+        if (__atomic_load_n(&slot->key_id, __ATOMIC_RELAXED) != key_id || !slot_pin(slot))
+        {
+            continue;
+        }
+
+        // Pinned: the slot cannot be recycled now, so this check is stable
+        if (__atomic_load_n(&slot->key_id, __ATOMIC_RELAXED) == key_id)
+        {
+            if (!__atomic_load_n(&slot->referenced, __ATOMIC_RELAXED))
+            {
+                __atomic_store_n(&slot->referenced, 1, __ATOMIC_RELAXED);
+            }
+            return slot;
+        }
+        sm4_key_cache_release(cache, &slot->pk);
+    }
+
+    return NULL;
+}
+
+const sm4_prepared_key *sm4_key_cache_get(sm4_key_cache *cache, uint64_t key_id)
+{
+    uint64_t h = hash_key_id(key_id);
+    cache_shard *sh = shard_for(cache, h);
+    cache_slot *slot = shard_lookup(cache, sh, key_id, h);
+
+    if (slot)
+    {
+        __atomic_fetch_add(&sh->hits, 1, __ATOMIC_RELAXED);
+        return &slot->pk;
+    }
+
+    __atomic_fetch_add(&sh->misses, 1, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+// Index maintenance (shard lock held)
+static void index_unlink(cache_shard *sh, uint64_t key_id, uint32_t slot_idx)
+{
+    uint32_t pos = (uint32_t)hash_key_id(key_id) & sh->index_mask;
+
+    for (uint32_t probe = 0; probe <= sh->index_mask; probe++, pos = (pos + 1) & sh->index_mask)
+    {
+        uint32_t b = sh->index[pos];
+        if (b == BUCKET_EMPTY)
+        {
+            return;
+        }
+        if (b == BUCKET_SLOT(slot_idx))
+        {
+            __atomic_store_n(&sh->index[pos], BUCKET_TOMBSTONE, __ATOMIC_RELEASE);
+            sh->tombstones++;
+            return;
+        }
+    }
+}
+
+static void index_link(cache_shard *sh, uint64_t key_id, uint32_t slot_idx)
+{
+    uint32_t pos = (uint32_t)hash_key_id(key_id) & sh->index_mask;
+
+    for (;;)
+    {
+        uint32_t b = sh->index[pos];
+        if (b == BUCKET_EMPTY || b == BUCKET_TOMBSTONE)
+        {
+            if (b == BUCKET_TOMBSTONE)
+            {
+                sh->tombstones--;
+            }
+            __atomic_store_n(&sh->index[pos], BUCKET_SLOT(slot_idx), __ATOMIC_RELEASE);
+            return;
+        }
+        pos = (pos + 1) & sh->index_mask;
+    }
+}
+
+// Too many tombstones make misses probe long chains: rebuild in place.
+// Concurrent readers may miss entries during the rebuild, which is harmless.
+static void index_rebuild(cache_shard *sh)
+{
+    for (uint32_t i = 0; i <= sh->index_mask; i++)
+    {
+        __atomic_store_n(&sh->index[i], BUCKET_EMPTY, __ATOMIC_RELEASE);
+    }
+    sh->tombstones = 0;
+
+    for (uint32_t i = 0; i < sh->nslots - sh->fresh; i++)
+    {
+        if (__atomic_load_n(&sh->slots[i].state, __ATOMIC_ACQUIRE) & SLOT_LIVE)
+        {
+            index_link(sh, sh->slots[i].key_id, i);
+        }
+    }
+}
+
+// Find a slot to fill: a never-used one, a free one, or a CLOCK victim
+static int shard_claim_slot(cache_shard *sh, uint32_t *out)
+{
+    uint32_t used = sh->nslots - sh->fresh;
+
+    if (sh->fresh > 0)
+    {
+        *out = used;
+        sh->fresh--;
+        return 0;
+    }
+
+    // Two sweeps: the first may only clear referenced bits
+    for (uint32_t step = 0; step < 2 * sh->nslots; step++)
+    {
+        uint32_t i = sh->hand;
+        cache_slot *slot = &sh->slots[i];
+        uint32_t expected = SLOT_LIVE;
+
+        sh->hand = (sh->hand + 1) % sh->nslots;
+
+        if (__atomic_load_n(&slot->state, __ATOMIC_ACQUIRE) == 0)
+        {
+            *out = i;
+            return 0;
+        }
+        if (__atomic_load_n(&slot->referenced, __ATOMIC_RELAXED))
+        {
+            __atomic_store_n(&slot->referenced, 0, __ATOMIC_RELAXED);
+            continue;
+        }
+        // Only an unpinned live entry can be evicted
+        if (__atomic_compare_exchange_n(&slot->state, &expected, 0, 0,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        {
+            index_unlink(sh, slot->key_id, i);
+            slot_wipe(slot);
+            sh->live--;
+            __atomic_fetch_add(&sh->evictions, 1, __ATOMIC_RELAXED);
+            *out = i;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+const sm4_prepared_key *sm4_key_cache_put(sm4_key_cache *cache, uint64_t key_id, const uint8_t key[SM4_KEY_SIZE])
+{
+    uint64_t h = hash_key_id(key_id);
+    cache_shard *sh = shard_for(cache, h);
+    cache_slot *slot;
+    uint32_t idx;
+
+    if (!key)
+    {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&sh->lock);
+
+    // Another thread may have loaded the same key meanwhile
+    slot = shard_lookup(cache, sh, key_id, h);
+    if (slot)
+    {
+        pthread_mutex_unlock(&sh->lock);
+        return &slot->pk;
+    }
+
+    if (shard_claim_slot(sh, &idx) != 0)
+    {
+        pthread_mutex_unlock(&sh->lock);
+        return NULL;
+    }
+
+    slot = &sh->slots[idx];
+    __atomic_store_n(&slot->key_id, key_id, __ATOMIC_RELAXED);
+    sm4_prepare_key(&slot->pk, key);
+    slot->referenced = 1;
+    // Publish: live and pinned once for the caller
+    __atomic_store_n(&slot->state, SLOT_LIVE | 1u, __ATOMIC_RELEASE);
+
+    if (sh->tombstones > sh->nslots / 2)
+    {
+        index_rebuild(sh);
+    }
+    index_link(sh, key_id, idx);
+    sh->live++;
+    __atomic_fetch_add(&sh->insertions, 1, __ATOMIC_RELAXED);
+
+    pthread_mutex_unlock(&sh->lock);
+    return &slot->pk;
+}
+
+void sm4_key_cache_release(sm4_key_cache *cache, const sm4_prepared_key *pk)
+{
+    cache_slot *slot;
+    uint32_t s;
+
+    if (!pk)
+    {
+        return;
+    }
+
+    slot = (cache_slot *)((uint8_t *)pk - offsetof(cache_slot, pk));
+    s = __atomic_sub_fetch(&slot->state, 1, __ATOMIC_RELEASE);
+
+    // Last user of a removed entry wipes it and hands the slot back
+    if (s == SLOT_DOOMED && cache)
+    {
+        cache_shard *sh = shard_for(cache, hash_key_id(slot->key_id));
+        pthread_mutex_lock(&sh->lock);
+        slot_wipe(slot);
+        __atomic_store_n(&slot->state, 0, __ATOMIC_RELEASE);
+        pthread_mutex_unlock(&sh->lock);
+    }
+}
+
+int sm4_key_cache_remove(sm4_key_cache *cache, uint64_t key_id)
+{
+    uint64_t h = hash_key_id(key_id);
+    cache_shard *sh = shard_for(cache, h);
+    cache_slot *slot;
+    uint32_t idx, s;
+
+    pthread_mutex_lock(&sh->lock);
+
+    slot = shard_lookup(cache, sh, key_id, h);
+    if (!slot)
+    {
+        pthread_mutex_unlock(&sh->lock);
+        return -1;
+    }
+    idx = (uint32_t)(slot - sh->slots);
+    index_unlink(sh, key_id, idx);
+    sh->live--;
+
+    // Drop LIVE so no new pins succeed; our own pin keeps the count above zero
+    s = __atomic_load_n(&slot->state, __ATOMIC_ACQUIRE);
+    while (!__atomic_compare_exchange_n(&slot->state, &s, (s & SLOT_PINS) | SLOT_DOOMED, 1,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+    {
+    }
+
+    pthread_mutex_unlock(&sh->lock);
+
+    // Releasing our pin wipes the entry unless other users still hold it
+    sm4_key_cache_release(cache, &slot->pk);
+    return 0;
+}
+
+void sm4_key_cache_get_stats(sm4_key_cache *cache, sm4_key_cache_stats *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+
+    for (unsigned int i = 0; i < cache->nshards; i++)
+    {
+        cache_shard *sh = &cache->shards[i];
+        stats->hits += __atomic_load_n(&sh->hits, __ATOMIC_RELAXED);
+        stats->misses += __atomic_load_n(&sh->misses, __ATOMIC_RELAXED);
+        stats->insertions += __atomic_load_n(&sh->insertions, __ATOMIC_RELAXED);
+        stats->evictions += __atomic_load_n(&sh->evictions, __ATOMIC_RELAXED);
+        stats->entries += __atomic_load_n(&sh->live, __ATOMIC_RELAXED);
+        stats->capacity += sh->nslots;
+    }
+    stats->memory_bytes = cache->memory_bytes;
+}
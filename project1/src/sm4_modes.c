@@ -0,0 +1,137 @@
+#include "sm4.h"
+#include <string.h>
+
+// ECB, CTR and CBC on top of the multi-block dispatcher
+// ECB, CTR and CBC decryption have independent blocks and go through
+// sm4_crypt_blocks() in batches; CBC encryption is inherently serial.
+
+// Blocks handed to the kernel per call
+#define MODES_BATCH 32
+
+int sm4_ecb_crypt(const sm4_context *ctx, const uint8_t *input, uint8_t *output, size_t len)
+{
+    if (!ctx || (len % SM4_BLOCK_SIZE) != 0 || ((!input || !output) && len))
+    {
+        return -1;
+    }
+
+    sm4_crypt_blocks(ctx, input, output, len / SM4_BLOCK_SIZE);
+    return 0;
+}
+
+// 128-bit big-endian increment
+static inline void ctr_increment(uint8_t ctr[SM4_BLOCK_SIZE])
+{
+    for (int i = SM4_BLOCK_SIZE - 1; i >= 0; i--)
+    {
+        if (++ctr[i] != 0)
+        {
+            break;
+        }
+    }
+}
+
+int sm4_ctr_crypt(const sm4_context *ctx, uint8_t ctr[SM4_BLOCK_SIZE],
+                  const uint8_t *input, uint8_t *output, size_t len)
+{
+    uint8_t ks[MODES_BATCH * SM4_BLOCK_SIZE];
+
+    if (!ctx || !ctr || ((!input || !output) && len))
+    {
+        return -1;
+    }
+
+    while (len > 0)
+    {
+        size_t n = len < sizeof(ks) ? len : sizeof(ks);
+        size_t nblocks = (n + SM4_BLOCK_SIZE - 1) / SM4_BLOCK_SIZE;
+
+        for (size_t b = 0; b < nblocks; b++)
+        {
+            memcpy(ks + SM4_BLOCK_SIZE * b, ctr, SM4_BLOCK_SIZE);
+            ctr_increment(ctr);
+        }
+        sm4_crypt_blocks(ctx, ks, ks, nblocks);
+
+        for (size_t i = 0; i < n; i++)
+        {
+            output[i] = input[i] ^ ks[i];
+        }
+
+        input += n;
+        output += n;
+        len -= n;
+    }
+
+    sm4_memzero(ks, sizeof(ks));
+    return 0;
+}
+
+int sm4_cbc_encrypt(const sm4_context *ctx, uint8_t iv[SM4_BLOCK_SIZE],
+                    const uint8_t *input, uint8_t *output, size_t len)
+{
+    uint8_t block[SM4_BLOCK_SIZE];
+
+    if (!ctx || !iv || (len % SM4_BLOCK_SIZE) != 0 || ((!input || !output) && len))
+    {
+        return -1;
+    }
+
+    for (size_t off = 0; off < len; off += SM4_BLOCK_SIZE)
+    {
+        for (int i = 0; i < SM4_BLOCK_SIZE; i++)
+        {
+            block[i] = input[off + i] ^ iv[i];
+        }
+        sm4_crypt_ecb((sm4_context *)ctx, 1, block, iv);
+        memcpy(output + off, iv, SM4_BLOCK_SIZE);
+    }
+
+    sm4_memzero(block, sizeof(block));
+    return 0;
+}
+
+// P[i] = D(C[i]) ^ C[i-1]: the block decryptions are independent, only the
+// final XOR needs the previous ciphertext. Works in place.
+int sm4_cbc_decrypt(const sm4_context *ctx, uint8_t iv[SM4_BLOCK_SIZE],
+                    const uint8_t *input, uint8_t *output, size_t len)
+{
+    uint8_t buf[MODES_BATCH * SM4_BLOCK_SIZE];
+    uint8_t next_iv[SM4_BLOCK_SIZE];
+
+    if (!ctx || !iv || (len % SM4_BLOCK_SIZE) != 0 || ((!input || !output) && len))
+    {
+        return -1;
+    }
+
+    while (len > 0)
+    {
+        size_t n = len < sizeof(buf) ? len : sizeof(buf);
+        size_t nblocks = n / SM4_BLOCK_SIZE;
+
+        sm4_crypt_blocks(ctx, input, buf, nblocks);
+        memcpy(next_iv, input + n - SM4_BLOCK_SIZE, SM4_BLOCK_SIZE);
+
+        // Back to front, so an in-place output never clobbers a ciphertext
+        // block that is still needed
+        for (size_t b = nblocks; b-- > 1;)
+        {
+            for (int i = 0; i < SM4_BLOCK_SIZE; i++)
+            {
+                output[SM4_BLOCK_SIZE * b + i] = buf[SM4_BLOCK_SIZE * b + i] ^ input[SM4_BLOCK_SIZE * (b - 1) + i];
+            }
+        }
+        for (int i = 0; i < SM4_BLOCK_SIZE; i++)
+        {
+            output[i] = buf[i] ^ iv[i];
+        }
+        memcpy(iv, next_iv, SM4_BLOCK_SIZE);
+
+        input += n;
+        output += n;
+        len -= n;
+    }
+
+    sm4_memzero(buf, sizeof(buf));
+    return 0;
+}
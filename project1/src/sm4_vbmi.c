@@ -0,0 +1,170 @@
+#include "sm4.h"
+#include <immintrin.h>
+
+#if defined(__AVX512VBMI__) && defined(__AVX512BW__)
+
+// AVX-512 VBMI implementation for CPUs without GFNI
+// The 256-byte S-box is held in four zmm registers (64-byte slices). vpermi2b
+// indexes two slices (128 entries) with the low 7 bits of every byte, so two
+// lookups cover the table and bit 7 of the input selects between them. Every
+// byte goes through the same instructions, so there are no secret-dependent
+// memory accesses.
+
+typedef struct
+{
+    __m512i t0, t1, t2, t3;
+} sm4_vbmi_sbox;
+
+static inline void sm4_vbmi_load_sbox(sm4_vbmi_sbox *s)
+{
+    s->t0 = _mm512_loadu_si512((const void *)(SM4_SBOX));
+    s->t1 = _mm512_loadu_si512((const void *)(SM4_SBOX + 64));
+    s->t2 = _mm512_loadu_si512((const void *)(SM4_SBOX + 128));
+    s->t3 = _mm512_loadu_si512((const void *)(SM4_SBOX + 192));
+}
+
+static inline __m512i sm4_sbox_vbmi_x64(const sm4_vbmi_sbox *s, __m512i x)
+{
+    __m512i lo = _mm512_permutex2var_epi8(s->t0, x, s->t1); // entries 0..127
+    __m512i hi = _mm512_permutex2var_epi8(s->t2, x, s->t3); // entries 128..255
+    return _mm512_mask_blend_epi8(_mm512_movepi8_mask(x), lo, hi);
+}
+
+// Byte swap within each 32-bit word
+static inline __m512i bswap32_vbmi(__m512i x)
+{
+    const __m512i mask = _mm512_broadcast_i32x4(
+        _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));
+    return _mm512_shuffle_epi8(x, mask);
+}
+
+// 4x4 transpose of 32-bit words inside each 128-bit lane
+#define SM4_TRANSPOSE_VBMI(r0, r1, r2, r3)          \
+    do                                              \
+    {                                               \
+        __m512i t0 = _mm512_unpacklo_epi32(r0, r1); \
+        __m512i t1 = _mm512_unpackhi_epi32(r0, r1); \
+        __m512i t2 = _mm512_unpacklo_epi32(r2, r3); \
+        __m512i t3 = _mm512_unpackhi_epi32(r2, r3); \
+        r0 = _mm512_unpacklo_epi64(t0, t2);         \
+        r1 = _mm512_unpackhi_epi64(t0, t2);         \
+        r2 = _mm512_unpacklo_epi64(t1, t3);         \
+        r3 = _mm512_unpackhi_epi64(t1, t3);         \
+    } while (0)
+
+// X0 ^= L(S(X1 ^ X2 ^ X3 ^ rk)) for 16 blocks at once
+#define SM4_ROUND_VBMI(sbox, x0, x1, x2, x3, rk)                              \
+    do                                                                        \
+    {                                                                         \
+        __m512i t = _mm512_ternarylogic_epi32(x1, x2, x3, 0x96);              \
+        t = sm4_sbox_vbmi_x64(sbox, _mm512_xor_si512(t, _mm512_set1_epi32((int)(rk)))); \
+        __m512i l = _mm512_ternarylogic_epi32(t, _mm512_rol_epi32(t, 2),        \
+                                              _mm512_rol_epi32(t, 10), 0x96);   \
+        l = _mm512_ternarylogic_epi32(l, _mm512_rol_epi32(t, 18),             \
+                                      _mm512_rol_epi32(t, 24), 0x96);         \
+        x0 = _mm512_xor_si512(x0, l);                                         \
+    } while (0)
+
+static void sm4_crypt_x16_vbmi(const sm4_vbmi_sbox *sbox, const uint32_t rk[SM4_ROUNDS],
+                               const uint8_t *in, uint8_t *out)
+{
+    __m512i x0 = bswap32_vbmi(_mm512_loadu_si512((const void *)(in)));
+    __m512i x1 = bswap32_vbmi(_mm512_loadu_si512((const void *)(in + 64)));
+    __m512i x2 = bswap32_vbmi(_mm512_loadu_si512((const void *)(in + 128)));
+    __m512i x3 = bswap32_vbmi(_mm512_loadu_si512((const void *)(in + 192)));
+
+    SM4_TRANSPOSE_VBMI(x0, x1, x2, x3);
+
+    for (int i = 0; i < SM4_ROUNDS; i += 4)
+    {
+        SM4_ROUND_VBMI(sbox, x0, x1, x2, x3, rk[i]);
+        SM4_ROUND_VBMI(sbox, x1, x2, x3, x0, rk[i + 1]);
+        SM4_ROUND_VBMI(sbox, x2, x3, x0, x1, rk[i + 2]);
+        SM4_ROUND_VBMI(sbox, x3, x0, x1, x2, rk[i + 3]);
+    }
+
+    // Output is (X35, X34, X33, X32)
+    SM4_TRANSPOSE_VBMI(x3, x2, x1, x0);
+
+    _mm512_storeu_si512((void *)(out), bswap32_vbmi(x3));
+    _mm512_storeu_si512((void *)(out + 64), bswap32_vbmi(x2));
+    _mm512_storeu_si512((void *)(out + 128), bswap32_vbmi(x1));
+    _mm512_storeu_si512((void *)(out + 192), bswap32_vbmi(x0));
+}
+
+// Two 16-block groups interleaved to keep both permute ports busy
+static void sm4_crypt_x32_vbmi(const sm4_vbmi_sbox *sbox, const uint32_t rk[SM4_ROUNDS],
+                               const uint8_t *in, uint8_t *out)
+{
+    __m512i a0 = bswap32_vbmi(_mm512_loadu_si512((const void *)(in)));
+    __m512i a1 = bswap32_vbmi(_mm512_loadu_si512((const void *)(in + 64)));
+    __m512i a2 = bswap32_vbmi(_mm512_loadu_si512((const void *)(in + 128)));
+    __m512i a3 = bswap32_vbmi(_mm512_loadu_si512((const void *)(in + 192)));
+    __m512i b0 = bswap32_vbmi(_mm512_loadu_si512((const void *)(in + 256)));
+    __m512i b1 = bswap32_vbmi(_mm512_loadu_si512((const void *)(in + 320)));
+    __m512i b2 = bswap32_vbmi(_mm512_loadu_si512((const void *)(in + 384)));
+    __m512i b3 = bswap32_vbmi(_mm512_loadu_si512((const void *)(in + 448)));
+
+    SM4_TRANSPOSE_VBMI(a0, a1, a2, a3);
+    SM4_TRANSPOSE_VBMI(b0, b1, b2, b3);
+
+    for (int i = 0; i < SM4_ROUNDS; i += 4)
+    {
+        SM4_ROUND_VBMI(sbox, a0, a1, a2, a3, rk[i]);
+        SM4_ROUND_VBMI(sbox, b0, b1, b2, b3, rk[i]);
+        SM4_ROUND_VBMI(sbox, a1, a2, a3, a0, rk[i + 1]);
+        SM4_ROUND_VBMI(sbox, b1, b2, b3, b0, rk[i + 1]);
+        SM4_ROUND_VBMI(sbox, a2, a3, a0, a1, rk[i + 2]);
+        SM4_ROUND_VBMI(sbox, b2, b3, b0, b1, rk[i + 2]);
+        SM4_ROUND_VBMI(sbox, a3, a0, a1, a2, rk[i + 3]);
+        SM4_ROUND_VBMI(sbox, b3, b0, b1, b2, rk[i + 3]);
+    }
+
+    SM4_TRANSPOSE_VBMI(a3, a2, a1, a0);
+    SM4_TRANSPOSE_VBMI(b3, b2, b1, b0);
+
+    _mm512_storeu_si512((void *)(out), bswap32_vbmi(a3));
+    _mm512_storeu_si512((void *)(out + 64), bswap32_vbmi(a2));
+    _mm512_storeu_si512((void *)(out + 128), bswap32_vbmi(a1));
+    _mm512_storeu_si512((void *)(out + 192), bswap32_vbmi(a0));
+    _mm512_storeu_si512((void *)(out + 256), bswap32_vbmi(b3));
+    _mm512_storeu_si512((void *)(out + 320), bswap32_vbmi(b2));
+    _mm512_storeu_si512((void *)(out + 384), bswap32_vbmi(b1));
+    _mm512_storeu_si512((void *)(out + 448), bswap32_vbmi(b0));
+}
+
+// Encrypt or decrypt nblocks independent blocks (direction comes from the key schedule)
+void sm4_crypt_blocks_vbmi(const sm4_context *ctx, const uint8_t *input, uint8_t *output, size_t nblocks)
+{
+    sm4_vbmi_sbox sbox;
+    sm4_vbmi_load_sbox(&sbox);
+
+    while (nblocks >= 32)
+    {
+        sm4_crypt_x32_vbmi(&sbox, ctx->rk, input, output);
+        input += 32 * SM4_BLOCK_SIZE;
+        output += 32 * SM4_BLOCK_SIZE;
+        nblocks -= 32;
+    }
+
+    if (nblocks >= 16)
+    {
+        sm4_crypt_x16_vbmi(&sbox, ctx->rk, input, output);
+        input += 16 * SM4_BLOCK_SIZE;
+        output += 16 * SM4_BLOCK_SIZE;
+        nblocks -= 16;
+    }
+
+    if (nblocks)
+    {
+        // Tail: run a full 16-block pass over a padded copy
+        uint8_t buf[16 * SM4_BLOCK_SIZE];
+        memset(buf, 0, sizeof(buf));
+        memcpy(buf, input, nblocks * SM4_BLOCK_SIZE);
+        sm4_crypt_x16_vbmi(&sbox, ctx->rk, buf, buf);
+        memcpy(output, buf, nblocks * SM4_BLOCK_SIZE);
+        sm4_memzero(buf, sizeof(buf));
+    }
+}
+
+#endif // __AVX512VBMI__ && __AVX512BW__
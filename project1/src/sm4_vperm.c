@@ -0,0 +1,337 @@
+#include "sm4.h"
+#include <immintrin.h>
+
+#ifdef __SSSE3__
+
+// Vector-permute implementation for x86-64 without AES-NI/GFNI
+// The S-box is S(x) = A * inv(A*x + c) + c over GF(2^8) mod x^8+x^7+x^6+x^5+x^4+x^2+1.
+// The field inversion is done in the isomorphic tower GF(16)[t]/(t^2 + 2t + 2),
+// where every step is a function of one nibble and maps to a 16-entry pshufb table:
+//   x = i*t + k, j = i ^ k
+//   io = 1/(1/i + 2/k) ^ j,  jo = 1/(1/j + 2/k) ^ i
+//   inv(x) = O1[io] ^ O2[jo]
+// 1/0 is stored as 0x80 so that pshufb returns zero for it, which makes the
+// zero cases come out right without branches. The basis change into the tower
+// and the affine maps are folded into the input and output tables.
+// Every lookup is a register shuffle, so the timing does not depend on data.
+
+// Input: x -> tower(A*x + c), split by nibble
+#define VPERM_IN_LO 0x55, 0x8c, 0x8a, 0x53, 0x3d, 0xe4, 0xe2, 0x3b, 0x15, 0xcc, 0xca, 0x13, 0x7d, 0xa4, 0xa2, 0x7b
+#define VPERM_IN_HI 0x00, 0xd6, 0x4b, 0x9d, 0x79, 0xaf, 0x32, 0xe4, 0xb0, 0x66, 0xfb, 0x2d, 0xc9, 0x1f, 0x82, 0x54
+// GF(16) inverse and 2/k, with 1/0 = 0x80
+#define VPERM_INV 0x80, 0x01, 0x09, 0x0e, 0x0d, 0x0b, 0x07, 0x06, 0x0f, 0x02, 0x0c, 0x05, 0x0a, 0x04, 0x03, 0x08
+#define VPERM_DIVK 0x80, 0x02, 0x01, 0x0f, 0x09, 0x05, 0x0e, 0x0c, 0x0d, 0x04, 0x0b, 0x0a, 0x07, 0x08, 0x06, 0x03
+// Output: A * tower^-1(inv) split over io and jo (the constant c is added separately)
+#define VPERM_OUT_IO 0x00, 0x63, 0x37, 0xe1, 0xef, 0x5a, 0xd6, 0xb5, 0x82, 0x6d, 0x8c, 0xbb, 0x39, 0xd8, 0x0e, 0x54
+#define VPERM_OUT_JO 0x00, 0x6e, 0x22, 0x50, 0xf8, 0xe4, 0x72, 0x1c, 0x3e, 0xc6, 0x96, 0xb4, 0x8a, 0xda, 0xa8, 0x4c
+#define VPERM_SBOX_CONST 0xd3
+
+// Byte shuffles: big-endian word load, and word rotations by 8, 16 and 24
+#define VPERM_BSWAP32 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12
+#define VPERM_ROL8 3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14
+#define VPERM_ROL16 2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13
+#define VPERM_ROL24 1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12
+
+// S-box on 16 bytes
+static inline __m128i sm4_sbox_vperm_x16(__m128i x)
+{
+    const __m128i m0f = _mm_set1_epi8(0x0f);
+    const __m128i inv = _mm_setr_epi8(VPERM_INV);
+    const __m128i divk = _mm_setr_epi8(VPERM_DIVK);
+
+    __m128i y = _mm_xor_si128(_mm_shuffle_epi8(_mm_setr_epi8(VPERM_IN_LO), _mm_and_si128(x, m0f)),
+                              _mm_shuffle_epi8(_mm_setr_epi8(VPERM_IN_HI), _mm_and_si128(_mm_srli_epi16(x, 4), m0f)));
+    __m128i k = _mm_and_si128(y, m0f);
+    __m128i i = _mm_and_si128(_mm_srli_epi16(y, 4), m0f);
+    __m128i j = _mm_xor_si128(i, k);
+    __m128i ak = _mm_shuffle_epi8(divk, k);
+    __m128i iak = _mm_xor_si128(_mm_shuffle_epi8(inv, i), ak);
+    __m128i jak = _mm_xor_si128(_mm_shuffle_epi8(inv, j), ak);
+    __m128i io = _mm_xor_si128(_mm_shuffle_epi8(inv, iak), j);
+    __m128i jo = _mm_xor_si128(_mm_shuffle_epi8(inv, jak), i);
+
+    return _mm_xor_si128(_mm_xor_si128(_mm_shuffle_epi8(_mm_setr_epi8(VPERM_OUT_IO), io),
+                                       _mm_shuffle_epi8(_mm_setr_epi8(VPERM_OUT_JO), jo)),
+                         _mm_set1_epi8((char)VPERM_SBOX_CONST));
+}
+
+// L(B) = B ^ rol24(B) ^ rol2(B ^ rol8(B) ^ rol16(B))
+static inline __m128i sm4_linear_vperm_x4(__m128i b)
+{
+    __m128i t = _mm_xor_si128(b, _mm_xor_si128(_mm_shuffle_epi8(b, _mm_setr_epi8(VPERM_ROL8)),
+                                               _mm_shuffle_epi8(b, _mm_setr_epi8(VPERM_ROL16))));
+    t = _mm_or_si128(_mm_slli_epi32(t, 2), _mm_srli_epi32(t, 30));
+    return _mm_xor_si128(_mm_xor_si128(b, t), _mm_shuffle_epi8(b, _mm_setr_epi8(VPERM_ROL24)));
+}
+
+// 4x4 transpose of 32-bit words
+#define SM4_TRANSPOSE_X4(r0, r1, r2, r3)          \
+    do                                            \
+    {                                             \
+        __m128i t0 = _mm_unpacklo_epi32(r0, r1);  \
+        __m128i t1 = _mm_unpackhi_epi32(r0, r1);  \
+        __m128i t2 = _mm_unpacklo_epi32(r2, r3);  \
+        __m128i t3 = _mm_unpackhi_epi32(r2, r3);  \
+        r0 = _mm_unpacklo_epi64(t0, t2);          \
+        r1 = _mm_unpackhi_epi64(t0, t2);          \
+        r2 = _mm_unpacklo_epi64(t1, t3);          \
+        r3 = _mm_unpackhi_epi64(t1, t3);          \
+    } while (0)
+
+// X0 ^= L(S(X1 ^ X2 ^ X3 ^ rk)) for 4 blocks at once
+#define SM4_ROUND_X4(x0, x1, x2, x3, rk)                                              \
+    do                                                                                \
+    {                                                                                 \
+        __m128i t = _mm_xor_si128(_mm_xor_si128(x1, x2), _mm_xor_si128(x3, _mm_set1_epi32((int)(rk)))); \
+        x0 = _mm_xor_si128(x0, sm4_linear_vperm_x4(sm4_sbox_vperm_x16(t)));           \
+    } while (0)
+
+static void sm4_crypt_x4_ssse3(const uint32_t rk[SM4_ROUNDS], const uint8_t *in, uint8_t *out)
+{
+    const __m128i bswap = _mm_setr_epi8(VPERM_BSWAP32);
+    __m128i x0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(in)), bswap);
+    __m128i x1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(in + 16)), bswap);
+    __m128i x2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(in + 32)), bswap);
+    __m128i x3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(in + 48)), bswap);
+
+    SM4_TRANSPOSE_X4(x0, x1, x2, x3);
+
+    for (int i = 0; i < SM4_ROUNDS; i += 4)
+    {
+        SM4_ROUND_X4(x0, x1, x2, x3, rk[i]);
+        SM4_ROUND_X4(x1, x2, x3, x0, rk[i + 1]);
+        SM4_ROUND_X4(x2, x3, x0, x1, rk[i + 2]);
+        SM4_ROUND_X4(x3, x0, x1, x2, rk[i + 3]);
+    }
+
+    // Output is (X35, X34, X33, X32)
+    SM4_TRANSPOSE_X4(x3, x2, x1, x0);
+
+    _mm_storeu_si128((__m128i *)(out), _mm_shuffle_epi8(x3, bswap));
+    _mm_storeu_si128((__m128i *)(out + 16), _mm_shuffle_epi8(x2, bswap));
+    _mm_storeu_si128((__m128i *)(out + 32), _mm_shuffle_epi8(x1, bswap));
+    _mm_storeu_si128((__m128i *)(out + 48), _mm_shuffle_epi8(x0, bswap));
+}
+
+// Two 4-block groups interleaved to hide the S-box latency
+static void sm4_crypt_x8_ssse3(const uint32_t rk[SM4_ROUNDS], const uint8_t *in, uint8_t *out)
+{
+    const __m128i bswap = _mm_setr_epi8(VPERM_BSWAP32);
+    __m128i a0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(in)), bswap);
+    __m128i a1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(in + 16)), bswap);
+    __m128i a2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(in + 32)), bswap);
+    __m128i a3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(in + 48)), bswap);
+    __m128i b0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(in + 64)), bswap);
+    __m128i b1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(in + 80)), bswap);
+    __m128i b2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(in + 96)), bswap);
+    __m128i b3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(in + 112)), bswap);
+
+    SM4_TRANSPOSE_X4(a0, a1, a2, a3);
+    SM4_TRANSPOSE_X4(b0, b1, b2, b3);
+
+    for (int i = 0; i < SM4_ROUNDS; i += 4)
+    {
+        SM4_ROUND_X4(a0, a1, a2, a3, rk[i]);
+        SM4_ROUND_X4(b0, b1, b2, b3, rk[i]);
+        SM4_ROUND_X4(a1, a2, a3, a0, rk[i + 1]);
+        SM4_ROUND_X4(b1, b2, b3, b0, rk[i + 1]);
+        SM4_ROUND_X4(a2, a3, a0, a1, rk[i + 2]);
+        SM4_ROUND_X4(b2, b3, b0, b1, rk[i + 2]);
+        SM4_ROUND_X4(a3, a0, a1, a2, rk[i + 3]);
+        SM4_ROUND_X4(b3, b0, b1, b2, rk[i + 3]);
+    }
+
+    SM4_TRANSPOSE_X4(a3, a2, a1, a0);
+    SM4_TRANSPOSE_X4(b3, b2, b1, b0);
+
+    _mm_storeu_si128((__m128i *)(out), _mm_shuffle_epi8(a3, bswap));
+    _mm_storeu_si128((__m128i *)(out + 16), _mm_shuffle_epi8(a2, bswap));
+    _mm_storeu_si128((__m128i *)(out + 32), _mm_shuffle_epi8(a1, bswap));
+    _mm_storeu_si128((__m128i *)(out + 48), _mm_shuffle_epi8(a0, bswap));
+    _mm_storeu_si128((__m128i *)(out + 64), _mm_shuffle_epi8(b3, bswap));
+    _mm_storeu_si128((__m128i *)(out + 80), _mm_shuffle_epi8(b2, bswap));
+    _mm_storeu_si128((__m128i *)(out + 96), _mm_shuffle_epi8(b1, bswap));
+    _mm_storeu_si128((__m128i *)(out + 112), _mm_shuffle_epi8(b0, bswap));
+}
+
+// Encrypt or decrypt nblocks independent blocks, 4 per xmm pass
+void sm4_crypt_blocks_ssse3(const sm4_context *ctx, const uint8_t *input, uint8_t *output, size_t nblocks)
+{
+    while (nblocks >= 8)
+    {
+        sm4_crypt_x8_ssse3(ctx->rk, input, output);
+        input += 8 * SM4_BLOCK_SIZE;
+        output += 8 * SM4_BLOCK_SIZE;
+        nblocks -= 8;
+    }
+
+    if (nblocks >= 4)
+    {
+        sm4_crypt_x4_ssse3(ctx->rk, input, output);
+        input += 4 * SM4_BLOCK_SIZE;
+        output += 4 * SM4_BLOCK_SIZE;
+        nblocks -= 4;
+    }
+
+    if (nblocks)
+    {
+        uint8_t buf[4 * SM4_BLOCK_SIZE];
+        memset(buf, 0, sizeof(buf));
+        memcpy(buf, input, nblocks * SM4_BLOCK_SIZE);
+        sm4_crypt_x4_ssse3(ctx->rk, buf, buf);
+        memcpy(output, buf, nblocks * SM4_BLOCK_SIZE);
+        sm4_memzero(buf, sizeof(buf));
+    }
+}
+
+// The file is built with -mssse3 only, so the xmm kernel above keeps legacy
+// SSE encodings; the ymm kernel opts into AVX2 here and is only dispatched
+// when sm4_cpu_support_avx2() says so
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+// Same tables and round, 8 blocks per ymm (shuffles work within each 128-bit lane)
+static inline __m256i sm4_sbox_vperm_x32(__m256i x)
+{
+    const __m256i m0f = _mm256_set1_epi8(0x0f);
+    const __m256i inv = _mm256_setr_epi8(VPERM_INV, VPERM_INV);
+    const __m256i divk = _mm256_setr_epi8(VPERM_DIVK, VPERM_DIVK);
+
+    __m256i y = _mm256_xor_si256(_mm256_shuffle_epi8(_mm256_setr_epi8(VPERM_IN_LO, VPERM_IN_LO), _mm256_and_si256(x, m0f)),
+                                 _mm256_shuffle_epi8(_mm256_setr_epi8(VPERM_IN_HI, VPERM_IN_HI), _mm256_and_si256(_mm256_srli_epi16(x, 4), m0f)));
+    __m256i k = _mm256_and_si256(y, m0f);
+    __m256i i = _mm256_and_si256(_mm256_srli_epi16(y, 4), m0f);
+    __m256i j = _mm256_xor_si256(i, k);
+    __m256i ak = _mm256_shuffle_epi8(divk, k);
+    __m256i iak = _mm256_xor_si256(_mm256_shuffle_epi8(inv, i), ak);
+    __m256i jak = _mm256_xor_si256(_mm256_shuffle_epi8(inv, j), ak);
+    __m256i io = _mm256_xor_si256(_mm256_shuffle_epi8(inv, iak), j);
+    __m256i jo = _mm256_xor_si256(_mm256_shuffle_epi8(inv, jak), i);
+
+    return _mm256_xor_si256(_mm256_xor_si256(_mm256_shuffle_epi8(_mm256_setr_epi8(VPERM_OUT_IO, VPERM_OUT_IO), io),
+                                             _mm256_shuffle_epi8(_mm256_setr_epi8(VPERM_OUT_JO, VPERM_OUT_JO), jo)),
+                            _mm256_set1_epi8((char)VPERM_SBOX_CONST));
+}
+
+static inline __m256i sm4_linear_vperm_x8(__m256i b)
+{
+    __m256i t = _mm256_xor_si256(b, _mm256_xor_si256(_mm256_shuffle_epi8(b, _mm256_setr_epi8(VPERM_ROL8, VPERM_ROL8)),
+                                                     _mm256_shuffle_epi8(b, _mm256_setr_epi8(VPERM_ROL16, VPERM_ROL16))));
+    t = _mm256_or_si256(_mm256_slli_epi32(t, 2), _mm256_srli_epi32(t, 30));
+    return _mm256_xor_si256(_mm256_xor_si256(b, t), _mm256_shuffle_epi8(b, _mm256_setr_epi8(VPERM_ROL24, VPERM_ROL24)));
+}
+
+// 4x4 transpose of 32-bit words inside each 128-bit lane
+#define SM4_TRANSPOSE_X8(r0, r1, r2, r3)             \
+    do                                               \
+    {                                                \
+        __m256i t0 = _mm256_unpacklo_epi32(r0, r1);  \
+        __m256i t1 = _mm256_unpackhi_epi32(r0, r1);  \
+        __m256i t2 = _mm256_unpacklo_epi32(r2, r3);  \
+        __m256i t3 = _mm256_unpackhi_epi32(r2, r3);  \
+        r0 = _mm256_unpacklo_epi64(t0, t2);          \
+        r1 = _mm256_unpackhi_epi64(t0, t2);          \
+        r2 = _mm256_unpacklo_epi64(t1, t3);          \
+        r3 = _mm256_unpackhi_epi64(t1, t3);          \
+    } while (0)
+
+#define SM4_ROUND_X8(x0, x1, x2, x3, rk)                                                       \
+    do                                                                                         \
+    {                                                                                          \
+        __m256i t = _mm256_xor_si256(_mm256_xor_si256(x1, x2), _mm256_xor_si256(x3, _mm256_set1_epi32((int)(rk)))); \
+        x0 = _mm256_xor_si256(x0, sm4_linear_vperm_x8(sm4_sbox_vperm_x32(t)));                 \
+    } while (0)
+
+static void sm4_crypt_x8_avx2(const uint32_t rk[SM4_ROUNDS], const uint8_t *in, uint8_t *out)
+{
+    const __m256i bswap = _mm256_setr_epi8(VPERM_BSWAP32, VPERM_BSWAP32);
+    __m256i x0 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(in)), bswap);
+    __m256i x1 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(in + 32)), bswap);
+    __m256i x2 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(in + 64)), bswap);
+    __m256i x3 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(in + 96)), bswap);
+
+    SM4_TRANSPOSE_X8(x0, x1, x2, x3);
+
+    for (int i = 0; i < SM4_ROUNDS; i += 4)
+    {
+        SM4_ROUND_X8(x0, x1, x2, x3, rk[i]);
+        SM4_ROUND_X8(x1, x2, x3, x0, rk[i + 1]);
+        SM4_ROUND_X8(x2, x3, x0, x1, rk[i + 2]);
+        SM4_ROUND_X8(x3, x0, x1, x2, rk[i + 3]);
+    }
+
+    SM4_TRANSPOSE_X8(x3, x2, x1, x0);
+
+    _mm256_storeu_si256((__m256i *)(out), _mm256_shuffle_epi8(x3, bswap));
+    _mm256_storeu_si256((__m256i *)(out + 32), _mm256_shuffle_epi8(x2, bswap));
+    _mm256_storeu_si256((__m256i *)(out + 64), _mm256_shuffle_epi8(x1, bswap));
+    _mm256_storeu_si256((__m256i *)(out + 96), _mm256_shuffle_epi8(x0, bswap));
+}
+
+// Two 8-block groups interleaved; one group alone is bound by the S-box latency
+static void sm4_crypt_x16_avx2(const uint32_t rk[SM4_ROUNDS], const uint8_t *in, uint8_t *out)
+{
+    const __m256i bswap = _mm256_setr_epi8(VPERM_BSWAP32, VPERM_BSWAP32);
+    __m256i a0 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(in)), bswap);
+    __m256i a1 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(in + 32)), bswap);
+    __m256i a2 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(in + 64)), bswap);
+    __m256i a3 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(in + 96)), bswap);
+    __m256i b0 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(in + 128)), bswap);
+    __m256i b1 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(in + 160)), bswap);
+    __m256i b2 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(in + 192)), bswap);
+    __m256i b3 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(in + 224)), bswap);
+
+    SM4_TRANSPOSE_X8(a0, a1, a2, a3);
+    SM4_TRANSPOSE_X8(b0, b1, b2, b3);
+
+    for (int i = 0; i < SM4_ROUNDS; i += 4)
+    {
+        SM4_ROUND_X8(a0, a1, a2, a3, rk[i]);
+        SM4_ROUND_X8(b0, b1, b2, b3, rk[i]);
+        SM4_ROUND_X8(a1, a2, a3, a0, rk[i + 1]);
+        SM4_ROUND_X8(b1, b2, b3, b0, rk[i + 1]);
+        SM4_ROUND_X8(a2, a3, a0, a1, rk[i + 2]);
+        SM4_ROUND_X8(b2, b3, b0, b1, rk[i + 2]);
+        SM4_ROUND_X8(a3, a0, a1, a2, rk[i + 3]);
+        SM4_ROUND_X8(b3, b0, b1, b2, rk[i + 3]);
+    }
+
+    SM4_TRANSPOSE_X8(a3, a2, a1, a0);
+    SM4_TRANSPOSE_X8(b3, b2, b1, b0);
+
+    _mm256_storeu_si256((__m256i *)(out), _mm256_shuffle_epi8(a3, bswap));
+    _mm256_storeu_si256((__m256i *)(out + 32), _mm256_shuffle_epi8(a2, bswap));
+    _mm256_storeu_si256((__m256i *)(out + 64), _mm256_shuffle_epi8(a1, bswap));
+    _mm256_storeu_si256((__m256i *)(out + 96), _mm256_shuffle_epi8(a0, bswap));
+    _mm256_storeu_si256((__m256i *)(out + 128), _mm256_shuffle_epi8(b3, bswap));
+    _mm256_storeu_si256((__m256i *)(out + 160), _mm256_shuffle_epi8(b2, bswap));
+    _mm256_storeu_si256((__m256i *)(out + 192), _mm256_shuffle_epi8(b1, bswap));
+    _mm256_storeu_si256((__m256i *)(out + 224), _mm256_shuffle_epi8(b0, bswap));
+}
+
+// Encrypt or decrypt nblocks independent blocks, 8 per ymm pass
+void sm4_crypt_blocks_avx2(const sm4_context *ctx, const uint8_t *input, uint8_t *output, size_t nblocks)
+{
+    while (nblocks >= 16)
+    {
+        sm4_crypt_x16_avx2(ctx->rk, input, output);
+        input += 16 * SM4_BLOCK_SIZE;
+        output += 16 * SM4_BLOCK_SIZE;
+        nblocks -= 16;
+    }
+
+    if (nblocks >= 8)
+    {
+        sm4_crypt_x8_avx2(ctx->rk, input, output);
+        input += 8 * SM4_BLOCK_SIZE;
+        output += 8 * SM4_BLOCK_SIZE;
+        nblocks -= 8;
+    }
+
+    // 1-7 remaining blocks go through the xmm kernel
+    sm4_crypt_blocks_ssse3(ctx, input, output, nblocks);
+}
+
+#pragma GCC pop_options
+
+#endif // __SSSE3__
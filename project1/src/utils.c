@@ -1,4 +1,4 @@
-#include "sm4.h"
+#include "sm4_internal.h"
 #include <stdio.h>
 #include <time.h>
 #include <sys/time.h>
@@ -83,6 +83,41 @@ static double get_cpu_frequency_ghz(void)
     return (double)elapsed_cycles / elapsed_time / 1e9;
 }
 
+// Hardware performance counters, when the caller installed a source
+static const sm4_perf_counters *perf_counters;
+
+void sm4_set_perf_counters(const sm4_perf_counters *src)
+{
+    perf_counters = src;
+}
+
+void sm4_perf_print_counters(const sm4_perf_result *result)
+{
+    const uint64_t *c = result->counters;
+    double bytes = (double)result->total_bytes;
+    double blocks = (double)(result->total_blocks ? result->total_blocks : result->total_bytes / SM4_BLOCK_SIZE);
+
+    if (!result->counters_valid || bytes == 0 || !perf_counters)
+    {
+        return;
+    }
+
+    printf("  %-14s %14s %12s %12s\n", "Counter", "total", "per byte", "per block");
+    for (int i = 0; i < SM4_PERF_CTR_COUNT; i++)
+    {
+        if (result->counters_valid & (1u << i))
+        {
+            printf("  %-14s %14llu %12.4f %12.3f\n", perf_counters->name(i),
+                   (unsigned long long)c[i], c[i] / bytes, blocks ? c[i] / blocks : 0.0);
+        }
+    }
+    if ((result->counters_valid & (1u << SM4_PERF_CTR_INSTRUCTIONS)) &&
+        (result->counters_valid & (1u << SM4_PERF_CTR_CYCLES)) && c[SM4_PERF_CTR_CYCLES])
+    {
+        printf("  IPC: %.2f\n", (double)c[SM4_PERF_CTR_INSTRUCTIONS] / c[SM4_PERF_CTR_CYCLES]);
+    }
+}
+
 // Benchmark function for SM4 implementations
 void sm4_benchmark(const char *impl_name,
                    void (*encrypt_func)(const uint8_t *, const uint8_t *, uint8_t *),
@@ -102,9 +137,12 @@ void sm4_benchmark(const char *impl_name,
         0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10};
 
     uint8_t ciphertext[SM4_BLOCK_SIZE];
+    const sm4_perf_counters *counters = perf_counters;
 
     printf("Benchmarking %s implementation...\n", impl_name);
 
+    result->counters_valid = 0;
+
     // Warm-up run
     for (size_t i = 0; i < 1000; i++)
     {
@@ -112,6 +150,10 @@ void sm4_benchmark(const char *impl_name,
     }
 
     // Actual benchmark
+    if (counters)
+    {
+        counters->start(counters->ctx);
+    }
     uint64_t start_cycles = get_cpu_cycles();
     double start_time = get_time_in_seconds();
 
@@ -122,6 +164,10 @@ void sm4_benchmark(const char *impl_name,
 
     uint64_t end_cycles = get_cpu_cycles();
     double end_time = get_time_in_seconds();
+    if (counters)
+    {
+        result->counters_valid = counters->stop(counters->ctx, result->counters);
+    }
 
     uint64_t total_cycles = end_cycles - start_cycles;
     double elapsed_time = end_time - start_time;
@@ -129,6 +175,7 @@ void sm4_benchmark(const char *impl_name,
     // Calculate results
     result->total_cycles = total_cycles;
     result->total_bytes = total_bytes;
+    result->total_blocks = num_iterations;
     result->cycles_per_byte = (double)total_cycles / (double)total_bytes;
     result->mbytes_per_sec = (double)total_bytes / elapsed_time / (1024.0 * 1024.0);
 
@@ -139,6 +186,7 @@ void sm4_benchmark(const char *impl_name,
     printf("  Cycles per byte: %.2f\n", result->cycles_per_byte);
     printf("  Throughput: %.2f MB/s\n", result->mbytes_per_sec);
     printf("  Operations per second: %.0f\n", (double)num_iterations / elapsed_time);
+    sm4_perf_print_counters(result);
     printf("\n");
 }
 
@@ -159,48 +207,10 @@ int sm4_memcmp_const_time(const uint8_t *a, const uint8_t *b, size_t len)
 // Secure memory clearing function
 void sm4_memzero(void *ptr, size_t len)
 {
-    volatile uint8_t *p = (volatile uint8_t *)ptr;
-    size_t i;
-
-    for (i = 0; i < len; i++)
-    {
-        p[i] = 0;
-    }
-}
-
-// Random number generation for testing (simple PRNG)
-static uint32_t rng_state = 1;
-
-void sm4_srand(uint32_t seed)
-{
-    rng_state = seed;
-}
-
-uint32_t sm4_rand(void)
-{
-    // Linear congruential generator
-    rng_state = rng_state * 1103515245 + 12345;
-    return rng_state;
+    sm4_wipe(ptr, len);
 }
 
-void sm4_rand_bytes(uint8_t *buf, size_t len)
-{
-    size_t i;
-    for (i = 0; i < len; i++)
-    {
-        if (i % 4 == 0)
-        {
-            uint32_t r = sm4_rand();
-            buf[i] = r & 0xFF;
-            if (i + 1 < len)
-                buf[i + 1] = (r >> 8) & 0xFF;
-            if (i + 2 < len)
-                buf[i + 2] = (r >> 16) & 0xFF;
-            if (i + 3 < len)
-                buf[i + 3] = (r >> 24) & 0xFF;
-        }
-    }
-}
+// Random number generation lives in sm4_drbg.c (SM4 CTR_DRBG)
 
 // Performance analysis functions
 void sm4_print_cpu_info(void)
@@ -253,4 +263,27 @@ void sm4_compare_implementations(void)
                speedup);
     }
     printf("\n");
+
+    // Why the rates differ: instructions and misses per block
+    const unsigned need = (1u << SM4_PERF_CTR_INSTRUCTIONS) | (1u << SM4_PERF_CTR_CYCLES);
+    if ((results[0].counters_valid & need) == need)
+    {
+        printf("Implementation | Instr/block | IPC  | L1D miss/block | Branch miss/block\n");
+        printf("---------------|-------------|------|----------------|------------------\n");
+        for (int i = 0; i < 4; i++)
+        {
+            const sm4_perf_result *r = &results[i];
+            double blocks = (double)r->total_blocks;
+            if ((r->counters_valid & need) != need)
+            {
+                continue;
+            }
+            printf("%-14s | %11.1f | %4.2f | %14.3f | %17.4f\n", impl_names[i],
+                   r->counters[SM4_PERF_CTR_INSTRUCTIONS] / blocks,
+                   (double)r->counters[SM4_PERF_CTR_INSTRUCTIONS] / r->counters[SM4_PERF_CTR_CYCLES],
+                   r->counters[SM4_PERF_CTR_L1D_MISSES] / blocks,
+                   r->counters[SM4_PERF_CTR_BRANCH_MISSES] / blocks);
+        }
+        printf("\n");
+    }
 }
@@ -0,0 +1,273 @@
+#include "../src/sm4.hpp"
+#include "test_vectors.h"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+// Tests for the header-only C++ API (sm4.hpp)
+
+static int total_tests = 0;
+static int failed_tests = 0;
+
+static void run_test(const char *test_name, int (*test_func)())
+{
+    std::printf("Running %s... ", test_name);
+    std::fflush(stdout);
+    total_tests++;
+
+    int rc;
+    try
+    {
+        rc = test_func();
+    }
+    catch (const std::exception &e)
+    {
+        std::printf("\n  unexpected exception: %s\n", e.what());
+        rc = -1;
+    }
+
+    if (rc == 0)
+    {
+        std::printf("PASSED\n");
+    }
+    else
+    {
+        std::printf("FAILED\n");
+        failed_tests++;
+    }
+}
+
+static int compare_arrays(const uint8_t *a, const uint8_t *b, size_t len, const char *name)
+{
+    if (std::memcmp(a, b, len) != 0)
+    {
+        std::printf("\n%s mismatch!\n", name);
+        std::printf("Expected: ");
+        sm4_print_hex(b, len);
+        std::printf("Got:      ");
+        sm4_print_hex(a, len);
+        return -1;
+    }
+    return 0;
+}
+
+static std::vector<uint8_t> pattern(size_t len)
+{
+    std::vector<uint8_t> v(len);
+    for (size_t i = 0; i < len; i++)
+    {
+        v[i] = uint8_t(7 * i + 3);
+    }
+    return v;
+}
+
+// ECB/CTR known answers plus a long round trip for one instantiation
+template <class Impl>
+static int check_sm4(const char *label)
+{
+    Impl sm4{sm4::Key(test_key1)};
+    std::vector<uint8_t> msg = pattern(600), out(600), back(600);
+    std::array<uint8_t, 16> ctr;
+
+    sm4.encrypt_ecb(sm4::bytes_view(msg.data(), 64), sm4::bytes_span(out.data(), 64));
+    if (compare_arrays(out.data(), ecb_ct64, 64, label) != 0)
+    {
+        return -1;
+    }
+
+    std::memcpy(ctr.data(), ctr_iv, 16);
+    sm4.ctr(ctr, sm4::bytes_view(msg.data(), 37), sm4::bytes_span(out.data(), 37));
+    if (compare_arrays(out.data(), ctr_ct37, 37, label) != 0)
+    {
+        return -1;
+    }
+
+    sm4.encrypt_ecb(sm4::bytes_view(msg.data(), 592), sm4::bytes_span(out.data(), 592));
+    sm4.decrypt_ecb(sm4::bytes_view(out.data(), 592), sm4::bytes_span(back.data(), 592));
+    return compare_arrays(back.data(), msg.data(), 592, label);
+}
+
+static int test_backends()
+{
+    std::printf("\n");
+    int rc = 0;
+
+    rc |= check_sm4<sm4::Sm4<sm4::backend::Scalar, 1>>("Scalar x1");
+    rc |= check_sm4<sm4::Sm4<sm4::backend::Scalar, 8>>("Scalar x8");
+#if defined(__GFNI__) && defined(__AVX512F__)
+    if (sm4::backend::Gfni::available())
+    {
+        rc |= check_sm4<sm4::Sm4<sm4::backend::Gfni, 16>>("GFNI x16");
+        rc |= check_sm4<sm4::Sm4<sm4::backend::Gfni, 32>>("GFNI x32");
+    }
+#endif
+#if defined(__AVX512VBMI__) && defined(__AVX512BW__)
+    if (sm4::backend::Vbmi::available())
+    {
+        rc |= check_sm4<sm4::Sm4<sm4::backend::Vbmi>>("VBMI");
+    }
+#endif
+#ifdef __AVX2__
+    if (sm4::backend::Avx2::available())
+    {
+        rc |= check_sm4<sm4::Sm4<sm4::backend::Avx2>>("AVX2");
+    }
+#endif
+#ifdef __SSSE3__
+    if (sm4::backend::Ssse3::available())
+    {
+        rc |= check_sm4<sm4::Sm4<sm4::backend::Ssse3>>("SSSE3");
+    }
+#endif
+    return rc ? -1 : 0;
+}
+
+template <class Gcm>
+static int check_gcm(const Gcm &gcm)
+{
+    std::vector<uint8_t> msg = pattern(100), ct(100), pt(100);
+    uint8_t tag[16];
+
+    gcm.encrypt(gcm_iv, gcm_aad, msg, ct, tag);
+    if (compare_arrays(ct.data(), gcm_prepared_ct, 100, "GCM ciphertext") != 0 ||
+        compare_arrays(tag, gcm_prepared_tag, 16, "GCM tag") != 0)
+    {
+        return -1;
+    }
+    if (!gcm.decrypt(gcm_iv, gcm_aad, ct, tag, pt) || compare_arrays(pt.data(), msg.data(), 100, "GCM decrypt") != 0)
+    {
+        return -1;
+    }
+
+    tag[0] ^= 1;
+    std::fill(pt.begin(), pt.end(), 0);
+    if (gcm.decrypt(gcm_iv, gcm_aad, ct, tag, pt) || pt[0] != 0)
+    {
+        std::printf("\n  forged tag accepted\n");
+        return -1;
+    }
+    return 0;
+}
+
+static int test_gcm()
+{
+    if (check_gcm(sm4::Sm4Gcm<sm4::backend::Scalar>(sm4::Key(gcm_key))) != 0)
+    {
+        return -1;
+    }
+    return check_gcm(sm4::AnySm4Gcm::create(sm4::Key(gcm_key)));
+}
+
+static int test_key_lifetime()
+{
+    sm4::Key a(test_key1);
+    sm4::Key b(std::move(a));
+    static const sm4_context zero = {};
+
+    if (std::memcmp(&a.enc(), &zero, sizeof(zero)) != 0 || std::memcmp(&a.dec(), &zero, sizeof(zero)) != 0)
+    {
+        std::printf("\n  moved-from key not wiped\n");
+        return -1;
+    }
+
+    static_assert(!std::is_copy_constructible_v<sm4::Key>, "keys must be move-only");
+    static_assert(!std::is_copy_constructible_v<sm4::Sm4Gcm<>>, "GCM contexts must be move-only");
+
+    try
+    {
+        uint8_t short_key[15] = {};
+        sm4::Key bad(short_key);
+        std::printf("\n  short key accepted\n");
+        return -1;
+    }
+    catch (const std::invalid_argument &)
+    {
+    }
+
+    sm4::Sm4<> sm4(std::move(b));
+    uint8_t out[16];
+    sm4.encrypt_ecb(sm4::bytes_view(test_plaintext1, 16), out);
+    return compare_arrays(out, test_ciphertext1, 16, "ECB after move");
+}
+
+static int test_facade()
+{
+    sm4::AnySm4 best = sm4::AnySm4::create(sm4::Key(test_key1));
+    sm4::AnySm4 scalar = sm4::AnySm4::create(sm4::Key(test_key1), "scalar");
+    std::vector<uint8_t> msg = pattern(600), a(600), b(600);
+
+    std::printf("\n  Best backend: %s\n  ", best.backend_name());
+
+    best.encrypt_ecb(sm4::bytes_view(msg.data(), 592), sm4::bytes_span(a.data(), 592));
+    scalar.encrypt_ecb(sm4::bytes_view(msg.data(), 592), sm4::bytes_span(b.data(), 592));
+    if (compare_arrays(a.data(), b.data(), 592, "facade") != 0)
+    {
+        return -1;
+    }
+
+    try
+    {
+        sm4::AnySm4::create(sm4::Key(test_key1), "no-such-backend");
+        return -1;
+    }
+    catch (const std::invalid_argument &)
+    {
+    }
+    return 0;
+}
+
+// MB/s of ECB over 1 MB buffers
+template <class Impl>
+static void bench(const char *label, const Impl &impl)
+{
+    std::vector<uint8_t> buf(1 << 20, 0x5a);
+    auto start = std::chrono::steady_clock::now();
+    int reps = 0;
+    double elapsed;
+
+    do
+    {
+        impl.encrypt_ecb(buf, buf);
+        reps++;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < 0.3);
+
+    std::printf("  %-28s %10.2f MB/s\n", label, reps / elapsed);
+}
+
+// The C API through the sm4_crypt_blocks() dispatcher, for comparison
+struct CEcb
+{
+    sm4_context ctx;
+    void encrypt_ecb(sm4::bytes_view in, sm4::bytes_span out) const { sm4_ecb_crypt(&ctx, in.data(), out.data(), in.size()); }
+};
+
+int main()
+{
+    std::printf("=== SM4 C++ API Tests ===\n\n");
+
+    run_test("Compile-time Backends", test_backends);
+    run_test("GCM", test_gcm);
+    run_test("Key Lifetime", test_key_lifetime);
+    run_test("Runtime Facade", test_facade);
+
+    std::printf("\nECB throughput:\n");
+    CEcb c;
+    sm4_setkey_enc(&c.ctx, test_key1);
+    bench("C sm4_ecb_crypt", c);
+    bench("Sm4<Scalar, 8>", sm4::Sm4<sm4::backend::Scalar, 8>(sm4::Key(test_key1)));
+#if defined(__GFNI__) && defined(__AVX512F__)
+    if (sm4::backend::Gfni::available())
+    {
+        bench("Sm4<Gfni, 32>", sm4::Sm4<sm4::backend::Gfni, 32>(sm4::Key(test_key1)));
+    }
+#endif
+    bench("AnySm4 (best)", sm4::AnySm4::create(sm4::Key(test_key1)));
+
+    std::printf("\n=== Test Summary ===\n");
+    std::printf("Total tests: %d\n", total_tests);
+    std::printf("Passed: %d\n", total_tests - failed_tests);
+    std::printf("Failed: %d\n", failed_tests);
+    return failed_tests == 0 ? 0 : 1;
+}
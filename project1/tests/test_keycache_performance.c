@@ -0,0 +1,152 @@
+#define _POSIX_C_SOURCE 200809L
+#include "../src/sm4.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+// Simulated multi-tenant service: NUM_KEYS key IDs, skewed access, 64-byte
+// GCM messages. Compares re-expanding the key per call with the key cache.
+
+#define NUM_KEYS 100000
+#define MSG_SIZE 64
+#define OPS_PER_THREAD 200000
+
+static const uint8_t test_iv[12] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0a, 0x0b};
+
+typedef struct
+{
+    sm4_key_cache *cache; // NULL: one-shot API without caching
+    uint32_t seed;
+    double seconds;
+} worker_args;
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Stand-in for a KMS fetch: the key is derived from its ID
+static void load_key(uint64_t key_id, uint8_t key[16])
+{
+    for (int i = 0; i < 16; i++)
+    {
+        key[i] = (uint8_t)((key_id >> (8 * (i % 8))) ^ (0x5a + i));
+    }
+}
+
+// Skewed key choice: most traffic goes to a small set of hot tenants. u takes
+// 53 bits from a 64-bit LCG so every one of the NUM_KEYS IDs can come up.
+static uint64_t pick_key(uint64_t *state)
+{
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    double u = (double)(*state >> 11) / 9007199254740992.0;
+    return (uint64_t)(u * u * u * NUM_KEYS);
+}
+
+static void *worker(void *p)
+{
+    worker_args *args = p;
+    uint8_t msg[MSG_SIZE], ct[MSG_SIZE], tag[16], key[16];
+    uint64_t state = args->seed;
+    double start = now_seconds();
+
+    memset(msg, 0xab, sizeof(msg));
+
+    for (int i = 0; i < OPS_PER_THREAD; i++)
+    {
+        uint64_t id = pick_key(&state);
+
+        if (!args->cache)
+        {
+            load_key(id, key);
+            sm4_gcm_encrypt_opt(key, test_iv, 12, NULL, 0, msg, sizeof(msg), ct, tag, 16);
+            continue;
+        }
+
+        const sm4_prepared_key *pk = sm4_key_cache_get(args->cache, id);
+        if (!pk)
+        {
+            load_key(id, key);
+            pk = sm4_key_cache_put(args->cache, id, key);
+        }
+        if (pk)
+        {
+            sm4_gcm_encrypt_prepared(pk, test_iv, 12, NULL, 0, msg, sizeof(msg), ct, tag, 16);
+            sm4_key_cache_release(args->cache, pk);
+        }
+    }
+
+    args->seconds = now_seconds() - start;
+    return NULL;
+}
+
+static double run(sm4_key_cache *cache, int nthreads)
+{
+    pthread_t tids[64];
+    worker_args args[64];
+    double total = 0;
+
+    for (int t = 0; t < nthreads; t++)
+    {
+        args[t].cache = cache;
+        args[t].seed = 1234u + 977u * (uint32_t)t;
+        pthread_create(&tids[t], NULL, worker, &args[t]);
+    }
+    for (int t = 0; t < nthreads; t++)
+    {
+        pthread_join(tids[t], NULL);
+        total += (double)OPS_PER_THREAD / args[t].seconds;
+    }
+    return total;
+}
+
+int main(int argc, char **argv)
+{
+    int nthreads = argc > 1 ? atoi(argv[1]) : 4;
+    sm4_key_cache_stats st;
+
+    if (nthreads < 1 || nthreads > 64)
+    {
+        nthreads = 4;
+    }
+
+    printf("=== SM4 Key Cache Performance Test ===\n\n");
+    printf("%d key IDs, %d-byte GCM messages, %d threads x %d ops\n\n",
+           NUM_KEYS, MSG_SIZE, nthreads, OPS_PER_THREAD);
+
+    double baseline = run(NULL, nthreads);
+    printf("  %-28s %12.0f ops/s\n", "sm4_gcm_encrypt_opt (no cache)", baseline);
+
+    // Budgets from "everything fits" down to a fraction of the key set
+    const double fractions[] = {1.25, 0.5, 0.1};
+    for (size_t i = 0; i < sizeof(fractions) / sizeof(fractions[0]); i++)
+    {
+        size_t budget = (size_t)(fractions[i] * NUM_KEYS * (sizeof(sm4_prepared_key) + 96));
+        sm4_key_cache *cache = sm4_key_cache_create(budget, 64);
+        if (!cache)
+        {
+            printf("Cache creation failed\n");
+            return 1;
+        }
+
+        double ops = run(cache, nthreads);
+        sm4_key_cache_get_stats(cache, &st);
+
+        char label[64];
+        snprintf(label, sizeof(label), "cache %.1f MB (%zu keys)", st.memory_bytes / (1024.0 * 1024.0), st.capacity);
+        printf("  %-28s %12.0f ops/s  %5.2fx  hit rate %5.1f%%  evictions %llu\n",
+               label, ops, ops / baseline,
+               100.0 * st.hits / (double)(st.hits + st.misses),
+               (unsigned long long)st.evictions);
+
+        sm4_key_cache_destroy(cache);
+    }
+
+    return 0;
+}
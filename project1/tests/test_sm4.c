@@ -300,6 +300,566 @@ static int test_gcm_mode(void)
     return 0;
 }
 
+// The optimized GCM path must build GHASH state per key: with a non-96-bit IV
+// (J0 goes through GHASH) it has to agree with sm4_gcm_encrypt for every key,
+// not only the first one used in the process
+static int test_gcm_opt_per_key(void)
+{
+    const uint8_t *keys[3] = {test_key1, gcm_key, test_key1};
+    uint8_t iv[16];
+
+    for (int i = 0; i < 16; i++)
+    {
+        iv[i] = (uint8_t)(0xa0 + i);
+    }
+
+    for (int k = 0; k < 3; k++)
+    {
+        uint8_t ct_ref[16], tag_ref[16], ct[16], tag[16];
+
+        sm4_gcm_encrypt(keys[k], iv, sizeof(iv), gcm_aad, 8, gcm_plaintext, 16, ct_ref, tag_ref, 16);
+        if (sm4_gcm_encrypt_opt(keys[k], iv, sizeof(iv), gcm_aad, 8, gcm_plaintext, 16, ct, tag, 16) != 0)
+        {
+            printf("\nsm4_gcm_encrypt_opt failed");
+            return -1;
+        }
+        if (compare_arrays(ct, ct_ref, 16, "GCM-opt ciphertext") != 0 ||
+            compare_arrays(tag, tag_ref, 16, "GCM-opt tag") != 0)
+        {
+            printf("Key #%d\n", k);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+// Test GMAC (known answers, incremental updates, batch API, GHASH backends)
+static int test_gmac_mode(void)
+{
+    uint8_t aad[1000];
+    uint8_t tag[16], ref_tag[16];
+    uint8_t iv20[20];
+    sm4_gmac_context ctx;
+    size_t i;
+
+    for (i = 0; i < sizeof(aad); i++)
+    {
+        aad[i] = (uint8_t)(7 * i + 3);
+    }
+    for (i = 0; i < sizeof(iv20); i++)
+    {
+        iv20[i] = (uint8_t)i;
+    }
+
+    // Known-answer tests
+    if (sm4_gmac(gcm_key, gcm_iv, 12, aad, 100, tag, 16) != 0 ||
+        compare_arrays(tag, gmac_tag_iv12, 16, "GMAC (96-bit IV)") != 0)
+    {
+        return -1;
+    }
+
+    if (sm4_gmac(gcm_key, iv20, sizeof(iv20), aad, 100, tag, 16) != 0 ||
+        compare_arrays(tag, gmac_tag_iv20, 16, "GMAC (160-bit IV)") != 0)
+    {
+        return -1;
+    }
+
+    if (sm4_gmac(gcm_key, gcm_iv, 12, NULL, 0, tag, 16) != 0 ||
+        compare_arrays(tag, gmac_tag_empty, 16, "GMAC (empty AAD)") != 0)
+    {
+        return -1;
+    }
+
+    // Incremental updates with awkward chunk sizes must match one-shot
+    sm4_gmac(gcm_key, gcm_iv, 12, aad, sizeof(aad), ref_tag, 16);
+
+    const size_t chunks[] = {1, 7, 15, 16, 33, 129};
+    for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++)
+    {
+        sm4_gmac_init(&ctx, gcm_key, gcm_iv, 12);
+        for (i = 0; i < sizeof(aad); i += chunks[c])
+        {
+            size_t n = sizeof(aad) - i < chunks[c] ? sizeof(aad) - i : chunks[c];
+            sm4_gmac_update(&ctx, aad + i, n);
+        }
+        sm4_gmac_final(&ctx, tag, 16);
+        if (compare_arrays(tag, ref_tag, 16, "GMAC incremental") != 0)
+        {
+            return -1;
+        }
+    }
+
+    // Batch API must match per-message results
+    const uint8_t *ivs[4] = {gcm_iv, gcm_iv, gcm_iv, gcm_iv};
+    const uint8_t *msgs[4] = {aad, aad + 1, aad + 100, aad};
+    const size_t lens[4] = {100, 999, 0, 1000};
+    uint8_t batch_tags[4 * 16];
+
+    if (sm4_gmac_batch(gcm_key, ivs, 12, msgs, lens, 4, batch_tags, 16) != 0)
+    {
+        return -1;
+    }
+    for (i = 0; i < 4; i++)
+    {
+        sm4_gmac(gcm_key, gcm_iv, 12, msgs[i], lens[i], ref_tag, 16);
+        if (compare_arrays(batch_tags + i * 16, ref_tag, 16, "GMAC batch") != 0)
+        {
+            return -1;
+        }
+    }
+
+    // Portable table backend must agree with the carry-less multiply backend
+    sm4_ghash_key gk;
+    uint8_t X1[16] = {0}, X2[16] = {0};
+
+    sm4_ghash_setkey(&gk, gmac_tag_iv12);
+    sm4_ghash_blocks(&gk, X1, aad, sizeof(aad) / 16);
+    gk.use_pclmul = 0;
+    sm4_ghash_blocks(&gk, X2, aad, sizeof(aad) / 16);
+    if (compare_arrays(X1, X2, 16, "GHASH backends") != 0)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+// Test the multi-block kernels against single-block ECB
+static int test_multiblock(void)
+{
+    uint8_t in[40 * 16], out[40 * 16], ref[40 * 16];
+    sm4_context enc, dec;
+    sm4_blocks_backend backends[8];
+    size_t nbackends, b, n, i;
+
+    printf("\n  Backend: %s\n  ", sm4_blocks_backend_name());
+
+    for (i = 0; i < sizeof(in); i++)
+    {
+        in[i] = (uint8_t)(i * 13 + 1);
+    }
+    sm4_setkey_enc(&enc, test_key1);
+    sm4_setkey_dec(&dec, test_key1);
+
+    // Every kernel this CPU can run, over partial, exact and multiple kernel widths
+    nbackends = sm4_blocks_backends(backends, 8);
+    for (b = 0; b < nbackends; b++)
+    {
+        for (n = 1; n <= 40; n++)
+        {
+            sm4_crypt_blocks_scalar(&enc, in, ref, n);
+            backends[b].crypt(&enc, in, out, n);
+            if (compare_arrays(out, ref, n * 16, backends[b].name) != 0)
+            {
+                return -1;
+            }
+
+            backends[b].crypt(&dec, out, out, n);
+            if (compare_arrays(out, in, n * 16, backends[b].name) != 0)
+            {
+                return -1;
+            }
+        }
+    }
+
+    sm4_crypt_blocks(&enc, test_plaintext1, out, 1);
+    return compare_arrays(out, test_ciphertext1, 16, "Multi-block KAT");
+}
+
+// Test ECB/CTR/CBC (known answers, then long inputs against the one-block path)
+static int test_block_modes(void)
+{
+    uint8_t msg[600], out[600], ref[600], iv[16], ctr[16];
+    sm4_context enc, dec;
+    size_t i, b;
+
+    for (i = 0; i < sizeof(msg); i++)
+    {
+        msg[i] = (uint8_t)(7 * i + 3);
+    }
+    sm4_setkey_enc(&enc, test_key1);
+    sm4_setkey_dec(&dec, test_key1);
+
+    if (sm4_ecb_crypt(&enc, msg, out, 64) != 0 || compare_arrays(out, ecb_ct64, 64, "ECB") != 0)
+    {
+        return -1;
+    }
+    memcpy(iv, cbc_iv, 16);
+    if (sm4_cbc_encrypt(&enc, iv, msg, out, 64) != 0 || compare_arrays(out, cbc_ct64, 64, "CBC") != 0)
+    {
+        return -1;
+    }
+    memcpy(ctr, ctr_iv, 16);
+    if (sm4_ctr_crypt(&enc, ctr, msg, out, 37) != 0 || compare_arrays(out, ctr_ct37, 37, "CTR") != 0)
+    {
+        return -1;
+    }
+    if (sm4_ecb_crypt(&enc, msg, out, 17) != -1 || sm4_cbc_decrypt(&dec, iv, msg, out, 20) != -1)
+    {
+        printf("Unaligned ECB/CBC length accepted\n");
+        return -1;
+    }
+
+    // CBC over several kernel batches, decrypted in place
+    memcpy(iv, cbc_iv, 16);
+    for (b = 0; b < sizeof(msg) / 16; b++)
+    {
+        uint8_t x[16];
+        for (i = 0; i < 16; i++)
+        {
+            x[i] = msg[16 * b + i] ^ (b ? ref[16 * (b - 1) + i] : cbc_iv[i]);
+        }
+        sm4_crypt_ecb(&enc, 1, x, ref + 16 * b);
+    }
+    memcpy(iv, cbc_iv, 16);
+    sm4_cbc_encrypt(&enc, iv, msg, out, 592);
+    if (compare_arrays(out, ref, 592, "CBC long") != 0)
+    {
+        return -1;
+    }
+    memcpy(iv, cbc_iv, 16);
+    sm4_cbc_decrypt(&dec, iv, out, out, 592);
+    if (compare_arrays(out, msg, 592, "CBC decrypt in place") != 0 ||
+        compare_arrays(iv, ref + 576, 16, "CBC chained IV") != 0)
+    {
+        return -1;
+    }
+
+    // CTR split across calls must match one call
+    memcpy(ctr, ctr_iv, 16);
+    sm4_ctr_crypt(&enc, ctr, msg, ref, sizeof(msg));
+    memcpy(ctr, ctr_iv, 16);
+    sm4_ctr_crypt(&enc, ctr, msg, out, 528);
+    sm4_ctr_crypt(&enc, ctr, msg + 528, out + 528, sizeof(msg) - 528);
+    if (compare_arrays(out, ref, sizeof(msg), "CTR chained") != 0)
+    {
+        return -1;
+    }
+    memcpy(ctr, ctr_iv, 16);
+    sm4_ctr_crypt(&enc, ctr, out, out, sizeof(msg));
+    return compare_arrays(out, msg, sizeof(msg), "CTR decrypt");
+}
+
+// Test CMAC (known answers and the multi-lane batch API)
+static int test_cmac_mode(void)
+{
+    uint8_t msg[600];
+    uint8_t tag[16];
+    size_t i;
+
+    for (i = 0; i < sizeof(msg); i++)
+    {
+        msg[i] = (uint8_t)(7 * i + 3);
+    }
+
+    // Known-answer tests: empty, one full block, partial final block, whole blocks
+    const size_t kat_lens[4] = {0, 16, 37, 64};
+    const uint8_t *kat_tags[4] = {cmac_tag_len0, cmac_tag_len16, cmac_tag_len37, cmac_tag_len64};
+    for (i = 0; i < 4; i++)
+    {
+        if (sm4_cmac(gcm_key, msg, kat_lens[i], tag, 16) != 0 ||
+            compare_arrays(tag, kat_tags[i], 16, "CMAC") != 0)
+        {
+            return -1;
+        }
+    }
+
+    // Batch with mixed lengths (more messages than lanes) must match one-shot
+    enum { COUNT = 3 * SM4_CMAC_LANES + 5 };
+    const uint8_t *msgs[COUNT];
+    size_t lens[COUNT];
+    uint8_t tags[COUNT * 16];
+    uint8_t ref_tag[16];
+
+    for (i = 0; i < COUNT; i++)
+    {
+        msgs[i] = msg + i;
+        lens[i] = (i * 37) % 300;
+    }
+
+    if (sm4_cmac_batch(gcm_key, msgs, lens, COUNT, tags, 16) != 0)
+    {
+        return -1;
+    }
+    for (i = 0; i < COUNT; i++)
+    {
+        sm4_cmac(gcm_key, msgs[i], lens[i], ref_tag, 16);
+        if (compare_arrays(tags + i * 16, ref_tag, 16, "CMAC batch") != 0)
+        {
+            return -1;
+        }
+    }
+
+    // Truncated tags are packed tag_len apart
+    uint8_t short_tags[COUNT * 8];
+    sm4_cmac_batch(gcm_key, msgs, lens, COUNT, short_tags, 8);
+    for (i = 0; i < COUNT; i++)
+    {
+        if (memcmp(short_tags + i * 8, tags + i * 16, 8) != 0)
+        {
+            printf("\nCMAC truncated tag mismatch at %zu\n", i);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+// Test the SM4 CTR_DRBG and the per-thread generator
+static int test_drbg(void)
+{
+    static const uint8_t pers[] = "sm4-ctr-drbg test";
+    static const uint8_t addl[] = "additional input";
+    uint8_t entropy[SM4_DRBG_SEED_LEN];
+    uint8_t out[64], out2[37];
+    sm4_drbg drbg, drbg2;
+    size_t i;
+
+    for (i = 0; i < sizeof(entropy); i++)
+    {
+        entropy[i] = (uint8_t)i;
+    }
+
+    // Known-answer test, including additional input and a partial final block
+    if (sm4_drbg_instantiate(&drbg, entropy, sizeof(entropy), pers, sizeof(pers) - 1) != 0 ||
+        sm4_drbg_generate(&drbg, out, sizeof(out), NULL, 0) != 0 ||
+        compare_arrays(out, drbg_out1, sizeof(out), "DRBG generate") != 0)
+    {
+        return -1;
+    }
+    if (sm4_drbg_generate(&drbg, out2, sizeof(out2), addl, sizeof(addl) - 1) != 0 ||
+        compare_arrays(out2, drbg_out2, sizeof(out2), "DRBG generate (additional input)") != 0)
+    {
+        return -1;
+    }
+
+    // Oversized requests are split at SM4_DRBG_MAX_REQUEST
+    const size_t big = SM4_DRBG_MAX_REQUEST + 1000;
+    uint8_t *a = malloc(big);
+    uint8_t *b = malloc(big);
+    if (!a || !b)
+    {
+        free(a);
+        free(b);
+        return -1;
+    }
+    sm4_drbg_instantiate(&drbg, entropy, sizeof(entropy), NULL, 0);
+    sm4_drbg_instantiate(&drbg2, entropy, sizeof(entropy), NULL, 0);
+    sm4_drbg_generate(&drbg, a, big, NULL, 0);
+    sm4_drbg_generate(&drbg2, b, SM4_DRBG_MAX_REQUEST, NULL, 0);
+    sm4_drbg_generate(&drbg2, b + SM4_DRBG_MAX_REQUEST, big - SM4_DRBG_MAX_REQUEST, NULL, 0);
+    int split_ok = memcmp(a, b, big) == 0;
+    free(a);
+    free(b);
+    sm4_drbg_uninstantiate(&drbg);
+    sm4_drbg_uninstantiate(&drbg2);
+    if (!split_ok)
+    {
+        printf("\nDRBG request splitting mismatch\n");
+        return -1;
+    }
+
+    // Bad lengths are rejected
+    if (sm4_drbg_instantiate(&drbg, entropy, 16, NULL, 0) == 0 ||
+        sm4_drbg_instantiate(&drbg, entropy, sizeof(entropy), entropy, 33) == 0)
+    {
+        printf("\nDRBG accepted invalid input lengths\n");
+        return -1;
+    }
+
+    // Fresh IVs from the getrandom-seeded generator
+    uint8_t iv1[12], iv2[12];
+    if (sm4_gcm_generate_iv(iv1, 12) != 0 || sm4_gcm_generate_iv(iv2, 12) != 0 ||
+        memcmp(iv1, iv2, 12) == 0)
+    {
+        printf("\nIV generation failed\n");
+        return -1;
+    }
+
+    // sm4_srand gives a reproducible stream; small and large reads both work
+    uint8_t r1[300], r2[300];
+    sm4_srand(42);
+    sm4_rand_bytes(r1, 7);
+    sm4_rand_bytes(r1 + 7, 293);
+    sm4_gcm_generate_iv(iv1, 12);
+    sm4_srand(42);
+    sm4_rand_bytes(r2, 7);
+    sm4_rand_bytes(r2 + 7, 293);
+    sm4_gcm_generate_iv(iv2, 12);
+    if (memcmp(r1, r2, sizeof(r1)) != 0)
+    {
+        printf("\nsm4_srand stream not reproducible\n");
+        return -1;
+    }
+
+    // ...but never reaches the IV stream
+    if (memcmp(iv1, iv2, 12) == 0)
+    {
+        printf("\nsm4_srand made GCM IVs repeat\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+// Test GCM on a prepared key and the key cache
+static int test_key_cache(void)
+{
+    uint8_t pt[100], ct[100], dec[100], tag[16];
+    uint8_t iv20[20];
+    sm4_prepared_key pk;
+    size_t i;
+
+    for (i = 0; i < sizeof(pt); i++)
+    {
+        pt[i] = (uint8_t)(7 * i + 3);
+    }
+    for (i = 0; i < sizeof(iv20); i++)
+    {
+        iv20[i] = (uint8_t)i;
+    }
+
+    // Known answer, round trip and tamper detection
+    sm4_prepare_key(&pk, gcm_key);
+    if (sm4_gcm_encrypt_prepared(&pk, gcm_iv, 12, gcm_aad, sizeof(gcm_aad), pt, sizeof(pt), ct, tag, 16) != 0 ||
+        compare_arrays(ct, gcm_prepared_ct, sizeof(ct), "Prepared GCM ciphertext") != 0 ||
+        compare_arrays(tag, gcm_prepared_tag, 16, "Prepared GCM tag") != 0)
+    {
+        return -1;
+    }
+    if (sm4_gcm_decrypt_prepared(&pk, gcm_iv, 12, gcm_aad, sizeof(gcm_aad), ct, sizeof(ct), tag, 16, dec) != 0 ||
+        compare_arrays(dec, pt, sizeof(pt), "Prepared GCM decrypt") != 0)
+    {
+        return -1;
+    }
+    ct[50] ^= 1;
+    if (sm4_gcm_decrypt_prepared(&pk, gcm_iv, 12, gcm_aad, sizeof(gcm_aad), ct, sizeof(ct), tag, 16, dec) != -2)
+    {
+        printf("\nPrepared GCM accepted a modified ciphertext\n");
+        return -1;
+    }
+
+    // Truncated tags below the minimum are refused, so an empty tag cannot verify
+    ct[50] ^= 1;
+    if (sm4_gcm_encrypt_prepared(&pk, gcm_iv, 12, NULL, 0, pt, sizeof(pt), ct, tag, 0) != -1 ||
+        sm4_gcm_encrypt_prepared(&pk, gcm_iv, 12, NULL, 0, pt, sizeof(pt), ct, tag, SM4_GCM_MIN_TAG_LEN - 1) != -1 ||
+        sm4_gcm_decrypt_prepared(&pk, gcm_iv, 12, NULL, 0, ct, sizeof(ct), tag, 0, dec) != -1 ||
+        sm4_gcm_decrypt_prepared(&pk, gcm_iv, 12, NULL, 0, ct, sizeof(ct), tag, SM4_GCM_MIN_TAG_LEN - 1, dec) != -1)
+    {
+        printf("\nPrepared GCM accepted a tag shorter than %d bytes\n", SM4_GCM_MIN_TAG_LEN);
+        return -1;
+    }
+    if (sm4_gcm_encrypt_prepared(&pk, gcm_iv, 12, NULL, 0, pt, sizeof(pt), ct, tag, SM4_GCM_MIN_TAG_LEN) != 0 ||
+        sm4_gcm_decrypt_prepared(&pk, gcm_iv, 12, NULL, 0, ct, sizeof(ct), tag, SM4_GCM_MIN_TAG_LEN, dec) != 0)
+    {
+        printf("\nPrepared GCM rejected a %d-byte tag\n", SM4_GCM_MIN_TAG_LEN);
+        return -1;
+    }
+
+    // With no plaintext GCM degenerates to GMAC
+    if (sm4_gcm_encrypt_prepared(&pk, iv20, sizeof(iv20), pt, 100, NULL, 0, NULL, tag, 16) != 0 ||
+        compare_arrays(tag, gmac_tag_iv20, 16, "Prepared GCM as GMAC") != 0)
+    {
+        return -1;
+    }
+
+    // Small cache: more keys than slots forces eviction
+    sm4_key_cache *cache = sm4_key_cache_create(64 * 1024, 4);
+    sm4_key_cache_stats st;
+    if (!cache)
+    {
+        return -1;
+    }
+    sm4_key_cache_get_stats(cache, &st);
+    const uint64_t nkeys = 3 * st.capacity;
+
+    // Key 0 stays pinned throughout and must survive eviction
+    uint8_t key[16];
+    memset(key, 0, sizeof(key));
+    const sm4_prepared_key *pinned = sm4_key_cache_put(cache, 0, key);
+    if (!pinned)
+    {
+        sm4_key_cache_destroy(cache);
+        return -1;
+    }
+
+    for (uint64_t id = 1; id < nkeys; id++)
+    {
+        const sm4_prepared_key *e = sm4_key_cache_get(cache, id);
+        if (e)
+        {
+            printf("\nUnexpected hit for new key %llu\n", (unsigned long long)id);
+            sm4_key_cache_destroy(cache);
+            return -1;
+        }
+
+        memcpy(key, &id, sizeof(id));
+        e = sm4_key_cache_put(cache, id, key);
+        if (!e)
+        {
+            printf("\nInsert failed for key %llu\n", (unsigned long long)id);
+            sm4_key_cache_destroy(cache);
+            return -1;
+        }
+
+        sm4_prepare_key(&pk, key);
+        if (memcmp(e, &pk, sizeof(pk)) != 0)
+        {
+            printf("\nCached key material differs for key %llu\n", (unsigned long long)id);
+            sm4_key_cache_destroy(cache);
+            return -1;
+        }
+        sm4_key_cache_release(cache, e);
+
+        e = sm4_key_cache_get(cache, id);
+        if (!e)
+        {
+            printf("\nMiss right after insert for key %llu\n", (unsigned long long)id);
+            sm4_key_cache_destroy(cache);
+            return -1;
+        }
+        sm4_key_cache_release(cache, e);
+    }
+
+    const sm4_prepared_key *again = sm4_key_cache_get(cache, 0);
+    if (again != pinned)
+    {
+        printf("\nPinned key was evicted\n");
+        sm4_key_cache_destroy(cache);
+        return -1;
+    }
+    sm4_key_cache_release(cache, again);
+
+    sm4_key_cache_get_stats(cache, &st);
+    printf("\n  capacity %zu, entries %zu, hits %llu, misses %llu, evictions %llu\n  ",
+           st.capacity, st.entries, (unsigned long long)st.hits,
+           (unsigned long long)st.misses, (unsigned long long)st.evictions);
+    if (st.entries > st.capacity || st.evictions == 0 || st.hits != nkeys || st.misses != nkeys - 1)
+    {
+        printf("\nUnexpected cache statistics\n");
+        sm4_key_cache_destroy(cache);
+        return -1;
+    }
+
+    // Removing a pinned key hides it at once; the slot is wiped on release
+    if (sm4_key_cache_remove(cache, 0) != 0 || sm4_key_cache_get(cache, 0) != NULL)
+    {
+        printf("\nRemoved key still visible\n");
+        sm4_key_cache_destroy(cache);
+        return -1;
+    }
+    sm4_key_cache_release(cache, pinned);
+    if (sm4_key_cache_remove(cache, 0) != -1)
+    {
+        sm4_key_cache_destroy(cache);
+        return -1;
+    }
+
+    sm4_key_cache_destroy(cache);
+    return 0;
+}
+
 // Test random data
 static int test_random_data(void)
 {
@@ -362,6 +922,13 @@ int main(void)
     run_test("Key Expansion", test_key_expansion);
     run_test("Million Rounds Test", test_million_rounds);
     run_test("GCM Mode", test_gcm_mode);
+    run_test("GCM Optimized Per-key GHASH", test_gcm_opt_per_key);
+    run_test("GMAC Mode", test_gmac_mode);
+    run_test("Multi-block Kernels", test_multiblock);
+    run_test("ECB/CTR/CBC Modes", test_block_modes);
+    run_test("CMAC Mode", test_cmac_mode);
+    run_test("CTR_DRBG", test_drbg);
+    run_test("Key Cache", test_key_cache);
     run_test("Random Data Test", test_random_data);
 
     // Print summary
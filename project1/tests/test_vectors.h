@@ -50,4 +50,116 @@ static const uint8_t gcm_plaintext[16] = {
 
 // Expected results will be computed during testing
 
+// GMAC test vectors (key = gcm_key, AAD[i] = (7 * i + 3) mod 256, 100 bytes)
+static const uint8_t gmac_tag_iv12[16] = {
+    0x6c, 0xc0, 0x45, 0x54, 0xd5, 0xbd, 0x09, 0x94,
+    0x8f, 0x9a, 0x9c, 0x60, 0xaa, 0x48, 0x36, 0x09};
+
+// Same AAD with IV = 00 01 .. 13 (20 bytes, exercises the GHASH-derived J0)
+static const uint8_t gmac_tag_iv20[16] = {
+    0x0c, 0xce, 0xbb, 0x16, 0xdc, 0xe7, 0xb2, 0x7b,
+    0x82, 0xe8, 0x71, 0x6d, 0x96, 0x63, 0x4c, 0x2f};
+
+// Empty AAD with gcm_iv
+static const uint8_t gmac_tag_empty[16] = {
+    0x56, 0xc4, 0x4d, 0x3e, 0xff, 0xc1, 0x54, 0x04,
+    0x56, 0xa3, 0xfa, 0xd9, 0x39, 0xc1, 0x75, 0x56};
+
+// CMAC test vectors (key = gcm_key, M[i] = (7 * i + 3) mod 256, checked against OpenSSL SM4-CBC CMAC)
+static const uint8_t cmac_tag_len0[16] = {
+    0x4d, 0xcf, 0x78, 0xc7, 0x3b, 0x13, 0xa3, 0xb9,
+    0x49, 0x4d, 0xe1, 0x15, 0x2e, 0x66, 0xe9, 0xef};
+
+static const uint8_t cmac_tag_len16[16] = {
+    0xab, 0x69, 0x62, 0x95, 0x51, 0xe6, 0xc7, 0x01,
+    0x87, 0x6e, 0x46, 0xbd, 0x2c, 0x64, 0xbd, 0xe8};
+
+static const uint8_t cmac_tag_len37[16] = {
+    0xc5, 0xa3, 0xb5, 0x17, 0xdf, 0x66, 0x64, 0xb8,
+    0xd8, 0x70, 0x09, 0xa7, 0x16, 0x22, 0xbf, 0xc8};
+
+static const uint8_t cmac_tag_len64[16] = {
+    0x67, 0x7b, 0xfc, 0xf3, 0xb1, 0xfb, 0x31, 0x0d,
+    0xb1, 0xbb, 0x7b, 0x86, 0xdc, 0xc2, 0x24, 0xf0};
+
+// CTR_DRBG test vectors (SM4, no df): entropy = 00..1f, personalization = "sm4-ctr-drbg test"
+// Computed with an independent Python model of SP 800-90A on top of OpenSSL SM4-ECB
+// First generate: 64 bytes, no additional input
+static const uint8_t drbg_out1[64] = {
+    0x00, 0x90, 0xe5, 0x0f, 0x9f, 0xb3, 0x06, 0x98,
+    0x99, 0xcb, 0xc3, 0xc9, 0x90, 0x5a, 0x40, 0x8f,
+    0x84, 0x62, 0xf2, 0x21, 0x35, 0xda, 0x3d, 0xf5,
+    0xbf, 0x46, 0x97, 0x61, 0xcf, 0x50, 0x07, 0xe4,
+    0x16, 0xf6, 0xa8, 0x4e, 0x9a, 0x01, 0xe2, 0x85,
+    0x09, 0x34, 0xc1, 0x7b, 0x93, 0x2d, 0xad, 0x6f,
+    0x7b, 0x58, 0x38, 0x8f, 0x61, 0x2a, 0xfe, 0x0a,
+    0xc5, 0x24, 0xc5, 0x03, 0xc7, 0x78, 0x98, 0x4b};
+
+// Second generate: 37 bytes, additional input = "additional input"
+static const uint8_t drbg_out2[37] = {
+    0x34, 0xc4, 0x92, 0x6a, 0xd4, 0x32, 0xa5, 0xb6,
+    0xe5, 0x36, 0x50, 0x71, 0xd0, 0xde, 0x21, 0x8b,
+    0x9b, 0x75, 0xfe, 0x54, 0xf6, 0x3d, 0x9e, 0x27,
+    0xf8, 0x6b, 0xe8, 0xc5, 0xe6, 0x19, 0x0c, 0x5b,
+    0xf5, 0xc8, 0x31, 0x8d, 0xb0};
+
+// GCM on a prepared key: key = gcm_key, IV = gcm_iv, AAD = gcm_aad, P[i] = (7 * i + 3) mod 256, 100 bytes
+static const uint8_t gcm_prepared_ct[100] = {
+    0x94, 0x4c, 0xcf, 0xe3, 0xd6, 0x4c, 0xa8, 0x34,
+    0xc4, 0xde, 0x3d, 0x1d, 0x86, 0xe5, 0x9c, 0x0a,
+    0x52, 0xed, 0x80, 0x43, 0xbe, 0x9f, 0x88, 0x53,
+    0x5c, 0x5a, 0x7b, 0x8c, 0xc5, 0x10, 0x5b, 0x0d,
+    0x68, 0x08, 0xaf, 0x45, 0x90, 0x6a, 0x20, 0x9d,
+    0x31, 0xbb, 0xb2, 0x1e, 0x78, 0x35, 0xe3, 0xed,
+    0xe7, 0x15, 0xbc, 0x58, 0x8f, 0x3d, 0xf5, 0x6c,
+    0xcd, 0xcc, 0x5b, 0xae, 0xff, 0x77, 0x8f, 0x61,
+    0x90, 0x43, 0x80, 0x3b, 0x3a, 0x17, 0xae, 0x14,
+    0x7a, 0xd1, 0xe2, 0xf5, 0xc4, 0xaa, 0x9e, 0x8e,
+    0xca, 0x5e, 0x3c, 0x3e, 0xaf, 0xda, 0x82, 0xc3,
+    0x83, 0xb7, 0xae, 0xee, 0x59, 0xe6, 0x64, 0x13,
+    0xe2, 0xe5, 0x7a, 0x0f};
+
+static const uint8_t gcm_prepared_tag[16] = {
+    0x79, 0xe8, 0x7f, 0x7c, 0x29, 0x70, 0x68, 0xce,
+    0x86, 0xcc, 0x62, 0xde, 0xc1, 0xfb, 0x0c, 0xa4};
+
+// Block modes: key = test_key1, P[i] = (7 * i + 3) mod 256
+// ECB, 64 bytes
+static const uint8_t ecb_ct64[64] = {
+    0x7f, 0x83, 0xeb, 0x6c, 0x5a, 0x41, 0x6a, 0x93,
+    0xec, 0x81, 0xbb, 0xbb, 0xa1, 0x94, 0x82, 0xce,
+    0x14, 0x59, 0xa8, 0x40, 0x11, 0xc8, 0x5c, 0xb4,
+    0x9b, 0xe3, 0xf6, 0x04, 0x57, 0x42, 0x86, 0xed,
+    0x77, 0x43, 0x57, 0x64, 0x01, 0x63, 0x21, 0x3d,
+    0xaf, 0xf2, 0xad, 0x1c, 0xaf, 0x67, 0x1c, 0x12,
+    0xa8, 0xca, 0xde, 0x62, 0x51, 0x8d, 0x07, 0xd0,
+    0x15, 0xf1, 0xba, 0xc6, 0xe7, 0x70, 0x5b, 0xf1};
+
+// CBC, IV = 000102...0f, 64 bytes
+static const uint8_t cbc_iv[16] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f};
+
+static const uint8_t cbc_ct64[64] = {
+    0xfd, 0xbb, 0x91, 0xd7, 0x06, 0x27, 0x50, 0x72,
+    0x24, 0xeb, 0x79, 0x47, 0x07, 0xf8, 0x2a, 0xa5,
+    0xb3, 0xdd, 0x73, 0x63, 0x3d, 0x2c, 0x1a, 0x6b,
+    0xa1, 0xbb, 0x39, 0xac, 0x62, 0x92, 0x09, 0xdd,
+    0xbe, 0x58, 0x4c, 0x65, 0xa2, 0x99, 0x43, 0x93,
+    0x98, 0x41, 0xe4, 0x8c, 0x48, 0xdc, 0x94, 0x8c,
+    0x56, 0xb2, 0x9e, 0x4b, 0x38, 0x88, 0x9a, 0xa1,
+    0x23, 0x38, 0x29, 0x82, 0x6b, 0x6b, 0xb2, 0xca};
+
+// CTR, 37 bytes; the initial counter carries out of the low 64 bits
+static const uint8_t ctr_iv[16] = {
+    0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+
+static const uint8_t ctr_ct37[37] = {
+    0x68, 0xd1, 0xb5, 0x98, 0x43, 0xab, 0x0b, 0x02,
+    0x08, 0x85, 0x92, 0x50, 0x35, 0xbb, 0x29, 0x69,
+    0x60, 0x7c, 0xf5, 0x56, 0x0a, 0x91, 0x84, 0x4a,
+    0xb1, 0xd4, 0x67, 0x49, 0x96, 0x76, 0xa4, 0xb4,
+    0x76, 0x5c, 0x15, 0x2e, 0xb1};
+
 #endif // TEST_VECTORS_H
@@ -0,0 +1,38 @@
+#include <stdio.h>
+#include "../src/sm3.h"
+#include "../../bench/bench_latency.h"
+
+// SM3 per-call latency for small messages (see bench/bench_latency.h).
+// SM3 has no key, so only the warm/cold cache runs apply.
+
+typedef void (*hash_func)(const uint8_t *, size_t, uint8_t *);
+
+static hash_func hash_basic = sm3_hash;
+static hash_func hash_optimized = sm3_hash_optimized;
+
+static void call_hash(void *arg, const uint8_t *key, int new_key, uint8_t *buf, size_t len)
+{
+    uint8_t digest[32];
+    hash_func f = *(hash_func *)arg;
+    (void)key;
+    (void)new_key;
+    f(buf, len, digest);
+}
+
+int main(int argc, char **argv)
+{
+    bench_latency_options opt;
+    int rc = bench_latency_parse_args(&opt, "project4-sm3-latency", argc, argv);
+
+    if (rc != 0)
+    {
+        return rc > 0 ? 0 : 1;
+    }
+
+    const bench_latency_case cases[] = {
+        {"sm3", "sm3_hash", &hash_basic, 0, NULL, call_hash},
+        {"sm3", "sm3_hash_optimized", &hash_optimized, 0, NULL, call_hash},
+    };
+
+    return bench_latency_run(cases, sizeof(cases) / sizeof(cases[0]), &opt) == 0 ? 0 : 1;
+}
@@ -76,6 +76,550 @@ void benchmark_sm3_implementations()
     printf("\n");
 }
 
+void benchmark_sm3_drbg()
+{
+    printf("SM3 Hash_DRBG Generate Benchmark\n");
+    printf("================================\n\n");
+
+    const size_t req_sizes[] = {32, 256, 4096, SM3_DRBG_MAX_REQUEST};
+    const int num_sizes = sizeof(req_sizes) / sizeof(req_sizes[0]);
+    const size_t total_bytes = 16 * 1024 * 1024;
+    uint8_t entropy[32] = {1}, nonce[16] = {2};
+    uint8_t *out = malloc(SM3_DRBG_MAX_REQUEST);
+    sm3_drbg_t drbg;
+
+    if (!out)
+    {
+        printf("Memory allocation failed\n");
+        return;
+    }
+    sm3_drbg_instantiate(&drbg, entropy, sizeof(entropy), nonce, sizeof(nonce), NULL, 0);
+
+    printf("%-10s %-30s %-15s %-10s\n", "Request", "Method", "MB/s", "Speedup");
+    printf("----------------------------------------------------------------\n");
+
+    for (int i = 0; i < num_sizes; i++)
+    {
+        size_t requests = total_bytes / req_sizes[i];
+        struct timeval start, end;
+
+        // Hashgen one SM3(V + i) at a time, plus a V update hashing as many
+        // blocks as SM3(0x03 || V)
+        uint8_t v[SM3_DRBG_SEED_LEN + 1] = {0x03};
+        memcpy(v + 1, drbg.V, SM3_DRBG_SEED_LEN);
+        gettimeofday(&start, NULL);
+        for (size_t r = 0; r < requests; r++)
+        {
+            uint8_t data[SM3_DRBG_SEED_LEN], h[SM3_DIGEST_SIZE];
+            memcpy(data, v + 1, sizeof(data));
+            for (size_t off = 0; off < req_sizes[i]; off += SM3_DIGEST_SIZE)
+            {
+                sm3_hash_optimized(data, sizeof(data), out + off);
+                for (int b = SM3_DRBG_SEED_LEN - 1; b >= 0 && ++data[b] == 0; b--)
+                {
+                }
+            }
+            sm3_hash_optimized(v, sizeof(v), h);
+            v[SM3_DRBG_SEED_LEN] ^= h[0];
+        }
+        gettimeofday(&end, NULL);
+        double seq_rate = total_bytes / get_time_diff(start, end) / (1024 * 1024);
+        printf("%-10zu %-30s %-15.2f %-10s\n", req_sizes[i], "one SM3 per block", seq_rate, "1.00x");
+
+        gettimeofday(&start, NULL);
+        for (size_t r = 0; r < requests; r++)
+        {
+            if (sm3_drbg_generate(&drbg, out, req_sizes[i], NULL, 0) == SM3_DRBG_NEED_RESEED)
+            {
+                sm3_drbg_reseed(&drbg, entropy, sizeof(entropy), NULL, 0);
+            }
+        }
+        gettimeofday(&end, NULL);
+        double gen_rate = total_bytes / get_time_diff(start, end) / (1024 * 1024);
+        printf("%-10s %-30s %-15.2f %.2fx\n", "", "sm3_drbg_generate", gen_rate, gen_rate / seq_rate);
+
+        gettimeofday(&start, NULL);
+        for (size_t r = 0; r < requests; r++)
+        {
+            sm3_drbg_random(out, req_sizes[i]);
+        }
+        gettimeofday(&end, NULL);
+        double thread_rate = total_bytes / get_time_diff(start, end) / (1024 * 1024);
+        printf("%-10s %-30s %-15.2f %.2fx\n", "", "sm3_drbg_random (per-thread)", thread_rate,
+               thread_rate / seq_rate);
+    }
+    printf("\n");
+
+    sm3_drbg_uninstantiate(&drbg);
+    free(out);
+}
+
+void benchmark_sm3_hash_many()
+{
+    printf("SM3 Multi-Buffer Benchmark (independent messages)\n");
+    printf("==================================================\n\n");
+
+    const size_t msg_sizes[] = {32, 64, 128, 256, 1024};
+    const int num_sizes = sizeof(msg_sizes) / sizeof(msg_sizes[0]);
+    const size_t num_msgs = 4096;
+    const int iterations = 20;
+    sm3_many_backend backends[4];
+    size_t nb = sm3_hash_many_backends(backends, 4);
+
+    printf("%-10s %-22s %-15s %-10s\n", "Msg size", "Backend", "Mhashes/s", "vs loop");
+    printf("------------------------------------------------------------\n");
+
+    uint8_t *data = malloc(num_msgs * msg_sizes[num_sizes - 1]);
+    const uint8_t **msgs = malloc(num_msgs * sizeof(*msgs));
+    size_t *lens = malloc(num_msgs * sizeof(*lens));
+    uint8_t *digests = malloc(num_msgs * SM3_DIGEST_SIZE);
+    if (!data || !msgs || !lens || !digests)
+    {
+        printf("Memory allocation failed\n");
+        free(data);
+        free(msgs);
+        free(lens);
+        free(digests);
+        return;
+    }
+    for (size_t j = 0; j < num_msgs * msg_sizes[num_sizes - 1]; j++)
+    {
+        data[j] = (uint8_t)(j & 0xFF);
+    }
+
+    for (int i = 0; i < num_sizes; i++)
+    {
+        struct timeval start, end;
+
+        for (size_t m = 0; m < num_msgs; m++)
+        {
+            msgs[m] = data + m * msg_sizes[i];
+            lens[m] = msg_sizes[i];
+        }
+
+        gettimeofday(&start, NULL);
+        for (int iter = 0; iter < iterations; iter++)
+        {
+            for (size_t m = 0; m < num_msgs; m++)
+            {
+                sm3_hash_optimized(msgs[m], lens[m], digests + m * SM3_DIGEST_SIZE);
+            }
+        }
+        gettimeofday(&end, NULL);
+        double loop_rate = num_msgs * iterations / get_time_diff(start, end) / 1e6;
+        printf("%-10zu %-22s %-15.3f %-10s\n", msg_sizes[i], "sm3_hash_optimized", loop_rate, "1.00x");
+
+        for (size_t b = 0; b < nb; b++)
+        {
+            gettimeofday(&start, NULL);
+            for (int iter = 0; iter < iterations; iter++)
+            {
+                backends[b].hash_many(msgs, lens, num_msgs, digests);
+            }
+            gettimeofday(&end, NULL);
+            double rate = num_msgs * iterations / get_time_diff(start, end) / 1e6;
+            printf("%-10s %-22s %-15.3f %.2fx\n", "", backends[b].name, rate, rate / loop_rate);
+        }
+    }
+    printf("\n");
+
+    free(data);
+    free(msgs);
+    free(lens);
+    free(digests);
+}
+
+void benchmark_hmac_sm3()
+{
+    printf("HMAC-SM3 Verify Benchmark (4 long-lived keys)\n");
+    printf("===============================================\n\n");
+
+    const size_t msg_sizes[] = {64, 256, 1024};
+    const int num_sizes = sizeof(msg_sizes) / sizeof(msg_sizes[0]);
+    const size_t num_msgs = 4096;
+    const int iterations = 10;
+    const uint8_t raw_key[4][32] = {{1}, {2}, {3}, {4}};
+    hmac_sm3_key_t keys[4];
+
+    printf("%-10s %-22s %-15s %-10s\n", "Msg size", "Method", "Mverifies/s", "vs setkey");
+    printf("------------------------------------------------------------\n");
+
+    uint8_t *data = malloc(num_msgs * msg_sizes[num_sizes - 1]);
+    const uint8_t **msgs = malloc(num_msgs * sizeof(*msgs));
+    const uint8_t **macs = malloc(num_msgs * sizeof(*macs));
+    const hmac_sm3_key_t **key_of = malloc(num_msgs * sizeof(*key_of));
+    size_t *lens = malloc(num_msgs * sizeof(*lens));
+    uint8_t *mac_data = malloc(num_msgs * HMAC_SM3_SIZE);
+    int *results = malloc(num_msgs * sizeof(*results));
+    if (!data || !msgs || !macs || !key_of || !lens || !mac_data || !results)
+    {
+        printf("Memory allocation failed\n");
+        free(data);
+        free(msgs);
+        free(macs);
+        free(key_of);
+        free(lens);
+        free(mac_data);
+        free(results);
+        return;
+    }
+    for (size_t j = 0; j < num_msgs * msg_sizes[num_sizes - 1]; j++)
+    {
+        data[j] = (uint8_t)(j & 0xFF);
+    }
+    for (int k = 0; k < 4; k++)
+    {
+        hmac_sm3_setkey(&keys[k], raw_key[k], sizeof(raw_key[k]));
+    }
+
+    for (int i = 0; i < num_sizes; i++)
+    {
+        struct timeval start, end;
+        size_t failures = 0;
+
+        for (size_t m = 0; m < num_msgs; m++)
+        {
+            msgs[m] = data + m * msg_sizes[i];
+            lens[m] = msg_sizes[i];
+            key_of[m] = &keys[m % 4];
+            macs[m] = mac_data + m * HMAC_SM3_SIZE;
+            hmac_sm3(key_of[m], msgs[m], lens[m], mac_data + m * HMAC_SM3_SIZE);
+        }
+
+        // Key schedule (ipad/opad compressions) redone for every message
+        gettimeofday(&start, NULL);
+        for (int iter = 0; iter < iterations; iter++)
+        {
+            for (size_t m = 0; m < num_msgs; m++)
+            {
+                hmac_sm3_key_t k;
+                hmac_sm3_setkey(&k, raw_key[m % 4], sizeof(raw_key[0]));
+                failures += hmac_sm3_verify(&k, msgs[m], lens[m], macs[m]) != 0;
+            }
+        }
+        gettimeofday(&end, NULL);
+        double base_rate = num_msgs * iterations / get_time_diff(start, end) / 1e6;
+        printf("%-10zu %-22s %-15.3f %-10s\n", msg_sizes[i], "setkey per message", base_rate, "1.00x");
+
+        gettimeofday(&start, NULL);
+        for (int iter = 0; iter < iterations; iter++)
+        {
+            for (size_t m = 0; m < num_msgs; m++)
+            {
+                failures += hmac_sm3_verify(key_of[m], msgs[m], lens[m], macs[m]) != 0;
+            }
+        }
+        gettimeofday(&end, NULL);
+        double cached_rate = num_msgs * iterations / get_time_diff(start, end) / 1e6;
+        printf("%-10s %-22s %-15.3f %.2fx\n", "", "cached midstates", cached_rate, cached_rate / base_rate);
+
+        gettimeofday(&start, NULL);
+        for (int iter = 0; iter < iterations; iter++)
+        {
+            failures += hmac_sm3_verify_many(key_of, msgs, lens, macs, num_msgs, results);
+        }
+        gettimeofday(&end, NULL);
+        double batch_rate = num_msgs * iterations / get_time_diff(start, end) / 1e6;
+        printf("%-10s %-22s %-15.3f %.2fx\n", "", "hmac_sm3_verify_many", batch_rate, batch_rate / base_rate);
+
+        if (failures)
+        {
+            printf("  %zu verifications failed\n", failures);
+        }
+    }
+    printf("\n");
+
+    free(data);
+    free(msgs);
+    free(macs);
+    free(key_of);
+    free(lens);
+    free(mac_data);
+    free(results);
+}
+
+void benchmark_sm3_kdf()
+{
+    printf("SM3 KDF Benchmark (Z = 64-byte SM2 point)\n");
+    printf("==========================================\n\n");
+
+    const size_t out_sizes[] = {256, 1024, 4096, 16384};
+    const int num_sizes = sizeof(out_sizes) / sizeof(out_sizes[0]);
+    const int iterations = 2000;
+    uint8_t z[64];
+    uint8_t *out = malloc(out_sizes[num_sizes - 1]);
+
+    if (!out)
+    {
+        printf("Memory allocation failed\n");
+        return;
+    }
+    for (int i = 0; i < 64; i++)
+    {
+        z[i] = (uint8_t)(i * 7);
+    }
+
+    printf("%-10s %-22s %-15s %-10s\n", "Output", "Method", "MB/s", "Speedup");
+    printf("------------------------------------------------------------\n");
+
+    for (int i = 0; i < num_sizes; i++)
+    {
+        struct timeval start, end;
+
+        // SM3(Z || ct) one counter at a time
+        gettimeofday(&start, NULL);
+        for (int iter = 0; iter < iterations; iter++)
+        {
+            for (uint32_t ct = 1; (ct - 1) * SM3_DIGEST_SIZE < out_sizes[i]; ct++)
+            {
+                uint8_t ctbuf[4] = {(uint8_t)(ct >> 24), (uint8_t)(ct >> 16), (uint8_t)(ct >> 8), (uint8_t)ct};
+                sm3_ctx_t ctx;
+                sm3_init_optimized(&ctx);
+                sm3_update_optimized(&ctx, z, sizeof(z));
+                sm3_update_optimized(&ctx, ctbuf, 4);
+                sm3_final_optimized(&ctx, out + (ct - 1) * SM3_DIGEST_SIZE);
+            }
+        }
+        gettimeofday(&end, NULL);
+        double seq_rate = out_sizes[i] * (double)iterations / get_time_diff(start, end) / (1024 * 1024);
+        printf("%-10zu %-22s %-15.2f %-10s\n", out_sizes[i], "sequential", seq_rate, "1.00x");
+
+        gettimeofday(&start, NULL);
+        for (int iter = 0; iter < iterations; iter++)
+        {
+            sm3_kdf(z, sizeof(z), out, out_sizes[i]);
+        }
+        gettimeofday(&end, NULL);
+        double kdf_rate = out_sizes[i] * (double)iterations / get_time_diff(start, end) / (1024 * 1024);
+        printf("%-10s %-22s %-15.2f %.2fx\n", "", "sm3_kdf", kdf_rate, kdf_rate / seq_rate);
+    }
+    printf("\n");
+
+    free(out);
+}
+
+void benchmark_pbkdf2_sm3()
+{
+    printf("PBKDF2-HMAC-SM3 Benchmark (32-byte keys, one core)\n");
+    printf("==================================================\n\n");
+
+    const uint32_t iterations = 10000;
+    const size_t num_pws = 64;
+    uint8_t pw_data[64][16], salt_data[64][16];
+    const uint8_t *pws[64], *salts[64];
+    size_t pwlens[64], saltlens[64];
+    uint8_t out[64 * SM3_DIGEST_SIZE];
+    struct timeval start, end;
+
+    for (size_t i = 0; i < num_pws; i++)
+    {
+        for (int j = 0; j < 16; j++)
+        {
+            pw_data[i][j] = (uint8_t)('a' + (i + j) % 26);
+            salt_data[i][j] = (uint8_t)(i * 16 + j);
+        }
+        pws[i] = pw_data[i];
+        salts[i] = salt_data[i];
+        pwlens[i] = 16;
+        saltlens[i] = 16;
+    }
+
+    printf("%-28s %-18s %-18s %-10s\n", "Method", "deriv/s (10k it)", "deriv/s (100k it)", "Speedup");
+    printf("------------------------------------------------------------------------------\n");
+
+    // Textbook loop: one hmac_sm3() call per iteration, key cached
+    const size_t ref_pws = 8;
+    gettimeofday(&start, NULL);
+    for (size_t i = 0; i < ref_pws; i++)
+    {
+        hmac_sm3_key_t key;
+        hmac_sm3_ctx_t ctx;
+        uint8_t u[SM3_DIGEST_SIZE], be_index[4] = {0, 0, 0, 1};
+        uint8_t *t = out + i * SM3_DIGEST_SIZE;
+
+        hmac_sm3_setkey(&key, pws[i], pwlens[i]);
+        hmac_sm3_init(&ctx, &key);
+        hmac_sm3_update(&ctx, salts[i], saltlens[i]);
+        hmac_sm3_update(&ctx, be_index, 4);
+        hmac_sm3_final(&ctx, u);
+        memcpy(t, u, SM3_DIGEST_SIZE);
+        for (uint32_t it = 1; it < iterations; it++)
+        {
+            hmac_sm3(&key, u, sizeof(u), u);
+            for (int b = 0; b < SM3_DIGEST_SIZE; b++)
+            {
+                t[b] ^= u[b];
+            }
+        }
+    }
+    gettimeofday(&end, NULL);
+    double ref_rate = ref_pws / get_time_diff(start, end);
+    printf("%-28s %-18.1f %-18.1f %-10s\n", "hmac_sm3 per iteration", ref_rate, ref_rate / 10, "1.00x");
+
+    gettimeofday(&start, NULL);
+    for (size_t i = 0; i < ref_pws; i++)
+    {
+        pbkdf2_hmac_sm3(pws[i], pwlens[i], salts[i], saltlens[i], iterations, out + i * SM3_DIGEST_SIZE,
+                        SM3_DIGEST_SIZE);
+    }
+    gettimeofday(&end, NULL);
+    double single_rate = ref_pws / get_time_diff(start, end);
+    printf("%-28s %-18.1f %-18.1f %.2fx\n", "pbkdf2_hmac_sm3 (one)", single_rate, single_rate / 10,
+           single_rate / ref_rate);
+
+    gettimeofday(&start, NULL);
+    pbkdf2_hmac_sm3_many(pws, pwlens, salts, saltlens, num_pws, iterations, out, SM3_DIGEST_SIZE);
+    gettimeofday(&end, NULL);
+    double batch_rate = num_pws / get_time_diff(start, end);
+    printf("%-28s %-18.1f %-18.1f %.2fx\n", "pbkdf2_hmac_sm3_many (64)", batch_rate, batch_rate / 10,
+           batch_rate / ref_rate);
+    printf("\n");
+}
+
+void benchmark_sm3_node65()
+{
+    printf("Merkle Internal Node Benchmark (SM3 of 0x01 || left || right)\n");
+    printf("==============================================================\n\n");
+
+    const size_t num_nodes = 4096;
+    const int iterations = 50;
+    uint8_t *children = malloc(num_nodes * 2 * SM3_DIGEST_SIZE);
+    uint8_t *parents = malloc(num_nodes * SM3_DIGEST_SIZE);
+    struct timeval start, end;
+
+    if (!children || !parents)
+    {
+        printf("Memory allocation failed\n");
+        free(children);
+        free(parents);
+        return;
+    }
+    for (size_t j = 0; j < num_nodes * 2 * SM3_DIGEST_SIZE; j++)
+    {
+        children[j] = (uint8_t)(j * 31);
+    }
+
+    printf("%-32s %-15s %-10s\n", "Method", "Mnodes/s", "Speedup");
+    printf("------------------------------------------------------------\n");
+
+    // The previous merkle_compute_internal_hash: three updates and a final
+    gettimeofday(&start, NULL);
+    for (int iter = 0; iter < iterations; iter++)
+    {
+        for (size_t i = 0; i < num_nodes; i++)
+        {
+            uint8_t prefix = 0x01;
+            sm3_ctx_t ctx;
+            sm3_init_optimized(&ctx);
+            sm3_update_optimized(&ctx, &prefix, 1);
+            sm3_update_optimized(&ctx, children + 2 * i * SM3_DIGEST_SIZE, SM3_DIGEST_SIZE);
+            sm3_update_optimized(&ctx, children + (2 * i + 1) * SM3_DIGEST_SIZE, SM3_DIGEST_SIZE);
+            sm3_final_optimized(&ctx, parents + i * SM3_DIGEST_SIZE);
+        }
+    }
+    gettimeofday(&end, NULL);
+    double generic_rate = num_nodes * iterations / get_time_diff(start, end) / 1e6;
+    printf("%-32s %-15.3f %-10s\n", "init/update x3/final (optimized)", generic_rate, "1.00x");
+
+    gettimeofday(&start, NULL);
+    for (int iter = 0; iter < iterations; iter++)
+    {
+        for (size_t i = 0; i < num_nodes; i++)
+        {
+            sm3_hash_node65(children + 2 * i * SM3_DIGEST_SIZE, children + (2 * i + 1) * SM3_DIGEST_SIZE,
+                            parents + i * SM3_DIGEST_SIZE);
+        }
+    }
+    gettimeofday(&end, NULL);
+    double node_rate = num_nodes * iterations / get_time_diff(start, end) / 1e6;
+    printf("%-32s %-15.3f %.2fx\n", "sm3_hash_node65", node_rate, node_rate / generic_rate);
+
+    gettimeofday(&start, NULL);
+    for (int iter = 0; iter < iterations; iter++)
+    {
+        sm3_hash_nodes65(children, num_nodes, parents);
+    }
+    gettimeofday(&end, NULL);
+    double level_rate = num_nodes * iterations / get_time_diff(start, end) / 1e6;
+    printf("%-32s %-15.3f %.2fx\n", "sm3_hash_nodes65 (whole level)", level_rate, level_rate / generic_rate);
+    printf("\n");
+
+    free(children);
+    free(parents);
+}
+
+void benchmark_length_extension_batch()
+{
+    printf("Length Extension Forgery Benchmark (secret lengths 1-64 per token)\n");
+    printf("====================================================================\n\n");
+
+    const size_t n_tokens = 2000;
+    const size_t min_secret = 1, max_secret = 64;
+    const char *append = "&role=admin&x=1";
+    const size_t append_len = strlen(append);
+    const size_t count = n_tokens * (max_secret - min_secret + 1);
+    uint8_t *digest_data = malloc(n_tokens * SM3_DIGEST_SIZE);
+    const uint8_t **digests = malloc(n_tokens * sizeof(*digests));
+    uint64_t *msg_lens = malloc(n_tokens * sizeof(*msg_lens));
+    size_t arena_size = sm3_forge_arena_size(n_tokens, min_secret, max_secret, append_len);
+    void *arena = malloc(arena_size);
+    struct timeval start, end;
+
+    if (!digest_data || !digests || !msg_lens || !arena)
+    {
+        printf("Memory allocation failed\n");
+        free(digest_data);
+        free(digests);
+        free(msg_lens);
+        free(arena);
+        return;
+    }
+    for (size_t t = 0; t < n_tokens; t++)
+    {
+        uint8_t token[64];
+        msg_lens[t] = 20 + t % 40;
+        memset(token, (int)t, sizeof(token));
+        sm3_hash_optimized(token, (size_t)msg_lens[t] + 8, digest_data + t * SM3_DIGEST_SIZE);
+        digests[t] = digest_data + t * SM3_DIGEST_SIZE;
+    }
+
+    printf("%-32s %-15s %-10s\n", "Method", "Mforgeries/s", "Speedup");
+    printf("------------------------------------------------------------\n");
+
+    gettimeofday(&start, NULL);
+    for (size_t t = 0; t < n_tokens; t++)
+    {
+        for (size_t s = min_secret; s <= max_secret; s++)
+        {
+            uint8_t forged[SM3_DIGEST_SIZE];
+            uint8_t *ext;
+            size_t ext_len;
+            if (sm3_length_extension_attack(digests[t], s + msg_lens[t], (const uint8_t *)append, append_len, forged,
+                                            &ext, &ext_len) == 0)
+            {
+                free(ext);
+            }
+        }
+    }
+    gettimeofday(&end, NULL);
+    double single_rate = count / get_time_diff(start, end) / 1e6;
+    printf("%-32s %-15.3f %-10s\n", "sm3_length_extension_attack", single_rate, "1.00x");
+
+    sm3_forgery_t *forgeries;
+    gettimeofday(&start, NULL);
+    sm3_forge_many(digests, msg_lens, n_tokens, min_secret, max_secret, (const uint8_t *)append, append_len, arena,
+                   arena_size, &forgeries);
+    gettimeofday(&end, NULL);
+    double batch_rate = count / get_time_diff(start, end) / 1e6;
+    printf("%-32s %-15.3f %.2fx\n", "sm3_forge_many (one arena)", batch_rate, batch_rate / single_rate);
+    printf("\n");
+
+    free(digest_data);
+    free(digests);
+    free(msg_lens);
+    free(arena);
+}
+
 void benchmark_merkle_tree_operations()
 {
     printf("Merkle Tree Performance Benchmark\n");
@@ -266,6 +810,13 @@ int main()
     printf("===================================================\n\n");
 
     benchmark_sm3_implementations();
+    benchmark_sm3_drbg();
+    benchmark_sm3_hash_many();
+    benchmark_hmac_sm3();
+    benchmark_sm3_kdf();
+    benchmark_pbkdf2_sm3();
+    benchmark_sm3_node65();
+    benchmark_length_extension_batch();
     benchmark_merkle_tree_operations();
     benchmark_memory_usage();
     comprehensive_performance_test();
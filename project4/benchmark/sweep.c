@@ -0,0 +1,178 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../src/sm3.h"
+#include "../src/merkle.h"
+#include "../../bench/bench_harness.h"
+
+// SM3 / Merkle size sweep on the shared harness (see bench/bench_harness.h
+// for options and output formats). For the Merkle cases the size is the
+// total leaf data: size / 64 leaves of 64 bytes each.
+
+#define LEAF_SIZE 64
+#define MERKLE_BUILD_MAX ((size_t)64 << 20)
+#define MERKLE_PROOF_MAX ((size_t)16 << 20)
+
+typedef void (*hash_func)(const uint8_t *, size_t, uint8_t *);
+
+static hash_func hash_basic = sm3_hash;
+static hash_func hash_optimized = sm3_hash_optimized;
+static hash_func hash_simd = sm3_hash_simd;
+
+static void run_hash(void *arg, uint8_t *buf, size_t len)
+{
+    uint8_t digest[32];
+    hash_func f = *(hash_func *)arg;
+    f(buf, len, digest);
+}
+
+static merkle_tree_t *build_tree(const uint8_t *buf, size_t len)
+{
+    merkle_tree_t *tree = merkle_tree_create();
+    if (!tree)
+    {
+        return NULL;
+    }
+    for (size_t off = 0; off + LEAF_SIZE <= len; off += LEAF_SIZE)
+    {
+        merkle_tree_add_leaf(tree, buf + off, LEAF_SIZE);
+    }
+    merkle_tree_build(tree);
+    return tree;
+}
+
+// Multi-buffer: the buffer as len / 64 independent 64-byte messages
+typedef struct
+{
+    sm3_many_func hash_many;
+    const uint8_t **msgs;
+    size_t *lens;
+    uint8_t *digests;
+    size_t n;
+} many_state;
+
+static void *setup_many(void *arg, uint8_t *buf, size_t len)
+{
+    many_state *s = malloc(sizeof(*s));
+    if (!s)
+    {
+        return NULL;
+    }
+    s->hash_many = ((const sm3_many_backend *)arg)->hash_many;
+    s->n = len / LEAF_SIZE;
+    s->msgs = malloc(s->n * sizeof(*s->msgs));
+    s->lens = malloc(s->n * sizeof(*s->lens));
+    s->digests = malloc(s->n * SM3_DIGEST_SIZE);
+    if (!s->msgs || !s->lens || !s->digests)
+    {
+        free(s->msgs);
+        free(s->lens);
+        free(s->digests);
+        free(s);
+        return NULL;
+    }
+    for (size_t i = 0; i < s->n; i++)
+    {
+        s->msgs[i] = buf + i * LEAF_SIZE;
+        s->lens[i] = LEAF_SIZE;
+    }
+    return s;
+}
+
+static void run_many(void *arg, uint8_t *buf, size_t len)
+{
+    many_state *s = arg;
+    (void)buf;
+    (void)len;
+    s->hash_many(s->msgs, s->lens, s->n, s->digests);
+}
+
+static void teardown_many(void *arg)
+{
+    many_state *s = arg;
+    free(s->msgs);
+    free(s->lens);
+    free(s->digests);
+    free(s);
+}
+
+// Whole tree: add the leaves, build, free
+static void run_merkle_build(void *arg, uint8_t *buf, size_t len)
+{
+    (void)arg;
+    merkle_tree_destroy(build_tree(buf, len));
+}
+
+// Audit proof for a leaf in the middle of a prebuilt tree, then verify it
+typedef struct
+{
+    merkle_tree_t *tree;
+    uint8_t root[MERKLE_NODE_SIZE];
+    uint8_t leaf_hash[MERKLE_NODE_SIZE];
+    uint64_t index;
+} proof_state;
+
+static void *setup_proof(void *arg, uint8_t *buf, size_t len)
+{
+    proof_state *s = malloc(sizeof(*s));
+    (void)arg;
+    if (!s)
+    {
+        return NULL;
+    }
+    s->tree = build_tree(buf, len);
+    s->index = (len / LEAF_SIZE) / 2;
+    merkle_get_root_hash(s->tree, s->root);
+    merkle_compute_leaf_hash(buf + s->index * LEAF_SIZE, LEAF_SIZE, s->leaf_hash);
+    return s;
+}
+
+static void run_proof(void *arg, uint8_t *buf, size_t len)
+{
+    proof_state *s = arg;
+    audit_proof_t proof;
+    (void)buf;
+    (void)len;
+    if (merkle_generate_audit_proof(s->tree, s->index, &proof) != 0 ||
+        merkle_verify_audit_proof(&proof, s->leaf_hash, s->root) != 0)
+    {
+        fprintf(stderr, "audit proof failed for leaf %llu\n", (unsigned long long)s->index);
+        exit(1);
+    }
+}
+
+static void teardown_proof(void *arg)
+{
+    proof_state *s = arg;
+    merkle_tree_destroy(s->tree);
+    free(s);
+}
+
+int main(int argc, char **argv)
+{
+    bench_options opt;
+    int rc = bench_parse_args(&opt, "project4-sm3", argc, argv);
+
+    if (rc != 0)
+    {
+        return rc > 0 ? 0 : 1;
+    }
+
+    static sm3_many_backend backends[4];
+    bench_case cases[13];
+    size_t n = 0, nb = sm3_hash_many_backends(backends, 4);
+
+    // Proof timing is per proof, so ns/op is the useful column there;
+    // counters are per 64-byte SM3 block for the hash cases
+    cases[n++] = (bench_case){"sm3", "sm3_hash", 1, 0, &hash_basic, NULL, run_hash, NULL, 64};
+    cases[n++] = (bench_case){"sm3", "sm3_hash_optimized", 1, 0, &hash_optimized, NULL, run_hash, NULL, 64};
+    cases[n++] = (bench_case){"sm3", "sm3_hash_simd", 1, 0, &hash_simd, NULL, run_hash, NULL, 64};
+    for (size_t i = 0; i < nb; i++)
+    {
+        cases[n++] = (bench_case){"sm3-many-64B", backends[i].name, LEAF_SIZE, MERKLE_BUILD_MAX, &backends[i], setup_many, run_many, teardown_many, 64};
+    }
+    cases[n++] = (bench_case){"merkle-build", "64B leaves", LEAF_SIZE, MERKLE_BUILD_MAX, NULL, NULL, run_merkle_build, NULL, 0};
+    cases[n++] = (bench_case){"merkle-audit-proof", "generate+verify", LEAF_SIZE, MERKLE_PROOF_MAX, NULL, setup_proof, run_proof, teardown_proof, 0};
+
+    return bench_run(cases, n, &opt) == 0 ? 0 : 1;
+}
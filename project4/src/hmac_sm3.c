@@ -0,0 +1,146 @@
+#include "sm3_internal.h"
+#include <string.h>
+
+// HMAC-SM3 with the ipad/opad compressions done once per key. The inner and
+// outer contexts sit on a block boundary, so they also serve as the starting
+// midstates for the multi-buffer batch calls.
+
+#define HMAC_BATCH 64 // Messages per pass through the lanes
+
+static int mac_differs(const uint8_t *a, const uint8_t *b)
+{
+    uint8_t diff = 0;
+    for (int i = 0; i < HMAC_SM3_SIZE; i++)
+    {
+        diff |= a[i] ^ b[i];
+    }
+    return diff != 0;
+}
+
+void hmac_sm3_setkey(hmac_sm3_key_t *key, const uint8_t *k, size_t klen)
+{
+    uint8_t block[SM3_BLOCK_SIZE];
+    uint8_t pad[SM3_BLOCK_SIZE];
+
+    // Keys longer than a block are hashed first
+    memset(block, 0, sizeof(block));
+    if (klen > SM3_BLOCK_SIZE)
+    {
+        sm3_hash_optimized(k, klen, block);
+    }
+    else if (klen > 0)
+    {
+        memcpy(block, k, klen);
+    }
+
+    for (int i = 0; i < SM3_BLOCK_SIZE; i++)
+    {
+        pad[i] = block[i] ^ 0x36;
+    }
+    sm3_init_optimized(&key->inner);
+    sm3_update_optimized(&key->inner, pad, SM3_BLOCK_SIZE);
+
+    for (int i = 0; i < SM3_BLOCK_SIZE; i++)
+    {
+        pad[i] = block[i] ^ 0x5c;
+    }
+    sm3_init_optimized(&key->outer);
+    sm3_update_optimized(&key->outer, pad, SM3_BLOCK_SIZE);
+
+    wipe(block, sizeof(block));
+    wipe(pad, sizeof(pad));
+}
+
+void hmac_sm3_init(hmac_sm3_ctx_t *ctx, const hmac_sm3_key_t *key)
+{
+    ctx->ctx = key->inner;
+    ctx->key = key;
+}
+
+void hmac_sm3_update(hmac_sm3_ctx_t *ctx, const uint8_t *data, size_t len)
+{
+    sm3_update_optimized(&ctx->ctx, data, len);
+}
+
+void hmac_sm3_final(hmac_sm3_ctx_t *ctx, uint8_t *mac)
+{
+    uint8_t inner[SM3_DIGEST_SIZE];
+
+    sm3_final_optimized(&ctx->ctx, inner);
+    ctx->ctx = ctx->key->outer;
+    sm3_update_optimized(&ctx->ctx, inner, sizeof(inner));
+    sm3_final_optimized(&ctx->ctx, mac);
+    wipe(&ctx->ctx, sizeof(ctx->ctx));
+}
+
+void hmac_sm3(const hmac_sm3_key_t *key, const uint8_t *msg, size_t len, uint8_t *mac)
+{
+    hmac_sm3_ctx_t ctx;
+    hmac_sm3_init(&ctx, key);
+    hmac_sm3_update(&ctx, msg, len);
+    hmac_sm3_final(&ctx, mac);
+}
+
+int hmac_sm3_verify(const hmac_sm3_key_t *key, const uint8_t *msg, size_t len, const uint8_t *mac)
+{
+    uint8_t expected[HMAC_SM3_SIZE];
+    int differs;
+
+    hmac_sm3(key, msg, len, expected);
+    differs = mac_differs(expected, mac);
+    wipe(expected, sizeof(expected));
+    return differs ? -1 : 0;
+}
+
+void hmac_sm3_many(const hmac_sm3_key_t *const keys[], const uint8_t *const msgs[], const size_t lens[],
+                   size_t n, uint8_t *macs)
+{
+    const sm3_ctx_t *starts[HMAC_BATCH];
+    const uint8_t *inner_msgs[HMAC_BATCH];
+    size_t inner_lens[HMAC_BATCH];
+    uint8_t inner[HMAC_BATCH * SM3_DIGEST_SIZE];
+
+    for (size_t base = 0; base < n; base += HMAC_BATCH)
+    {
+        size_t count = n - base < HMAC_BATCH ? n - base : HMAC_BATCH;
+
+        // Inner hashes: message blocks from each key's ipad midstate
+        for (size_t i = 0; i < count; i++)
+        {
+            starts[i] = &keys[base + i]->inner;
+        }
+        sm3_hash_many_from(starts, msgs + base, lens + base, count, inner);
+
+        // Outer hashes: one block each from the opad midstate
+        for (size_t i = 0; i < count; i++)
+        {
+            starts[i] = &keys[base + i]->outer;
+            inner_msgs[i] = inner + i * SM3_DIGEST_SIZE;
+            inner_lens[i] = SM3_DIGEST_SIZE;
+        }
+        sm3_hash_many_from(starts, inner_msgs, inner_lens, count, macs + base * HMAC_SM3_SIZE);
+    }
+    wipe(inner, sizeof(inner));
+}
+
+size_t hmac_sm3_verify_many(const hmac_sm3_key_t *const keys[], const uint8_t *const msgs[], const size_t lens[],
+                            const uint8_t *const macs[], size_t n, int *results)
+{
+    uint8_t expected[HMAC_BATCH * HMAC_SM3_SIZE];
+    size_t failures = 0;
+
+    for (size_t base = 0; base < n; base += HMAC_BATCH)
+    {
+        size_t count = n - base < HMAC_BATCH ? n - base : HMAC_BATCH;
+
+        hmac_sm3_many(keys + base, msgs + base, lens + base, count, expected);
+        for (size_t i = 0; i < count; i++)
+        {
+            int differs = mac_differs(expected + i * HMAC_SM3_SIZE, macs[base + i]);
+            results[base + i] = differs ? -1 : 0;
+            failures += (size_t)differs;
+        }
+    }
+    wipe(expected, sizeof(expected));
+    return failures;
+}
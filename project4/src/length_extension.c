@@ -2,19 +2,11 @@
 #include <stdlib.h>
 #include <string.h>
 
+// Glue padding after original_len bytes: 0x80, zeros up to 56 mod 64 and
+// the 64-bit bit length (9 to 72 bytes)
 static size_t calculate_padding_len(uint64_t original_len)
 {
-    size_t padding_len = 1;
-    size_t total_bits = (original_len + padding_len) * 8;
-
-    while ((total_bits + 64) % 512 != 0)
-    {
-        padding_len++;
-        total_bits = (original_len + padding_len) * 8;
-    }
-
-    padding_len += 8;
-    return padding_len;
+    return (size_t)((55 + SM3_BLOCK_SIZE - original_len % SM3_BLOCK_SIZE) % SM3_BLOCK_SIZE) + 1 + 8;
 }
 
 static void construct_padding(uint64_t original_len, uint8_t *padding, size_t padding_len)
@@ -56,17 +48,7 @@ int sm3_length_extension_attack(const uint8_t *original_hash,
     memcpy(*extended_message + padding_len, append_data, append_len);
 
     sm3_ctx_t ctx;
-
-    for (int i = 0; i < 8; i++)
-    {
-        ctx.state[i] = (original_hash[i * 4] << 24) |
-                       (original_hash[i * 4 + 1] << 16) |
-                       (original_hash[i * 4 + 2] << 8) |
-                       original_hash[i * 4 + 3];
-    }
-
-    ctx.count = original_len + padding_len;
-    memset(ctx.buffer, 0, SM3_BLOCK_SIZE);
+    sm3_import_digest(&ctx, original_hash, original_len + padding_len);
 
     sm3_update(&ctx, append_data, append_len);
     sm3_final(&ctx, new_hash);
@@ -123,3 +105,104 @@ int verify_length_extension_attack(const char *secret,
 
     return success ? 0 : -1;
 }
+
+// --- Batch forger ------------------------------------------------------------
+
+#define FORGE_BATCH 64                      // Candidates per pass through the lanes
+#define FORGE_GLUE_MAX (SM3_BLOCK_SIZE + 8) // Longest glue padding
+#define FORGE_ALIGN 16                      // Records at the start of the arena
+
+size_t sm3_forge_arena_size(size_t n_tokens, size_t min_secret, size_t max_secret, size_t append_len)
+{
+    size_t per_token, count, record;
+
+    // 0 for an empty range or a size that does not fit in a size_t
+    if (max_secret < min_secret || max_secret - min_secret == SIZE_MAX)
+    {
+        return 0;
+    }
+    per_token = max_secret - min_secret + 1;
+    if (n_tokens > SIZE_MAX / per_token || append_len > SIZE_MAX - sizeof(sm3_forgery_t) - FORGE_GLUE_MAX)
+    {
+        return 0;
+    }
+    count = n_tokens * per_token;
+    record = sizeof(sm3_forgery_t) + FORGE_GLUE_MAX + append_len;
+    if (count > (SIZE_MAX - (FORGE_ALIGN - 1)) / record)
+    {
+        return 0;
+    }
+    return FORGE_ALIGN - 1 + count * record;
+}
+
+int sm3_forge_many(const uint8_t *const digests[], const uint64_t msg_lens[], size_t n_tokens, size_t min_secret,
+                   size_t max_secret, const uint8_t *append, size_t append_len, void *arena, size_t arena_size,
+                   sm3_forgery_t **forgeries)
+{
+    static const uint8_t empty = 0;
+    sm3_ctx_t starts_data[FORGE_BATCH];
+    const sm3_ctx_t *starts[FORGE_BATCH];
+    const uint8_t *msgs[FORGE_BATCH];
+    size_t lens[FORGE_BATCH];
+    uint8_t out[FORGE_BATCH * SM3_DIGEST_SIZE];
+
+    size_t need = sm3_forge_arena_size(n_tokens, min_secret, max_secret, append_len);
+
+    if (need == 0 || arena_size < need)
+    {
+        return -1;
+    }
+
+    // Records first, then one fixed-size extension slot per record
+    size_t per_token = max_secret - min_secret + 1;
+    size_t count = n_tokens * per_token;
+    size_t stride = FORGE_GLUE_MAX + append_len;
+    uintptr_t base = ((uintptr_t)arena + FORGE_ALIGN - 1) & ~(uintptr_t)(FORGE_ALIGN - 1);
+    sm3_forgery_t *rec = (sm3_forgery_t *)base;
+    uint8_t *ext = (uint8_t *)(rec + count);
+
+    if (!append)
+    {
+        append = &empty;
+    }
+    for (size_t i = 0; i < FORGE_BATCH; i++)
+    {
+        starts[i] = &starts_data[i];
+        msgs[i] = append;
+        lens[i] = append_len;
+    }
+
+    for (size_t first = 0; first < count; first += FORGE_BATCH)
+    {
+        size_t batch = count - first < FORGE_BATCH ? count - first : FORGE_BATCH;
+
+        for (size_t i = 0; i < batch; i++)
+        {
+            sm3_forgery_t *f = &rec[first + i];
+            size_t token = (first + i) / per_token;
+            uint64_t original_len = (uint64_t)(min_secret + (first + i) % per_token) + msg_lens[token];
+            size_t glue_len = calculate_padding_len(original_len);
+            uint8_t *e = ext + (first + i) * stride;
+
+            construct_padding(original_len, e, glue_len);
+            if (append_len)
+            {
+                memcpy(e + glue_len, append, append_len);
+            }
+            f->token = token;
+            f->secret_len = min_secret + (first + i) % per_token;
+            f->extension = e;
+            f->extension_len = glue_len + append_len;
+            sm3_import_digest(&starts_data[i], digests[token], original_len + glue_len);
+        }
+
+        sm3_hash_many_from(starts, msgs, lens, batch, out);
+        for (size_t i = 0; i < batch; i++)
+        {
+            memcpy(rec[first + i].digest, out + i * SM3_DIGEST_SIZE, SM3_DIGEST_SIZE);
+        }
+    }
+
+    *forgeries = rec;
+    return 0;
+}
@@ -48,14 +48,8 @@ void merkle_compute_leaf_hash(const uint8_t *data, size_t len, uint8_t *hash)
 
 void merkle_compute_internal_hash(const uint8_t *left, const uint8_t *right, uint8_t *hash)
 {
-    sm3_ctx_t ctx;
-    sm3_init(&ctx);
-
-    uint8_t prefix = 0x01;
-    sm3_update(&ctx, &prefix, 1);
-    sm3_update(&ctx, left, MERKLE_NODE_SIZE);
-    sm3_update(&ctx, right, MERKLE_NODE_SIZE);
-    sm3_final(&ctx, hash);
+    // SM3(0x01 || left || right), always 65 bytes
+    sm3_hash_node65(left, right, hash);
 }
 
 int merkle_tree_add_leaf(merkle_tree_t *tree, const uint8_t *data, size_t len)
@@ -80,14 +74,8 @@ int merkle_tree_add_leaf(merkle_tree_t *tree, const uint8_t *data, size_t len)
     return 0;
 }
 
-static void compute_tree_hashes(uint8_t **leaf_hashes, uint64_t n, uint8_t *result)
+static void compute_tree_hashes_recursive(uint8_t **leaf_hashes, uint64_t n, uint8_t *result)
 {
-    if (n == 0)
-    {
-        sm3_hash(NULL, 0, result);
-        return;
-    }
-
     if (n == 1)
     {
         memcpy(result, leaf_hashes[0], MERKLE_NODE_SIZE);
@@ -102,12 +90,44 @@ static void compute_tree_hashes(uint8_t **leaf_hashes, uint64_t n, uint8_t *resu
     uint8_t left_hash[MERKLE_NODE_SIZE];
     uint8_t right_hash[MERKLE_NODE_SIZE];
 
-    compute_tree_hashes(leaf_hashes, k, left_hash);
-    compute_tree_hashes(leaf_hashes + k, n - k, right_hash);
+    compute_tree_hashes_recursive(leaf_hashes, k, left_hash);
+    compute_tree_hashes_recursive(leaf_hashes + k, n - k, right_hash);
 
     merkle_compute_internal_hash(left_hash, right_hash, result);
 }
 
+// Level by level: pairing left to right and carrying an odd last node up
+// gives the same tree as the recursive split, and each level is one
+// multi-buffer call
+static void compute_tree_hashes(uint8_t **leaf_hashes, uint64_t n, uint8_t *result)
+{
+    if (n == 0)
+    {
+        sm3_hash(NULL, 0, result);
+        return;
+    }
+
+    uint8_t *level = malloc(n * MERKLE_NODE_SIZE);
+    if (!level)
+    {
+        compute_tree_hashes_recursive(leaf_hashes, n, result);
+        return;
+    }
+    for (uint64_t i = 0; i < n; i++)
+        memcpy(level + i * MERKLE_NODE_SIZE, leaf_hashes[i], MERKLE_NODE_SIZE);
+
+    while (n > 1)
+    {
+        uint64_t parents = n / 2;
+        sm3_hash_nodes65(level, parents, level);
+        if (n % 2)
+            memcpy(level + parents * MERKLE_NODE_SIZE, level + (n - 1) * MERKLE_NODE_SIZE, MERKLE_NODE_SIZE);
+        n = parents + n % 2;
+    }
+    memcpy(result, level, MERKLE_NODE_SIZE);
+    free(level);
+}
+
 int merkle_tree_build(merkle_tree_t *tree)
 {
     if (!tree || tree->leaf_count == 0)
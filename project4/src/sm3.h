@@ -24,6 +24,156 @@ void sm3_update_optimized(sm3_ctx_t *ctx, const uint8_t *data, size_t len);
 void sm3_final_optimized(sm3_ctx_t *ctx, uint8_t *digest);
 void sm3_hash_optimized(const uint8_t *data, size_t len, uint8_t *digest);
 
+// One 64-byte block into ctx->state (count and buffer are left alone)
+void sm3_process_block_optimized(sm3_ctx_t *ctx, const uint8_t *block);
+
+// Single-stream SM3 with an SSE message schedule interleaved with the rounds,
+// for long messages
+void sm3_init_simd(sm3_ctx_t *ctx);
+void sm3_update_simd(sm3_ctx_t *ctx, const uint8_t *data, size_t len);
+void sm3_final_simd(sm3_ctx_t *ctx, uint8_t *digest);
+void sm3_hash_simd(const uint8_t *data, size_t len, uint8_t *digest);
+
+// nblocks consecutive 64-byte blocks into ctx->state
+void sm3_process_blocks_simd(sm3_ctx_t *ctx, const uint8_t *data, size_t nblocks);
+
+// Portable snapshot of a context (state words, byte count and buffered
+// bytes, all big-endian), e.g. to store cached midstates; works with every
+// sm3_*_ctx implementation and any position in the message
+#define SM3_STATE_EXPORT_SIZE (32 + 8 + SM3_BLOCK_SIZE)
+void sm3_export_state(const sm3_ctx_t *ctx, uint8_t *out);
+void sm3_import_state(sm3_ctx_t *ctx, const uint8_t *in);
+
+// Context that resumes from a digest, i.e. the state after count bytes of
+// padded message (count a multiple of 64, such as secret || msg || glue
+// padding). Returns -1 if count is not block-aligned.
+int sm3_import_digest(sm3_ctx_t *ctx, const uint8_t *digest, uint64_t count);
+
+// Multi-buffer hashing of independent messages, one block of each message per
+// SIMD pass; digest i is written to digests + i * SM3_DIGEST_SIZE.
+// sm3_hash_many() uses the widest backend the CPU supports.
+void sm3_hash_many(const uint8_t *const msgs[], const size_t lens[], size_t n, uint8_t *digests);
+
+// As sm3_hash_many(), but message i continues from starts[i], a context that
+// has absorbed a whole number of blocks (count % 64 == 0), such as a cached
+// HMAC or KDF prefix. starts == NULL or starts[i] == NULL means the IV.
+void sm3_hash_many_from(const sm3_ctx_t *const starts[], const uint8_t *const msgs[], const size_t lens[],
+                        size_t n, uint8_t *digests);
+
+typedef void (*sm3_many_func)(const uint8_t *const msgs[], const size_t lens[], size_t n, uint8_t *digests);
+
+// One 64-byte block per lane into state, which is 8 rows of `lanes` words
+// (row i holds word i of every lane), for callers that build their own blocks
+typedef void (*sm3_compress_func)(uint32_t *state, const uint8_t *const blocks[]);
+
+typedef struct
+{
+    const char *name;
+    size_t lanes; // Messages per pass
+    sm3_many_func hash_many;
+    sm3_compress_func compress;
+} sm3_many_backend;
+
+// Backends usable on this CPU, preferred first (for tests and benchmarks)
+size_t sm3_hash_many_backends(sm3_many_backend *out, size_t max);
+
+// Fixed 65-byte messages without the update/final buffering and with a
+// precomputed schedule for the constant second block:
+// sm3_hash_node65 = SM3(0x01 || left || right) (Merkle parent, 32-byte
+// children) and sm3_hash_leaf64 = SM3(0x00 || data) (64-byte Merkle leaf).
+// The _many forms hash a whole level in the multi-buffer lanes: n parents
+// from 2n consecutive children, or n leaves from n consecutive 64-byte
+// records; the output may overlap the input, so a level can be reduced in
+// place.
+void sm3_hash_node65(const uint8_t *left, const uint8_t *right, uint8_t *digest);
+void sm3_hash_leaf64(const uint8_t *data, uint8_t *digest);
+void sm3_hash_nodes65(const uint8_t *children, size_t n, uint8_t *parents);
+void sm3_hash_leaves64(const uint8_t *data, size_t n, uint8_t *digests);
+
+// HMAC-SM3 (RFC 2104 with SM3). hmac_sm3_setkey() compresses K ^ ipad and
+// K ^ opad once; each MAC after that costs the message blocks plus one
+// outer block.
+#define HMAC_SM3_SIZE SM3_DIGEST_SIZE
+
+typedef struct
+{
+    sm3_ctx_t inner; // After K ^ ipad
+    sm3_ctx_t outer; // After K ^ opad
+} hmac_sm3_key_t;
+
+typedef struct
+{
+    sm3_ctx_t ctx;
+    const hmac_sm3_key_t *key;
+} hmac_sm3_ctx_t;
+
+void hmac_sm3_setkey(hmac_sm3_key_t *key, const uint8_t *k, size_t klen);
+void hmac_sm3_init(hmac_sm3_ctx_t *ctx, const hmac_sm3_key_t *key);
+void hmac_sm3_update(hmac_sm3_ctx_t *ctx, const uint8_t *data, size_t len);
+void hmac_sm3_final(hmac_sm3_ctx_t *ctx, uint8_t *mac);
+void hmac_sm3(const hmac_sm3_key_t *key, const uint8_t *msg, size_t len, uint8_t *mac);
+
+// Both return 0 if the MAC matches and -1 otherwise (constant-time compare)
+int hmac_sm3_verify(const hmac_sm3_key_t *key, const uint8_t *msg, size_t len, const uint8_t *mac);
+
+// MACs of n messages in multi-buffer lanes; message i uses keys[i] and its
+// MAC goes to macs + i * HMAC_SM3_SIZE
+void hmac_sm3_many(const hmac_sm3_key_t *const keys[], const uint8_t *const msgs[], const size_t lens[],
+                   size_t n, uint8_t *macs);
+
+// Verifies n (key, message, MAC) triples in lanes; results[i] gets 0 or -1
+// as from hmac_sm3_verify(). Returns the number of mismatches.
+size_t hmac_sm3_verify_many(const hmac_sm3_key_t *const keys[], const uint8_t *const msgs[], const size_t lens[],
+                            const uint8_t *const macs[], size_t n, int *results);
+
+// GB/T 32918 key derivation: outlen bytes of SM3(Z || ct) for ct = 1, 2, ...
+// (32-bit big-endian). Returns -1 if outlen needs more than 2^32 - 1 blocks.
+int sm3_kdf(const uint8_t *z, size_t zlen, uint8_t *out, size_t outlen);
+
+// PBKDF2-HMAC-SM3 (RFC 8018 with HMAC-SM3 as the PRF). Returns -1 if
+// iterations is 0 or outlen needs more than 2^32 - 1 blocks.
+int pbkdf2_hmac_sm3(const uint8_t *pw, size_t pwlen, const uint8_t *salt, size_t saltlen, uint32_t iterations,
+                    uint8_t *out, size_t outlen);
+
+// n derivations with the same iteration count and output length; every
+// output block of every password runs in its own multi-buffer lane. Key i
+// goes to outs + i * outlen.
+int pbkdf2_hmac_sm3_many(const uint8_t *const pws[], const size_t pwlens[], const uint8_t *const salts[],
+                         const size_t saltlens[], size_t n, uint32_t iterations, uint8_t *outs, size_t outlen);
+
+// Hash_DRBG (NIST SP 800-90A) with SM3, e.g. for SM2 signing nonces and key
+// generation. The caller supplies the entropy; an instance must not be
+// shared between threads without a lock. Functions return 0 on success and
+// -1 on bad arguments (entropy shorter than 32 bytes, a request over
+// SM3_DRBG_MAX_REQUEST bytes); sm3_drbg_generate() returns
+// SM3_DRBG_NEED_RESEED, without output, once the reseed counter has passed
+// SM3_DRBG_RESEED_INTERVAL. Large requests are hashed in the multi-buffer
+// lanes.
+#define SM3_DRBG_SEED_LEN 55                         // seedlen = 440 bits
+#define SM3_DRBG_MIN_ENTROPY 32                      // 256-bit security strength
+#define SM3_DRBG_MAX_REQUEST 65536                   // 2^19 bits per generate
+#define SM3_DRBG_RESEED_INTERVAL ((uint64_t)1 << 20) // Generates between reseeds
+#define SM3_DRBG_NEED_RESEED 1
+
+typedef struct
+{
+    uint8_t V[SM3_DRBG_SEED_LEN];
+    uint8_t C[SM3_DRBG_SEED_LEN];
+    uint64_t reseed_counter;
+} sm3_drbg_t;
+
+int sm3_drbg_instantiate(sm3_drbg_t *drbg, const uint8_t *entropy, size_t entropy_len, const uint8_t *nonce,
+                         size_t nonce_len, const uint8_t *pers, size_t pers_len);
+int sm3_drbg_reseed(sm3_drbg_t *drbg, const uint8_t *entropy, size_t entropy_len, const uint8_t *add,
+                    size_t add_len);
+int sm3_drbg_generate(sm3_drbg_t *drbg, uint8_t *out, size_t outlen, const uint8_t *add, size_t add_len);
+void sm3_drbg_uninstantiate(sm3_drbg_t *drbg);
+
+// len bytes from the calling thread's own instance, seeded from
+// /dev/urandom on first use (and again in a forked child) and reseeded
+// automatically; any length. 0 on success, -1 if /dev/urandom fails.
+int sm3_drbg_random(uint8_t *out, size_t len);
+
 int sm3_length_extension_attack(const uint8_t *original_hash,
                                 uint64_t original_len,
                                 const uint8_t *append_data,
@@ -36,6 +186,30 @@ int verify_length_extension_attack(const char *secret,
                                    const char *original_msg,
                                    const char *append_msg);
 
+// Batch length extension over unknown secret lengths: for every token
+// (digest = SM3(secret || msg) with msg_lens[t] known) and every secret length
+// from min_secret to max_secret, the extension glue || append and the forged
+// digest SM3(secret || msg || glue || append). The candidates are hashed in
+// the multi-buffer lanes and everything is written into one caller-allocated
+// arena of sm3_forge_arena_size() bytes; *forgeries then points at
+// n_tokens * (max_secret - min_secret + 1) records in token-major order,
+// whose extensions also live in the arena. sm3_forge_arena_size() is 0 when
+// the range is empty or the size overflows a size_t. Returns 0, or -1 if the
+// arena size is 0 or the arena too small.
+typedef struct
+{
+    uint8_t digest[SM3_DIGEST_SIZE];
+    size_t token;
+    size_t secret_len;
+    const uint8_t *extension; // glue padding || append
+    size_t extension_len;
+} sm3_forgery_t;
+
+size_t sm3_forge_arena_size(size_t n_tokens, size_t min_secret, size_t max_secret, size_t append_len);
+int sm3_forge_many(const uint8_t *const digests[], const uint64_t msg_lens[], size_t n_tokens, size_t min_secret,
+                   size_t max_secret, const uint8_t *append, size_t append_len, void *arena, size_t arena_size,
+                   sm3_forgery_t **forgeries);
+
 #define ROTL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
 
 static inline uint32_t P0(uint32_t x)
@@ -0,0 +1,335 @@
+#ifndef SM3_HPP
+#define SM3_HPP
+
+// Header-only C++17 layer over sm3.h
+// Sm3<Backend> binds the compression function at compile time. Basic and
+// Optimized forward to the C implementations; Inline defines the compression
+// function here with its 64 rounds unrolled and the round constants folded,
+// so it inlines into the caller. AnySm3 picks a backend by name at runtime.
+
+extern "C"
+{
+#include "sm3.h"
+}
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace sm3
+{
+
+    // Minimal read-only byte view (std::span is C++20)
+    class bytes_view
+    {
+    public:
+        constexpr bytes_view() noexcept = default;
+        constexpr bytes_view(const std::uint8_t *data, std::size_t size) noexcept : data_(data), size_(size) {}
+
+        template <std::size_t N>
+        constexpr bytes_view(const std::uint8_t (&arr)[N]) noexcept : data_(arr), size_(N) {}
+
+        // Any container of bytes with data()/size() (std::vector, std::array, ...)
+        template <class C, class = std::enable_if_t<
+                               std::is_convertible_v<decltype(std::declval<const C &>().data()), const std::uint8_t *>>>
+        constexpr bytes_view(const C &c) noexcept : data_(c.data()), size_(c.size()) {}
+
+        // Text, without the terminator
+        bytes_view(const std::string &s) noexcept
+            : data_(reinterpret_cast<const std::uint8_t *>(s.data())), size_(s.size()) {}
+
+        constexpr const std::uint8_t *data() const noexcept { return data_; }
+        constexpr std::size_t size() const noexcept { return size_; }
+
+    private:
+        const std::uint8_t *data_ = nullptr;
+        std::size_t size_ = 0;
+    };
+
+    using digest_t = std::array<std::uint8_t, SM3_DIGEST_SIZE>;
+
+    namespace detail
+    {
+        // ROTL from sm3.h shifts by 32 when n == 0; this one does not
+        constexpr std::uint32_t rotl(std::uint32_t x, unsigned n) noexcept
+        {
+            n &= 31;
+            return n ? (x << n) | (x >> (32 - n)) : x;
+        }
+
+        inline std::uint32_t load_be(const std::uint8_t *p) noexcept
+        {
+            return (std::uint32_t(p[0]) << 24) | (std::uint32_t(p[1]) << 16) | (std::uint32_t(p[2]) << 8) | p[3];
+        }
+
+        inline void store_be(std::uint8_t *p, std::uint32_t v) noexcept
+        {
+            p[0] = std::uint8_t(v >> 24);
+            p[1] = std::uint8_t(v >> 16);
+            p[2] = std::uint8_t(v >> 8);
+            p[3] = std::uint8_t(v);
+        }
+
+        inline void wipe(void *p, std::size_t n) noexcept
+        {
+            volatile std::uint8_t *v = static_cast<volatile std::uint8_t *>(p);
+            while (n--)
+            {
+                *v++ = 0;
+            }
+        }
+    }
+
+    namespace backend
+    {
+        // sm3_basic.c
+        struct Basic
+        {
+            static constexpr const char *name = "basic";
+            static void init(sm3_ctx_t &ctx) noexcept { sm3_init(&ctx); }
+            static void update(sm3_ctx_t &ctx, const std::uint8_t *data, std::size_t len) noexcept { sm3_update(&ctx, data, len); }
+            static void final(sm3_ctx_t &ctx, std::uint8_t *digest) noexcept { sm3_final(&ctx, digest); }
+        };
+
+        // sm3_optimized.c
+        struct Optimized
+        {
+            static constexpr const char *name = "optimized";
+            static void init(sm3_ctx_t &ctx) noexcept { sm3_init_optimized(&ctx); }
+            static void update(sm3_ctx_t &ctx, const std::uint8_t *data, std::size_t len) noexcept { sm3_update_optimized(&ctx, data, len); }
+            static void final(sm3_ctx_t &ctx, std::uint8_t *digest) noexcept { sm3_final_optimized(&ctx, digest); }
+        };
+
+        // Compression function defined in this header, rounds unrolled at compile time
+        struct Inline
+        {
+            static constexpr const char *name = "inline";
+
+            static void init(sm3_ctx_t &ctx) noexcept
+            {
+                static constexpr std::uint32_t iv[8] = {
+                    0x7380166F, 0x4914B2B9, 0x172442D7, 0xDA8A0600,
+                    0xA96F30BC, 0x163138AA, 0xE38DEE4D, 0xB0FB0E4E};
+                std::memcpy(ctx.state, iv, sizeof(iv));
+                ctx.count = 0;
+                std::memset(ctx.buffer, 0, SM3_BLOCK_SIZE);
+            }
+
+            static void update(sm3_ctx_t &ctx, const std::uint8_t *data, std::size_t len) noexcept
+            {
+                std::size_t pos = ctx.count % SM3_BLOCK_SIZE;
+                ctx.count += len;
+
+                if (pos && len >= SM3_BLOCK_SIZE - pos)
+                {
+                    std::memcpy(ctx.buffer + pos, data, SM3_BLOCK_SIZE - pos);
+                    compress(ctx.state, ctx.buffer);
+                    data += SM3_BLOCK_SIZE - pos;
+                    len -= SM3_BLOCK_SIZE - pos;
+                    pos = 0;
+                }
+                for (; len >= SM3_BLOCK_SIZE; data += SM3_BLOCK_SIZE, len -= SM3_BLOCK_SIZE)
+                {
+                    compress(ctx.state, data);
+                }
+                if (len)
+                {
+                    std::memcpy(ctx.buffer + pos, data, len);
+                }
+            }
+
+            static void final(sm3_ctx_t &ctx, std::uint8_t *digest) noexcept
+            {
+                std::size_t pos = ctx.count % SM3_BLOCK_SIZE;
+                std::uint64_t bits = ctx.count * 8;
+
+                ctx.buffer[pos++] = 0x80;
+                if (pos > SM3_BLOCK_SIZE - 8)
+                {
+                    std::memset(ctx.buffer + pos, 0, SM3_BLOCK_SIZE - pos);
+                    compress(ctx.state, ctx.buffer);
+                    pos = 0;
+                }
+                std::memset(ctx.buffer + pos, 0, SM3_BLOCK_SIZE - 8 - pos);
+                detail::store_be(ctx.buffer + 56, std::uint32_t(bits >> 32));
+                detail::store_be(ctx.buffer + 60, std::uint32_t(bits));
+                compress(ctx.state, ctx.buffer);
+
+                for (int i = 0; i < 8; i++)
+                {
+                    detail::store_be(digest + 4 * i, ctx.state[i]);
+                }
+            }
+
+            static void compress(std::uint32_t state[8], const std::uint8_t *block) noexcept
+            {
+                std::uint32_t w[68];
+                std::uint32_t v[8];
+
+                for (int j = 0; j < 16; j++)
+                {
+                    w[j] = detail::load_be(block + 4 * j);
+                }
+                for (int j = 16; j < 68; j++)
+                {
+                    w[j] = p1(w[j - 16] ^ w[j - 9] ^ detail::rotl(w[j - 3], 15)) ^ detail::rotl(w[j - 13], 7) ^ w[j - 6];
+                }
+
+                std::memcpy(v, state, sizeof(v));
+                rounds(v, w, std::make_index_sequence<64>{});
+                for (int i = 0; i < 8; i++)
+                {
+                    state[i] ^= v[i];
+                }
+            }
+
+        private:
+            static std::uint32_t p0(std::uint32_t x) noexcept { return x ^ detail::rotl(x, 9) ^ detail::rotl(x, 17); }
+            static std::uint32_t p1(std::uint32_t x) noexcept { return x ^ detail::rotl(x, 15) ^ detail::rotl(x, 23); }
+
+            // Round J; instead of moving A..H, the roles rotate through v[]
+            // (A = v[(-J) % 8], ...), so the unrolled body has no register shuffle
+            template <std::size_t J>
+            static void round(std::uint32_t (&v)[8], const std::uint32_t *w) noexcept
+            {
+                constexpr std::uint32_t tj = detail::rotl(J < 16 ? 0x79CC4519u : 0x7A879D8Au, J % 32);
+                std::uint32_t &a = v[(8 - J % 8) % 8], &b = v[(9 - J % 8) % 8], &c = v[(10 - J % 8) % 8], &d = v[(11 - J % 8) % 8];
+                std::uint32_t &e = v[(12 - J % 8) % 8], &f = v[(13 - J % 8) % 8], &g = v[(14 - J % 8) % 8], &h = v[(15 - J % 8) % 8];
+
+                std::uint32_t a12 = detail::rotl(a, 12);
+                std::uint32_t ss1 = detail::rotl(a12 + e + tj, 7);
+                std::uint32_t ss2 = ss1 ^ a12;
+                std::uint32_t ff, gg;
+                if constexpr (J < 16)
+                {
+                    ff = a ^ b ^ c;
+                    gg = e ^ f ^ g;
+                }
+                else
+                {
+                    ff = (a & b) | (a & c) | (b & c);
+                    gg = (e & f) | (~e & g);
+                }
+                std::uint32_t tt1 = ff + d + ss2 + (w[J] ^ w[J + 4]);
+                std::uint32_t tt2 = gg + h + ss1 + w[J];
+
+                // Next round's A is this round's H slot, E is D's slot
+                b = detail::rotl(b, 9);
+                f = detail::rotl(f, 19);
+                h = tt1;
+                d = p0(tt2);
+            }
+
+            template <std::size_t... J>
+            static void rounds(std::uint32_t (&v)[8], const std::uint32_t *w, std::index_sequence<J...>) noexcept
+            {
+                (round<J>(v, w), ...);
+            }
+        };
+    }
+
+    // Streaming hash; the context is wiped on destruction
+    template <class Backend = backend::Inline>
+    class Sm3
+    {
+    public:
+        using backend_type = Backend;
+
+        Sm3() noexcept { Backend::init(ctx_); }
+        ~Sm3() { detail::wipe(&ctx_, sizeof(ctx_)); }
+
+        Sm3(const Sm3 &) = default;
+        Sm3 &operator=(const Sm3 &) = default;
+
+        Sm3 &update(bytes_view data) noexcept
+        {
+            Backend::update(ctx_, data.data(), data.size());
+            return *this;
+        }
+
+        // Produces the digest and resets for the next message
+        digest_t final() noexcept
+        {
+            digest_t out;
+            Backend::final(ctx_, out.data());
+            Backend::init(ctx_);
+            return out;
+        }
+
+        void reset() noexcept { Backend::init(ctx_); }
+
+        static digest_t digest(bytes_view data) noexcept
+        {
+            Sm3 h;
+            h.update(data);
+            return h.final();
+        }
+
+    private:
+        sm3_ctx_t ctx_;
+    };
+
+    // Backend chosen at runtime: one virtual call per update(), not per block
+    class AnySm3
+    {
+    public:
+        // name: "basic", "optimized" or "inline" (the default)
+        static AnySm3 create(const char *name = nullptr)
+        {
+            std::string n = name ? name : backend::Inline::name;
+            if (n == backend::Inline::name)
+            {
+                return AnySm3(std::make_unique<Model<backend::Inline>>());
+            }
+            if (n == backend::Optimized::name)
+            {
+                return AnySm3(std::make_unique<Model<backend::Optimized>>());
+            }
+            if (n == backend::Basic::name)
+            {
+                return AnySm3(std::make_unique<Model<backend::Basic>>());
+            }
+            throw std::invalid_argument("sm3: unknown backend " + n);
+        }
+
+        AnySm3 &update(bytes_view data)
+        {
+            impl_->update(data);
+            return *this;
+        }
+
+        digest_t final() { return impl_->final(); }
+        const char *backend_name() const noexcept { return impl_->name(); }
+
+    private:
+        struct Concept
+        {
+            virtual ~Concept() = default;
+            virtual void update(bytes_view data) noexcept = 0;
+            virtual digest_t final() noexcept = 0;
+            virtual const char *name() const noexcept = 0;
+        };
+
+        template <class Backend>
+        struct Model final : Concept
+        {
+            Sm3<Backend> h;
+            void update(bytes_view data) noexcept override { h.update(data); }
+            digest_t final() noexcept override { return h.final(); }
+            const char *name() const noexcept override { return Backend::name; }
+        };
+
+        explicit AnySm3(std::unique_ptr<Concept> impl) : impl_(std::move(impl)) {}
+
+        std::unique_ptr<Concept> impl_;
+    };
+
+}
+
+#endif // SM3_HPP
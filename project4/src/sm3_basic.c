@@ -159,3 +159,53 @@ void sm3_hash(const uint8_t *data, size_t len, uint8_t *digest)
     sm3_update(&ctx, data, len);
     sm3_final(&ctx, digest);
 }
+
+void sm3_export_state(const sm3_ctx_t *ctx, uint8_t *out)
+{
+    size_t buffered = ctx->count % SM3_BLOCK_SIZE;
+
+    for (int i = 0; i < 8; i++)
+    {
+        out[i * 4] = (uint8_t)(ctx->state[i] >> 24);
+        out[i * 4 + 1] = (uint8_t)(ctx->state[i] >> 16);
+        out[i * 4 + 2] = (uint8_t)(ctx->state[i] >> 8);
+        out[i * 4 + 3] = (uint8_t)(ctx->state[i]);
+    }
+    for (int i = 0; i < 8; i++)
+    {
+        out[32 + i] = (uint8_t)(ctx->count >> (56 - i * 8));
+    }
+    memcpy(out + 40, ctx->buffer, buffered);
+    memset(out + 40 + buffered, 0, SM3_BLOCK_SIZE - buffered);
+}
+
+void sm3_import_state(sm3_ctx_t *ctx, const uint8_t *in)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        ctx->state[i] = ((uint32_t)in[i * 4] << 24) | ((uint32_t)in[i * 4 + 1] << 16) |
+                        ((uint32_t)in[i * 4 + 2] << 8) | in[i * 4 + 3];
+    }
+    ctx->count = 0;
+    for (int i = 0; i < 8; i++)
+    {
+        ctx->count = (ctx->count << 8) | in[32 + i];
+    }
+    memcpy(ctx->buffer, in + 40, SM3_BLOCK_SIZE);
+}
+
+int sm3_import_digest(sm3_ctx_t *ctx, const uint8_t *digest, uint64_t count)
+{
+    if (count % SM3_BLOCK_SIZE != 0)
+    {
+        return -1;
+    }
+    for (int i = 0; i < 8; i++)
+    {
+        ctx->state[i] = ((uint32_t)digest[i * 4] << 24) | ((uint32_t)digest[i * 4 + 1] << 16) |
+                        ((uint32_t)digest[i * 4 + 2] << 8) | digest[i * 4 + 3];
+    }
+    ctx->count = count;
+    memset(ctx->buffer, 0, SM3_BLOCK_SIZE);
+    return 0;
+}
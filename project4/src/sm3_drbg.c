@@ -0,0 +1,338 @@
+#define _POSIX_C_SOURCE 200809L
+#include "sm3_internal.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+// Hash_DRBG (NIST SP 800-90A, section 10.1.1) with SM3: seedlen is 440 bits
+// and the generate function outputs SM3(V), SM3(V + 1), ... Each of those
+// messages is 55 bytes, exactly one padded block, so a request is built as
+// a batch of blocks (V + i, 0x80, bit length 440) and compressed in the
+// backend's lanes from the IV, without the message scheduler.
+
+#define DRBG_BATCH 64 // Blocks built per pass
+#define DRBG_MAX_LANES 16
+
+// v = (v + x) mod 2^440, both big-endian, x no longer than v
+static void add_be(uint8_t *v, const uint8_t *x, size_t xlen)
+{
+    unsigned int carry = 0;
+    size_t i = SM3_DRBG_SEED_LEN;
+
+    while (i-- > 0)
+    {
+        size_t back = SM3_DRBG_SEED_LEN - 1 - i;
+        carry += v[i] + (back < xlen ? x[xlen - 1 - back] : 0);
+        v[i] = (uint8_t)carry;
+        carry >>= 8;
+    }
+}
+
+static void increment_be(uint8_t *v)
+{
+    size_t i = SM3_DRBG_SEED_LEN;
+    while (i-- > 0 && ++v[i] == 0)
+    {
+    }
+}
+
+// Hash_df: SM3(counter || no_of_bits || input) for counter = 1, 2, ...,
+// truncated to SM3_DRBG_SEED_LEN bytes; the input is given in pieces
+static void hash_df(const uint8_t *const parts[], const size_t lens[], size_t nparts, uint8_t *out)
+{
+    uint8_t prefix[5] = {1, 0, 0, 0, 0};
+    uint8_t digest[SM3_DIGEST_SIZE];
+    size_t done = 0;
+
+    store_be32(prefix + 1, SM3_DRBG_SEED_LEN * 8);
+    while (done < SM3_DRBG_SEED_LEN)
+    {
+        size_t take = SM3_DRBG_SEED_LEN - done < SM3_DIGEST_SIZE ? SM3_DRBG_SEED_LEN - done : SM3_DIGEST_SIZE;
+        sm3_ctx_t ctx;
+
+        sm3_init_optimized(&ctx);
+        sm3_update_optimized(&ctx, prefix, sizeof(prefix));
+        for (size_t i = 0; i < nparts; i++)
+        {
+            if (lens[i])
+            {
+                sm3_update_optimized(&ctx, parts[i], lens[i]);
+            }
+        }
+        sm3_final_optimized(&ctx, digest);
+        memcpy(out + done, digest, take);
+        done += take;
+        prefix[0]++;
+    }
+    wipe(digest, sizeof(digest));
+}
+
+// SM3(byte || V || extra)
+static void hash_v(uint8_t byte, const uint8_t *v, const uint8_t *extra, size_t extra_len, uint8_t *digest)
+{
+    sm3_ctx_t ctx;
+
+    sm3_init_optimized(&ctx);
+    sm3_update_optimized(&ctx, &byte, 1);
+    sm3_update_optimized(&ctx, v, SM3_DRBG_SEED_LEN);
+    if (extra_len)
+    {
+        sm3_update_optimized(&ctx, extra, extra_len);
+    }
+    sm3_final_optimized(&ctx, digest);
+}
+
+// C = Hash_df(0x00 || V), reseed_counter = 1
+static void derive_c(sm3_drbg_t *drbg)
+{
+    static const uint8_t zero = 0;
+    const uint8_t *parts[2] = {&zero, drbg->V};
+    const size_t lens[2] = {1, SM3_DRBG_SEED_LEN};
+
+    hash_df(parts, lens, 2, drbg->C);
+    drbg->reseed_counter = 1;
+}
+
+int sm3_drbg_instantiate(sm3_drbg_t *drbg, const uint8_t *entropy, size_t entropy_len, const uint8_t *nonce,
+                         size_t nonce_len, const uint8_t *pers, size_t pers_len)
+{
+    const uint8_t *parts[3] = {entropy, nonce, pers};
+    const size_t lens[3] = {entropy_len, nonce_len, pers_len};
+
+    if (entropy_len < SM3_DRBG_MIN_ENTROPY)
+    {
+        return -1;
+    }
+    hash_df(parts, lens, 3, drbg->V);
+    derive_c(drbg);
+    return 0;
+}
+
+int sm3_drbg_reseed(sm3_drbg_t *drbg, const uint8_t *entropy, size_t entropy_len, const uint8_t *add,
+                    size_t add_len)
+{
+    static const uint8_t one = 1;
+    uint8_t v[SM3_DRBG_SEED_LEN];
+    const uint8_t *parts[4] = {&one, v, entropy, add};
+    const size_t lens[4] = {1, SM3_DRBG_SEED_LEN, entropy_len, add_len};
+
+    if (entropy_len < SM3_DRBG_MIN_ENTROPY)
+    {
+        return -1;
+    }
+    memcpy(v, drbg->V, sizeof(v));
+    hash_df(parts, lens, 4, drbg->V);
+    derive_c(drbg);
+    wipe(v, sizeof(v));
+    return 0;
+}
+
+// Hashgen: SM3(V + i) for i = 0 .. ceil(outlen / 32) - 1
+static void hashgen(const uint8_t *v, uint8_t *out, size_t outlen)
+{
+    uint8_t block_data[DRBG_BATCH][SM3_BLOCK_SIZE];
+    const uint8_t *blocks[DRBG_BATCH];
+    uint32_t state[8 * DRBG_MAX_LANES];
+    uint8_t data[SM3_DRBG_SEED_LEN], last[SM3_DIGEST_SIZE];
+    size_t total = (outlen + SM3_DIGEST_SIZE - 1) / SM3_DIGEST_SIZE;
+    sm3_engine wide, narrow;
+
+    sm3_engines(&wide, &narrow);
+    memcpy(data, v, sizeof(data));
+
+    // Only the slots a lane can reach, so that nonce-sized requests do not
+    // pay for a whole batch
+    size_t slots = total * 8 <= wide.lanes ? total : (total + wide.lanes - 1) / wide.lanes * wide.lanes;
+    slots = slots < DRBG_BATCH ? slots : DRBG_BATCH;
+    for (size_t b = 0; b < slots; b++)
+    {
+        memset(block_data[b], 0, SM3_BLOCK_SIZE);
+        block_data[b][SM3_DRBG_SEED_LEN] = 0x80;
+        block_data[b][SM3_BLOCK_SIZE - 2] = (uint8_t)((SM3_DRBG_SEED_LEN * 8) >> 8);
+        block_data[b][SM3_BLOCK_SIZE - 1] = (uint8_t)(SM3_DRBG_SEED_LEN * 8);
+        blocks[b] = block_data[b];
+    }
+
+    for (size_t base = 0; base < total; base += DRBG_BATCH)
+    {
+        size_t count = total - base < DRBG_BATCH ? total - base : DRBG_BATCH;
+
+        for (size_t b = 0; b < count; b++)
+        {
+            memcpy(block_data[b], data, SM3_DRBG_SEED_LEN);
+            increment_be(data);
+        }
+
+        for (size_t first = 0; first < count;)
+        {
+            // One or two blocks (a nonce-sized request): scalar is faster
+            const sm3_engine *eng = (count - first) * 8 <= wide.lanes ? &narrow : &wide;
+            size_t lanes = eng->lanes;
+            size_t group = count - first < lanes ? count - first : lanes;
+
+            for (size_t l = 0; l < lanes; l++)
+            {
+                for (int i = 0; i < 8; i++)
+                {
+                    state[i * lanes + l] = SM3_IV[i];
+                }
+            }
+            // Groups start at multiples of the lane count (which divides
+            // DRBG_BATCH); lanes past the request compress stale blocks
+            eng->compress(state, blocks + first);
+
+            for (size_t l = 0; l < group; l++)
+            {
+                size_t off = (base + first + l) * SM3_DIGEST_SIZE;
+                uint8_t *dst = outlen - off >= SM3_DIGEST_SIZE ? out + off : last;
+
+                for (int i = 0; i < 8; i++)
+                {
+                    store_be32(dst + 4 * i, state[i * lanes + l]);
+                }
+                if (dst == last)
+                {
+                    memcpy(out + off, last, outlen - off);
+                }
+            }
+            first += group;
+        }
+    }
+    wipe(block_data, slots * SM3_BLOCK_SIZE);
+    wipe(state, sizeof(state));
+    wipe(data, sizeof(data));
+    wipe(last, sizeof(last));
+}
+
+int sm3_drbg_generate(sm3_drbg_t *drbg, uint8_t *out, size_t outlen, const uint8_t *add, size_t add_len)
+{
+    uint8_t h[SM3_DIGEST_SIZE];
+    uint8_t counter[8];
+
+    if (outlen > SM3_DRBG_MAX_REQUEST)
+    {
+        return -1;
+    }
+    if (drbg->reseed_counter > SM3_DRBG_RESEED_INTERVAL)
+    {
+        return SM3_DRBG_NEED_RESEED;
+    }
+
+    if (add_len)
+    {
+        hash_v(0x02, drbg->V, add, add_len, h);
+        add_be(drbg->V, h, sizeof(h));
+    }
+    hashgen(drbg->V, out, outlen);
+
+    // V = V + SM3(0x03 || V) + C + reseed_counter
+    hash_v(0x03, drbg->V, NULL, 0, h);
+    for (int i = 0; i < 8; i++)
+    {
+        counter[i] = (uint8_t)(drbg->reseed_counter >> (56 - 8 * i));
+    }
+    add_be(drbg->V, h, sizeof(h));
+    add_be(drbg->V, drbg->C, SM3_DRBG_SEED_LEN);
+    add_be(drbg->V, counter, sizeof(counter));
+    drbg->reseed_counter++;
+    wipe(h, sizeof(h));
+    return 0;
+}
+
+void sm3_drbg_uninstantiate(sm3_drbg_t *drbg)
+{
+    wipe(drbg, sizeof(*drbg));
+}
+
+// --- Per-thread instance -----------------------------------------------------
+
+static int read_urandom(uint8_t *buf, size_t len)
+{
+    int fd = open("/dev/urandom", O_RDONLY);
+
+    if (fd < 0)
+    {
+        return -1;
+    }
+    while (len > 0)
+    {
+        ssize_t got = read(fd, buf, len);
+        if (got < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (got <= 0)
+        {
+            close(fd);
+            return -1;
+        }
+        buf += got;
+        len -= (size_t)got;
+    }
+    close(fd);
+    return 0;
+}
+
+static __thread sm3_drbg_t thread_drbg;
+static __thread int thread_seeded;
+static __thread unsigned int thread_fork_gen; // fork_generation when instantiated
+
+// Bumped in the child after fork() so per-thread instances are instantiated
+// afresh instead of repeating the parent's output; checking it costs no
+// system call
+static volatile unsigned int fork_generation = 0;
+static pthread_once_t atfork_once = PTHREAD_ONCE_INIT;
+
+static void drbg_atfork_child(void)
+{
+    fork_generation++;
+}
+
+static void drbg_register_atfork(void)
+{
+    pthread_atfork(NULL, NULL, drbg_atfork_child);
+}
+
+int sm3_drbg_random(uint8_t *out, size_t len)
+{
+    uint8_t seed[SM3_DRBG_MIN_ENTROPY + SM3_DRBG_MIN_ENTROPY / 2];
+    int rc = 0;
+
+    if (!thread_seeded || thread_fork_gen != fork_generation)
+    {
+        // Entropy and nonce, personalised with the instance's address so
+        // threads stay distinct even if the kernel returned the same bytes
+        const sm3_drbg_t *self = &thread_drbg;
+
+        pthread_once(&atfork_once, drbg_register_atfork);
+        if (read_urandom(seed, sizeof(seed)) != 0 ||
+            sm3_drbg_instantiate(&thread_drbg, seed, SM3_DRBG_MIN_ENTROPY, seed + SM3_DRBG_MIN_ENTROPY,
+                                 sizeof(seed) - SM3_DRBG_MIN_ENTROPY, (const uint8_t *)&self, sizeof(self)) != 0)
+        {
+            wipe(seed, sizeof(seed));
+            return -1;
+        }
+        thread_fork_gen = fork_generation;
+        thread_seeded = 1;
+    }
+
+    while (len > 0 && rc == 0)
+    {
+        size_t take = len < SM3_DRBG_MAX_REQUEST ? len : SM3_DRBG_MAX_REQUEST;
+
+        rc = sm3_drbg_generate(&thread_drbg, out, take, NULL, 0);
+        if (rc == SM3_DRBG_NEED_RESEED)
+        {
+            rc = read_urandom(seed, SM3_DRBG_MIN_ENTROPY) == 0
+                     ? sm3_drbg_reseed(&thread_drbg, seed, SM3_DRBG_MIN_ENTROPY, NULL, 0)
+                     : -1;
+            continue;
+        }
+        out += take;
+        len -= take;
+    }
+    wipe(seed, sizeof(seed));
+    return rc;
+}
@@ -0,0 +1,513 @@
+#include "sm3_internal.h"
+#include <string.h>
+
+// Fixed 65-byte messages, prefix || 64 bytes: Merkle parents
+// (0x01 || left || right) and 64-byte Merkle leaves (0x00 || data).
+// Block 1 (prefix and the first 63 bytes) goes straight to the compression
+// without the update/final buffering. Block 2 is the last data byte, 0x80,
+// zeros and the bit length 520. The message expansion is XOR-linear, so
+// its schedule is the schedule of the constant part XOR the schedule of the
+// data byte, each nibble of which is looked up in a precomputed table.
+
+#define FIXED_LEN 65
+#define FIXED_BATCH 64
+
+// Block-2 schedules: sched_lo[v] for data byte v (0x80, length included),
+// sched_hi[v] for data byte v << 4 alone. Generated offline by expanding
+// W[0] = (v << 24) | 0x00800000, W[15] = 520 and W[0] = v << 28 (all other
+// words zero), so they are const data and need no initialisation.
+static const uint32_t sched_lo[16][68] = {
+    {
+        0x00800000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000208,
+        0x00804040, 0x00000000, 0x01048282, 0x00100050, 0x00000000, 0x802082aa, 0x04ac545c, 0x00000000,
+        0xed7d4a91, 0x00a00030, 0x00000000, 0x0020828a, 0x04a55458, 0x40202000, 0xb0251a58, 0x0535025c,
+        0x00a00020, 0xa88008a8, 0xc03a8435, 0x160a0e02, 0xba36f4c3, 0x919bd091, 0x00200000, 0xa08008aa,
+        0x907b4175, 0x44a02200, 0xded190cd, 0xc5c7527c, 0x200a8063, 0x0abc8224, 0x19aeb91f, 0x79489a62,
+        0xd67e758d, 0x5d7efef3, 0xa1e56322, 0xaa208060, 0x5d22a00f, 0x44e820aa, 0x3d7cd1a6, 0xc1796723,
+        0x7667ebec, 0x68090361, 0x35043bd0, 0x319e87a4, 0xcb2d1c0a, 0xfcc40746, 0x2a3e5632, 0xeec5c1ec,
+        0x618c3f2d, 0xa0ce800a, 0x0d23478f, 0x7ce5c672
+    },
+    {
+        0x01800000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000208,
+        0x0180c0c0, 0x00000000, 0x01048282, 0x003000f0, 0x00000000, 0x802082aa, 0x0df4fce4, 0x00000000,
+        0xed7d4a91, 0x01e00050, 0x00000000, 0x0020828a, 0x0dedf4e8, 0xc0606000, 0xb0251a58, 0x055702f6,
+        0x01e00060, 0xa88008a8, 0x60cf2ede, 0x3a1e1206, 0xba36f4c3, 0x90cfd057, 0x00600000, 0xa08008aa,
+        0xb08feb1e, 0xcce46600, 0xfef1908d, 0x64e172d6, 0x215e8027, 0x0a94822c, 0xaaf94b09, 0x8bd9abb2,
+        0xd73ed52d, 0x3c2bbe9f, 0xa0e16322, 0xaa3080b0, 0xe765ca99, 0xcc2c24ea, 0x1e1e7142, 0x7b292533,
+        0x3732aba8, 0xe90b8361, 0xf78c46f2, 0x12a388bd, 0xcb391600, 0x8a9523f6, 0x2a6e1632, 0xeec4c1e1,
+        0x2294435f, 0xa046c44e, 0x6f356dc1, 0xd604e253
+    },
+    {
+        0x02800000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000208,
+        0x02814140, 0x00000000, 0x01048282, 0x00500110, 0x00000000, 0x802082aa, 0x161d052c, 0x00000000,
+        0xed7d4a91, 0x022000f0, 0x00000000, 0x0020828a, 0x16341538, 0x40a0a001, 0xb0251a58, 0x05f10308,
+        0x022000a0, 0xa88008a8, 0x81d1d1e2, 0x4e22360a, 0xba36f4c3, 0x9333d11d, 0x00a00000, 0xa08008aa,
+        0xd19215a3, 0x5428aa01, 0x9e91904d, 0x878b1329, 0x22a280eb, 0x0aec8234, 0x7f015d32, 0x9c6af9c3,
+        0xd4ff34cd, 0x9fd47e2b, 0xa3ed6322, 0xaa0081c0, 0x29ac7522, 0x5560282b, 0x7bb9906e, 0xb5d9e302,
+        0xf4cd6b64, 0x6a0c0360, 0xb014c195, 0x77e49996, 0xcb05081e, 0x10664e26, 0x2a9ed632, 0xeec7c1f6,
+        0xe7bcc7c9, 0xa1de0882, 0xc90f1313, 0x29278e31
+    },
+    {
+        0x03800000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000208,
+        0x0381c1c0, 0x00000000, 0x01048282, 0x007001b0, 0x00000000, 0x802082aa, 0x1f45ad94, 0x00000000,
+        0xed7d4a91, 0x03600090, 0x00000000, 0x0020828a, 0x1f7cb588, 0xc0e0e001, 0xb0251a58, 0x059303a2,
+        0x036000e0, 0xa88008a8, 0x21247b09, 0x62362a0e, 0xba36f4c3, 0x9267d1db, 0x00e00000, 0xa08008aa,
+        0xf166bfc8, 0xdc6cee01, 0xbeb1900d, 0x26ad3383, 0x23f680af, 0x0ac4823c, 0xcc56af24, 0x6efbc813,
+        0xd5bf946d, 0xfe813e47, 0xa2e96322, 0xaa108110, 0x93eb1fb4, 0xdda42c6b, 0x58db308a, 0x0f89a112,
+        0xb5982b20, 0xeb0e8360, 0x729cbcb7, 0x54d9968f, 0xcb110214, 0x66376a96, 0x2ace9632, 0xeec6c1fb,
+        0xa4a4bbbb, 0xa1564cc6, 0xab19395d, 0x83c6aa10
+    },
+    {
+        0x04800000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000208,
+        0x04824240, 0x00000000, 0x01048282, 0x009002d0, 0x00000000, 0x802082aa, 0x21cef6bc, 0x00000000,
+        0xed7d4a91, 0x05a001b0, 0x00000000, 0x0020828a, 0x2187d698, 0x41212002, 0xb0251a58, 0x04bd00f4,
+        0x05a00120, 0xa88008a8, 0x43ec2f9b, 0xa65a7e12, 0xba36f4c3, 0x94cbd389, 0x01200000, 0xa08008aa,
+        0x13a9e8d9, 0x65b13202, 0x5e5191cd, 0x415fd0d6, 0x255a8173, 0x0a1c8204, 0xd4f17145, 0xb30c5d21,
+        0xd37cf70d, 0xd82bff42, 0xa5f56322, 0xaa608320, 0xb43f0a55, 0x67f831a8, 0xb0f65236, 0x28386f61,
+        0x7332eafd, 0x6c030363, 0x3f25cf5b, 0xbd6abbc0, 0xcb7d3422, 0x25809587, 0x2b7f5632, 0xeec1c1d8,
+        0x6dedcee4, 0xa2ef911a, 0x857beeb6, 0xd76156f4
+    },
+    {
+        0x05800000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000208,
+        0x0582c2c0, 0x00000000, 0x01048282, 0x00b00270, 0x00000000, 0x802082aa, 0x28965e04, 0x00000000,
+        0xed7d4a91, 0x04e001d0, 0x00000000, 0x0020828a, 0x28cf7628, 0xc1616002, 0xb0251a58, 0x04df005e,
+        0x04e00160, 0xa88008a8, 0xe3198570, 0x8a4e6216, 0xba36f4c3, 0x959fd34f, 0x01600000, 0xa08008aa,
+        0x335d42b2, 0xedf57602, 0x7e71918d, 0xe079f07c, 0x240e8137, 0x0a34820c, 0x67a68353, 0x419d6cf1,
+        0xd23c57ad, 0xb97ebf2e, 0xa4f16322, 0xaa7083f0, 0x0e7860c3, 0xef3c35e8, 0x9394f2d2, 0x92682d71,
+        0x3267aab9, 0xed018363, 0xfdadb279, 0x9e57b4d9, 0xcb693e28, 0x53d1b137, 0x2b2f1632, 0xeec0c1d5,
+        0x2ef5b296, 0xa267d55e, 0xe76dc4f8, 0x7d8072d5
+    },
+    {
+        0x06800000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000208,
+        0x06834340, 0x00000000, 0x01048282, 0x00d00390, 0x00000000, 0x802082aa, 0x337fa7cc, 0x00000000,
+        0xed7d4a91, 0x07200170, 0x00000000, 0x0020828a, 0x331697f8, 0x41a1a003, 0xb0251a58, 0x047901a0,
+        0x072001a0, 0xa88008a8, 0x02077a4c, 0xfe72461a, 0xba36f4c3, 0x9663d205, 0x01a00000, 0xa08008aa,
+        0x5240bc0f, 0x7539ba03, 0x1e11914d, 0x03139183, 0x27f281fb, 0x0a4c8214, 0xb25e9568, 0x562e3e80,
+        0xd1fdb64d, 0x1a817f9a, 0xa7fd6322, 0xaa408280, 0xc0b1df78, 0x76703929, 0xf63313fe, 0x5c98eb40,
+        0xf1986a75, 0x6e060362, 0xba35351e, 0xfb10a5f2, 0xcb552036, 0xc922dce7, 0x2bdfd632, 0xeec3c1c2,
+        0xebdd3600, 0xa3ff1992, 0x4157ba2a, 0x82a31eb7
+    },
+    {
+        0x07800000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000208,
+        0x0783c3c0, 0x00000000, 0x01048282, 0x00f00330, 0x00000000, 0x802082aa, 0x3a270f74, 0x00000000,
+        0xed7d4a91, 0x06600110, 0x00000000, 0x0020828a, 0x3a5e3748, 0xc1e1e003, 0xb0251a58, 0x041b010a,
+        0x066001e0, 0xa88008a8, 0xa2f2d0a7, 0xd2665a1e, 0xba36f4c3, 0x9737d2c3, 0x01e00000, 0xa08008aa,
+        0x72b41664, 0xfd7dfe03, 0x3e31910d, 0xa235b129, 0x26a681bf, 0x0a64821c, 0x0109677e, 0xa4bf0f50,
+        0xd0bd16ed, 0x7bd43ff6, 0xa6f96322, 0xaa508250, 0x7af6b5ee, 0xfeb43d69, 0xd551b31a, 0xe6c8a950,
+        0xb0cd2a31, 0xef048362, 0x78bd483c, 0xd82daaeb, 0xcb412a3c, 0xbf73f857, 0x2b8f9632, 0xeec2c1cf,
+        0xa8c54a72, 0xa3775dd6, 0x23419064, 0x28423a96
+    },
+    {
+        0x08800000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000208,
+        0x08844440, 0x00000000, 0x01048282, 0x01100550, 0x00000000, 0x802082aa, 0x4e69119c, 0x00000000,
+        0xed7d4a91, 0x0aa00330, 0x00000000, 0x0020828a, 0x4ee051d8, 0x42222004, 0xb0251a58, 0x0625070c,
+        0x0aa00220, 0xa88008a8, 0xc797d368, 0x76aaee23, 0xba36f4c3, 0x9b3bd6a1, 0x02200000, 0xa08008aa,
+        0x97de122c, 0x06820204, 0xdfd192cc, 0xccf65729, 0x2aaa8243, 0x0bfc8264, 0x831129aa, 0xedc114e5,
+        0xdc7b708d, 0x57d4fd90, 0xa9c56322, 0xaaa086e0, 0x8f19f4ba, 0x02c802ae, 0x2669d687, 0x13fb77a6,
+        0x7ccde9ce, 0x601d0365, 0x2147d2c6, 0x2876ff6d, 0xcb8d4c5a, 0x4e4d22c5, 0x28bc5632, 0xeecdc184,
+        0x794fdcbf, 0xa48ca22a, 0x1d9215fc, 0x2bece77f
+    },
+    {
+        0x09800000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000208,
+        0x0984c4c0, 0x00000000, 0x01048282, 0x013005f0, 0x00000000, 0x802082aa, 0x4731b924, 0x00000000,
+        0xed7d4a91, 0x0be00350, 0x00000000, 0x0020828a, 0x47a8f168, 0xc2626004, 0xb0251a58, 0x064707a6,
+        0x0be00260, 0xa88008a8, 0x67627983, 0x5abef227, 0xba36f4c3, 0x9a6fd667, 0x02600000, 0xa08008aa,
+        0xb72ab847, 0x8ec64604, 0xfff1928c, 0x6dd07783, 0x2bfe8207, 0x0bd4826c, 0x3046dbbc, 0x1f502535,
+        0xdd3bd02d, 0x3681bdfc, 0xa8c16322, 0xaab08630, 0x355e9e2c, 0x8a0c06ee, 0x050b7663, 0xa9ab35b6,
+        0x3d98a98a, 0xe11f8365, 0xe3cfafe4, 0x0b4bf074, 0xcb994650, 0x381c0675, 0x28ec1632, 0xeeccc189,
+        0x3a57a0cd, 0xa404e66e, 0x7f843fb2, 0x810dc35e
+    },
+    {
+        0x0a800000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000208,
+        0x0a854540, 0x00000000, 0x01048282, 0x01500410, 0x00000000, 0x802082aa, 0x5cd840ec, 0x00000000,
+        0xed7d4a91, 0x082003f0, 0x00000000, 0x0020828a, 0x5c7110b8, 0x42a2a005, 0xb0251a58, 0x06e10658,
+        0x082002a0, 0xa88008a8, 0x867c86bf, 0x2e82d62b, 0xba36f4c3, 0x9993d72d, 0x02a00000, 0xa08008aa,
+        0xd63746fa, 0x160a8a05, 0x9f91924c, 0x8eba167c, 0x280282cb, 0x0bac8274, 0xe5becd87, 0x08e37744,
+        0xdefa31cd, 0x957e7d48, 0xabcd6322, 0xaa808740, 0xfb972197, 0x13400a2f, 0x60ac974f, 0x675bf387,
+        0xfe676946, 0x62180364, 0xa4572883, 0x6e0ce15f, 0xcba5584e, 0xa2ef6ba5, 0x281cd632, 0xeecfc19e,
+        0xff7f245b, 0xa59c2aa2, 0xd9be4160, 0x7e2eaf3c
+    },
+    {
+        0x0b800000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000208,
+        0x0b85c5c0, 0x00000000, 0x01048282, 0x017004b0, 0x00000000, 0x802082aa, 0x5580e854, 0x00000000,
+        0xed7d4a91, 0x09600390, 0x00000000, 0x0020828a, 0x5539b008, 0xc2e2e005, 0xb0251a58, 0x068306f2,
+        0x096002e0, 0xa88008a8, 0x26892c54, 0x0296ca2f, 0xba36f4c3, 0x98c7d7eb, 0x02e00000, 0xa08008aa,
+        0xf6c3ec91, 0x9e4ece05, 0xbfb1920c, 0x2f9c36d6, 0x2956828f, 0x0b84827c, 0x56e93f91, 0xfa724694,
+        0xdfba916d, 0xf42b3d24, 0xaac96322, 0xaa908790, 0x41d04b01, 0x9b840e6f, 0x43ce37ab, 0xdd0bb197,
+        0xbf322902, 0xe31a8364, 0x66df55a1, 0x4d31ee46, 0xcbb15244, 0xd4be4f15, 0x284c9632, 0xeecec193,
+        0xbc675829, 0xa5146ee6, 0xbba86b2e, 0xd4cf8b1d
+    },
+    {
+        0x0c800000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000208,
+        0x0c864640, 0x00000000, 0x01048282, 0x019007d0, 0x00000000, 0x802082aa, 0x6b0bb37c, 0x00000000,
+        0xed7d4a91, 0x0fa002b0, 0x00000000, 0x0020828a, 0x6bc2d318, 0x43232006, 0xb0251a58, 0x07ad05a4,
+        0x0fa00320, 0xa88008a8, 0x444178c6, 0xc6fa9e33, 0xba36f4c3, 0x9e6bd5b9, 0x03200000, 0xa08008aa,
+        0x140cbb80, 0x27931206, 0x5f5193cc, 0x486ed583, 0x2ffa8353, 0x0b5c8244, 0x4e4ee1f0, 0x2785d3a6,
+        0xd979f20d, 0xd281fc21, 0xadd56322, 0xaae085a0, 0x66045ee0, 0x21d813ac, 0xabe35517, 0xfaba7fe4,
+        0x7998e8df, 0x64170367, 0x2b66264d, 0xa482c309, 0xcbdd6472, 0x9709b004, 0x29fd5632, 0xeec9c1b0,
+        0x752e2d76, 0xa6adb33a, 0x95cabcc5, 0x806877f9
+    },
+    {
+        0x0d800000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000208,
+        0x0d86c6c0, 0x00000000, 0x01048282, 0x01b00770, 0x00000000, 0x802082aa, 0x62531bc4, 0x00000000,
+        0xed7d4a91, 0x0ee002d0, 0x00000000, 0x0020828a, 0x628a73a8, 0xc3636006, 0xb0251a58, 0x07cf050e,
+        0x0ee00360, 0xa88008a8, 0xe4b4d22d, 0xeaee8237, 0xba36f4c3, 0x9f3fd57f, 0x03600000, 0xa08008aa,
+        0x34f811eb, 0xafd75606, 0x7f71938c, 0xe948f529, 0x2eae8317, 0x0b74824c, 0xfd1913e6, 0xd514e276,
+        0xd83952ad, 0xb3d4bc4d, 0xacd16322, 0xaaf08570, 0xdc433476, 0xa91c17ec, 0x8881f5f3, 0x40ea3df4,
+        0x38cda89b, 0xe5158367, 0xe9ee5b6f, 0x87bfcc10, 0xcbc96e78, 0xe15894b4, 0x29ad1632, 0xeec8c1bd,
+        0x36365104, 0xa625f77e, 0xf7dc968b, 0x2a8953d8
+    },
+    {
+        0x0e800000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000208,
+        0x0e874740, 0x00000000, 0x01048282, 0x01d00690, 0x00000000, 0x802082aa, 0x79bae20c, 0x00000000,
+        0xed7d4a91, 0x0d200270, 0x00000000, 0x0020828a, 0x79539278, 0x43a3a007, 0xb0251a58, 0x076904f0,
+        0x0d2003a0, 0xa88008a8, 0x05aa2d11, 0x9ed2a63b, 0xba36f4c3, 0x9cc3d435, 0x03a00000, 0xa08008aa,
+        0x55e5ef56, 0x371b9a07, 0x1f11934c, 0x0a2294d6, 0x2d5283db, 0x0b0c8254, 0x28e105dd, 0xc2a7b007,
+        0xdbf8b34d, 0x102b7cf9, 0xafdd6322, 0xaac08400, 0x128a8bcd, 0x30501b2d, 0xed2614df, 0x8e1afbc5,
+        0xfb326857, 0x66120366, 0xae76dc08, 0xe2f8dd3b, 0xcbf57066, 0x7babf964, 0x295dd632, 0xeecbc1aa,
+        0xf31ed592, 0xa7bd3bb2, 0x51e6e859, 0xd5aa3fba
+    },
+    {
+        0x0f800000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000208,
+        0x0f87c7c0, 0x00000000, 0x01048282, 0x01f00630, 0x00000000, 0x802082aa, 0x70e24ab4, 0x00000000,
+        0xed7d4a91, 0x0c600210, 0x00000000, 0x0020828a, 0x701b32c8, 0xc3e3e007, 0xb0251a58, 0x070b045a,
+        0x0c6003e0, 0xa88008a8, 0xa55f87fa, 0xb2c6ba3f, 0xba36f4c3, 0x9d97d4f3, 0x03e00000, 0xa08008aa,
+        0x7511453d, 0xbf5fde07, 0x3f31930c, 0xab04b47c, 0x2c06839f, 0x0b24825c, 0x9bb6f7cb, 0x303681d7,
+        0xdab813ed, 0x717e3c95, 0xaed96322, 0xaad084d0, 0xa8cde15b, 0xb8941f6d, 0xce44b43b, 0x344ab9d5,
+        0xba672813, 0xe7108366, 0x6cfea12a, 0xc1c5d222, 0xcbe17a6c, 0x0dfaddd4, 0x290d9632, 0xeecac1a7,
+        0xb006a9e0, 0xa7357ff6, 0x33f0c217, 0x7f4b1b9b
+    }
+};
+
+static const uint32_t sched_hi[16][68] = {
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000
+    },
+    {
+        0x10000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x10080800, 0x00000000, 0x00000000, 0x02000a00, 0x00000000, 0x00000000, 0x958a8b80, 0x00000000,
+        0x00000000, 0x14000600, 0x00000000, 0x00000000, 0x948a0b00, 0x04040008, 0x00000000, 0x06200aa0,
+        0x14000400, 0x00000000, 0x0f5aaeba, 0xc141c042, 0x00000000, 0x15400c60, 0x04000000, 0x00000000,
+        0x0f4aa6b2, 0x84444008, 0x02000402, 0x12620aaa, 0x15400440, 0x02800080, 0x357f216b, 0x29131d0f,
+        0x140a0a00, 0x155406c6, 0x10400000, 0x01000d00, 0xa476a96b, 0x8c404408, 0x362a0e42, 0xa504210b,
+        0x15540444, 0x10280008, 0x2887d22c, 0x33d0f192, 0x0140a0a0, 0x65124b07, 0x05040000, 0x001000d0,
+        0x3187c724, 0x08844440, 0x2162a4e6, 0xae12421a
+    },
+    {
+        0x20000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x20101000, 0x00000000, 0x00000000, 0x04001400, 0x00000000, 0x00000000, 0x2b151701, 0x00000000,
+        0x00000000, 0x28000c00, 0x00000000, 0x00000000, 0x29141601, 0x08080010, 0x00000000, 0x0c401540,
+        0x28000800, 0x00000000, 0x1eb55d74, 0x82838085, 0x00000000, 0x2a8018c0, 0x08000000, 0x00000000,
+        0x1e954d64, 0x08888011, 0x04000804, 0x24c41554, 0x2a800880, 0x05000100, 0x6afe42d6, 0x52263a1e,
+        0x28141400, 0x2aa80d8c, 0x20800000, 0x02001a00, 0x48ed52d7, 0x18808811, 0x6c541c84, 0x4a084217,
+        0x2aa80888, 0x20500010, 0x510fa458, 0x67a1e324, 0x02814140, 0xca24960e, 0x0a080000, 0x002001a0,
+        0x630f8e48, 0x11088880, 0x42c549cc, 0x5c248435
+    },
+    {
+        0x30000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x30181800, 0x00000000, 0x00000000, 0x06001e00, 0x00000000, 0x00000000, 0xbe9f9c81, 0x00000000,
+        0x00000000, 0x3c000a00, 0x00000000, 0x00000000, 0xbd9e1d01, 0x0c0c0018, 0x00000000, 0x0a601fe0,
+        0x3c000c00, 0x00000000, 0x11eff3ce, 0x43c240c7, 0x00000000, 0x3fc014a0, 0x0c000000, 0x00000000,
+        0x11dfebd6, 0x8cccc019, 0x06000c06, 0x36a61ffe, 0x3fc00cc0, 0x07800180, 0x5f8163bd, 0x7b352711,
+        0x3c1e1e00, 0x3ffc0b4a, 0x30c00000, 0x03001700, 0xec9bfbbc, 0x94c0cc19, 0x5a7e12c6, 0xef0c631c,
+        0x3ffc0ccc, 0x30780018, 0x79887674, 0x547112b6, 0x03c1e1e0, 0xaf36dd09, 0x0f0c0000, 0x00300170,
+        0x5288496c, 0x198cccc0, 0x63a7ed2a, 0xf236c62f
+    },
+    {
+        0x40000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x40202000, 0x00000000, 0x00000000, 0x08002800, 0x00000000, 0x00000000, 0x562a2e02, 0x00000000,
+        0x00000000, 0x50001800, 0x00000000, 0x00000000, 0x52282c02, 0x10100020, 0x00000000, 0x18802a80,
+        0x50001000, 0x00000000, 0x3d6abae8, 0x0507010b, 0x00000000, 0x55003180, 0x10000000, 0x00000000,
+        0x3d2a9ac8, 0x11110022, 0x08001008, 0x49882aa8, 0x55001100, 0x0a000200, 0xd5fc85ac, 0xa44c743c,
+        0x50282800, 0x55501b18, 0x41000000, 0x04003400, 0x91daa5ae, 0x31011022, 0xd8a83908, 0x9410842e,
+        0x55501110, 0x40a00020, 0xa21f48b0, 0xcf43c648, 0x05028280, 0x94492c1d, 0x14100000, 0x00400340,
+        0xc61f1c90, 0x22111100, 0x858a9398, 0xb849086a
+    },
+    {
+        0x50000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x50282800, 0x00000000, 0x00000000, 0x0a002200, 0x00000000, 0x00000000, 0xc3a0a582, 0x00000000,
+        0x00000000, 0x44001e00, 0x00000000, 0x00000000, 0xc6a22702, 0x14140028, 0x00000000, 0x1ea02020,
+        0x44001400, 0x00000000, 0x32301452, 0xc446c149, 0x00000000, 0x40403de0, 0x14000000, 0x00000000,
+        0x32603c7a, 0x9555402a, 0x0a00140a, 0x5bea2002, 0x40401540, 0x08800280, 0xe083a4c7, 0x8d5f6933,
+        0x44222200, 0x40041dde, 0x51400000, 0x05003900, 0x35ac0cc5, 0xbd41542a, 0xee82374a, 0x3114a525,
+        0x40041554, 0x50880028, 0x8a989a9c, 0xfc9337da, 0x04422220, 0xf15b671a, 0x11140000, 0x00500390,
+        0xf798dbb4, 0x2a955540, 0xa4e8377e, 0x165b4a70
+    },
+    {
+        0x60000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x60303000, 0x00000000, 0x00000000, 0x0c003c00, 0x00000000, 0x00000000, 0x7d3f3903, 0x00000000,
+        0x00000000, 0x78001400, 0x00000000, 0x00000000, 0x7b3c3a03, 0x18180030, 0x00000000, 0x14c03fc0,
+        0x78001800, 0x00000000, 0x23dfe79c, 0x8784818e, 0x00000000, 0x7f802940, 0x18000000, 0x00000000,
+        0x23bfd7ac, 0x19998033, 0x0c00180c, 0x6d4c3ffc, 0x7f801980, 0x0f000300, 0xbf02c77a, 0xf66a4e22,
+        0x783c3c00, 0x7ff81694, 0x61800000, 0x06002e00, 0xd937f779, 0x29819833, 0xb4fc258c, 0xde18c639,
+        0x7ff81998, 0x60f00030, 0xf310ece8, 0xa8e2256c, 0x0783c3c0, 0x5e6dba13, 0x1e180000, 0x006002e0,
+        0xa51092d8, 0x33199980, 0xc74fda54, 0xe46d8c5f
+    },
+    {
+        0x70000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x70383800, 0x00000000, 0x00000000, 0x0e003600, 0x00000000, 0x00000000, 0xe8b5b283, 0x00000000,
+        0x00000000, 0x6c001200, 0x00000000, 0x00000000, 0xefb63103, 0x1c1c0038, 0x00000000, 0x12e03560,
+        0x6c001c00, 0x00000000, 0x2c854926, 0x46c541cc, 0x00000000, 0x6ac02520, 0x1c000000, 0x00000000,
+        0x2cf5711e, 0x9dddc03b, 0x0e001c0e, 0x7f2e3556, 0x6ac01dc0, 0x0d800380, 0x8a7de611, 0xdf79532d,
+        0x6c363600, 0x6aac1052, 0x71c00000, 0x07002300, 0x7d415e12, 0xa5c1dc3b, 0x82d62bce, 0x7b1ce732,
+        0x6aac1ddc, 0x70d80038, 0xdb973ec4, 0x9b32d4fe, 0x06c36360, 0x3b7ff114, 0x1b1c0000, 0x00700230,
+        0x949755fc, 0x3b9dddc0, 0xe62d7eb2, 0x4a7fce45
+    },
+    {
+        0x80000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x80404000, 0x00000000, 0x00000000, 0x10005000, 0x00000000, 0x00000000, 0xac545c04, 0x00000000,
+        0x00000000, 0xa0003000, 0x00000000, 0x00000000, 0xa4505804, 0x20200040, 0x00000000, 0x31005500,
+        0xa0002000, 0x00000000, 0x7ad575d0, 0x0a0e0216, 0x00000000, 0xaa006300, 0x20000000, 0x00000000,
+        0x7a553590, 0x22220044, 0x10002010, 0x93105550, 0xaa002200, 0x14000400, 0xabf90b59, 0x4898e879,
+        0xa0505000, 0xaaa03630, 0x82000000, 0x08006800, 0x23b54b5d, 0x62022044, 0xb1507211, 0x2821085d,
+        0xaaa02220, 0x81400040, 0x443e9161, 0x9e878c91, 0x0a050500, 0x2892583b, 0x28200000, 0x00800680,
+        0x8c3e3921, 0x44222200, 0x0b152731, 0x709210d5
+    },
+    {
+        0x90000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x90484800, 0x00000000, 0x00000000, 0x12005a00, 0x00000000, 0x00000000, 0x39ded784, 0x00000000,
+        0x00000000, 0xb4003600, 0x00000000, 0x00000000, 0x30da5304, 0x24240048, 0x00000000, 0x37205fa0,
+        0xb4002400, 0x00000000, 0x758fdb6a, 0xcb4fc254, 0x00000000, 0xbf406f60, 0x24000000, 0x00000000,
+        0x751f9322, 0xa666404c, 0x12002412, 0x81725ffa, 0xbf402640, 0x16800480, 0x9e862a32, 0x618bf576,
+        0xb45a5a00, 0xbff430f6, 0x92400000, 0x09006500, 0x87c3e236, 0xee42644c, 0x877a7c53, 0x8d252956,
+        0xbff42664, 0x91680048, 0x6cb9434d, 0xad577d03, 0x0b45a5a0, 0x4d80133c, 0x2d240000, 0x00900650,
+        0xbdb9fe05, 0x4ca66640, 0x2a7783d7, 0xde8052cf
+    },
+    {
+        0xa0000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0xa0505000, 0x00000000, 0x00000000, 0x14004400, 0x00000000, 0x00000000, 0x87414b05, 0x00000000,
+        0x00000000, 0x88003c00, 0x00000000, 0x00000000, 0x8d444e05, 0x28280050, 0x00000000, 0x3d404040,
+        0x88002800, 0x00000000, 0x646028a4, 0x888d8293, 0x00000000, 0x80807bc0, 0x28000000, 0x00000000,
+        0x64c078f4, 0x2aaa8055, 0x14002814, 0xb7d44004, 0x80802a80, 0x11000500, 0xc107498f, 0x1abed267,
+        0x88444400, 0x80083bbc, 0xa2800000, 0x0a007200, 0x6b58198a, 0x7a82a855, 0xdd046e95, 0x62294a4a,
+        0x80082aa8, 0xa1100050, 0x15313539, 0xf9266fb5, 0x08844440, 0xe2b6ce35, 0x22280000, 0x00a00720,
+        0xef31b769, 0x552aaa80, 0x49d06efd, 0x2cb694e0
+    },
+    {
+        0xb0000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0xb0585800, 0x00000000, 0x00000000, 0x16004e00, 0x00000000, 0x00000000, 0x12cbc085, 0x00000000,
+        0x00000000, 0x9c003a00, 0x00000000, 0x00000000, 0x19ce4505, 0x2c2c0058, 0x00000000, 0x3b604ae0,
+        0x9c002c00, 0x00000000, 0x6b3a861e, 0x49cc42d1, 0x00000000, 0x95c077a0, 0x2c000000, 0x00000000,
+        0x6b8ade46, 0xaeeec05d, 0x16002c16, 0xa5b64aae, 0x95c02ec0, 0x13800580, 0xf47868e4, 0x33adcf68,
+        0x9c4e4e00, 0x955c3d7a, 0xb2c00000, 0x0b007f00, 0xcf2eb0e1, 0xf6c2ec5d, 0xeb2e60d7, 0xc72d6b41,
+        0x955c2eec, 0xb1380058, 0x3db6e715, 0xcaf69e27, 0x09c4e4e0, 0x87a48532, 0x272c0000, 0x00b007f0,
+        0xdeb6704d, 0x5daeeec0, 0x68b2ca1b, 0x82a4d6fa
+    },
+    {
+        0xc0000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0xc0606000, 0x00000000, 0x00000000, 0x18007800, 0x00000000, 0x00000000, 0xfa7e7206, 0x00000000,
+        0x00000000, 0xf0002800, 0x00000000, 0x00000000, 0xf6787406, 0x30300060, 0x00000000, 0x29807f80,
+        0xf0003000, 0x00000000, 0x47bfcf38, 0x0f09031d, 0x00000000, 0xff005280, 0x30000000, 0x00000000,
+        0x477faf58, 0x33330066, 0x18003018, 0xda987ff8, 0xff003300, 0x1e000600, 0x7e058ef5, 0xecd49c45,
+        0xf0787800, 0xfff02d28, 0xc3000000, 0x0c005c00, 0xb26feef3, 0x53033066, 0x69f84b19, 0xbc318c73,
+        0xfff03330, 0xc1e00060, 0xe621d9d1, 0x51c44ad9, 0x0f078780, 0xbcdb7426, 0x3c300000, 0x00c005c0,
+        0x4a2125b1, 0x66333300, 0x8e9fb4a9, 0xc8db18bf
+    },
+    {
+        0xd0000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0xd0686800, 0x00000000, 0x00000000, 0x1a007200, 0x00000000, 0x00000000, 0x6ff4f986, 0x00000000,
+        0x00000000, 0xe4002e00, 0x00000000, 0x00000000, 0x62f27f06, 0x34340068, 0x00000000, 0x2fa07520,
+        0xe4003400, 0x00000000, 0x48e56182, 0xce48c35f, 0x00000000, 0xea405ee0, 0x34000000, 0x00000000,
+        0x483509ea, 0xb777406e, 0x1a00341a, 0xc8fa7552, 0xea403740, 0x1c800680, 0x4b7aaf9e, 0xc5c7814a,
+        0xe4727200, 0xeaa42bee, 0xd3400000, 0x0d005100, 0x16194798, 0xdf43746e, 0x5fd2455b, 0x1935ad78,
+        0xeaa43774, 0xd1c80068, 0xcea60bfd, 0x6214bb4b, 0x0e472720, 0xd9c93f21, 0x39340000, 0x00d00510,
+        0x7ba6e295, 0x6eb77740, 0xaffd104f, 0x66c95aa5
+    },
+    {
+        0xe0000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0xe0707000, 0x00000000, 0x00000000, 0x1c006c00, 0x00000000, 0x00000000, 0xd16b6507, 0x00000000,
+        0x00000000, 0xd8002400, 0x00000000, 0x00000000, 0xdf6c6207, 0x38380070, 0x00000000, 0x25c06ac0,
+        0xd8003800, 0x00000000, 0x590a924c, 0x8d8a8398, 0x00000000, 0xd5804a40, 0x38000000, 0x00000000,
+        0x59eae23c, 0x3bbb8077, 0x1c00381c, 0xfe5c6aac, 0xd5803b80, 0x1b000700, 0x14fbcc23, 0xbef2a65b,
+        0xd86c6c00, 0xd55820a4, 0xe3800000, 0x0e004600, 0xfa82bc24, 0x4b83b877, 0x05ac579d, 0xf639ce64,
+        0xd5583bb8, 0xe1b00070, 0xb72e7d89, 0x3665a9fd, 0x0d86c6c0, 0x76ffe228, 0x36380000, 0x00e00460,
+        0x292eabf9, 0x773bbb80, 0xcc5afd65, 0x94ff9c8a
+    },
+    {
+        0xf0000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0xf0787800, 0x00000000, 0x00000000, 0x1e006600, 0x00000000, 0x00000000, 0x44e1ee87, 0x00000000,
+        0x00000000, 0xcc002200, 0x00000000, 0x00000000, 0x4be66907, 0x3c3c0078, 0x00000000, 0x23e06060,
+        0xcc003c00, 0x00000000, 0x56503cf6, 0x4ccb43da, 0x00000000, 0xc0c04620, 0x3c000000, 0x00000000,
+        0x56a0448e, 0xbfffc07f, 0x1e003c1e, 0xec3e6006, 0xc0c03fc0, 0x19800780, 0x2184ed48, 0x97e1bb54,
+        0xcc666600, 0xc00c2662, 0xf3c00000, 0x0f004b00, 0x5ef4154f, 0xc7c3fc7f, 0x338659df, 0x533def6f,
+        0xc00c3ffc, 0xf1980078, 0x9fa9afa5, 0x05b5586f, 0x0cc66660, 0x13eda92f, 0x333c0000, 0x00f004b0,
+        0x18a96cdd, 0x7fbfffc0, 0xed385983, 0x3aedde90
+    }
+};
+
+#define FF0(x, y, z) ((x) ^ (y) ^ (z))
+#define FF1(x, y, z) (((x) & (y)) | ((z) & ((x) | (y))))
+#define GG0(x, y, z) ((x) ^ (y) ^ (z))
+#define GG1(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
+
+// One round; the next round is R(D, A, B, C, H, E, F, G)
+#define R(A, B, C, D, E, F, G, H, FFX, GGX, j)                       \
+    do                                                               \
+    {                                                                \
+        uint32_t a12 = ROTL(A, 12);                                  \
+        uint32_t SS1 = ROTL(a12 + E + SM3_TJ[j], 7);                 \
+        uint32_t SS2 = SS1 ^ a12;                                    \
+        uint32_t TT1 = FFX(A, B, C) + D + SS2 + (W[j] ^ W[(j) + 4]); \
+        uint32_t TT2 = GGX(E, F, G) + H + SS1 + W[j];                \
+        B = ROTL(B, 9);                                              \
+        D = TT1;                                                     \
+        F = ROTL(F, 19);                                             \
+        H = P0(TT2);                                                 \
+    } while (0)
+
+#define R4(FFX, GGX, j)                                \
+    do                                                 \
+    {                                                  \
+        R(A, B, C, D, E, F, G, H, FFX, GGX, (j));     \
+        R(D, A, B, C, H, E, F, G, FFX, GGX, (j) + 1); \
+        R(C, D, A, B, G, H, E, F, FFX, GGX, (j) + 2); \
+        R(B, C, D, A, F, G, H, E, FFX, GGX, (j) + 3); \
+    } while (0)
+
+// Rounds over an already expanded schedule
+static void compress_scheduled(uint32_t *state, const uint32_t *W)
+{
+    uint32_t A = state[0], B = state[1], C = state[2], D = state[3];
+    uint32_t E = state[4], F = state[5], G = state[6], H = state[7];
+    int j;
+
+    for (j = 0; j < 16; j += 4)
+    {
+        R4(FF0, GG0, j);
+    }
+    for (; j < 64; j += 4)
+    {
+        R4(FF1, GG1, j);
+    }
+
+    state[0] ^= A;
+    state[1] ^= B;
+    state[2] ^= C;
+    state[3] ^= D;
+    state[4] ^= E;
+    state[5] ^= F;
+    state[6] ^= G;
+    state[7] ^= H;
+}
+
+static void hash65(uint8_t prefix, const uint8_t *a, const uint8_t *b, uint8_t *digest)
+{
+    uint8_t block[SM3_BLOCK_SIZE];
+    uint32_t W[68];
+    sm3_ctx_t ctx;
+    uint8_t last = b[31];
+
+    block[0] = prefix;
+    memcpy(block + 1, a, 32);
+    memcpy(block + 33, b, 31);
+    memcpy(ctx.state, SM3_IV, sizeof(SM3_IV));
+    sm3_process_blocks_simd(&ctx, block, 1);
+
+    const uint32_t *lo = sched_lo[last & 15], *hi = sched_hi[last >> 4];
+    for (int j = 0; j < 68; j++)
+    {
+        W[j] = lo[j] ^ hi[j];
+    }
+    compress_scheduled(ctx.state, W);
+
+    for (int i = 0; i < 8; i++)
+    {
+        store_be32(digest + 4 * i, ctx.state[i]);
+    }
+}
+
+void sm3_hash_node65(const uint8_t *left, const uint8_t *right, uint8_t *digest)
+{
+    hash65(0x01, left, right, digest);
+}
+
+void sm3_hash_leaf64(const uint8_t *data, uint8_t *digest)
+{
+    hash65(0x00, data, data + 32, digest);
+}
+
+// prefix || 64 bytes for n consecutive 64-byte records, in the lanes.
+// Each batch is copied out before its digests are written, so out may
+// overlap in (a tree level hashed in place).
+static void hash65_many(uint8_t prefix, const uint8_t *in, size_t n, uint8_t *out)
+{
+    uint8_t msgs_data[FIXED_BATCH][FIXED_LEN];
+    const uint8_t *msgs[FIXED_BATCH];
+    size_t lens[FIXED_BATCH];
+    sm3_engine wide, narrow;
+
+    sm3_engines(&wide, &narrow);
+
+    // Without SIMD lanes the table-driven kernel is the fastest path
+    if (wide.lanes == 1)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            hash65(prefix, in + i * 64, in + i * 64 + 32, out + i * SM3_DIGEST_SIZE);
+        }
+        return;
+    }
+
+    for (size_t base = 0; base < n; base += FIXED_BATCH)
+    {
+        size_t count = n - base < FIXED_BATCH ? n - base : FIXED_BATCH;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            msgs_data[i][0] = prefix;
+            memcpy(msgs_data[i] + 1, in + (base + i) * 64, 64);
+            msgs[i] = msgs_data[i];
+            lens[i] = FIXED_LEN;
+        }
+        sm3_hash_many(msgs, lens, count, out + base * SM3_DIGEST_SIZE);
+    }
+}
+
+void sm3_hash_nodes65(const uint8_t *children, size_t n, uint8_t *parents)
+{
+    hash65_many(0x01, children, n, parents);
+}
+
+void sm3_hash_leaves64(const uint8_t *data, size_t n, uint8_t *digests)
+{
+    hash65_many(0x00, data, n, digests);
+}
@@ -0,0 +1,69 @@
+#include "sm3_internal.h"
+#include <string.h>
+
+// GB/T 32918 KDF: out = SM3(Z || 1) || SM3(Z || 2) || ..., truncated to
+// outlen. The whole blocks of Z are compressed once into a midstate; every
+// counter then only hashes the rest of Z plus its 4-byte counter, and those
+// tails go through the multi-buffer lanes together.
+
+#define KDF_BATCH 64                       // Counter blocks per pass
+#define KDF_TAIL_MAX (SM3_BLOCK_SIZE + 4)  // Partial block of Z + counter
+
+int sm3_kdf(const uint8_t *z, size_t zlen, uint8_t *out, size_t outlen)
+{
+    sm3_ctx_t prefix;
+    const sm3_ctx_t *starts[KDF_BATCH];
+    const uint8_t *tails[KDF_BATCH];
+    size_t tail_lens[KDF_BATCH];
+    uint8_t tail_data[KDF_BATCH][KDF_TAIL_MAX];
+    uint8_t digests[KDF_BATCH * SM3_DIGEST_SIZE];
+    size_t whole = zlen - zlen % SM3_BLOCK_SIZE;
+    size_t rem = zlen - whole;
+    uint64_t blocks = ((uint64_t)outlen + SM3_DIGEST_SIZE - 1) / SM3_DIGEST_SIZE;
+    uint32_t ct = 1;
+
+    // The counter is 32 bits and must not wrap
+    if (blocks > 0xFFFFFFFFu)
+    {
+        return -1;
+    }
+
+    sm3_init_optimized(&prefix);
+    sm3_update_optimized(&prefix, z, whole);
+    for (size_t i = 0; i < KDF_BATCH; i++)
+    {
+        starts[i] = &prefix;
+        tails[i] = tail_data[i];
+        tail_lens[i] = rem + 4;
+        memcpy(tail_data[i], z + whole, rem);
+    }
+
+    while (outlen > 0)
+    {
+        size_t want = (outlen + SM3_DIGEST_SIZE - 1) / SM3_DIGEST_SIZE;
+        size_t count = want < KDF_BATCH ? want : KDF_BATCH;
+        size_t produced = count * SM3_DIGEST_SIZE;
+
+        for (size_t i = 0; i < count; i++, ct++)
+        {
+            tail_data[i][rem] = (uint8_t)(ct >> 24);
+            tail_data[i][rem + 1] = (uint8_t)(ct >> 16);
+            tail_data[i][rem + 2] = (uint8_t)(ct >> 8);
+            tail_data[i][rem + 3] = (uint8_t)ct;
+        }
+        sm3_hash_many_from(starts, tails, tail_lens, count, digests);
+
+        if (produced > outlen)
+        {
+            produced = outlen;
+        }
+        memcpy(out, digests, produced);
+        out += produced;
+        outlen -= produced;
+    }
+
+    wipe(digests, sizeof(digests));
+    wipe(tail_data, sizeof(tail_data));
+    wipe(&prefix, sizeof(prefix));
+    return 0;
+}
@@ -0,0 +1,472 @@
+#include "sm3_internal.h"
+#include <string.h>
+#include <immintrin.h>
+
+// Multi-buffer SM3: the states of 16 (AVX-512) or 8 (AVX2) messages are kept
+// transposed - word i of every lane in one vector - and each pass compresses
+// one block of every lane. A lane that finishes its message is refilled from
+// the queue right away, so messages of different lengths share the passes.
+// When the queue is empty and only a few lanes are left, they are finished
+// with the scalar compression instead of running mostly-empty vectors.
+// A lane can start from a cached midstate (HMAC or KDF prefix) instead of
+// the IV; the prefix length then counts towards the padded bit length.
+
+#define MB_MAX_LANES 16
+
+// Message words of one block per lane, transposed: wt[j * lanes + l]
+static inline void load_words(uint32_t *wt, const uint8_t *const blocks[], size_t lanes)
+{
+    for (size_t l = 0; l < lanes; l++)
+    {
+        for (int j = 0; j < 16; j++)
+        {
+            wt[j * lanes + l] = load_be32(blocks[l] + 4 * j);
+        }
+    }
+}
+
+#if defined(__AVX512F__)
+
+#define ROL16(x, n) _mm512_rol_epi32((x), (n))
+#define XOR3_16(a, b, c) _mm512_ternarylogic_epi32((a), (b), (c), 0x96)
+#define MAJ16(a, b, c) _mm512_ternarylogic_epi32((a), (b), (c), 0xE8)
+#define CH16(a, b, c) _mm512_ternarylogic_epi32((a), (b), (c), 0xCA)
+
+static void compress_x16(uint32_t *state, const uint8_t *const blocks[])
+{
+    uint32_t wt[16 * 16];
+    __m512i W[68];
+    __m512i A, B, C, D, E, F, G, H;
+    int j;
+
+    load_words(wt, blocks, 16);
+    for (j = 0; j < 16; j++)
+    {
+        W[j] = _mm512_loadu_si512((const void *)(wt + 16 * j));
+    }
+    for (j = 16; j < 68; j++)
+    {
+        __m512i t = XOR3_16(W[j - 16], W[j - 9], ROL16(W[j - 3], 15));
+        t = XOR3_16(t, ROL16(t, 15), ROL16(t, 23)); // P1
+        W[j] = XOR3_16(t, ROL16(W[j - 13], 7), W[j - 6]);
+    }
+
+    A = _mm512_loadu_si512((const void *)(state + 0 * 16));
+    B = _mm512_loadu_si512((const void *)(state + 1 * 16));
+    C = _mm512_loadu_si512((const void *)(state + 2 * 16));
+    D = _mm512_loadu_si512((const void *)(state + 3 * 16));
+    E = _mm512_loadu_si512((const void *)(state + 4 * 16));
+    F = _mm512_loadu_si512((const void *)(state + 5 * 16));
+    G = _mm512_loadu_si512((const void *)(state + 6 * 16));
+    H = _mm512_loadu_si512((const void *)(state + 7 * 16));
+    const __m512i A0 = A, B0 = B, C0 = C, D0 = D, E0 = E, F0 = F, G0 = G, H0 = H;
+
+    for (j = 0; j < 64; j++)
+    {
+        __m512i a12 = ROL16(A, 12);
+        __m512i SS1 = ROL16(_mm512_add_epi32(_mm512_add_epi32(a12, E), _mm512_set1_epi32((int)SM3_TJ[j])), 7);
+        __m512i SS2 = _mm512_xor_si512(SS1, a12);
+        __m512i ff = j < 16 ? XOR3_16(A, B, C) : MAJ16(A, B, C);
+        __m512i gg = j < 16 ? XOR3_16(E, F, G) : CH16(E, F, G);
+        __m512i TT1 = _mm512_add_epi32(_mm512_add_epi32(ff, D),
+                                       _mm512_add_epi32(SS2, _mm512_xor_si512(W[j], W[j + 4])));
+        __m512i TT2 = _mm512_add_epi32(_mm512_add_epi32(gg, H), _mm512_add_epi32(SS1, W[j]));
+        D = C;
+        C = ROL16(B, 9);
+        B = A;
+        A = TT1;
+        H = G;
+        G = ROL16(F, 19);
+        F = E;
+        E = XOR3_16(TT2, ROL16(TT2, 9), ROL16(TT2, 17)); // P0
+    }
+
+    _mm512_storeu_si512((void *)(state + 0 * 16), _mm512_xor_si512(A, A0));
+    _mm512_storeu_si512((void *)(state + 1 * 16), _mm512_xor_si512(B, B0));
+    _mm512_storeu_si512((void *)(state + 2 * 16), _mm512_xor_si512(C, C0));
+    _mm512_storeu_si512((void *)(state + 3 * 16), _mm512_xor_si512(D, D0));
+    _mm512_storeu_si512((void *)(state + 4 * 16), _mm512_xor_si512(E, E0));
+    _mm512_storeu_si512((void *)(state + 5 * 16), _mm512_xor_si512(F, F0));
+    _mm512_storeu_si512((void *)(state + 6 * 16), _mm512_xor_si512(G, G0));
+    _mm512_storeu_si512((void *)(state + 7 * 16), _mm512_xor_si512(H, H0));
+}
+
+#endif // __AVX512F__
+
+#if defined(__AVX2__)
+
+#define ROL8(x, n) _mm256_or_si256(_mm256_slli_epi32((x), (n)), _mm256_srli_epi32((x), 32 - (n)))
+#define XOR3_8(a, b, c) _mm256_xor_si256(_mm256_xor_si256((a), (b)), (c))
+#define MAJ8(a, b, c) _mm256_or_si256(_mm256_and_si256((a), (b)), _mm256_and_si256(_mm256_or_si256((a), (b)), (c)))
+#define CH8(a, b, c) _mm256_or_si256(_mm256_and_si256((a), (b)), _mm256_andnot_si256((a), (c)))
+
+static void compress_x8(uint32_t *state, const uint8_t *const blocks[])
+{
+    uint32_t wt[16 * 8];
+    __m256i W[68];
+    __m256i A, B, C, D, E, F, G, H;
+    int j;
+
+    load_words(wt, blocks, 8);
+    for (j = 0; j < 16; j++)
+    {
+        W[j] = _mm256_loadu_si256((const __m256i *)(wt + 8 * j));
+    }
+    for (j = 16; j < 68; j++)
+    {
+        __m256i t = XOR3_8(W[j - 16], W[j - 9], ROL8(W[j - 3], 15));
+        t = XOR3_8(t, ROL8(t, 15), ROL8(t, 23)); // P1
+        W[j] = XOR3_8(t, ROL8(W[j - 13], 7), W[j - 6]);
+    }
+
+    A = _mm256_loadu_si256((const __m256i *)(state + 0 * 8));
+    B = _mm256_loadu_si256((const __m256i *)(state + 1 * 8));
+    C = _mm256_loadu_si256((const __m256i *)(state + 2 * 8));
+    D = _mm256_loadu_si256((const __m256i *)(state + 3 * 8));
+    E = _mm256_loadu_si256((const __m256i *)(state + 4 * 8));
+    F = _mm256_loadu_si256((const __m256i *)(state + 5 * 8));
+    G = _mm256_loadu_si256((const __m256i *)(state + 6 * 8));
+    H = _mm256_loadu_si256((const __m256i *)(state + 7 * 8));
+    const __m256i A0 = A, B0 = B, C0 = C, D0 = D, E0 = E, F0 = F, G0 = G, H0 = H;
+
+    for (j = 0; j < 64; j++)
+    {
+        __m256i a12 = ROL8(A, 12);
+        __m256i SS1 = _mm256_add_epi32(_mm256_add_epi32(a12, E), _mm256_set1_epi32((int)SM3_TJ[j]));
+        SS1 = ROL8(SS1, 7);
+        __m256i SS2 = _mm256_xor_si256(SS1, a12);
+        __m256i ff = j < 16 ? XOR3_8(A, B, C) : MAJ8(A, B, C);
+        __m256i gg = j < 16 ? XOR3_8(E, F, G) : CH8(E, F, G);
+        __m256i TT1 = _mm256_add_epi32(_mm256_add_epi32(ff, D),
+                                       _mm256_add_epi32(SS2, _mm256_xor_si256(W[j], W[j + 4])));
+        __m256i TT2 = _mm256_add_epi32(_mm256_add_epi32(gg, H), _mm256_add_epi32(SS1, W[j]));
+        D = C;
+        C = ROL8(B, 9);
+        B = A;
+        A = TT1;
+        H = G;
+        G = ROL8(F, 19);
+        F = E;
+        E = XOR3_8(TT2, ROL8(TT2, 9), ROL8(TT2, 17)); // P0
+    }
+
+    _mm256_storeu_si256((__m256i *)(state + 0 * 8), _mm256_xor_si256(A, A0));
+    _mm256_storeu_si256((__m256i *)(state + 1 * 8), _mm256_xor_si256(B, B0));
+    _mm256_storeu_si256((__m256i *)(state + 2 * 8), _mm256_xor_si256(C, C0));
+    _mm256_storeu_si256((__m256i *)(state + 3 * 8), _mm256_xor_si256(D, D0));
+    _mm256_storeu_si256((__m256i *)(state + 4 * 8), _mm256_xor_si256(E, E0));
+    _mm256_storeu_si256((__m256i *)(state + 5 * 8), _mm256_xor_si256(F, F0));
+    _mm256_storeu_si256((__m256i *)(state + 6 * 8), _mm256_xor_si256(G, G0));
+    _mm256_storeu_si256((__m256i *)(state + 7 * 8), _mm256_xor_si256(H, H0));
+}
+
+#endif // __AVX2__
+
+// --- Lane scheduler --------------------------------------------------------
+
+// Only the vector backends drive lanes; the scalar one hashes messages whole
+#if defined(__AVX2__) || defined(__AVX512F__)
+
+typedef struct
+{
+    const uint8_t *msg;
+    size_t len;
+    uint64_t prefix;    // Bytes already absorbed into the starting state
+    size_t pos;         // Next unread message byte
+    size_t index;       // Message number, for the digest slot
+    int active;
+    int tail_blocks;    // Padded tail blocks (0 until the tail is built, then 1 or 2)
+    int tail_next;      // Next tail block to hand out
+    uint8_t tail[2 * SM3_BLOCK_SIZE];
+} mb_lane;
+
+// starts == NULL (or starts[index] == NULL) means the IV
+static void lane_start(mb_lane *ln, uint32_t *state, size_t lanes, size_t l,
+                       const sm3_ctx_t *const starts[], const uint8_t *msg, size_t len, size_t index)
+{
+    const sm3_ctx_t *start = starts ? starts[index] : NULL;
+    const uint32_t *st = start ? start->state : SM3_IV;
+
+    for (int i = 0; i < 8; i++)
+    {
+        state[i * lanes + l] = st[i];
+    }
+    ln->msg = msg;
+    ln->len = len;
+    ln->prefix = start ? start->count : 0;
+    ln->pos = 0;
+    ln->index = index;
+    ln->active = 1;
+    ln->tail_blocks = 0;
+    ln->tail_next = 0;
+}
+
+// Next block of the padded message; *last is set on the final one
+static const uint8_t *lane_next_block(mb_lane *ln, int *last)
+{
+    *last = 0;
+    if (ln->tail_blocks == 0)
+    {
+        if (ln->len - ln->pos >= SM3_BLOCK_SIZE)
+        {
+            const uint8_t *b = ln->msg + ln->pos;
+            ln->pos += SM3_BLOCK_SIZE;
+            return b;
+        }
+
+        // Remaining bytes || 0x80 || zeros || 64-bit big-endian bit length
+        size_t rem = ln->len - ln->pos;
+        uint64_t bits = (ln->prefix + ln->len) * 8;
+
+        ln->tail_blocks = rem < 56 ? 1 : 2;
+        memset(ln->tail, 0, sizeof(ln->tail));
+        if (rem)
+        {
+            memcpy(ln->tail, ln->msg + ln->pos, rem);
+        }
+        ln->tail[rem] = 0x80;
+        for (int i = 0; i < 8; i++)
+        {
+            ln->tail[ln->tail_blocks * SM3_BLOCK_SIZE - 1 - i] = (uint8_t)(bits >> (8 * i));
+        }
+        ln->pos = ln->len;
+    }
+
+    *last = ln->tail_next == ln->tail_blocks - 1;
+    return ln->tail + SM3_BLOCK_SIZE * ln->tail_next++;
+}
+
+static void write_digest(uint8_t *digest, const uint32_t st[8])
+{
+    for (int i = 0; i < 8; i++)
+    {
+        store_be32(digest + 4 * i, st[i]);
+    }
+}
+
+// The rest of one lane's message on the scalar compression
+static void lane_finish_scalar(mb_lane *ln, const uint32_t st[8], uint8_t *digests)
+{
+    sm3_ctx_t ctx;
+    int last = 0;
+
+    memcpy(ctx.state, st, sizeof(ctx.state));
+    while (!last)
+    {
+        sm3_process_block_optimized(&ctx, lane_next_block(ln, &last));
+    }
+    write_digest(digests + ln->index * SM3_DIGEST_SIZE, ctx.state);
+    ln->active = 0;
+}
+
+static void hash_many_lanes(size_t lanes, sm3_compress_func compress, const sm3_ctx_t *const starts[],
+                            const uint8_t *const msgs[], const size_t lens[], size_t n, uint8_t *digests)
+{
+    static const uint8_t idle_block[SM3_BLOCK_SIZE];
+    mb_lane ln[MB_MAX_LANES];
+    uint32_t state[8 * MB_MAX_LANES];
+    const uint8_t *blocks[MB_MAX_LANES];
+    int last[MB_MAX_LANES];
+    size_t next = 0, active = 0;
+
+    for (size_t l = 0; l < lanes; l++)
+    {
+        ln[l].active = 0;
+        for (int i = 0; i < 8; i++)
+        {
+            state[i * lanes + l] = SM3_IV[i];
+        }
+        if (next < n)
+        {
+            lane_start(&ln[l], state, lanes, l, starts, msgs[next], lens[next], next);
+            next++;
+            active++;
+        }
+    }
+
+    while (active > 0)
+    {
+        // Few lanes left and nothing queued: vectors would run mostly empty
+        if (next == n && active * 4 <= lanes)
+        {
+            for (size_t l = 0; l < lanes; l++)
+            {
+                if (ln[l].active)
+                {
+                    uint32_t st[8];
+                    for (int i = 0; i < 8; i++)
+                    {
+                        st[i] = state[i * lanes + l];
+                    }
+                    lane_finish_scalar(&ln[l], st, digests);
+                }
+            }
+            break;
+        }
+
+        for (size_t l = 0; l < lanes; l++)
+        {
+            blocks[l] = ln[l].active ? lane_next_block(&ln[l], &last[l]) : idle_block;
+        }
+
+        compress(state, blocks);
+
+        for (size_t l = 0; l < lanes; l++)
+        {
+            if (!ln[l].active || !last[l])
+            {
+                continue;
+            }
+
+            uint32_t st[8];
+            for (int i = 0; i < 8; i++)
+            {
+                st[i] = state[i * lanes + l];
+                state[i * lanes + l] = SM3_IV[i];
+            }
+            write_digest(digests + ln[l].index * SM3_DIGEST_SIZE, st);
+            ln[l].active = 0;
+            active--;
+
+            if (next < n)
+            {
+                lane_start(&ln[l], state, lanes, l, starts, msgs[next], lens[next], next);
+                next++;
+                active++;
+            }
+        }
+    }
+}
+
+#endif // __AVX2__ || __AVX512F__
+
+// --- Backends --------------------------------------------------------------
+
+static void hash_from_scalar(const sm3_ctx_t *start, const uint8_t *msg, size_t len, uint8_t *digest)
+{
+    sm3_ctx_t ctx;
+
+    if (!start)
+    {
+        sm3_hash_optimized(msg, len, digest);
+        return;
+    }
+    ctx = *start;
+    sm3_update_optimized(&ctx, msg, len);
+    sm3_final_optimized(&ctx, digest);
+}
+
+static void hash_many_scalar(const uint8_t *const msgs[], const size_t lens[], size_t n, uint8_t *digests)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        sm3_hash_optimized(msgs[i], lens[i], digests + i * SM3_DIGEST_SIZE);
+    }
+}
+
+// One lane: the state rows are just the 8 words
+static void compress_x1(uint32_t *state, const uint8_t *const blocks[])
+{
+    sm3_ctx_t ctx;
+
+    memcpy(ctx.state, state, sizeof(ctx.state));
+    sm3_process_blocks_simd(&ctx, blocks[0], 1);
+    memcpy(state, ctx.state, sizeof(ctx.state));
+}
+
+#if defined(__AVX512F__)
+static void hash_many_avx512(const uint8_t *const msgs[], const size_t lens[], size_t n, uint8_t *digests)
+{
+    hash_many_lanes(16, compress_x16, NULL, msgs, lens, n, digests);
+}
+#endif
+
+#if defined(__AVX2__)
+static void hash_many_avx2(const uint8_t *const msgs[], const size_t lens[], size_t n, uint8_t *digests)
+{
+    hash_many_lanes(8, compress_x8, NULL, msgs, lens, n, digests);
+}
+#endif
+
+size_t sm3_hash_many_backends(sm3_many_backend *out, size_t max)
+{
+    sm3_many_backend all[3];
+    size_t count = 0, i;
+
+#if defined(__AVX512F__)
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        all[count++] = (sm3_many_backend){"AVX-512 (16 lanes)", 16, hash_many_avx512, compress_x16};
+    }
+#endif
+#if defined(__AVX2__)
+    if (__builtin_cpu_supports("avx2"))
+    {
+        all[count++] = (sm3_many_backend){"AVX2 (8 lanes)", 8, hash_many_avx2, compress_x8};
+    }
+#endif
+    all[count++] = (sm3_many_backend){"scalar (1 lane)", 1, hash_many_scalar, compress_x1};
+
+    for (i = 0; i < count && i < max; i++)
+    {
+        out[i] = all[i];
+    }
+    return count;
+}
+
+// Looked up once (CPUID can trap under a hypervisor); lanes is published last
+void sm3_engines(sm3_engine *wide, sm3_engine *narrow)
+{
+    static sm3_compress_func wide_compress, narrow_compress;
+    static size_t wide_lanes;
+    size_t lanes = __atomic_load_n(&wide_lanes, __ATOMIC_ACQUIRE);
+
+    if (!lanes)
+    {
+        sm3_many_backend all[3];
+        size_t count = sm3_hash_many_backends(all, 3);
+        count = count < 3 ? count : 3;
+
+        __atomic_store_n(&wide_compress, all[0].compress, __ATOMIC_RELAXED);
+        __atomic_store_n(&narrow_compress, all[count - 1].compress, __ATOMIC_RELAXED);
+        lanes = all[0].lanes;
+        __atomic_store_n(&wide_lanes, lanes, __ATOMIC_RELEASE);
+    }
+    wide->lanes = lanes;
+    wide->compress = __atomic_load_n(&wide_compress, __ATOMIC_RELAXED);
+    narrow->lanes = 1;
+    narrow->compress = __atomic_load_n(&narrow_compress, __ATOMIC_RELAXED);
+}
+
+void sm3_hash_many_from(const sm3_ctx_t *const starts[], const uint8_t *const msgs[], const size_t lens[],
+                        size_t n, uint8_t *digests)
+{
+    sm3_engine wide, narrow;
+    sm3_engines(&wide, &narrow);
+    size_t lanes = wide.lanes;
+
+    // A single message gains nothing from the lanes
+    if (n == 1 || lanes == 1)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            hash_from_scalar(starts ? starts[i] : NULL, msgs[i], lens[i], digests + i * SM3_DIGEST_SIZE);
+        }
+        return;
+    }
+#if defined(__AVX512F__)
+    if (lanes == 16)
+    {
+        hash_many_lanes(16, compress_x16, starts, msgs, lens, n, digests);
+        return;
+    }
+#endif
+#if defined(__AVX2__)
+    hash_many_lanes(8, compress_x8, starts, msgs, lens, n, digests);
+#endif
+}
+
+void sm3_hash_many(const uint8_t *const msgs[], const size_t lens[], size_t n, uint8_t *digests)
+{
+    sm3_hash_many_from(NULL, msgs, lens, n, digests);
+}
@@ -23,7 +23,7 @@ static const uint32_t SM3_IV[8] = {
         E = P0(TT2);                                                 \
     } while (0)
 
-static void sm3_process_block_optimized(sm3_ctx_t *ctx, const uint8_t *block)
+void sm3_process_block_optimized(sm3_ctx_t *ctx, const uint8_t *block)
 {
     uint32_t W[68], W1[64];
     uint32_t A, B, C, D, E, F, G, H;
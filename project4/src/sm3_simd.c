@@ -0,0 +1,199 @@
+#include "sm3_internal.h"
+#include <string.h>
+#include <immintrin.h>
+
+// Single-stream SM3 with a vectorized message schedule.
+// W[16..67] is expanded four words per SSE step: lanes 0-2 only need words
+// that already exist, and the W[j] term lane 3 is missing is added after the
+// fact (P1 is linear over XOR). Each step runs four rounds ahead of the
+// rounds that consume it, so the vector expansion overlaps the scalar round
+// chain instead of running as a separate pass. Rounds 0-15 and 16-63 are
+// separate loops with T_j <<< j precomputed, so no round tests j.
+
+#if defined(__AVX512VL__)
+#define VROL(x, n) _mm_rol_epi32((x), (n))
+#else
+#define VROL(x, n) _mm_or_si128(_mm_slli_epi32((x), (n)), _mm_srli_epi32((x), 32 - (n)))
+#endif
+
+static inline __m128i vp1(__m128i x)
+{
+    return _mm_xor_si128(x, _mm_xor_si128(VROL(x, 15), VROL(x, 23)));
+}
+
+// W[j..j+3] from W[j-16..j-1], j a multiple of 4
+static inline void expand4(uint32_t *W, int j)
+{
+    __m128i a = _mm_loadu_si128((const __m128i *)(W + j - 16));
+    __m128i b = _mm_loadu_si128((const __m128i *)(W + j - 9));
+    __m128i c = _mm_srli_si128(_mm_loadu_si128((const __m128i *)(W + j - 4)), 4); // W[j-3..j-1], 0
+    __m128i d = _mm_loadu_si128((const __m128i *)(W + j - 13));
+    __m128i e = _mm_loadu_si128((const __m128i *)(W + j - 6));
+    __m128i x = vp1(_mm_xor_si128(_mm_xor_si128(a, b), VROL(c, 15)));
+    __m128i w = _mm_xor_si128(_mm_xor_si128(x, VROL(d, 7)), e);
+
+    // Lane 3 still lacks P1(W[j] <<< 15)
+    __m128i fix = _mm_slli_si128(w, 12);
+    w = _mm_xor_si128(w, vp1(VROL(fix, 15)));
+    _mm_storeu_si128((__m128i *)(W + j), w);
+}
+
+// One round; the caller rotates the variable roles instead of moving them:
+// the next round is R(D, A, B, C, H, E, F, G)
+#define R(A, B, C, D, E, F, G, H, FFX, GGX, j)                       \
+    do                                                               \
+    {                                                                \
+        uint32_t a12 = ROTL(A, 12);                                  \
+        uint32_t SS1 = ROTL(a12 + E + SM3_TJ[j], 7);                 \
+        uint32_t SS2 = SS1 ^ a12;                                    \
+        uint32_t TT1 = FFX(A, B, C) + D + SS2 + (W[j] ^ W[(j) + 4]); \
+        uint32_t TT2 = GGX(E, F, G) + H + SS1 + W[j];                \
+        B = ROTL(B, 9);                                              \
+        D = TT1;                                                     \
+        F = ROTL(F, 19);                                             \
+        H = P0(TT2);                                                 \
+    } while (0)
+
+#define FF0(x, y, z) ((x) ^ (y) ^ (z))
+#define FF1(x, y, z) (((x) & (y)) | ((z) & ((x) | (y))))
+#define GG0(x, y, z) ((x) ^ (y) ^ (z))
+#define GG1(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
+
+#define R4(FFX, GGX, j)                                \
+    do                                                 \
+    {                                                  \
+        R(A, B, C, D, E, F, G, H, FFX, GGX, (j));     \
+        R(D, A, B, C, H, E, F, G, FFX, GGX, (j) + 1); \
+        R(C, D, A, B, G, H, E, F, FFX, GGX, (j) + 2); \
+        R(B, C, D, A, F, G, H, E, FFX, GGX, (j) + 3); \
+    } while (0)
+
+void sm3_process_blocks_simd(sm3_ctx_t *ctx, const uint8_t *data, size_t nblocks)
+{
+    uint32_t W[68];
+    uint32_t A, B, C, D, E, F, G, H;
+    int j;
+
+    while (nblocks--)
+    {
+        for (j = 0; j < 16; j++)
+        {
+            W[j] = ((uint32_t)data[4 * j] << 24) | ((uint32_t)data[4 * j + 1] << 16) |
+                   ((uint32_t)data[4 * j + 2] << 8) | data[4 * j + 3];
+        }
+        expand4(W, 16);
+
+        A = ctx->state[0];
+        B = ctx->state[1];
+        C = ctx->state[2];
+        D = ctx->state[3];
+        E = ctx->state[4];
+        F = ctx->state[5];
+        G = ctx->state[6];
+        H = ctx->state[7];
+
+        // Rounds j..j+3 use W[j..j+7]; the words for the next group are
+        // expanded while these rounds run
+        for (j = 0; j < 16; j += 4)
+        {
+            expand4(W, j + 20);
+            R4(FF0, GG0, j);
+        }
+        for (; j < 64; j += 4)
+        {
+            if (j + 20 <= 64)
+            {
+                expand4(W, j + 20);
+            }
+            R4(FF1, GG1, j);
+        }
+
+        ctx->state[0] ^= A;
+        ctx->state[1] ^= B;
+        ctx->state[2] ^= C;
+        ctx->state[3] ^= D;
+        ctx->state[4] ^= E;
+        ctx->state[5] ^= F;
+        ctx->state[6] ^= G;
+        ctx->state[7] ^= H;
+        data += SM3_BLOCK_SIZE;
+    }
+}
+
+void sm3_init_simd(sm3_ctx_t *ctx)
+{
+    memcpy(ctx->state, SM3_IV, sizeof(SM3_IV));
+    ctx->count = 0;
+    memset(ctx->buffer, 0, SM3_BLOCK_SIZE);
+}
+
+void sm3_update_simd(sm3_ctx_t *ctx, const uint8_t *data, size_t len)
+{
+    size_t buffer_pos = ctx->count % SM3_BLOCK_SIZE;
+
+    ctx->count += len;
+
+    if (buffer_pos > 0)
+    {
+        size_t take = SM3_BLOCK_SIZE - buffer_pos;
+        if (take > len)
+        {
+            take = len;
+        }
+        memcpy(ctx->buffer + buffer_pos, data, take);
+        data += take;
+        len -= take;
+        if (buffer_pos + take < SM3_BLOCK_SIZE)
+        {
+            return;
+        }
+        sm3_process_blocks_simd(ctx, ctx->buffer, 1);
+    }
+
+    if (len >= SM3_BLOCK_SIZE)
+    {
+        size_t nblocks = len / SM3_BLOCK_SIZE;
+        sm3_process_blocks_simd(ctx, data, nblocks);
+        data += nblocks * SM3_BLOCK_SIZE;
+        len -= nblocks * SM3_BLOCK_SIZE;
+    }
+
+    if (len > 0)
+    {
+        memcpy(ctx->buffer, data, len);
+    }
+}
+
+void sm3_final_simd(sm3_ctx_t *ctx, uint8_t *digest)
+{
+    size_t buffer_pos = ctx->count % SM3_BLOCK_SIZE;
+    uint64_t bit_count = ctx->count * 8;
+    size_t nblocks = buffer_pos < 56 ? 1 : 2;
+    uint8_t tail[SM3_BLOCK_SIZE * 2];
+
+    memset(tail, 0, sizeof(tail));
+    memcpy(tail, ctx->buffer, buffer_pos);
+    tail[buffer_pos] = 0x80;
+    for (int i = 0; i < 8; i++)
+    {
+        tail[nblocks * SM3_BLOCK_SIZE - 1 - i] = (uint8_t)(bit_count >> (8 * i));
+    }
+    sm3_process_blocks_simd(ctx, tail, nblocks);
+
+    for (int i = 0; i < 8; i++)
+    {
+        uint32_t state = ctx->state[i];
+        digest[i * 4] = (uint8_t)(state >> 24);
+        digest[i * 4 + 1] = (uint8_t)(state >> 16);
+        digest[i * 4 + 2] = (uint8_t)(state >> 8);
+        digest[i * 4 + 3] = (uint8_t)(state);
+    }
+}
+
+void sm3_hash_simd(const uint8_t *data, size_t len, uint8_t *digest)
+{
+    sm3_ctx_t ctx;
+    sm3_init_simd(&ctx);
+    sm3_update_simd(&ctx, data, len);
+    sm3_final_simd(&ctx, digest);
+}
@@ -0,0 +1,296 @@
+#define _POSIX_C_SOURCE 200809L
+#include "sm3_tree.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Leaves are hashed in passes of batch_chunks chunks: each thread takes a
+// contiguous run of chunks and feeds them through the multi-buffer lanes
+// from the cached 0x00-block midstate. The leaf digests are then merged in
+// order on a stack of completed subtrees, so memory stays bounded however
+// long the input is. Parents are about one per 1024 leaf blocks and are
+// computed on the calling thread.
+
+#define CHUNKS_PER_THREAD 32 // 2 MiB of input per thread and pass
+#define LANE_GROUP 16        // Chunks per sm3_hash_many_from() call
+
+typedef struct
+{
+    const sm3_ctx_t *start;
+    const uint8_t *data;
+    size_t len;
+    uint8_t *digests;
+} leaf_job;
+
+static void prefix_state(sm3_ctx_t *ctx, uint8_t tag)
+{
+    uint8_t block[SM3_BLOCK_SIZE] = {0};
+
+    block[0] = tag;
+    sm3_init_optimized(ctx);
+    sm3_update_optimized(ctx, block, sizeof(block));
+}
+
+static size_t chunk_count(size_t len)
+{
+    return len == 0 ? 1 : (len + SM3_TREE_CHUNK_SIZE - 1) / SM3_TREE_CHUNK_SIZE;
+}
+
+static void hash_leaves(const sm3_ctx_t *start, const uint8_t *data, size_t len, uint8_t *digests)
+{
+    const sm3_ctx_t *starts[LANE_GROUP];
+    const uint8_t *msgs[LANE_GROUP];
+    size_t lens[LANE_GROUP];
+    size_t n = chunk_count(len), i = 0;
+
+    for (size_t l = 0; l < LANE_GROUP; l++)
+    {
+        starts[l] = start;
+    }
+    while (i < n)
+    {
+        size_t count = n - i < LANE_GROUP ? n - i : LANE_GROUP;
+
+        for (size_t l = 0; l < count; l++, i++)
+        {
+            size_t off = i * SM3_TREE_CHUNK_SIZE;
+            msgs[l] = data + off;
+            lens[l] = len - off < SM3_TREE_CHUNK_SIZE ? len - off : SM3_TREE_CHUNK_SIZE;
+        }
+        sm3_hash_many_from(starts, msgs, lens, count, digests);
+        digests += count * SM3_DIGEST_SIZE;
+    }
+}
+
+static void *leaf_worker(void *arg)
+{
+    leaf_job *job = arg;
+    hash_leaves(job->start, job->data, job->len, job->digests);
+    return NULL;
+}
+
+static void hash_parent(const sm3_tree_ctx_t *ctx, const uint8_t *left, const uint8_t *right, uint8_t *out)
+{
+    sm3_ctx_t c = ctx->parent_start;
+    uint8_t pair[2 * SM3_DIGEST_SIZE];
+
+    memcpy(pair, left, SM3_DIGEST_SIZE);
+    memcpy(pair + SM3_DIGEST_SIZE, right, SM3_DIGEST_SIZE);
+    sm3_update_optimized(&c, pair, sizeof(pair));
+    sm3_final_optimized(&c, out);
+}
+
+static int push_leaf(sm3_tree_ctx_t *ctx, const uint8_t *digest)
+{
+    uint8_t node[SM3_DIGEST_SIZE];
+    int height = 0;
+
+    memcpy(node, digest, SM3_DIGEST_SIZE);
+    while (ctx->depth > 0 && ctx->heights[ctx->depth - 1] == height)
+    {
+        hash_parent(ctx, ctx->stack[ctx->depth - 1], node, node);
+        ctx->depth--;
+        height++;
+    }
+    if (ctx->depth == SM3_TREE_MAX_DEPTH)
+    {
+        return -1;
+    }
+    memcpy(ctx->stack[ctx->depth], node, SM3_DIGEST_SIZE);
+    ctx->heights[ctx->depth++] = height;
+    ctx->leaf_count++;
+    return 0;
+}
+
+// Leaves of len bytes (at most one batch) in parallel, then into the tree
+static int process_batch(sm3_tree_ctx_t *ctx, const uint8_t *data, size_t len)
+{
+    pthread_t tid[SM3_TREE_MAX_THREADS];
+    leaf_job jobs[SM3_TREE_MAX_THREADS];
+    int started[SM3_TREE_MAX_THREADS];
+    size_t n = chunk_count(len);
+    size_t threads = (size_t)ctx->threads < n ? (size_t)ctx->threads : n;
+    size_t per = (n + threads - 1) / threads;
+    size_t t, jobs_used = 0;
+
+    for (t = 0; t < threads && t * per < n; t++)
+    {
+        size_t first = t * per;
+        size_t off = first * SM3_TREE_CHUNK_SIZE;
+        size_t end = (first + per) * SM3_TREE_CHUNK_SIZE;
+
+        jobs[t].start = &ctx->leaf_start;
+        jobs[t].data = data + off;
+        jobs[t].len = (end < len ? end : len) - off;
+        jobs[t].digests = ctx->leaves + first * SM3_DIGEST_SIZE;
+        jobs_used++;
+    }
+
+    // Job 0 runs here; a worker that cannot be started runs here too
+    for (t = 1; t < jobs_used; t++)
+    {
+        started[t] = pthread_create(&tid[t], NULL, leaf_worker, &jobs[t]) == 0;
+    }
+    leaf_worker(&jobs[0]);
+    for (t = 1; t < jobs_used; t++)
+    {
+        if (started[t])
+        {
+            pthread_join(tid[t], NULL);
+        }
+        else
+        {
+            leaf_worker(&jobs[t]);
+        }
+    }
+
+    for (size_t i = 0; i < n; i++)
+    {
+        if (push_leaf(ctx, ctx->leaves + i * SM3_DIGEST_SIZE) != 0)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+sm3_tree_ctx_t *sm3_tree_create(int threads)
+{
+    sm3_tree_ctx_t *ctx;
+
+    if (threads <= 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if (threads > SM3_TREE_MAX_THREADS)
+    {
+        threads = SM3_TREE_MAX_THREADS;
+    }
+
+    ctx = calloc(1, sizeof(*ctx));
+    if (!ctx)
+    {
+        return NULL;
+    }
+    ctx->threads = threads;
+    ctx->batch_chunks = (size_t)threads * CHUNKS_PER_THREAD;
+    ctx->leaves = malloc(ctx->batch_chunks * SM3_DIGEST_SIZE);
+    if (!ctx->leaves)
+    {
+        free(ctx);
+        return NULL;
+    }
+    prefix_state(&ctx->leaf_start, 0x00);
+    prefix_state(&ctx->parent_start, 0x01);
+    return ctx;
+}
+
+void sm3_tree_destroy(sm3_tree_ctx_t *ctx)
+{
+    if (!ctx)
+    {
+        return;
+    }
+    free(ctx->buffer);
+    free(ctx->leaves);
+    free(ctx);
+}
+
+int sm3_tree_update(sm3_tree_ctx_t *ctx, const uint8_t *data, size_t len)
+{
+    size_t batch_bytes = ctx->batch_chunks * SM3_TREE_CHUNK_SIZE;
+
+    while (len > 0)
+    {
+        // Whole batches straight from the caller's memory
+        if (ctx->buffered == 0 && len >= batch_bytes)
+        {
+            if (process_batch(ctx, data, batch_bytes) != 0)
+            {
+                return -1;
+            }
+            data += batch_bytes;
+            len -= batch_bytes;
+            continue;
+        }
+
+        if (!ctx->buffer)
+        {
+            ctx->buffer = malloc(batch_bytes);
+            if (!ctx->buffer)
+            {
+                return -1;
+            }
+        }
+
+        size_t take = batch_bytes - ctx->buffered < len ? batch_bytes - ctx->buffered : len;
+        memcpy(ctx->buffer + ctx->buffered, data, take);
+        ctx->buffered += take;
+        data += take;
+        len -= take;
+
+        if (ctx->buffered == batch_bytes)
+        {
+            if (process_batch(ctx, ctx->buffer, batch_bytes) != 0)
+            {
+                return -1;
+            }
+            ctx->buffered = 0;
+        }
+    }
+    return 0;
+}
+
+int sm3_tree_final(sm3_tree_ctx_t *ctx, uint8_t *digest)
+{
+    // The short last chunk, or the single empty chunk of an empty input
+    if (ctx->buffered > 0 || ctx->leaf_count == 0)
+    {
+        if (process_batch(ctx, ctx->buffer, ctx->buffered) != 0)
+        {
+            return -1;
+        }
+        ctx->buffered = 0;
+    }
+
+    // Fold the remaining subtrees right to left
+    while (ctx->depth > 1)
+    {
+        hash_parent(ctx, ctx->stack[ctx->depth - 2], ctx->stack[ctx->depth - 1], ctx->stack[ctx->depth - 2]);
+        ctx->depth--;
+    }
+    memcpy(digest, ctx->stack[0], SM3_DIGEST_SIZE);
+    return 0;
+}
+
+int sm3_tree_hash(const uint8_t *data, size_t len, int threads, uint8_t *digest)
+{
+    sm3_tree_ctx_t *ctx = sm3_tree_create(threads);
+
+    size_t batch_bytes;
+    int rc = 0;
+
+    if (!ctx)
+    {
+        return -1;
+    }
+    // Every batch, the short last one included, is read from the caller's
+    // memory; unlike sm3_tree_update() nothing is copied into ctx->buffer
+    batch_bytes = ctx->batch_chunks * SM3_TREE_CHUNK_SIZE;
+    while (rc == 0 && len > 0)
+    {
+        size_t take = len < batch_bytes ? len : batch_bytes;
+
+        rc = process_batch(ctx, data, take);
+        data += take;
+        len -= take;
+    }
+    if (rc == 0)
+    {
+        rc = sm3_tree_final(ctx, digest);
+    }
+    sm3_tree_destroy(ctx);
+    return rc;
+}
@@ -0,0 +1,51 @@
+#ifndef SM3_TREE_H
+#define SM3_TREE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sm3.h"
+
+// SM3 tree hash for large inputs. The input is cut into 64 KiB chunks
+// (the last one may be shorter; empty input is one empty chunk) and
+//   leaf   = SM3(0x00-block || chunk)
+//   parent = SM3(0x01-block || left || right)
+// where an N-block is the byte N followed by 63 zero bytes, so both prefixes
+// are cached midstates. Levels are paired left to right and an odd node is
+// carried up unchanged, which gives the same shape as RFC 6962. The digest
+// is the root; it is not interchangeable with plain SM3 of the input.
+
+#define SM3_TREE_CHUNK_SIZE (64 * 1024)
+#define SM3_TREE_MAX_THREADS 256
+#define SM3_TREE_MAX_DEPTH 64
+
+typedef struct
+{
+    int threads;
+    size_t batch_chunks;  // Chunks hashed per parallel pass
+    uint8_t *buffer;      // batch_chunks * SM3_TREE_CHUNK_SIZE, allocated on first use
+    size_t buffered;
+    uint8_t *leaves;      // Leaf digests of one pass
+    uint64_t leaf_count;
+    sm3_ctx_t leaf_start;   // After the 0x00 block
+    sm3_ctx_t parent_start; // After the 0x01 block
+    // Completed subtrees, heights strictly decreasing from the bottom
+    uint8_t stack[SM3_TREE_MAX_DEPTH][SM3_DIGEST_SIZE];
+    int heights[SM3_TREE_MAX_DEPTH];
+    int depth;
+} sm3_tree_ctx_t;
+
+// threads <= 0 uses every online CPU
+sm3_tree_ctx_t *sm3_tree_create(int threads);
+void sm3_tree_destroy(sm3_tree_ctx_t *ctx);
+
+// Streaming input (a pipe or any sequence of reads); 0 on success. Whole
+// batches (threads * 2 MiB) are hashed from the caller's memory, anything
+// shorter is copied into a buffer of that size until a batch is complete
+int sm3_tree_update(sm3_tree_ctx_t *ctx, const uint8_t *data, size_t len);
+int sm3_tree_final(sm3_tree_ctx_t *ctx, uint8_t *digest);
+
+// Whole input in memory (e.g. an mmap'd file): every chunk, the last partial
+// batch included, is hashed in place and no batch buffer is allocated
+int sm3_tree_hash(const uint8_t *data, size_t len, int threads, uint8_t *digest);
+
+#endif
@@ -230,6 +230,103 @@ void test_multiple_extensions()
     free(final_msg);
 }
 
+void test_batch_forgery()
+{
+    printf("Testing batch forgery over secret lengths...\n");
+
+    // Legacy tokens SM3(secret || msg) with secrets of unknown length
+    const char *secrets[] = {"k", "short_key", "a_rather_long_server_side_secret_value_0123456789", ""};
+    const char *msgs[] = {"user=alice&role=user", "id=42", "", "amount=100&to=bob&note=padding_boundary_test!"};
+    const size_t n_tokens = sizeof(secrets) / sizeof(secrets[0]);
+    const char *append = "&role=admin";
+    const size_t min_secret = 0, max_secret = 70;
+    uint8_t token_digest[4][SM3_DIGEST_SIZE];
+    const uint8_t *digests[4];
+    uint64_t msg_lens[4];
+
+    for (size_t t = 0; t < n_tokens; t++)
+    {
+        sm3_ctx_t ctx;
+        sm3_init(&ctx);
+        sm3_update(&ctx, (const uint8_t *)secrets[t], strlen(secrets[t]));
+        sm3_update(&ctx, (const uint8_t *)msgs[t], strlen(msgs[t]));
+        sm3_final(&ctx, token_digest[t]);
+        digests[t] = token_digest[t];
+        msg_lens[t] = strlen(msgs[t]);
+    }
+
+    size_t arena_size = sm3_forge_arena_size(n_tokens, min_secret, max_secret, strlen(append));
+    void *arena = malloc(arena_size);
+    sm3_forgery_t *forgeries;
+    assert(arena != NULL);
+    assert(sm3_forge_many(digests, msg_lens, n_tokens, min_secret, max_secret, (const uint8_t *)append,
+                          strlen(append), arena, arena_size - 1, &forgeries) == -1);
+    assert(sm3_forge_many(digests, msg_lens, n_tokens, min_secret, max_secret, (const uint8_t *)append,
+                          strlen(append), arena, arena_size, &forgeries) == 0);
+
+    size_t per_token = max_secret - min_secret + 1;
+    for (size_t t = 0; t < n_tokens; t++)
+    {
+        for (size_t s = min_secret; s <= max_secret; s++)
+        {
+            const sm3_forgery_t *f = &forgeries[t * per_token + s - min_secret];
+            uint8_t single_hash[SM3_DIGEST_SIZE];
+            uint8_t *single_ext;
+            size_t single_len;
+
+            assert(f->token == t && f->secret_len == s);
+            assert((uint8_t *)f->extension >= (uint8_t *)arena &&
+                   (uint8_t *)f->extension + f->extension_len <= (uint8_t *)arena + arena_size);
+
+            // Same forgery as the one-at-a-time attack
+            assert(sm3_length_extension_attack(digests[t], s + msg_lens[t], (const uint8_t *)append, strlen(append),
+                                               single_hash, &single_ext, &single_len) == 0);
+            assert(f->extension_len == single_len);
+            assert(memcmp(f->extension, single_ext, single_len) == 0);
+            assert(memcmp(f->digest, single_hash, SM3_DIGEST_SIZE) == 0);
+            free(single_ext);
+
+            // The right guess verifies under the real secret
+            if (s == strlen(secrets[t]))
+            {
+                size_t secret_len = strlen(secrets[t]), msg_len = strlen(msgs[t]);
+                uint8_t *forged = malloc(secret_len + msg_len + f->extension_len);
+                uint8_t expected[SM3_DIGEST_SIZE];
+
+                assert(forged != NULL);
+                memcpy(forged, secrets[t], secret_len);
+                memcpy(forged + secret_len, msgs[t], msg_len);
+                memcpy(forged + secret_len + msg_len, f->extension, f->extension_len);
+                sm3_hash(forged, secret_len + msg_len + f->extension_len, expected);
+                assert(memcmp(f->digest, expected, SM3_DIGEST_SIZE) == 0);
+                free(forged);
+            }
+        }
+    }
+
+    // Nothing appended: the forgery is the digest after the glue alone
+    assert(sm3_forge_many(digests, msg_lens, n_tokens, 9, 9, NULL, 0, arena, arena_size, &forgeries) == 0);
+    {
+        uint8_t forged[9 + 5 + SM3_BLOCK_SIZE + 8], expected[SM3_DIGEST_SIZE];
+        memcpy(forged, secrets[1], 9);
+        memcpy(forged + 9, msgs[1], 5);
+        memcpy(forged + 14, forgeries[1].extension, forgeries[1].extension_len);
+        sm3_hash(forged, 14 + forgeries[1].extension_len, expected);
+        assert(memcmp(forgeries[1].digest, expected, SM3_DIGEST_SIZE) == 0);
+    }
+    assert(sm3_forge_many(digests, msg_lens, n_tokens, 5, 4, NULL, 0, arena, arena_size, &forgeries) == -1);
+
+    // Sizes that overflow a size_t are refused, not wrapped to a small arena
+    assert(sm3_forge_arena_size(n_tokens, 0, SIZE_MAX, 0) == 0);
+    assert(sm3_forge_arena_size(SIZE_MAX / 2, 0, 2, 0) == 0);
+    assert(sm3_forge_arena_size(1, 0, 0, SIZE_MAX - 8) == 0);
+    assert(sm3_forge_arena_size(SIZE_MAX / 64, 0, 0, 0) == 0);
+    assert(sm3_forge_many(digests, msg_lens, n_tokens, 0, SIZE_MAX, NULL, 0, arena, arena_size, &forgeries) == -1);
+
+    free(arena);
+    printf("✓ %zu forgeries match the single attack; the right secret lengths verify\n\n", n_tokens * per_token);
+}
+
 int main()
 {
     printf("SM3 Length Extension Attack Test Suite\n");
@@ -239,6 +336,7 @@ int main()
     test_length_extension_detailed();
     test_authentication_bypass();
     test_multiple_extensions();
+    test_batch_forgery();
 
     printf("All length extension attack tests passed!\n");
     printf("This demonstrates the vulnerability of SM3 to length extension attacks\n");
@@ -1,9 +1,13 @@
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
 #include <time.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
 #include "../src/sm3.h"
+#include "../src/sm3_tree.h"
 
 void print_hex(const uint8_t *data, size_t len)
 {
@@ -118,6 +122,640 @@ void test_sm3_incremental()
     printf("✓ Incremental hashing test passed\n\n");
 }
 
+void test_sm3_hash_many()
+{
+    printf("Testing multi-buffer hashing...\n");
+
+    // Lengths around the padding boundaries, plus one long message that
+    // outlives the others in its lane
+    enum
+    {
+        NUM_MSGS = 150
+    };
+    static uint8_t data[NUM_MSGS * 200 + 5000];
+    const uint8_t *msgs[NUM_MSGS];
+    size_t lens[NUM_MSGS];
+    uint8_t expected[NUM_MSGS * SM3_DIGEST_SIZE];
+    uint8_t got[NUM_MSGS * SM3_DIGEST_SIZE];
+    sm3_many_backend backends[4];
+    size_t offset = 0;
+
+    for (size_t i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t)(i * 131 + 7);
+    }
+    for (int i = 0; i < NUM_MSGS; i++)
+    {
+        lens[i] = (i == 3) ? 5000 : (size_t)((i * 37) % 200);
+        msgs[i] = data + offset;
+        offset += lens[i];
+        sm3_hash(msgs[i], lens[i], expected + i * SM3_DIGEST_SIZE);
+    }
+
+    size_t nb = sm3_hash_many_backends(backends, 4);
+    for (size_t b = 0; b < nb; b++)
+    {
+        for (int n = 1; n <= NUM_MSGS; n += (n < 20 ? 1 : 43))
+        {
+            memset(got, 0, sizeof(got));
+            backends[b].hash_many(msgs, lens, n, got);
+            assert(memcmp(got, expected, n * SM3_DIGEST_SIZE) == 0);
+        }
+        printf("✓ %s matches sm3_hash\n", backends[b].name);
+    }
+
+    sm3_hash_many(msgs, lens, NUM_MSGS, got);
+    assert(memcmp(got, expected, sizeof(expected)) == 0);
+    printf("✓ sm3_hash_many matches sm3_hash\n\n");
+}
+
+void test_sm3_simd()
+{
+    printf("Testing single-stream SIMD hashing...\n");
+
+    // Every length up to three blocks, then a few multi-block ones
+    size_t max_len = 4096 + 67;
+    uint8_t *data = malloc(max_len);
+    assert(data != NULL);
+    for (size_t i = 0; i < max_len; i++)
+    {
+        data[i] = (uint8_t)(i * 131 + 7);
+    }
+
+    for (size_t len = 0; len <= max_len; len += (len < 192 ? 1 : 389))
+    {
+        uint8_t expected[SM3_DIGEST_SIZE];
+        uint8_t result[SM3_DIGEST_SIZE];
+
+        sm3_hash(data, len, expected);
+        sm3_hash_simd(data, len, result);
+        assert(memcmp(expected, result, SM3_DIGEST_SIZE) == 0);
+    }
+
+    // Uneven update sizes across block boundaries
+    uint8_t expected[SM3_DIGEST_SIZE];
+    uint8_t result[SM3_DIGEST_SIZE];
+    sm3_ctx_t ctx;
+    size_t pos = 0, step = 1;
+
+    sm3_hash(data, max_len, expected);
+    sm3_init_simd(&ctx);
+    while (pos < max_len)
+    {
+        size_t take = step < max_len - pos ? step : max_len - pos;
+        sm3_update_simd(&ctx, data + pos, take);
+        pos += take;
+        step = step * 3 + 1;
+    }
+    sm3_final_simd(&ctx, result);
+    assert(memcmp(expected, result, SM3_DIGEST_SIZE) == 0);
+
+    free(data);
+    printf("✓ SIMD hashing matches the reference\n\n");
+}
+
+static void parse_hex(const char *hex, uint8_t *out, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        unsigned int byte;
+        sscanf(hex + 2 * i, "%2x", &byte);
+        out[i] = (uint8_t)byte;
+    }
+}
+
+void test_sm3_state_export()
+{
+    printf("Testing context export/import...\n");
+
+    const char *message = "The quick brown fox jumps over the lazy dog, twice over: the quick brown fox";
+    size_t len = strlen(message);
+    uint8_t expected[SM3_DIGEST_SIZE];
+    uint8_t result[SM3_DIGEST_SIZE];
+    uint8_t blob[SM3_STATE_EXPORT_SIZE];
+
+    sm3_hash((const uint8_t *)message, len, expected);
+
+    // Snapshot at every split point, finish on another implementation
+    for (size_t split = 0; split <= len; split++)
+    {
+        sm3_ctx_t ctx, restored;
+
+        sm3_init(&ctx);
+        sm3_update(&ctx, (const uint8_t *)message, split);
+        sm3_export_state(&ctx, blob);
+        memset(&restored, 0xAA, sizeof(restored));
+        sm3_import_state(&restored, blob);
+        sm3_update_optimized(&restored, (const uint8_t *)message + split, len - split);
+        sm3_final_optimized(&restored, result);
+        assert(memcmp(expected, result, SM3_DIGEST_SIZE) == 0);
+    }
+    printf("✓ Context export/import test passed\n\n");
+}
+
+void test_hmac_sm3()
+{
+    printf("Testing HMAC-SM3...\n");
+
+    // Reference values from OpenSSL's HMAC with SM3
+    struct
+    {
+        const char *key;
+        size_t key_repeat;
+        const char *msg;
+        size_t msg_repeat;
+        const char *mac;
+    } vectors[] = {
+        {"key", 1, "The quick brown fox jumps over the lazy dog", 1,
+         "bd4a34077888162b210645b8ebf74b9af357303789357a27c7fc457244ebd398"},
+        {"k", 100, "abc", 50, "c28b4c9415780644d2ce8629028da57f5e8a9ebf2174b58c6b22dd7be89a4b3e"},
+        {"", 0, "", 0, "0d23f72ba15e9c189a879aefc70996b06091de6e64d31b7a84004356dd915261"},
+    };
+
+    for (size_t v = 0; v < sizeof(vectors) / sizeof(vectors[0]); v++)
+    {
+        uint8_t key[256], msg[256], expected[HMAC_SM3_SIZE], mac[HMAC_SM3_SIZE];
+        size_t klen = strlen(vectors[v].key) * vectors[v].key_repeat;
+        size_t mlen = strlen(vectors[v].msg) * vectors[v].msg_repeat;
+        hmac_sm3_key_t hk;
+        hmac_sm3_ctx_t ctx;
+
+        for (size_t i = 0; i < klen; i++)
+        {
+            key[i] = (uint8_t)vectors[v].key[i % strlen(vectors[v].key)];
+        }
+        for (size_t i = 0; i < mlen; i++)
+        {
+            msg[i] = (uint8_t)vectors[v].msg[i % strlen(vectors[v].msg)];
+        }
+        parse_hex(vectors[v].mac, expected, HMAC_SM3_SIZE);
+
+        hmac_sm3_setkey(&hk, key, klen);
+        hmac_sm3(&hk, msg, mlen, mac);
+        assert(memcmp(expected, mac, HMAC_SM3_SIZE) == 0);
+        assert(hmac_sm3_verify(&hk, msg, mlen, expected) == 0);
+
+        hmac_sm3_init(&ctx, &hk);
+        for (size_t i = 0; i < mlen; i++)
+        {
+            hmac_sm3_update(&ctx, msg + i, 1);
+        }
+        hmac_sm3_final(&ctx, mac);
+        assert(memcmp(expected, mac, HMAC_SM3_SIZE) == 0);
+
+        expected[HMAC_SM3_SIZE - 1] ^= 1;
+        assert(hmac_sm3_verify(&hk, msg, mlen, expected) == -1);
+    }
+
+    // Batch calls against the one-shot MAC, with a few keys and mixed lengths
+    enum { N = 150 };
+    static uint8_t data[N * 131];
+    static hmac_sm3_key_t hkeys[3];
+    const hmac_sm3_key_t *keys[N];
+    const uint8_t *msgs[N];
+    const uint8_t *macs[N];
+    size_t lens[N];
+    int results[N];
+    static uint8_t batch[N * HMAC_SM3_SIZE], single[N * HMAC_SM3_SIZE];
+
+    for (size_t i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t)(i * 29 + 3);
+    }
+    for (int k = 0; k < 3; k++)
+    {
+        hmac_sm3_setkey(&hkeys[k], data + k * 40, 16 + (size_t)k * 50);
+    }
+    for (size_t i = 0; i < N; i++)
+    {
+        keys[i] = &hkeys[i % 3];
+        msgs[i] = data + i * 131;
+        lens[i] = (i * 37) % 131;
+        hmac_sm3(keys[i], msgs[i], lens[i], single + i * HMAC_SM3_SIZE);
+        macs[i] = single + i * HMAC_SM3_SIZE;
+    }
+
+    for (size_t n = 1; n <= N; n += (n < 20 ? 1 : 43))
+    {
+        hmac_sm3_many(keys, msgs, lens, n, batch);
+        assert(memcmp(batch, single, n * HMAC_SM3_SIZE) == 0);
+    }
+
+    assert(hmac_sm3_verify_many(keys, msgs, lens, macs, N, results) == 0);
+    single[7 * HMAC_SM3_SIZE] ^= 0x80;
+    single[100 * HMAC_SM3_SIZE + 31] ^= 0x01;
+    assert(hmac_sm3_verify_many(keys, msgs, lens, macs, N, results) == 2);
+    for (size_t i = 0; i < N; i++)
+    {
+        assert(results[i] == ((i == 7 || i == 100) ? -1 : 0));
+    }
+
+    printf("✓ HMAC-SM3 test passed\n\n");
+}
+
+void test_sm3_kdf()
+{
+    printf("Testing SM3 KDF...\n");
+
+    // Reference values from SM3(Z || ct) with OpenSSL's SM3
+    uint8_t z[200], out[4201], expected[70];
+    for (int i = 0; i < 200; i++)
+    {
+        z[i] = (uint8_t)i;
+    }
+    parse_hex("c3e5cfe48b9da30523c65df3b189227188a89ac9057b739bb779f028e4afe606"
+              "e9df98cf02023b778579bdf48e7002306ba21850d002971e209d2e785d3518c9"
+              "113608e38a6d",
+              expected, 70);
+    assert(sm3_kdf(z, 64, out, 70) == 0);
+    assert(memcmp(out, expected, 70) == 0);
+    parse_hex("88c0cffa4c713446a03f1fff1630aa6353bdb53e2a9272146be7a82fde06afa3", expected, 32);
+    assert(sm3_kdf(z, 0, out, 32) == 0);
+    assert(memcmp(out, expected, 32) == 0);
+
+    // Against a sequential SM3(Z || ct) loop for Z lengths around the block
+    // size and outputs spanning several batches
+    const size_t zlens[] = {1, 55, 59, 60, 63, 64, 65, 128, 200};
+    const size_t outlens[] = {1, 31, 32, 33, 1000, 4200};
+    for (size_t a = 0; a < sizeof(zlens) / sizeof(zlens[0]); a++)
+    {
+        for (size_t b = 0; b < sizeof(outlens) / sizeof(outlens[0]); b++)
+        {
+            size_t zlen = zlens[a], outlen = outlens[b];
+
+            memset(out, 0xEE, sizeof(out));
+            assert(sm3_kdf(z, zlen, out, outlen) == 0);
+            for (uint32_t ct = 1; (ct - 1) * SM3_DIGEST_SIZE < outlen; ct++)
+            {
+                uint8_t ctbuf[4] = {(uint8_t)(ct >> 24), (uint8_t)(ct >> 16), (uint8_t)(ct >> 8), (uint8_t)ct};
+                uint8_t digest[SM3_DIGEST_SIZE];
+                size_t off = (ct - 1) * SM3_DIGEST_SIZE;
+                size_t n = outlen - off < SM3_DIGEST_SIZE ? outlen - off : SM3_DIGEST_SIZE;
+                sm3_ctx_t ctx;
+
+                sm3_init(&ctx);
+                sm3_update(&ctx, z, zlen);
+                sm3_update(&ctx, ctbuf, 4);
+                sm3_final(&ctx, digest);
+                assert(memcmp(out + off, digest, n) == 0);
+            }
+            assert(out[outlen] == 0xEE);
+        }
+    }
+    printf("✓ SM3 KDF test passed\n\n");
+}
+
+// PBKDF2 as written in RFC 8018, one HMAC at a time
+static void pbkdf2_reference(const uint8_t *pw, size_t pwlen, const uint8_t *salt, size_t saltlen,
+                             uint32_t iterations, uint8_t *out, size_t outlen)
+{
+    hmac_sm3_key_t key;
+    hmac_sm3_setkey(&key, pw, pwlen);
+
+    for (uint32_t index = 1; (index - 1) * SM3_DIGEST_SIZE < outlen; index++)
+    {
+        uint8_t be_index[4] = {(uint8_t)(index >> 24), (uint8_t)(index >> 16), (uint8_t)(index >> 8), (uint8_t)index};
+        uint8_t u[SM3_DIGEST_SIZE], t[SM3_DIGEST_SIZE];
+        size_t off = (index - 1) * SM3_DIGEST_SIZE;
+        size_t n = outlen - off < SM3_DIGEST_SIZE ? outlen - off : SM3_DIGEST_SIZE;
+        hmac_sm3_ctx_t ctx;
+
+        hmac_sm3_init(&ctx, &key);
+        hmac_sm3_update(&ctx, salt, saltlen);
+        hmac_sm3_update(&ctx, be_index, 4);
+        hmac_sm3_final(&ctx, u);
+        memcpy(t, u, sizeof(t));
+        for (uint32_t it = 1; it < iterations; it++)
+        {
+            hmac_sm3(&key, u, sizeof(u), u);
+            for (int i = 0; i < SM3_DIGEST_SIZE; i++)
+            {
+                t[i] ^= u[i];
+            }
+        }
+        memcpy(out + off, t, n);
+    }
+}
+
+void test_pbkdf2_sm3()
+{
+    printf("Testing PBKDF2-HMAC-SM3...\n");
+
+    // Reference values from OpenSSL's PBKDF2 with SM3
+    const char *long_pw = "passwordPASSWORDpassword";
+    const char *long_salt = "saltSALTsaltSALTsaltSALTsaltSALTsalt";
+    uint8_t out[40], expected[40];
+
+    parse_hex("4612f922a1fdcefaf4312fc6f8f3322b489cbf24f2ea361b44c2bd8fa2c6dcb0", expected, 32);
+    assert(pbkdf2_hmac_sm3((const uint8_t *)"password", 8, (const uint8_t *)"salt", 4, 1, out, 32) == 0);
+    assert(memcmp(out, expected, 32) == 0);
+    parse_hex("fee723a2bc966e11dffb66133f4e8df577383c78ade30e3298edbd3e54ed85b7", expected, 32);
+    assert(pbkdf2_hmac_sm3((const uint8_t *)"password", 8, (const uint8_t *)"salt", 4, 2, out, 32) == 0);
+    assert(memcmp(out, expected, 32) == 0);
+    parse_hex("b6e8f2074c87432b78f62e5ced980fdff89e86af2f693dab1638e2b3683045dd", expected, 32);
+    assert(pbkdf2_hmac_sm3((const uint8_t *)"password", 8, (const uint8_t *)"salt", 4, 4096, out, 32) == 0);
+    assert(memcmp(out, expected, 32) == 0);
+    parse_hex("3b6282ac8519f059e465abff0ea37b0dbfe6c672a76e6b805312d53900db6307"
+              "32ccc1a88fa5512a",
+              expected, 40);
+    assert(pbkdf2_hmac_sm3((const uint8_t *)long_pw, strlen(long_pw), (const uint8_t *)long_salt,
+                           strlen(long_salt), 4096, out, 40) == 0);
+    assert(memcmp(out, expected, 40) == 0);
+    assert(pbkdf2_hmac_sm3((const uint8_t *)"password", 8, (const uint8_t *)"salt", 4, 0, out, 32) == -1);
+
+    // A batch that fills the lanes several times and leaves a partial group,
+    // with passwords longer than a block and 3 output blocks each
+    enum
+    {
+        N = 37,
+        OUTLEN = 70,
+        ITER = 100
+    };
+    uint8_t pw_data[N][80], salt_data[N][20];
+    const uint8_t *pws[N], *salts[N];
+    size_t pwlens[N], saltlens[N];
+    uint8_t *outs = malloc(N * OUTLEN + 1), ref[OUTLEN];
+    assert(outs != NULL);
+
+    for (int i = 0; i < N; i++)
+    {
+        pwlens[i] = (size_t)(i * 7) % 80;
+        saltlens[i] = 8 + (size_t)i % 12;
+        for (size_t j = 0; j < sizeof(pw_data[i]); j++)
+        {
+            pw_data[i][j] = (uint8_t)(i * 31 + j);
+        }
+        for (size_t j = 0; j < sizeof(salt_data[i]); j++)
+        {
+            salt_data[i][j] = (uint8_t)(i + j * 17);
+        }
+        pws[i] = pw_data[i];
+        salts[i] = salt_data[i];
+    }
+    outs[N * OUTLEN] = 0xEE;
+    assert(pbkdf2_hmac_sm3_many(pws, pwlens, salts, saltlens, N, ITER, outs, OUTLEN) == 0);
+    assert(outs[N * OUTLEN] == 0xEE);
+    for (int i = 0; i < N; i++)
+    {
+        pbkdf2_reference(pws[i], pwlens[i], salts[i], saltlens[i], ITER, ref, OUTLEN);
+        assert(memcmp(outs + i * OUTLEN, ref, OUTLEN) == 0);
+        assert(pbkdf2_hmac_sm3(pws[i], pwlens[i], salts[i], saltlens[i], ITER, out, 33) == 0);
+        assert(memcmp(out, ref, 33) == 0);
+    }
+    free(outs);
+    printf("✓ PBKDF2-HMAC-SM3 test passed\n\n");
+}
+
+void test_sm3_drbg()
+{
+    printf("Testing SM3 Hash_DRBG...\n");
+
+    // Reference values from a direct Python transcription of SP 800-90A
+    // Hash_DRBG over hashlib's SM3
+    uint8_t entropy[32], nonce[16], reseed_entropy[32];
+    uint8_t out[4096], expected[100], digest[SM3_DIGEST_SIZE];
+    const char *pers = "SM2 signing";
+    sm3_drbg_t drbg;
+
+    for (int i = 0; i < 32; i++)
+    {
+        entropy[i] = (uint8_t)i;
+        reseed_entropy[i] = (uint8_t)(64 + i);
+    }
+    for (int i = 0; i < 16; i++)
+    {
+        nonce[i] = (uint8_t)(32 + i);
+    }
+    assert(sm3_drbg_instantiate(&drbg, entropy, 32, nonce, 16, (const uint8_t *)pers, strlen(pers)) == 0);
+
+    parse_hex("2f80ee5e7ab2262ab5fd57331652a80f609f0c7b6f104df8d725594fbe5b918b", expected, 32);
+    assert(sm3_drbg_generate(&drbg, out, 32, NULL, 0) == 0);
+    assert(memcmp(out, expected, 32) == 0);
+
+    // 128 hashes: two full batches through the lanes
+    parse_hex("064a7c72636bdc667c5a5d17a10e83a209a667280ed35ac225943f777ec8f400", expected, 32);
+    assert(sm3_drbg_generate(&drbg, out, 4096, NULL, 0) == 0);
+    sm3_hash(out, 4096, digest);
+    assert(memcmp(digest, expected, 32) == 0);
+
+    parse_hex("b4d3913ef54d2c6023492742d8788c8a88bc3363b418ca9630fe97e1176ef76e"
+              "6620343dcbcf847980f80e50126bd9dd93486ab7d24bda83996a8e8069d33061"
+              "ab99a0efaad58590c025edce221be29c62b7ecae3015b8f6e66c66fa39543e90"
+              "119cd6b6",
+              expected, 100);
+    out[100] = 0xEE;
+    assert(sm3_drbg_generate(&drbg, out, 100, (const uint8_t *)"additional input", 16) == 0);
+    assert(memcmp(out, expected, 100) == 0);
+    assert(out[100] == 0xEE);
+
+    parse_hex("4f7ad7d2de1065417a3dbfce76b55e22521021aeffdc038cffc2c851ae7d9e6b"
+              "b5dc7caccd6ba51666696eb4c621c8adf01a3edcff0eaabc9943a49d8ebe9177"
+              "98bdd031bae8",
+              expected, 70);
+    assert(sm3_drbg_reseed(&drbg, reseed_entropy, 32, (const uint8_t *)"reseed", 6) == 0);
+    assert(sm3_drbg_generate(&drbg, out, 70, NULL, 0) == 0);
+    assert(memcmp(out, expected, 70) == 0);
+
+    // V + i wrapping around 2^440
+    assert(sm3_drbg_instantiate(&drbg, entropy, 32, nonce, 16, NULL, 0) == 0);
+    memset(drbg.V, 0xFF, sizeof(drbg.V));
+    parse_hex("be82549383de8cdb502d56b18ff373045a5fc397d160e1aad4dc5d363c757010", expected, 32);
+    assert(sm3_drbg_generate(&drbg, out, 200, NULL, 0) == 0);
+    sm3_hash(out, 200, digest);
+    assert(memcmp(digest, expected, 32) == 0);
+
+    // Limits
+    assert(sm3_drbg_instantiate(&drbg, entropy, 31, nonce, 16, NULL, 0) == -1);
+    assert(sm3_drbg_generate(&drbg, out, SM3_DRBG_MAX_REQUEST + 1, NULL, 0) == -1);
+    drbg.reseed_counter = SM3_DRBG_RESEED_INTERVAL + 1;
+    assert(sm3_drbg_generate(&drbg, out, 32, NULL, 0) == SM3_DRBG_NEED_RESEED);
+    assert(sm3_drbg_reseed(&drbg, reseed_entropy, 32, NULL, 0) == 0);
+    assert(sm3_drbg_generate(&drbg, out, 32, NULL, 0) == 0);
+    sm3_drbg_uninstantiate(&drbg);
+
+    // Per-thread instance: successive outputs differ, long requests are split
+    uint8_t *big = malloc(3 * SM3_DRBG_MAX_REQUEST + 5);
+    assert(big != NULL);
+    assert(sm3_drbg_random(out, 32) == 0);
+    assert(sm3_drbg_random(expected, 32) == 0);
+    assert(memcmp(out, expected, 32) != 0);
+    assert(sm3_drbg_random(big, 3 * SM3_DRBG_MAX_REQUEST + 5) == 0);
+    free(big);
+
+    // A forked child is instantiated afresh instead of repeating the parent's stream
+    int fds[2], status;
+    assert(pipe(fds) == 0);
+    pid_t child = fork();
+    assert(child >= 0);
+    if (child == 0)
+    {
+        uint8_t mine[32];
+        _exit(sm3_drbg_random(mine, 32) == 0 && write(fds[1], mine, 32) == 32 ? 0 : 1);
+    }
+    assert(sm3_drbg_random(out, 32) == 0);
+    assert(read(fds[0], expected, 32) == 32);
+    assert(waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    assert(memcmp(out, expected, 32) != 0);
+    close(fds[0]);
+    close(fds[1]);
+    printf("✓ SM3 Hash_DRBG test passed\n\n");
+}
+
+// Tree hash recomputed level by level with the reference SM3
+static void tree_reference(const uint8_t *data, size_t len, uint8_t *root)
+{
+    size_t n = len == 0 ? 1 : (len + SM3_TREE_CHUNK_SIZE - 1) / SM3_TREE_CHUNK_SIZE;
+    uint8_t *level = malloc(n * SM3_DIGEST_SIZE);
+    uint8_t prefix[SM3_BLOCK_SIZE] = {0};
+    sm3_ctx_t ctx;
+
+    assert(level != NULL);
+    for (size_t i = 0; i < n; i++)
+    {
+        size_t off = i * SM3_TREE_CHUNK_SIZE;
+        size_t clen = len - off < SM3_TREE_CHUNK_SIZE ? len - off : SM3_TREE_CHUNK_SIZE;
+
+        prefix[0] = 0x00;
+        sm3_init(&ctx);
+        sm3_update(&ctx, prefix, sizeof(prefix));
+        sm3_update(&ctx, data + off, clen);
+        sm3_final(&ctx, level + i * SM3_DIGEST_SIZE);
+    }
+    while (n > 1)
+    {
+        size_t parents = n / 2;
+        for (size_t i = 0; i < parents; i++)
+        {
+            prefix[0] = 0x01;
+            sm3_init(&ctx);
+            sm3_update(&ctx, prefix, sizeof(prefix));
+            sm3_update(&ctx, level + 2 * i * SM3_DIGEST_SIZE, 2 * SM3_DIGEST_SIZE);
+            sm3_final(&ctx, level + i * SM3_DIGEST_SIZE);
+        }
+        // An odd node moves up unchanged
+        if (n % 2)
+        {
+            memmove(level + parents * SM3_DIGEST_SIZE, level + (n - 1) * SM3_DIGEST_SIZE, SM3_DIGEST_SIZE);
+        }
+        n = parents + n % 2;
+    }
+    memcpy(root, level, SM3_DIGEST_SIZE);
+    free(level);
+}
+
+void test_sm3_tree()
+{
+    printf("Testing SM3 tree hash...\n");
+
+    // Up to 70 chunks: more than one 32-chunk pass with a single thread
+    const size_t C = SM3_TREE_CHUNK_SIZE;
+    const size_t sizes[] = {0, 1, 64, C - 1, C, C + 1, 3 * C, 5 * C + 3, 33 * C, 70 * C - 5};
+    const int threads[] = {1, 3};
+    size_t max_len = 70 * C;
+    uint8_t *data = malloc(max_len);
+
+    assert(data != NULL);
+    for (size_t i = 0; i < max_len; i++)
+    {
+        data[i] = (uint8_t)((i >> 8) ^ (i * 13));
+    }
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        uint8_t expected[SM3_DIGEST_SIZE], result[SM3_DIGEST_SIZE];
+
+        tree_reference(data, sizes[s], expected);
+        for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++)
+        {
+            assert(sm3_tree_hash(data, sizes[s], threads[t], result) == 0);
+            assert(memcmp(expected, result, SM3_DIGEST_SIZE) == 0);
+
+            // Streaming in uneven pieces, as from a pipe
+            sm3_tree_ctx_t *ctx = sm3_tree_create(threads[t]);
+            size_t pos = 0, step = 1000;
+            assert(ctx != NULL);
+            while (pos < sizes[s])
+            {
+                size_t take = step < sizes[s] - pos ? step : sizes[s] - pos;
+                assert(sm3_tree_update(ctx, data + pos, take) == 0);
+                pos += take;
+                step = step * 7 % 3000001 + 1;
+            }
+            assert(sm3_tree_final(ctx, result) == 0);
+            sm3_tree_destroy(ctx);
+            assert(memcmp(expected, result, SM3_DIGEST_SIZE) == 0);
+        }
+    }
+
+    free(data);
+    printf("✓ SM3 tree hash test passed\n\n");
+}
+
+void test_sm3_fixed65()
+{
+    printf("Testing fixed 65-byte node/leaf hashing...\n");
+
+    enum { N = 300 };
+    static uint8_t records[N * 64];
+    static uint8_t expected[N * SM3_DIGEST_SIZE], result[N * SM3_DIGEST_SIZE];
+    uint8_t msg[65];
+
+    // Every value of the last byte, which selects the block-2 schedule
+    for (size_t i = 0; i < sizeof(records); i++)
+    {
+        records[i] = (uint8_t)(i * 151 + (i >> 7));
+    }
+    for (int i = 0; i < N; i++)
+    {
+        records[i * 64 + 63] = (uint8_t)i;
+    }
+
+    for (int prefix = 0; prefix <= 1; prefix++)
+    {
+        for (int i = 0; i < N; i++)
+        {
+            msg[0] = (uint8_t)prefix;
+            memcpy(msg + 1, records + i * 64, 64);
+            sm3_hash(msg, sizeof(msg), expected + i * SM3_DIGEST_SIZE);
+
+            if (prefix)
+            {
+                sm3_hash_node65(records + i * 64, records + i * 64 + 32, result);
+            }
+            else
+            {
+                sm3_hash_leaf64(records + i * 64, result);
+            }
+            assert(memcmp(expected + i * SM3_DIGEST_SIZE, result, SM3_DIGEST_SIZE) == 0);
+        }
+
+        for (size_t n = 1; n <= N; n += (n < 20 ? 1 : 61))
+        {
+            memset(result, 0, sizeof(result));
+            if (prefix)
+            {
+                sm3_hash_nodes65(records, n, result);
+            }
+            else
+            {
+                sm3_hash_leaves64(records, n, result);
+            }
+            assert(memcmp(expected, result, n * SM3_DIGEST_SIZE) == 0);
+        }
+    }
+
+    // A level reduced in place, and a parent written over its left child
+    uint8_t level[N * 64];
+    memcpy(level, records, sizeof(level));
+    sm3_hash_nodes65(level, N, level);
+    assert(memcmp(level, expected, N * SM3_DIGEST_SIZE) == 0);
+    memcpy(level, records, 64);
+    sm3_hash_node65(level, level + 32, level);
+    assert(memcmp(level, expected, SM3_DIGEST_SIZE) == 0);
+
+    printf("✓ Fixed 65-byte hashing test passed\n\n");
+}
+
 void performance_test()
 {
     printf("Performance testing...\n");
@@ -172,6 +810,15 @@ int main()
     test_sm3_basic_vectors();
     test_sm3_optimized_vs_basic();
     test_sm3_incremental();
+    test_sm3_hash_many();
+    test_sm3_simd();
+    test_sm3_state_export();
+    test_hmac_sm3();
+    test_sm3_kdf();
+    test_pbkdf2_sm3();
+    test_sm3_drbg();
+    test_sm3_tree();
+    test_sm3_fixed65();
     performance_test();
 
     printf("All SM3 tests passed!\n");
@@ -0,0 +1,154 @@
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "../src/sm3.hpp"
+
+static void print_hex(const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        printf("%02x", data[i]);
+    }
+    printf("\n");
+}
+
+static const uint8_t expected_abc[] = {0x66, 0xc7, 0xf0, 0xf4, 0x62, 0xee, 0xed, 0xd9,
+                                       0xd1, 0xf2, 0xd4, 0x6b, 0xdc, 0x10, 0xe4, 0xe2,
+                                       0x41, 0x67, 0xc4, 0x87, 0x5c, 0xf2, 0xf7, 0xa2,
+                                       0x29, 0x7d, 0xa0, 0x2b, 0x8f, 0x4b, 0xa8, 0xe0};
+
+static const uint8_t expected_abcd16[] = {0xde, 0xbe, 0x9f, 0xf9, 0x22, 0x75, 0xb8, 0xa1,
+                                          0x38, 0x60, 0x48, 0x89, 0xc1, 0x8e, 0x5a, 0x4d,
+                                          0x6f, 0xdb, 0x70, 0xe5, 0x38, 0x7e, 0x57, 0x65,
+                                          0x29, 0x3d, 0xcb, 0xa3, 0x9c, 0x0c, 0x57, 0x32};
+
+template <class Backend>
+static void test_vectors()
+{
+    printf("Testing %s backend...\n", Backend::name);
+
+    sm3::digest_t d = sm3::Sm3<Backend>::digest(std::string("abc"));
+    printf("abc:      ");
+    print_hex(d.data(), d.size());
+    assert(memcmp(d.data(), expected_abc, SM3_DIGEST_SIZE) == 0);
+
+    d = sm3::Sm3<Backend>::digest(std::string(
+        "abcdabcdabcdabcdabcdabcdabcdabcdabcdabcdabcdabcdabcdabcdabcdabcd"));
+    printf("abcd x16: ");
+    print_hex(d.data(), d.size());
+    assert(memcmp(d.data(), expected_abcd16, SM3_DIGEST_SIZE) == 0);
+    printf("✓ %s backend passed\n\n", Backend::name);
+}
+
+// Every length across the padding boundaries, fed in uneven chunks,
+// against the C sm3_hash()
+static void test_lengths_and_chunks()
+{
+    printf("Testing lengths 0..300 with chunked updates...\n");
+
+    std::vector<uint8_t> msg(300);
+    for (size_t i = 0; i < msg.size(); i++)
+    {
+        msg[i] = (uint8_t)(i * 31 + 7);
+    }
+
+    for (size_t len = 0; len <= msg.size(); len++)
+    {
+        uint8_t ref[SM3_DIGEST_SIZE];
+        sm3_hash(msg.data(), len, ref);
+
+        sm3::Sm3<> h;
+        size_t off = 0;
+        for (size_t step = 1; off < len; step = step * 3 % 71 + 1)
+        {
+            size_t n = step < len - off ? step : len - off;
+            h.update(sm3::bytes_view(msg.data() + off, n));
+            off += n;
+        }
+        sm3::digest_t got = h.final();
+        assert(memcmp(got.data(), ref, SM3_DIGEST_SIZE) == 0);
+
+        // final() leaves the context ready for the next message
+        got = h.update(sm3::bytes_view(msg.data(), len)).final();
+        assert(memcmp(got.data(), ref, SM3_DIGEST_SIZE) == 0);
+    }
+    printf("✓ Chunked hashing matches sm3_hash\n\n");
+}
+
+static void test_facade()
+{
+    printf("Testing runtime backend selection...\n");
+
+    const char *names[] = {"basic", "optimized", "inline"};
+    for (const char *name : names)
+    {
+        sm3::AnySm3 h = sm3::AnySm3::create(name);
+        sm3::digest_t d = h.update(std::string("abc")).final();
+        assert(std::string(h.backend_name()) == name);
+        assert(memcmp(d.data(), expected_abc, SM3_DIGEST_SIZE) == 0);
+    }
+
+    bool threw = false;
+    try
+    {
+        sm3::AnySm3::create("no-such-backend");
+    }
+    catch (const std::invalid_argument &)
+    {
+        threw = true;
+    }
+    assert(threw);
+    printf("✓ Runtime selection passed\n\n");
+}
+
+template <class Backend>
+static double mb_per_sec(const std::vector<uint8_t> &buf)
+{
+    auto start = std::chrono::steady_clock::now();
+    int reps = 0;
+    double elapsed;
+    volatile uint8_t sink = 0;
+
+    do
+    {
+        sink ^= sm3::Sm3<Backend>::digest(buf)[0];
+        reps++;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < 0.3);
+
+    (void)sink;
+    return (double)buf.size() * reps / (1024 * 1024) / elapsed;
+}
+
+static void performance_test()
+{
+    printf("Performance testing (1 MB messages)...\n");
+
+    std::vector<uint8_t> buf(1 << 20);
+    for (size_t j = 0; j < buf.size(); j++)
+    {
+        buf[j] = (uint8_t)(j & 0xFF);
+    }
+
+    printf("  Sm3<Basic>:     %.2f MB/s\n", mb_per_sec<sm3::backend::Basic>(buf));
+    printf("  Sm3<Optimized>: %.2f MB/s\n", mb_per_sec<sm3::backend::Optimized>(buf));
+    printf("  Sm3<Inline>:    %.2f MB/s\n\n", mb_per_sec<sm3::backend::Inline>(buf));
+}
+
+int main()
+{
+    printf("SM3 C++ API Test Suite\n");
+    printf("======================\n\n");
+
+    test_vectors<sm3::backend::Basic>();
+    test_vectors<sm3::backend::Optimized>();
+    test_vectors<sm3::backend::Inline>();
+    test_lengths_and_chunks();
+    test_facade();
+    performance_test();
+
+    printf("All SM3 C++ API tests passed!\n");
+    return 0;
+}
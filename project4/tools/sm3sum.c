@@ -0,0 +1,768 @@
+#define _DEFAULT_SOURCE
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "../src/sm3.h"
+
+// sha256sum-compatible SM3 checksums for large file sets. A pool of workers
+// takes paths and directories from a shared queue; a directory pushes its
+// entries back onto the queue, so walking runs on the pool as well. Small
+// files are read whole (one read() each) into a per-worker arena and hashed
+// together with sm3_hash_many(), one file per SIMD lane. Large files are
+// mmap'd and hashed on their own with the single-stream SIMD path.
+// Lines are printed in completion order, one batch per write.
+
+#define BATCH_FILES 64
+#define ARENA_SIZE ((size_t)4 << 20)
+#define SMALL_MAX ((size_t)256 << 10)
+#define STREAM_SIZE ((size_t)4 << 20)
+
+typedef struct
+{
+    char *path;
+    int expect;                       // Check mode: compare against expected
+    uint8_t expected[SM3_DIGEST_SIZE];
+} task_t;
+
+typedef struct
+{
+    task_t *tasks[BATCH_FILES];
+    const uint8_t *msgs[BATCH_FILES];
+    size_t lens[BATCH_FILES];
+    uint8_t digests[BATCH_FILES * SM3_DIGEST_SIZE];
+    size_t count;
+    uint8_t *arena;
+    size_t arena_used;
+    char *out;                        // Pending output lines
+    size_t out_len, out_cap;
+} batch_t;
+
+static struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    task_t **items;
+    size_t len, cap;
+    int busy;
+} queue = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, 0, 0, 0};
+
+static pthread_mutex_t out_lock = PTHREAD_MUTEX_INITIALIZER;
+static int recursive = 0;
+static int check_mode = 0;
+static int quiet = 0;
+static int errors = 0;      // Unreadable files and other failures
+static int mismatches = 0;  // Check mode: digests that differ
+static uint64_t files_done = 0;
+static uint64_t bytes_done = 0;
+
+static void report_error(const char *path, const char *what)
+{
+    pthread_mutex_lock(&out_lock);
+    fflush(stdout);
+    fprintf(stderr, "sm3sum: %s: %s\n", path, what);
+    errors++;
+    pthread_mutex_unlock(&out_lock);
+}
+
+static int queue_push(char *path, const uint8_t *expected)
+{
+    task_t *t = malloc(sizeof(*t));
+
+    if (!t)
+    {
+        free(path);
+        return -1;
+    }
+    t->path = path;
+    t->expect = expected != NULL;
+    if (expected)
+    {
+        memcpy(t->expected, expected, SM3_DIGEST_SIZE);
+    }
+
+    pthread_mutex_lock(&queue.lock);
+    if (queue.len == queue.cap)
+    {
+        size_t cap = queue.cap ? queue.cap * 2 : 1024;
+        task_t **items = realloc(queue.items, cap * sizeof(*items));
+        if (!items)
+        {
+            pthread_mutex_unlock(&queue.lock);
+            free(t->path);
+            free(t);
+            return -1;
+        }
+        queue.items = items;
+        queue.cap = cap;
+    }
+    queue.items[queue.len++] = t;
+    pthread_cond_signal(&queue.cond);
+    pthread_mutex_unlock(&queue.lock);
+    return 0;
+}
+
+static void free_task(task_t *t)
+{
+    free(t->path);
+    free(t);
+}
+
+// --- Output ----------------------------------------------------------------
+
+static void out_append(batch_t *b, const char *s, size_t n)
+{
+    if (b->out_len + n > b->out_cap)
+    {
+        size_t cap = (b->out_len + n) * 2;
+        char *p = realloc(b->out, cap);
+        if (!p)
+        {
+            return;
+        }
+        b->out = p;
+        b->out_cap = cap;
+    }
+    memcpy(b->out + b->out_len, s, n);
+    b->out_len += n;
+}
+
+static void out_flush(batch_t *b)
+{
+    if (b->out_len == 0)
+    {
+        return;
+    }
+    pthread_mutex_lock(&out_lock);
+    fwrite(b->out, 1, b->out_len, stdout);
+    pthread_mutex_unlock(&out_lock);
+    b->out_len = 0;
+}
+
+// Names with a backslash or newline are escaped and the line gets a leading
+// backslash, as sha256sum does
+static void out_name(batch_t *b, const char *path)
+{
+    for (const char *p = path; *p; p++)
+    {
+        if (*p == '\\')
+        {
+            out_append(b, "\\\\", 2);
+        }
+        else if (*p == '\n')
+        {
+            out_append(b, "\\n", 2);
+        }
+        else if (*p == '\r')
+        {
+            out_append(b, "\\r", 2);
+        }
+        else
+        {
+            out_append(b, p, 1);
+        }
+    }
+}
+
+static void emit(batch_t *b, const task_t *t, const uint8_t *digest, uint64_t bytes)
+{
+    int escape = strpbrk(t->path, "\\\n\r") != NULL;
+
+    if (t->expect)
+    {
+        int ok = memcmp(digest, t->expected, SM3_DIGEST_SIZE) == 0;
+        if (!ok)
+        {
+            __atomic_add_fetch(&mismatches, 1, __ATOMIC_RELAXED);
+        }
+        if (!ok || !quiet)
+        {
+            if (escape)
+            {
+                out_append(b, "\\", 1);
+            }
+            out_name(b, t->path);
+            out_append(b, ok ? ": OK\n" : ": FAILED\n", ok ? 5 : 9);
+        }
+    }
+    else
+    {
+        static const char hex[] = "0123456789abcdef";
+        char line[2 * SM3_DIGEST_SIZE + 2];
+
+        for (int i = 0; i < SM3_DIGEST_SIZE; i++)
+        {
+            line[2 * i] = hex[digest[i] >> 4];
+            line[2 * i + 1] = hex[digest[i] & 15];
+        }
+        line[2 * SM3_DIGEST_SIZE] = ' ';
+        line[2 * SM3_DIGEST_SIZE + 1] = ' ';
+        if (escape)
+        {
+            out_append(b, "\\", 1);
+        }
+        out_append(b, line, sizeof(line));
+        out_name(b, t->path);
+        out_append(b, "\n", 1);
+    }
+    __atomic_add_fetch(&files_done, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&bytes_done, bytes, __ATOMIC_RELAXED);
+}
+
+static void fail_file(batch_t *b, const task_t *t, const char *path, int err)
+{
+    if (t->expect)
+    {
+        // sha256sum -c reports unreadable files inline as well
+        if (strpbrk(t->path, "\\\n\r"))
+        {
+            out_append(b, "\\", 1);
+        }
+        out_name(b, t->path);
+        out_append(b, ": FAILED open or read\n", 22);
+    }
+    report_error(path, strerror(err));
+}
+
+// --- Hashing ---------------------------------------------------------------
+
+static void batch_flush(batch_t *b)
+{
+    if (b->count > 0)
+    {
+        sm3_hash_many(b->msgs, b->lens, b->count, b->digests);
+        for (size_t i = 0; i < b->count; i++)
+        {
+            emit(b, b->tasks[i], b->digests + i * SM3_DIGEST_SIZE, b->lens[i]);
+            free_task(b->tasks[i]);
+        }
+        b->count = 0;
+        b->arena_used = 0;
+    }
+    out_flush(b);
+}
+
+// Read to EOF through the streaming API (pipes, growing files, no mmap)
+static int hash_stream(int fd, uint8_t *digest, uint64_t *bytes)
+{
+    uint8_t *buf = malloc(STREAM_SIZE);
+    sm3_ctx_t ctx;
+
+    if (!buf)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+    sm3_init_simd(&ctx);
+    *bytes = 0;
+    for (;;)
+    {
+        ssize_t got = read(fd, buf, STREAM_SIZE);
+        if (got < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (got < 0)
+        {
+            int err = errno;
+            free(buf);
+            errno = err;
+            return -1;
+        }
+        if (got == 0)
+        {
+            break;
+        }
+        sm3_update_simd(&ctx, buf, (size_t)got);
+        *bytes += (uint64_t)got;
+    }
+    sm3_final_simd(&ctx, digest);
+    free(buf);
+    return 0;
+}
+
+static void hash_large(batch_t *b, task_t *t, int fd, size_t size)
+{
+    uint8_t digest[SM3_DIGEST_SIZE];
+    uint64_t bytes = size;
+    uint8_t *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (data != MAP_FAILED)
+    {
+        posix_madvise(data, size, POSIX_MADV_SEQUENTIAL);
+        sm3_hash_simd(data, size, digest);
+        munmap(data, size);
+    }
+    else if (lseek(fd, 0, SEEK_SET) != 0 || hash_stream(fd, digest, &bytes) != 0)
+    {
+        fail_file(b, t, t->path, errno);
+        free_task(t);
+        return;
+    }
+    emit(b, t, digest, bytes);
+    free_task(t);
+}
+
+// Whole file into the arena; falls back to streaming if it grew meanwhile
+static void hash_small(batch_t *b, task_t *t, int fd, size_t size)
+{
+    uint8_t *dst;
+    size_t got = 0;
+    uint8_t probe;
+
+    if (b->count == BATCH_FILES || b->arena_used + size > ARENA_SIZE)
+    {
+        batch_flush(b);
+    }
+    dst = b->arena + b->arena_used;
+    while (got < size)
+    {
+        ssize_t r = read(fd, dst + got, size - got);
+        if (r < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (r < 0)
+        {
+            fail_file(b, t, t->path, errno);
+            free_task(t);
+            return;
+        }
+        if (r == 0)
+        {
+            break;
+        }
+        got += (size_t)r;
+    }
+    if (got == size && read(fd, &probe, 1) > 0)
+    {
+        uint8_t digest[SM3_DIGEST_SIZE];
+        uint64_t bytes;
+
+        if (lseek(fd, 0, SEEK_SET) != 0 || hash_stream(fd, digest, &bytes) != 0)
+        {
+            fail_file(b, t, t->path, errno);
+            free_task(t);
+            return;
+        }
+        emit(b, t, digest, bytes);
+        free_task(t);
+        return;
+    }
+
+    b->tasks[b->count] = t;
+    b->msgs[b->count] = dst;
+    b->lens[b->count] = got;
+    b->count++;
+    b->arena_used += got;
+}
+
+static void walk_dir(batch_t *b, task_t *t, int fd)
+{
+    DIR *dir = fdopendir(fd);
+    struct dirent *e;
+    size_t base = strlen(t->path);
+    int slash = base > 0 && t->path[base - 1] == '/';
+
+    if (!dir)
+    {
+        fail_file(b, t, t->path, errno);
+        close(fd);
+        free_task(t);
+        return;
+    }
+    while ((e = readdir(dir)) != NULL)
+    {
+        if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0)
+        {
+            continue;
+        }
+        // Symlinks met while walking are not followed (as find does)
+        if (e->d_type == DT_LNK)
+        {
+            continue;
+        }
+        size_t n = strlen(e->d_name);
+        char *child = malloc(base + 1 + n + 1);
+        if (!child)
+        {
+            report_error(t->path, strerror(ENOMEM));
+            break;
+        }
+        memcpy(child, t->path, base);
+        if (!slash)
+        {
+            child[base] = '/';
+        }
+        memcpy(child + base + !slash, e->d_name, n + 1);
+        if (e->d_type == DT_UNKNOWN)
+        {
+            struct stat st;
+            if (lstat(child, &st) == 0 && S_ISLNK(st.st_mode))
+            {
+                free(child);
+                continue;
+            }
+        }
+        if (queue_push(child, NULL) != 0)
+        {
+            report_error(t->path, strerror(ENOMEM));
+            break;
+        }
+    }
+    closedir(dir);
+    free_task(t);
+}
+
+// Takes ownership of t
+static void process(batch_t *b, task_t *t)
+{
+    struct stat st;
+    int fd = open(t->path, O_RDONLY);
+
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        fail_file(b, t, t->path, errno);
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        free_task(t);
+        return;
+    }
+
+    if (S_ISDIR(st.st_mode) && recursive && !t->expect)
+    {
+        walk_dir(b, t, fd); // Takes over fd
+        return;
+    }
+
+    if (S_ISDIR(st.st_mode))
+    {
+        fail_file(b, t, t->path, EISDIR);
+        free_task(t);
+    }
+    else if (S_ISREG(st.st_mode) && (size_t)st.st_size <= SMALL_MAX)
+    {
+        hash_small(b, t, fd, (size_t)st.st_size);
+    }
+    else if (S_ISREG(st.st_mode))
+    {
+        hash_large(b, t, fd, (size_t)st.st_size);
+    }
+    else
+    {
+        uint8_t digest[SM3_DIGEST_SIZE];
+        uint64_t bytes;
+
+        if (hash_stream(fd, digest, &bytes) != 0)
+        {
+            fail_file(b, t, t->path, errno);
+        }
+        else
+        {
+            emit(b, t, digest, bytes);
+        }
+        free_task(t);
+    }
+    close(fd);
+}
+
+static void *worker(void *arg)
+{
+    batch_t b;
+
+    (void)arg;
+    memset(&b, 0, sizeof(b));
+    b.arena = malloc(ARENA_SIZE);
+    if (!b.arena)
+    {
+        report_error("worker", strerror(ENOMEM));
+        return NULL;
+    }
+
+    pthread_mutex_lock(&queue.lock);
+    for (;;)
+    {
+        while (queue.len == 0 && queue.busy > 0)
+        {
+            // Nothing to take: finish the pending batch before sleeping
+            if (b.count > 0 || b.out_len > 0)
+            {
+                pthread_mutex_unlock(&queue.lock);
+                batch_flush(&b);
+                pthread_mutex_lock(&queue.lock);
+                continue;
+            }
+            pthread_cond_wait(&queue.cond, &queue.lock);
+        }
+        if (queue.len == 0)
+        {
+            break;
+        }
+
+        task_t *t = queue.items[--queue.len];
+        queue.busy++;
+        pthread_mutex_unlock(&queue.lock);
+
+        process(&b, t);
+
+        pthread_mutex_lock(&queue.lock);
+        queue.busy--;
+        if (queue.busy == 0 && queue.len == 0)
+        {
+            pthread_cond_broadcast(&queue.cond);
+        }
+    }
+    pthread_mutex_unlock(&queue.lock);
+
+    batch_flush(&b);
+    free(b.arena);
+    free(b.out);
+    return NULL;
+}
+
+// --- Check mode ------------------------------------------------------------
+
+static int parse_hex_digest(const char *s, uint8_t *out)
+{
+    for (int i = 0; i < SM3_DIGEST_SIZE; i++)
+    {
+        int v = 0;
+        for (int k = 0; k < 2; k++)
+        {
+            char c = s[2 * i + k];
+            v <<= 4;
+            if (c >= '0' && c <= '9')
+                v |= c - '0';
+            else if (c >= 'a' && c <= 'f')
+                v |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F')
+                v |= c - 'A' + 10;
+            else
+                return -1;
+        }
+        out[i] = (uint8_t)v;
+    }
+    return 0;
+}
+
+// "<hex>  name" or "<hex> *name", optionally with a leading backslash and
+// escaped name
+static int queue_check_file(const char *list)
+{
+    FILE *f = strcmp(list, "-") == 0 ? stdin : fopen(list, "r");
+    char *line = NULL;
+    size_t cap = 0;
+    ssize_t n;
+    int bad = 0;
+
+    if (!f)
+    {
+        report_error(list, strerror(errno));
+        return -1;
+    }
+    while ((n = getline(&line, &cap, f)) > 0)
+    {
+        uint8_t expected[SM3_DIGEST_SIZE];
+        char *p = line;
+        int escaped = 0;
+
+        while (n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r'))
+        {
+            line[--n] = '\0';
+        }
+        if (*p == '\\')
+        {
+            escaped = 1;
+            p++;
+        }
+        if (strlen(p) < 2 * SM3_DIGEST_SIZE + 2 || parse_hex_digest(p, expected) != 0 ||
+            p[2 * SM3_DIGEST_SIZE] != ' ' || (p[2 * SM3_DIGEST_SIZE + 1] != ' ' && p[2 * SM3_DIGEST_SIZE + 1] != '*'))
+        {
+            bad++;
+            continue;
+        }
+        p += 2 * SM3_DIGEST_SIZE + 2;
+
+        char *name = malloc(strlen(p) + 1), *q = name;
+        if (!name)
+        {
+            break;
+        }
+        for (; *p; p++)
+        {
+            if (escaped && *p == '\\' && p[1])
+            {
+                p++;
+                *q++ = *p == 'n' ? '\n' : *p == 'r' ? '\r' : *p;
+            }
+            else
+            {
+                *q++ = *p;
+            }
+        }
+        *q = '\0';
+        if (queue_push(name, expected) != 0)
+        {
+            report_error(list, strerror(ENOMEM));
+            break;
+        }
+    }
+    free(line);
+    if (f != stdin)
+    {
+        fclose(f);
+    }
+    if (bad)
+    {
+        fprintf(stderr, "sm3sum: WARNING: %d line%s improperly formatted\n", bad, bad == 1 ? " is" : "s are");
+    }
+    return 0;
+}
+
+// --- Main ------------------------------------------------------------------
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [options] [FILE|DIR]...\n", prog);
+    fprintf(stderr, "Print or check SM3 checksums, in the sha256sum format.\n");
+    fprintf(stderr, "  -c, --check    read checksums from the FILEs and check them\n");
+    fprintf(stderr, "  -r             hash directory trees (symlinks inside are skipped)\n");
+    fprintf(stderr, "  -j N           worker threads for walking, I/O and hashing\n");
+    fprintf(stderr, "                 (default: twice the online CPUs)\n");
+    fprintf(stderr, "  --quiet        with -c, do not print OK lines\n");
+    fprintf(stderr, "  --stats        print files, bytes and throughput to stderr\n");
+    fprintf(stderr, "With no FILE, or when FILE is -, read standard input.\n");
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = cpus > 0 ? 2 * (int)cpus : 2;
+    int stats = 0, i = 1, stdin_used = 0;
+    double start = now();
+
+    for (; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; i++)
+    {
+        if (strcmp(argv[i], "-c") == 0 || strcmp(argv[i], "--check") == 0)
+            check_mode = 1;
+        else if (strcmp(argv[i], "-r") == 0)
+            recursive = 1;
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--quiet") == 0)
+            quiet = 1;
+        else if (strcmp(argv[i], "--stats") == 0)
+            stats = 1;
+        else if (strcmp(argv[i], "--") == 0)
+        {
+            i++;
+            break;
+        }
+        else
+        {
+            usage(argv[0]);
+            return strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0 ? 0 : 2;
+        }
+    }
+    if (threads < 1)
+    {
+        threads = 1;
+    }
+
+    // Seed the queue; stdin is hashed here since it cannot be reopened
+    for (int a = i; a < argc || (a == i && i == argc); a++)
+    {
+        const char *arg = a < argc ? argv[a] : "-";
+
+        if (check_mode)
+        {
+            queue_check_file(arg);
+        }
+        else if (strcmp(arg, "-") == 0)
+        {
+            uint8_t digest[SM3_DIGEST_SIZE];
+            uint64_t bytes;
+
+            if (stdin_used++ == 0 && hash_stream(STDIN_FILENO, digest, &bytes) == 0)
+            {
+                for (int k = 0; k < SM3_DIGEST_SIZE; k++)
+                {
+                    printf("%02x", digest[k]);
+                }
+                printf("  -\n");
+                files_done++;
+                bytes_done += bytes;
+            }
+        }
+        else
+        {
+            char *path = strdup(arg);
+            if (!path || queue_push(path, NULL) != 0)
+            {
+                report_error(arg, strerror(ENOMEM));
+            }
+        }
+    }
+
+    // Hash names listed on the command line in reverse to pop them in order
+    pthread_mutex_lock(&queue.lock);
+    for (size_t lo = 0, hi = queue.len; hi > lo + 1; lo++, hi--)
+    {
+        task_t *tmp = queue.items[lo];
+        queue.items[lo] = queue.items[hi - 1];
+        queue.items[hi - 1] = tmp;
+    }
+    pthread_mutex_unlock(&queue.lock);
+
+    pthread_t *tid = malloc((size_t)threads * sizeof(*tid));
+    int started = 0;
+    fflush(stdout);
+    for (int t = 0; tid && t < threads; t++)
+    {
+        if (pthread_create(&tid[started], NULL, worker, NULL) == 0)
+        {
+            started++;
+        }
+    }
+    if (started == 0)
+    {
+        worker(NULL);
+    }
+    for (int t = 0; t < started; t++)
+    {
+        pthread_join(tid[t], NULL);
+    }
+    free(tid);
+    free(queue.items);
+    fflush(stdout);
+
+    if (check_mode && mismatches)
+    {
+        fprintf(stderr, "sm3sum: WARNING: %d computed checksum%s did NOT match\n", mismatches,
+                mismatches == 1 ? "" : "s");
+    }
+    if (stats)
+    {
+        double secs = now() - start;
+        fprintf(stderr, "sm3sum: %llu files, %llu bytes in %.3f s: %.0f files/s, %.3f GB/s (%d threads)\n",
+                (unsigned long long)files_done, (unsigned long long)bytes_done, secs,
+                secs > 0 ? files_done / secs : 0.0, secs > 0 ? bytes_done / secs / 1e9 : 0.0, threads);
+    }
+    return errors || mismatches ? 1 : 0;
+}